@@ -37,6 +37,8 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include "usb.h"
+#include "ch37x_stats.h"
+#include "ch37x_capture.h"
 
 #define WAIT_INT_TIMEOUT_MS 2000
 #define CH375_CHECK_EXIST_DATA1 0x65
@@ -143,6 +145,9 @@ struct ch375_Context_t {
     ch375_readDataFn_t read_data;
     ch375_queryIntFn_t query_int;
     struct k_mutex lock;
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+    struct ch37x_LinkStats_t stats;
+#endif
 };
 
 /**
@@ -168,6 +173,9 @@ int ch375_getStatus(struct ch375_Context_t *pCtx, uint8_t *pStatus);
 int ch375_abortNAK(struct ch375_Context_t *pCtx);
 int ch375_queryInt(struct ch375_Context_t *pCtx);
 int ch375_waitInt(struct ch375_Context_t *pCtx, uint32_t timeout_ms);
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+void ch375_getLinkStats(struct ch375_Context_t *pCtx, struct ch37x_LinkStats_t *pStats);
+#endif
 
 /**
  * @brief Host commands
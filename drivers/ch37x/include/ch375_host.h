@@ -49,6 +49,8 @@ extern "C" {
 #define USB_MAX_INTERFACES 4
 
 #define RESET_WAIT_DEVICE_RECONNECT_TIMEOUT_MS 1000
+#define CH375_HOST_READY_TIMEOUT_MS 500     // Power-on reset plus margin, the old fixed settle was 300 ms
+#define CH375_HOST_READY_POLL_MS 1
 #define TRANSFER_TIMEOUT 5000
 
 #define USB_DEFAULT_ADDRESS 1
@@ -148,10 +150,12 @@ struct USB_HID_Descriptor_t {
  * @brief Function prototypes
  */
 int ch375_hostInit(ch37x_Context_t *pCtx, uint32_t baudrate);
+int ch375_hostWaitReady(ch37x_Context_t *pCtx, uint32_t timeoutMs);
 int ch375_hostWaitDeviceConnect(ch37x_Context_t *pCtx, uint32_t timeout);
 int ch375_hostUdevOpen(ch37x_Context_t *pCtx, struct USB_Device_t *pUdev);
 void ch375_hostUdevClose(struct USB_Device_t *pUdev);
 int ch375_hostResetDev(struct USB_Device_t *pUdev);
+int ch375_hostParseConfig(struct USB_Device_t *pUdev);
 
 /**
  * @brief Transfer functions
@@ -54,10 +54,19 @@ extern "C" {
     #include <hardware/pio.h>
     #include <hardware/clocks.h>
     #include <hardware/gpio.h>
+#elif defined(CONFIG_ARCH_POSIX) && defined(CONFIG_GHOSTHIDE_CH37X_REPLAY)
+    #include "ch37x_replay.h"
+#elif defined(CONFIG_ARCH_POSIX)
+    #include "ch37x_sim.h"
+    #include "ch37x_sim_hid.h"
 #else
     #error "Unsupported platform"
 #endif
 
+// Start, 8 data, command flag, stop
+#define CH375_UART_FRAME_BITS 11
+#define CH375_UART_FRAME_US(_baud) DIV_ROUND_UP(CH375_UART_FRAME_BITS * USEC_PER_SEC, (_baud))
+
 /**
  * Hardware context structure
  */
@@ -84,6 +93,8 @@ extern "C" {
     #define PIO_UART_SM_TX 0
     #define PIO_UART_SM_RX 1
 
+    #define PIO_UART_IDLE_TIMEOUT_MS 20     // Longest wait for the line to go quiet
+
     typedef struct {
         const char *name;
         uint32_t baudrate;
@@ -97,6 +108,21 @@ extern "C" {
         uint offset_rx;
     } ch375_HwContext_t;
 
+#elif defined(CONFIG_ARCH_POSIX)
+    #define CH375_A_USART_INDEX 0
+    #define CH375_B_USART_INDEX 1
+
+    typedef struct {
+        const char *name;
+        uint32_t baudrate;
+#if defined(CONFIG_GHOSTHIDE_CH37X_REPLAY)
+        struct CH37xReplay_t replay;
+#else
+        struct CH37xSim_Chip_t chip;
+        struct CH37xSimHid_Device_t hid;
+#endif
+    } ch375_HwContext_t;
+
 #endif
 
 // Abstract wrapper for CH375 hardware initialization
@@ -36,6 +36,8 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include "usb.h"
+#include "ch37x_stats.h"
+#include "ch37x_capture.h"
 
 #define WAIT_INT_TIMEOUT_MS 2000
 #define CH376S_CHECK_EXIST_DATA1 0x65
@@ -138,6 +140,9 @@ struct ch376s_Context_t {
     ch376s_readDataFn_t read_data;
     ch376s_queryIntFn_t query_int;
     struct k_mutex lock;
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+    struct ch37x_LinkStats_t stats;
+#endif
 };
 
 /**
@@ -162,6 +167,9 @@ int ch376s_getStatus(struct ch376s_Context_t *pCtx, uint8_t *pStatus);
 int ch376s_abortNAK(struct ch376s_Context_t *pCtx);
 int ch376s_queryInt(struct ch376s_Context_t *pCtx);
 int ch376s_waitInt(struct ch376s_Context_t *pCtx, uint32_t timeout_ms);
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+void ch376s_getLinkStats(struct ch376s_Context_t *pCtx, struct ch37x_LinkStats_t *pStats);
+#endif
 
 /**
  * @brief Host commands
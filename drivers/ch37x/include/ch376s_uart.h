@@ -41,22 +41,44 @@ extern "C" {
 #include "ch376s.h"
 
 /**
- * Platform-specific includes - CH376S only supports RP2040/RP2350 for now
+ * Platform-specific includes - CH376S only supports RP2040/RP2350 (and native_sim) for now
  */
 #if defined(CONFIG_SOC_RP2350A_M33) || defined(CONFIG_SOC_RP2040) || defined(CONFIG_SOC_SERIES_RP2XXX)
     #include <hardware/pio.h>
     #include <hardware/clocks.h>
     #include <hardware/gpio.h>
+#elif defined(CONFIG_ARCH_POSIX) && defined(CONFIG_GHOSTHIDE_CH37X_REPLAY)
+    #include "ch37x_replay.h"
+#elif defined(CONFIG_ARCH_POSIX)
+    #include "ch37x_sim.h"
+    #include "ch37x_sim_hid.h"
 #else
     #error "CH376S currently only supports RP2040/RP2350 platforms"
 #endif
 
+// Start, 8 data, stop
+#define CH376S_UART_FRAME_BITS 10
+#define CH376S_UART_FRAME_US(_baud) DIV_ROUND_UP(CH376S_UART_FRAME_BITS * USEC_PER_SEC, (_baud))
+
 /**
  * Hardware context structure for CH376S (RP2 with 8-bit PIO UART)
  */
 #define CH376S_A_USART_INDEX 0
 #define CH376S_B_USART_INDEX 1
 
+#if defined(CONFIG_ARCH_POSIX)
+typedef struct {
+    const char *name;
+    uint32_t baudrate;
+#if defined(CONFIG_GHOSTHIDE_CH37X_REPLAY)
+    struct CH37xReplay_t replay;
+#else
+    struct CH37xSim_Chip_t chip;
+    struct CH37xSimHid_Device_t hid;
+#endif
+} ch376s_HwContext_t;
+
+#else
 #define PIO_UART_TX_PIN_CH376S_A 4
 #define PIO_UART_RX_PIN_CH376S_A 5
 #define PIO_UART_TX_PIN_CH376S_B 8
@@ -65,6 +87,8 @@ extern "C" {
 #define PIO_UART_SM_TX 0
 #define PIO_UART_SM_RX 1
 
+#define PIO_UART_IDLE_TIMEOUT_MS 20     // Longest wait for the line to go quiet
+
 typedef struct {
     const char *name;
     uint32_t baudrate;
@@ -77,6 +101,7 @@ typedef struct {
     uint offset_tx;
     uint offset_rx;
 } ch376s_HwContext_t;
+#endif
 
 /**
  * @brief Initialize CH376S hardware layer
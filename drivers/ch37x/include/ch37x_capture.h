@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_capture.h
+ * @brief          CH37x link capture shared by the CH375 and CH376S cores
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * With CONFIG_GHOSTHIDE_LINK_CAPTURE every command and data byte written to a
+ * chip, every byte (or error) read back and every INT# sample is stored as a
+ * 4 byte record: cycles since the previous record, kind and port, and the
+ * byte. Gaps over 16 bits of cycles are carried by a TIME record in front.
+ * Recording starts at boot and stops when the buffer is full, so the capture
+ * always holds the enumeration. The dump is turned into a trace file by
+ * scripts/capture_extract.py and played back by ch37x_replay.c on native_sim.
+ * Without the option the hooks expand to nothing.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CH37X_CAPTURE_H
+#define CH37X_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define CH37X_CAPTURE_PORT_COUNT    2
+#define CH37X_CAPTURE_PORT_NONE     0x0F    // Context not bound to a port
+#define CH37X_CAPTURE_RECORD_SIZE   4
+#define CH37X_CAPTURE_VERSION       1
+#define CH37X_CAPTURE_CHIP_CH375    0
+#define CH37X_CAPTURE_CHIP_CH376S   1
+
+#define CH37X_CAPTURE_KIND(kindPort)    ((kindPort) & 0x0F)
+#define CH37X_CAPTURE_PORT(kindPort)    ((kindPort) >> 4)
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Record kinds, byte in brackets
+ * @note scripts/capture_extract.py reads the names from here, keep new
+ * kinds at the end.
+ */
+typedef enum {
+    CH37X_CAPTURE_TIME = 0,     // Bits 16..31 of the next record's delta in dt (0)
+    CH37X_CAPTURE_CMD,          // Command written (command)
+    CH37X_CAPTURE_DATA,         // Data written (data)
+    CH37X_CAPTURE_RX,           // Byte read back (byte)
+    CH37X_CAPTURE_RX_ERR,       // Read failed (negated return code)
+    CH37X_CAPTURE_INT,          // INT# sampled (query_int result)
+    CH37X_CAPTURE_KIND_COUNT
+} ch37x_CaptureKind_e;
+
+/**
+ * @brief One record, little endian as dumped
+ */
+struct ch37x_CaptureRecord_t {
+    uint16_t dt;                // Cycles since the previous record, low 16 bits
+    uint8_t kind_port;          // Kind in bits 0..3, port in bits 4..7
+    uint8_t data;
+};
+
+/**
+ * @brief Header of a trace file, records follow
+ */
+struct ch37x_CaptureHeader_t {
+    char magic[4];              // "GHLC"
+    uint8_t version;
+    uint8_t chip;               // CH37X_CAPTURE_CHIP_*
+    uint16_t record_size;
+    uint32_t hz;                // Cycle counter frequency
+    uint32_t count;             // Records in the file
+    uint32_t dropped;           // Records lost to a full buffer
+};
+
+#if defined(CONFIG_GHOSTHIDE_LINK_CAPTURE)
+#define CH37X_CAPTURE(pCtx, kind, data)                                         \
+    ch37xCapture_record((pCtx), (kind), (uint8_t)(data))
+#else
+#define CH37X_CAPTURE(pCtx, kind, data)         do { } while (0)
+#endif
+
+/* Function prototypes ------------------------------------------------------*/
+void ch37xCapture_record(const void *pCtx, uint8_t kind, uint8_t data);
+void ch37xCapture_bindPort(const void *pCtx, uint8_t port);
+void ch37xCapture_clear(void);
+int ch37xCapture_export(uint8_t *pBuff, size_t size);
+void ch37xCapture_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH37X_CAPTURE_H */
@@ -324,6 +324,19 @@ static inline int ch37x_waitInt(ch37x_Context_t *pCtx, uint32_t timeout_ms) {
 #endif
 }
 
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+/**
+ * @brief Copy the UART link counters
+ */
+static inline void ch37x_getLinkStats(ch37x_Context_t *pCtx, struct ch37x_LinkStats_t *pStats) {
+#ifdef USE_CH376S
+    ch376s_getLinkStats((struct ch376s_Context_t *)pCtx, pStats);
+#else
+    ch375_getLinkStats((struct ch375_Context_t *)pCtx, pStats);
+#endif
+}
+#endif
+
 /* ==========================================================================
  * UNIFIED API WRAPPERS - Data Transfer
  * ========================================================================== */
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_replay.h
+ * @brief          Play a CH37x link capture back on native_sim
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Stands in for one chip of a captured session (see ch37x_capture.h). Every
+ * byte the cores write is checked against the next record of that port, reads
+ * and INT# samples return what the chip answered back then, and each record
+ * is held back until its captured time relative to the port's first record,
+ * spent with k_busy_wait() so polling loops and timeouts see the original
+ * timing. The first write that differs from the capture marks the replay as
+ * diverged: from then on writes are ignored and reads time out, and the
+ * record index of the divergence is kept for the report. Reads return 0,
+ * the error the chip's backend returned at capture time, or -ETIMEDOUT once
+ * the port's records ran out.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CH37X_REPLAY_H
+#define CH37X_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ch37x_capture.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define CH37X_REPLAY_READ_TIMEOUT_US    50000   // Read past the end or after a divergence
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Replay state of one port
+ */
+struct CH37xReplay_t {
+    const uint8_t *pRecords;
+    uint32_t count;
+    uint32_t hz;
+    uint8_t chip;               // CH37X_CAPTURE_CHIP_* of the capture
+    uint8_t port;
+    uint32_t pos;               // Next record, any port
+    uint64_t cyc;               // Capture time of the record before pos
+    uint64_t first_cyc;         // Capture time of the port's first record
+    uint64_t start_us;          // Replay time of the port's first record
+    bool is_started;
+    bool is_diverged;
+    uint32_t diverge_pos;       // Record the cores disagreed with
+    uint32_t records;           // Records of this port played
+};
+
+/* Function prototypes ------------------------------------------------------*/
+int ch37xReplay_open(struct CH37xReplay_t *pReplay, const uint8_t *pTrace, size_t len, uint8_t port);
+int ch37xReplay_writeCmd(struct CH37xReplay_t *pReplay, uint8_t cmd);
+int ch37xReplay_writeData(struct CH37xReplay_t *pReplay, uint8_t data);
+int ch37xReplay_writeByte(struct CH37xReplay_t *pReplay, uint8_t data);
+int ch37xReplay_readData(struct CH37xReplay_t *pReplay, uint8_t *pData);
+int ch37xReplay_queryInt(struct CH37xReplay_t *pReplay);
+bool ch37xReplay_isDone(struct CH37xReplay_t *pReplay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH37X_REPLAY_H */
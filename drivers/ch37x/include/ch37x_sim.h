@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_sim.h
+ * @brief          Behavioral CH375/CH376S model for native_sim
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Models the serial side of a CH375 (9-bit frames) or CH376S (8-bit frames)
+ * in host mode: the commands ch375.c and ch376s.c issue, the chip's baud
+ * rate, the interrupt status register and the USB transactions behind
+ * ISSUE_TKN_X. Every byte on the link costs its frame time at the current
+ * baud rate and every token its bus time at the device speed, spent with
+ * k_busy_wait(), which advances simulated time on native_sim. Bytes sent at
+ * a baud rate the chip is not running at are lost, as on the wire.
+ *
+ * A virtual USB device (see ch37x_sim_hid.h) is attached behind the chip.
+ * The model runs its control pipe (SETUP/DATA/STATUS, SET_ADDRESS) and hands
+ * requests and interrupt/bulk tokens to the device through its ops.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CH37X_SIM_H
+#define CH37X_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <zephyr/usb/usb_ch9.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define CH37X_SIM_BUFF_SIZE         64          // Chip USB buffer
+#define CH37X_SIM_CTRL_SIZE         512         // Longest control IN response
+#define CH37X_SIM_READ_TIMEOUT_US   50000       // Backend read timeout, as on hardware
+#define CH37X_SIM_TOKEN_US          12          // Chip latency per USB transaction
+#define CH37X_SIM_STATUS_BUSY       0x00        // GET_STATUS while a transaction runs
+#define CH37X_SIM_STATUS_NO_REPLY   0x20        // Device did not answer the token
+#define CH37X_SIM_IC_VER            0x43
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Serial framing of the modelled chip
+ */
+typedef enum {
+    CH37X_SIM_CH375 = 0,        // 9-bit frames, command bytes flagged by bit 8
+    CH37X_SIM_CH376S            // 8-bit frames, commands told apart by parser state
+} CH37xSim_ChipType_e;
+
+struct CH37xSim_Device_t;
+
+/**
+ * @brief Virtual device callbacks, all run on the thread driving the chip
+ */
+struct CH37xSim_DeviceOps_t {
+    // Bus reset, the model has already cleared the address
+    void (*reset)(struct CH37xSim_Device_t *pDev);
+    // Control request other than SET_ADDRESS. IN requests fill pIn (inSize
+    // bytes at most) and return the length, OUT requests get their data
+    // stage in pOut and return 0. Negative STALLs the request.
+    int (*control)(struct CH37xSim_Device_t *pDev, const struct usb_setup_packet *pSetup,
+                   const uint8_t *pOut, uint8_t *pIn, uint16_t inSize);
+    // IN token on endpoint ep (number only). Returns the packet length, 0 to NAK,
+    // negative to STALL. nowUs is the simulated time the token reached the device.
+    int (*in)(struct CH37xSim_Device_t *pDev, uint8_t ep, uint8_t *pData, uint8_t size, uint64_t nowUs);
+    // OUT token on endpoint ep. Returns 0 to ACK, negative to STALL.
+    int (*out)(struct CH37xSim_Device_t *pDev, uint8_t ep, const uint8_t *pData, uint8_t len);
+};
+
+/**
+ * @brief Bus side of a virtual device
+ */
+struct CH37xSim_Device_t {
+    const struct CH37xSim_DeviceOps_t *ops;
+    bool is_low_speed;
+    uint8_t ep0_max_packet;
+    uint8_t address;            // Managed by the model
+    void *priv;
+};
+
+/**
+ * @brief Control pipe state of the attached device
+ */
+struct CH37xSim_Ctrl_t {
+    struct usb_setup_packet setup;
+    uint8_t data[CH37X_SIM_CTRL_SIZE];
+    uint16_t len;               // IN response length, OUT data received
+    uint16_t pos;               // IN bytes sent
+    bool is_active;
+    bool is_stalled;
+};
+
+/**
+ * @brief One modelled chip
+ */
+struct CH37xSim_Chip_t {
+    struct CH37xSim_Device_t *pDev;
+    uint8_t bits_per_byte;      // Start + data (+ bit 8) + stop
+    uint8_t chip_type;
+    uint32_t chip_baud;         // Rate the chip runs at
+    uint32_t link_baud;         // Rate the MCU side runs at
+    // Command parser
+    uint8_t cmd;
+    uint8_t params[2];
+    uint8_t param_count;
+    uint8_t param_need;
+    uint8_t sync_state;         // CH376S serial sync header (0x57 0xAB) seen so far
+    // Bytes the chip answers with
+    uint8_t out[CH37X_SIM_BUFF_SIZE + 1];
+    uint8_t out_len;
+    uint8_t out_pos;
+    // USB host state
+    uint8_t usb_mode;
+    uint8_t usb_addr;
+    uint8_t retry;
+    bool is_low_speed;
+    bool is_bus_reset;          // Device went through a bus reset since attaching
+    uint8_t rx_buff[CH37X_SIM_BUFF_SIZE];
+    uint8_t rx_len;
+    uint8_t tx_buff[CH37X_SIM_BUFF_SIZE];
+    uint8_t tx_len;
+    uint8_t tx_need;
+    // Transaction behind the last ISSUE_TKN_X
+    uint8_t status;
+    bool is_busy;
+    bool is_int;                // Interrupt pending until GET_STATUS
+    bool is_retrying;
+    uint8_t token;              // (ep << 4) | pid
+    uint64_t done_us;
+    uint64_t retry_until_us;
+    struct CH37xSim_Ctrl_t ctrl;
+};
+
+/* Function prototypes ------------------------------------------------------*/
+void ch37xSim_init(struct CH37xSim_Chip_t *pChip, uint8_t chipType, uint32_t baudrate);
+void ch37xSim_attach(struct CH37xSim_Chip_t *pChip, struct CH37xSim_Device_t *pDev);
+void ch37xSim_detach(struct CH37xSim_Chip_t *pChip);
+void ch37xSim_setLinkBaudrate(struct CH37xSim_Chip_t *pChip, uint32_t baudrate);
+uint32_t ch37xSim_getChipBaudrate(const struct CH37xSim_Chip_t *pChip);
+int ch37xSim_writeCmd(struct CH37xSim_Chip_t *pChip, uint8_t cmd);
+int ch37xSim_writeData(struct CH37xSim_Chip_t *pChip, uint8_t data);
+int ch37xSim_writeByte(struct CH37xSim_Chip_t *pChip, uint8_t data);
+int ch37xSim_readData(struct CH37xSim_Chip_t *pChip, uint8_t *pData);
+int ch37xSim_queryInt(struct CH37xSim_Chip_t *pChip);
+uint64_t ch37xSim_nowUs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH37X_SIM_H */
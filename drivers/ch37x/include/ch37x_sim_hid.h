@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_sim_hid.h
+ * @brief          Virtual HID devices for the CH37x model
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * A full speed mouse (16 buttons, 16 bit X/Y, wheel, 7 byte reports at a set
+ * rate) and a low speed boot keyboard, both described by real descriptors
+ * and answering the standard and HID class requests the host side issues.
+ * The mouse draws small circles and rocks the wheel, the keyboard taps F24,
+ * so a simulated build attached to a desktop over USB/IP stays harmless.
+ * Any other HID device can be put together from a profile: its report
+ * descriptor, speed, endpoint sizes and polling interval. The model builds
+ * the device and configuration descriptors around it and sends idle reports
+ * (only the Report ID set) at the endpoint's bInterval, which is what the
+ * benchmark corpus uses. The IDs are pid.codes test IDs.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CH37X_SIM_HID_H
+#define CH37X_SIM_HID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ch37x_sim.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define CH37X_SIM_HID_VID           0x1209
+#define CH37X_SIM_HID_MOUSE_PID     0x0001
+#define CH37X_SIM_HID_KEYBOARD_PID  0x0002
+#define CH37X_SIM_HID_REPORT_MAX    16
+#define CH37X_SIM_HID_DEV_DESC_LEN  18
+#define CH37X_SIM_HID_CFG_DESC_LEN  34
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief A HID device described by its report descriptor
+ */
+struct CH37xSimHid_Profile_t {
+    uint16_t pid;
+    bool is_low_speed;
+    uint8_t ep0_max_packet;             // 8 on low speed, 8 to 64 on full speed
+    uint8_t protocol;                   // bInterfaceProtocol, 0 none, 1 keyboard, 2 mouse
+    uint8_t ep_max_packet;              // Interrupt IN wMaxPacketSize
+    uint8_t interval;                   // Interrupt IN bInterval in ms
+    const uint8_t *pReportDesc;
+    uint16_t report_desc_len;
+    uint8_t report_len;                 // Input report length, Report ID included
+    uint8_t report_id;                  // 0 when the descriptor declares none
+};
+
+/**
+ * @brief One virtual HID device
+ */
+struct CH37xSimHid_Device_t {
+    struct CH37xSim_Device_t dev;       // Attach this one to the chip
+    const uint8_t *pDevDesc;
+    const uint8_t *pCfgDesc;
+    uint16_t cfg_len;
+    const uint8_t *pReportDesc;
+    uint16_t report_desc_len;
+    bool is_keyboard;
+    uint8_t config;
+    uint8_t idle;
+    uint8_t protocol;
+    uint8_t leds;                       // Last output report (keyboard LEDs)
+    uint32_t interval_us;               // Time between input reports
+    uint64_t next_us;                   // Next input report due, 0 until the first IN
+    uint32_t seq;                       // Input reports sent
+    uint8_t report[CH37X_SIM_HID_REPORT_MAX];
+    uint8_t report_len;
+    uint8_t report_id;                  // First byte of every report, 0 for none
+    bool is_idle;                       // Profile device, reports carry no input
+    uint8_t dev_desc[CH37X_SIM_HID_DEV_DESC_LEN];
+    uint8_t cfg_desc[CH37X_SIM_HID_CFG_DESC_LEN];
+};
+
+/* Function prototypes ------------------------------------------------------*/
+void ch37xSimHid_initMouse(struct CH37xSimHid_Device_t *pHid, uint32_t reportHz);
+void ch37xSimHid_initKeyboard(struct CH37xSimHid_Device_t *pHid, uint32_t keysPerSec);
+int ch37xSimHid_initProfile(struct CH37xSimHid_Device_t *pHid, const struct CH37xSimHid_Profile_t *pProfile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH37X_SIM_HID_H */
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_stats.h
+ * @brief          UART link accounting shared by the CH375 and CH376S cores
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * With CONFIG_GHOSTHIDE_LINK_STATS every context counts the bytes, commands,
+ * status polls and NAKs it spends on the UART, and how long callers waited
+ * for its lock. Without it the hooks below expand to nothing (the lock to a
+ * plain k_mutex_lock()) and the context carries no counters.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CH37X_STATS_H
+#define CH37X_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/**
+ * @brief Command groups counted separately
+ */
+typedef enum {
+    CH37X_STATS_CMD_STATUS,         // GET_STATUS
+    CH37X_STATS_CMD_TOKEN,          // ISSUE_TKN_X / ISSUE_TOKEN
+    CH37X_STATS_CMD_RD_DATA,        // RD_USB_DATA(0)
+    CH37X_STATS_CMD_WR_DATA,        // WR_USB_DATA7
+    CH37X_STATS_CMD_RETRY,          // SET_RETRY
+    CH37X_STATS_CMD_OTHER,
+    CH37X_STATS_CMD_COUNT
+} ch37x_StatsCmd_e;
+
+/**
+ * @brief UART link counters of one context, all wrap around
+ */
+struct ch37x_LinkStats_t {
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t rx_timeouts;           // Backend gave up waiting for a byte
+    uint32_t cmds[CH37X_STATS_CMD_COUNT];
+    uint32_t wait_ints;
+    uint32_t status_polls;          // GET_STATUS issued from waitInt
+    uint32_t in_ok;                 // IN tokens answered with data
+    uint32_t in_naks;               // IN tokens answered with NAK
+    uint32_t short_timeouts;        // IN transfers ended by a NAK after a short packet
+    uint64_t lock_wait_cyc;
+};
+
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+#define CH37X_STATS_INC(pCtx, field)    ((pCtx)->stats.field++)
+#define CH37X_STATS_CMD(pCtx, slot)     ((pCtx)->stats.cmds[(slot)]++)
+#define CH37X_LOCK(pCtx)                                                        \
+    do {                                                                        \
+        uint32_t lockStartCyc = k_cycle_get_32();                               \
+        k_mutex_lock(&(pCtx)->lock, K_FOREVER);                                 \
+        (pCtx)->stats.lock_wait_cyc += k_cycle_get_32() - lockStartCyc;         \
+    } while (0)
+#else
+#define CH37X_STATS_INC(pCtx, field)    do { } while (0)
+#define CH37X_STATS_CMD(pCtx, slot)     do { } while (0)
+#define CH37X_LOCK(pCtx)                k_mutex_lock(&(pCtx)->lock, K_FOREVER)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH37X_STATS_H */
@@ -26,6 +26,10 @@
 
 LOG_MODULE_REGISTER(ch375, LOG_LEVEL_DBG);
 
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+static ch37x_StatsCmd_e stats_cmd_slot(uint8_t cmd);
+#endif
+
 /* --------------------------------------------------------------------------
  * CH375 core functions
  * -------------------------------------------------------------------------*/
@@ -118,7 +122,7 @@ int ch375_checkExist(struct ch375_Context_t *pCtx) {
 	uint8_t recvBuff = 0;
 	int ret = -1;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_CHECK_EXIST);
 	if ( CH375_SUCCESS != ret) {
@@ -164,7 +168,7 @@ int ch375_getVersion(struct ch375_Context_t *pCtx, uint8_t *pVersion) {
 	uint8_t ver = 0;
 	int ret = -1;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_GET_IC_VER);
 	if ( CH375_SUCCESS != ret) {
@@ -268,7 +272,7 @@ int ch375_setBaudrate(struct ch375_Context_t *pCtx, uint32_t baudrate) {
 		}
 	}
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_SET_BAUDRATE);
 	if ( CH375_SUCCESS != ret) {
@@ -308,7 +312,7 @@ int ch375_setUSBMode(struct ch375_Context_t *pCtx, uint8_t mode) {
 	int ret = -1;
 	uint8_t usb_mode = 0;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_SET_USB_MODE);
 	if ( CH375_SUCCESS != ret) {
@@ -354,7 +358,7 @@ int ch375_getStatus(struct ch375_Context_t *pCtx, uint8_t *pStatus) {
 	int ret = -1;
 	uint8_t status = -1;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_GET_STATUS);
 	if ( CH375_SUCCESS != ret) {
@@ -388,7 +392,7 @@ int ch375_abortNAK(struct ch375_Context_t *pCtx) {
 
 	int ret = -1;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_ABORT_NAK);
 
@@ -404,12 +408,17 @@ int ch375_abortNAK(struct ch375_Context_t *pCtx) {
   */
 int ch375_queryInt(struct ch375_Context_t *pCtx) {
 	
+	int ret = -1;
+
 	if ( NULL == pCtx ) {
 		LOG_ERR("Invalid context!");
 		return 0;
 	}
 
-	return pCtx->query_int(pCtx);
+	ret = pCtx->query_int(pCtx);
+	CH37X_CAPTURE(pCtx, CH37X_CAPTURE_INT, ret);
+
+	return ret;
 }
 
 /**
@@ -430,8 +439,11 @@ int ch375_waitInt(struct ch375_Context_t *pCtx, uint32_t timeout_ms) {
         LOG_ERR("Invalid context!");
         return CH375_PARAM_INVALID;
     }
+
+    CH37X_STATS_INC(pCtx, wait_ints);
     
     // Initial status read
+    CH37X_STATS_INC(pCtx, status_polls);
     ret = ch375_getStatus(pCtx, &status);
     if ( CH375_SUCCESS == ret ) {
         lastStatus = status;
@@ -449,6 +461,7 @@ int ch375_waitInt(struct ch375_Context_t *pCtx, uint32_t timeout_ms) {
     while ((k_uptime_get_32() - start) < timeout_ms) {
         
 		pollCount++;
+        CH37X_STATS_INC(pCtx, status_polls);
         ret = ch375_getStatus(pCtx, &status);
         
         if (CH375_SUCCESS == ret) {
@@ -481,12 +494,32 @@ int ch375_waitInt(struct ch375_Context_t *pCtx, uint32_t timeout_ms) {
     }
 
     // Timeout
+    CH37X_STATS_INC(pCtx, status_polls);
     ret = ch375_getStatus(pCtx, &status);
     LOG_ERR("Polling timeout after %u ms (%u polls, final_status=0x%02X, ret=%d)", timeout_ms, pollCount, status, ret);
     
     return CH375_TIMEOUT;
 }
 
+/**
+  * @brief Copy the UART link counters of a context
+  * @param pCtx The context
+  * @param pStats Pointer to the counters to fill
+  * @retval None
+  */
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+void ch375_getLinkStats(struct ch375_Context_t *pCtx, struct ch37x_LinkStats_t *pStats) {
+
+	if (NULL == pCtx || NULL == pStats) {
+		return;
+	}
+
+	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	*pStats = pCtx->stats;
+	k_mutex_unlock(&pCtx->lock);
+}
+#endif
+
 /* --------------------------------------------------------------------------
  * Host commands
  * -------------------------------------------------------------------------*/
@@ -508,7 +541,7 @@ int ch375_testConnect(struct ch375_Context_t *pCtx, uint8_t *pConnStatus) {
 	uint8_t status = 0;
 	uint8_t buff = 0;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx,CH375_CMD_TEST_CONNECT);
 	if (CH375_SUCCESS != ret) {
@@ -553,7 +586,7 @@ int ch375_getDevSpeed(struct ch375_Context_t *pCtx, uint8_t *pSpeed) {
 	int ret = -1;
 	uint8_t devSpeed;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret  = ch375_writeCmd(pCtx, CH375_CMD_GET_DEV_RATE);
 	if (CH375_SUCCESS != ret) {
@@ -603,7 +636,7 @@ int ch375_setDevSpeed(struct ch375_Context_t *pCtx, uint8_t speed) {
 
 	devSpeed = (speed == USB_SPEED_SPEED_LS ? 0x02 : 0x00);
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_SET_USB_SPEED);
 	if ( CH375_SUCCESS != ret) {
@@ -636,7 +669,7 @@ int ch375_setUSBAddr(struct ch375_Context_t *pCtx, uint8_t addr) {
 
 	int ret = -1;
 	
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_SET_USB_ADDR);
 	if ( CH375_SUCCESS != ret) {
@@ -670,7 +703,7 @@ int ch375_setRetry(struct ch375_Context_t *pCtx, uint8_t times) {
 	int ret = -1;
 	uint8_t param;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_SET_RETRY);
 	if ( CH375_SUCCESS != ret ) {
@@ -739,7 +772,7 @@ int ch375_sendToken(struct ch375_Context_t *pCtx, uint8_t ep, bool tog,
 	// 4 MSBs are EP number and the rest is PID token
 	epPID = (ep << 4) | pid;
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 
 	ret = ch375_writeCmd(pCtx, CH375_CMD_ISSUE_TKN_X);
 	if (CH375_SUCCESS != ret) {
@@ -798,6 +831,10 @@ int ch375_writeCmd(struct ch375_Context_t *pCtx, uint8_t cmd) {
 		return CH375_PARAM_INVALID;
 	}
 
+	CH37X_STATS_INC(pCtx, tx_bytes);
+	CH37X_STATS_CMD(pCtx, stats_cmd_slot(cmd));
+	CH37X_CAPTURE(pCtx, CH37X_CAPTURE_CMD, cmd);
+
 	return pCtx->write_cmd(pCtx, cmd);
 }
 
@@ -814,6 +851,9 @@ int ch375_writeData(struct ch375_Context_t *pCtx, uint8_t data) {
 		return CH375_PARAM_INVALID;
 	}
 
+	CH37X_STATS_INC(pCtx, tx_bytes);
+	CH37X_CAPTURE(pCtx, CH37X_CAPTURE_DATA, data);
+
 	return pCtx->write_data(pCtx, data);
 }
 
@@ -825,12 +865,25 @@ int ch375_writeData(struct ch375_Context_t *pCtx, uint8_t data) {
   */
 int ch375_readData(struct ch375_Context_t *pCtx, uint8_t *pData) {
 	
+	int ret = -1;
+
 	if (NULL == pCtx || NULL == pData) {
 		LOG_ERR("Invalid parameters!");
 		return CH375_PARAM_INVALID;
 	}
 
-	return pCtx->read_data(pCtx, pData);
+	ret = pCtx->read_data(pCtx, pData);
+	if (CH375_SUCCESS == ret) {
+		CH37X_STATS_INC(pCtx, rx_bytes);
+		CH37X_CAPTURE(pCtx, CH37X_CAPTURE_RX, *pData);
+	} else {
+		if (CH375_TIMEOUT == ret) {
+			CH37X_STATS_INC(pCtx, rx_timeouts);
+		}
+		CH37X_CAPTURE(pCtx, CH37X_CAPTURE_RX_ERR, -ret);
+	}
+
+	return ret;
 }
 
 /**
@@ -852,7 +905,7 @@ int ch375_writeBlockData(struct ch375_Context_t *pCtx, uint8_t *pBuff, uint8_t l
 		return CH375_PARAM_INVALID;
 	}
 
-	k_mutex_lock(&pCtx->lock, K_FOREVER);
+	CH37X_LOCK(pCtx);
 	
 	ret = ch375_writeCmd(pCtx, CH375_CMD_WR_USB_DATA7);
     if (CH375_SUCCESS != ret) {
@@ -901,7 +954,7 @@ int ch375_readBlockData(struct ch375_Context_t *pCtx, uint8_t *pBuff, uint8_t le
         return CH375_PARAM_INVALID;
     }
     
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
     
     ret = ch375_writeCmd(pCtx, CH375_CMD_RD_USB_DATA);
     if (CH375_SUCCESS != ret) {
@@ -942,4 +995,32 @@ int ch375_readBlockData(struct ch375_Context_t *pCtx, uint8_t *pBuff, uint8_t le
     
     k_mutex_unlock(&pCtx->lock);
     return CH375_SUCCESS;
-}
\ No newline at end of file
+}
+
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+static ch37x_StatsCmd_e stats_cmd_slot(uint8_t cmd) {
+
+	switch (cmd) {
+		case CH375_CMD_GET_STATUS: {
+			return CH37X_STATS_CMD_STATUS;
+		}
+		case CH375_CMD_ISSUE_TKN_X:
+		case CH375_CMD_ISSUE_TOKEN: {
+			return CH37X_STATS_CMD_TOKEN;
+		}
+		case CH375_CMD_RD_USB_DATA0:
+		case CH375_CMD_RD_USB_DATA: {
+			return CH37X_STATS_CMD_RD_DATA;
+		}
+		case CH375_CMD_WR_USB_DATA7: {
+			return CH37X_STATS_CMD_WR_DATA;
+		}
+		case CH375_CMD_SET_RETRY: {
+			return CH37X_STATS_CMD_RETRY;
+		}
+		default: {
+			return CH37X_STATS_CMD_OTHER;
+		}
+	}
+}
+#endif
@@ -24,15 +24,15 @@
  */
 
 #include "ch375_host.h"
+#include "trace_points.h"
 
-LOG_MODULE_REGISTER(ch375_host, LOG_LEVEL_DBG);
+LOG_MODULE_REGISTER(ch375_host, LOG_LEVEL_INF);
 
 /* Private variables ---------------------------------------------------------*/
 
 /* Private function prototypes -----------------------------------------------*/
 static int set_dev_address(struct USB_Device_t *pUdev, uint8_t addr);
 static int get_config_descriptor(struct USB_Device_t *pUdev, uint8_t *pBuff, uint16_t len);
-static int parse_config_descriptor(struct USB_Device_t *pUdev);
 static void parse_interface_descriptor(struct USB_Device_t *pUdev, struct usb_if_descriptor *pDesc);
 static void parse_endpoint_descriptor(struct USB_Interface_t *pIfc, struct usb_ep_descriptor *pDesc);
 static int reset_dev(ch37x_Context_t *pCtx);
@@ -53,12 +53,14 @@ int ch375_hostInit(ch37x_Context_t *pCtx, uint32_t baudrate) {
         return CH37X_HOST_PARAM_INVALID;
     }
 
-    ret = ch37x_checkExist(pCtx);
-    if (CH37X_SUCCESS != ret) {
+    // The chip may still be in its power-on reset
+    ret = ch375_hostWaitReady(pCtx, CH375_HOST_READY_TIMEOUT_MS);
+    if (CH37X_HOST_SUCCESS != ret) {
         LOG_ERR("CH375 doesn't exist: %d", ret);
         return CH37X_HOST_ERROR;
     }
 
+    // The chip answers SET_USB_MODE once the mode is in effect, no settle time needed
     ret = ch37x_setUSBMode(pCtx, CH37X_USB_MODE_SOF_AUTO);
     if (CH37X_SUCCESS != ret) {
         LOG_ERR("Set USB mode failed: %d", ret);
@@ -66,8 +68,6 @@ int ch375_hostInit(ch37x_Context_t *pCtx, uint32_t baudrate) {
     }
     LOG_INF("Set USB mode to Host with SOF");
 
-    k_msleep(20);
-
     ret = ch37x_setBaudrate(pCtx, baudrate);
     if (CH37X_SUCCESS != ret) {
         LOG_ERR("Set baudrate failed: %d", ret);
@@ -78,6 +78,34 @@ int ch375_hostInit(ch37x_Context_t *pCtx, uint32_t baudrate) {
     return CH37X_HOST_SUCCESS;
 }
 
+/**
+  * @brief Wait until the CH375 answers CHECK_EXIST
+  * @param pCtx Pointer to the context
+  * @param timeoutMs How long to keep asking, in milliseconds
+  * @retval 0 as soon as it answers, CH37X_HOST_TIMEOUT otherwise
+  * @note Used instead of fixed delays after power-on and after a baud rate
+  *       switch. A silent chip costs one read timeout per try.
+  */
+int ch375_hostWaitReady(ch37x_Context_t *pCtx, uint32_t timeoutMs) {
+
+    int ret = -1;
+    int64_t deadlineMs = k_uptime_get() + timeoutMs;
+
+    while (1) {
+        ret = ch37x_checkExist(pCtx);
+        if (CH37X_SUCCESS == ret) {
+            return CH37X_HOST_SUCCESS;
+        }
+
+        if (k_uptime_get() >= deadlineMs) {
+            LOG_ERR("No answer within %" PRIu32 " ms: %d", timeoutMs, ret);
+            return CH37X_HOST_TIMEOUT;
+        }
+
+        k_msleep(CH375_HOST_READY_POLL_MS);
+    }
+}
+
 /**
   * @brief Try to connect to the CH375
   * @param pCtx Pointer to the context
@@ -232,7 +260,7 @@ int ch375_hostUdevOpen(ch37x_Context_t *pCtx, struct USB_Device_t *pUdev) {
         return CH37X_HOST_ERROR;
     }
 
-    ret = parse_config_descriptor(pUdev);
+    ret = ch375_hostParseConfig(pUdev);
     if (CH37X_HOST_SUCCESS != ret) {
         LOG_ERR("Parse config descriptor failed: %d", ret);
         if (pUdev->raw_conf_desc) {
@@ -301,6 +329,96 @@ void ch375_hostUdevClose(struct USB_Device_t *pUdev) {
     memset(pUdev, 0x00, sizeof(struct USB_Device_t));
 }
 
+/**
+  * @brief Fill in the interfaces and endpoints of a device from its raw configuration descriptor
+  * @param pUdev Pointer to the device, raw_conf_desc and raw_conf_desc_len set
+  * @retval 0 on success, error code otherwise
+  * @note The descriptor comes from the device and is not trusted. Interfaces and
+  * endpoints past USB_MAX_INTERFACES / USB_MAX_ENDPOINTS and endpoints outside
+  * an interface are ignored, a descriptor running past the end or too short
+  * for its type fails the parse.
+  */
+int ch375_hostParseConfig(struct USB_Device_t *pUdev) {
+    
+    bool isInInterface = false;
+
+    if ( NULL == pUdev || NULL == pUdev->raw_conf_desc || 0 == pUdev->raw_conf_desc_len) {
+        return CH37X_HOST_ERROR;
+    }
+
+    uint8_t *pDescStart = (uint8_t *)pUdev->raw_conf_desc;
+    uint8_t *pDescEnd = pDescStart + pUdev->raw_conf_desc_len;
+
+    pUdev->interface_count = 0;
+    memset(pUdev->interfaces, 0x00, sizeof(pUdev->interfaces));
+
+    while (pDescStart + sizeof(struct usb_desc_header) <= pDescEnd) {
+        struct usb_desc_header *pHdr = (struct usb_desc_header *)pDescStart;
+
+        if (0 == pHdr->bLength) {
+            LOG_ERR("Descriptor parsing error: %d length", pHdr->bLength);
+            return CH37X_HOST_ERROR;
+        }
+
+        if (pDescStart + pHdr->bLength > pDescEnd) {
+            LOG_ERR("Descriptor parsing error: %" PRIu32 " length exceed descriptor end. %" PRIu32 " bytes truncated", pHdr->bLength, (unsigned)(pDescEnd - pDescStart));
+            return CH37X_HOST_ERROR;
+        }
+
+        switch (pHdr->bDescriptorType) {
+            case USB_DESC_INTERFACE: {
+                if (pHdr->bLength < sizeof(struct usb_if_descriptor)) {
+                    LOG_ERR("Interface descriptor too short: %d", pHdr->bLength);
+                    return CH37X_HOST_ERROR;
+                }
+
+                isInInterface = (pUdev->interface_count < USB_MAX_INTERFACES);
+                if (true != isInInterface) {
+                    LOG_WRN("More than %d interfaces, ignoring interface %d", USB_MAX_INTERFACES,
+                                            ((struct usb_if_descriptor *)pHdr)->bInterfaceNumber);
+                    break;
+                }
+
+                parse_interface_descriptor(pUdev, (struct usb_if_descriptor *)pHdr);
+                break;
+            }
+            
+            case USB_DESC_ENDPOINT: {
+                struct USB_Interface_t *pIfc = NULL;
+
+                if (pHdr->bLength < sizeof(struct usb_ep_descriptor)) {
+                    LOG_ERR("Endpoint descriptor too short: %d", pHdr->bLength);
+                    return CH37X_HOST_ERROR;
+                }
+
+                if (true != isInInterface) {
+                    LOG_WRN("Endpoint 0x%02X outside a known interface, ignored",
+                                            ((struct usb_ep_descriptor *)pHdr)->bEndpointAddress);
+                    break;
+                }
+
+                pIfc = &pUdev->interfaces[pUdev->interface_count - 1];
+                if (pIfc->endpoint_count >= USB_MAX_ENDPOINTS) {
+                    LOG_WRN("More than %d endpoints on interface %d, ignoring endpoint 0x%02X", USB_MAX_ENDPOINTS,
+                            pIfc->interface_number, ((struct usb_ep_descriptor *)pHdr)->bEndpointAddress);
+                    break;
+                }
+
+                parse_endpoint_descriptor(pIfc, (struct usb_ep_descriptor  *)pHdr);
+                break;
+            }
+
+            default: {
+                break;
+            }
+        }
+
+        pDescStart += pHdr->bLength;
+    }
+
+    return CH37X_HOST_SUCCESS;
+}
+
 /**
   * @brief Reset device connected to CH375
   * @param pUdev Pointer to the device
@@ -398,8 +516,9 @@ int ch375_hostResetDev(struct USB_Device_t *pUdev) {
   * @param pData Pointer to data buffer
   * @param wLength Request length
   * @param pActualLen Actual length of data
-  * @param timeout Timeout in milliseconds
-  * @retval 0 on success, error code otherwise
+  * @param timeout Timeout in milliseconds, 0 for a single attempt per stage
+  * @retval 0 on success, CH37X_HOST_TIMEOUT if a 0 ms transfer was NAKed,
+  *         error code otherwise
   */
 int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8_t bRequest, 
     uint16_t wValue, uint16_t wIndex, uint8_t *pData, uint16_t wLength, int *pActualLen, uint32_t timeout) {
@@ -423,7 +542,10 @@ int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8
 
     pCtx = pUdev->ctx;
 
-    if (USB_SREQ_GET_DESCRIPTOR == bRequest) {
+    if (0 == timeout) {
+        // Fail on the first NAK instead of letting the chip retry
+        ret = ch37x_setRetry(pCtx, CH37X_RETRY_TIMES_ZERO);
+    } else if (USB_SREQ_GET_DESCRIPTOR == bRequest) {
         ret = ch37x_setRetry(pCtx, CH37X_RETRY_TIMES_2MS);
         LOG_DBG("Using tolerant retry for GET_DESCRIPTOR");
     } else {
@@ -487,10 +609,7 @@ int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8
                     // Handle NAK
                     if (status == CH37X_PID2STATUS(USB_PID_NAK)) {
                         naks++;
-                        if (naks % 100 == 0) {
-                            LOG_DBG("NAK count: %d (received so far: %d/%d)", 
-                                   naks, totalReceived, wLength);
-                        }
+                        TRACE_POINT(TRACE_EVT_CTRL_NAK, tracePoints_portOf(pCtx), naks, totalReceived);
                         
                         // For large descriptors wait longer
                         if (totalReceived > 0) {
@@ -543,9 +662,7 @@ int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8
                 if (packetLen > 0) {
                     totalReceived += packetLen;
                     toggle = !toggle;
-                    
-                    LOG_DBG("Received packet: len=%d, total=%d/%d, toggle=%d", 
-                           packetLen, totalReceived, wLength, toggle);
+                    TRACE_POINT(TRACE_EVT_CTRL_PACKET, tracePoints_portOf(pCtx), packetLen, totalReceived);
                 }
 
                 // Short packet indicates EOT
@@ -583,6 +700,10 @@ int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8
                     return CH37X_HOST_ERROR;
                 }
 
+                if (status == CH37X_PID2STATUS(USB_PID_NAK)) {
+                    return CH37X_HOST_TIMEOUT;
+                }
+
                 if (CH37X_USB_INT_SUCCESS != status) {
                     LOG_ERR("OUT token failed, status: 0x%02X", status);
                     if (CH37X_USB_INT_DISCONNECT == status) {
@@ -659,6 +780,10 @@ int ch375_hostControlTransfer(struct USB_Device_t *pUdev, uint8_t reqType, uint8
             return CH37X_HOST_ERROR;
         }
         
+        if (status == CH37X_PID2STATUS(USB_PID_NAK)) {
+            return CH37X_HOST_TIMEOUT;
+        }
+
         if (CH37X_USB_INT_SUCCESS != status) {
             LOG_ERR("Status IN failed: 0x%02X", status);
             if (CH37X_USB_INT_DISCONNECT == status) {
@@ -719,10 +844,8 @@ int ch375_hostBulkTransfer(struct USB_Device_t *pUdev, uint8_t ep, uint8_t *pDat
     }
 
     uint32_t nakCount = 0;
-    uint32_t loopCount = 0;
 
     while (resiLen > 0) {
-        loopCount++;
         uint8_t len = resiLen > endpoint->max_packet ? endpoint->max_packet : resiLen;
         uint8_t actualLen = 0;
         
@@ -733,18 +856,14 @@ int ch375_hostBulkTransfer(struct USB_Device_t *pUdev, uint8_t ep, uint8_t *pDat
                 return CH37X_HOST_ERROR;
             }
             
-            if (loopCount <= 3 || status != CH37X_PID2STATUS(USB_PID_NAK)) {
-                LOG_DBG("[#%" PRIu32 "] IN token response: status=0x%02X (loop=%" PRIu32 ")",
-                        thisTransfer, status, loopCount);
-            }
-            
             if (CH37X_USB_INT_SUCCESS == status) {
+                CH37X_STATS_INC(pCtx, in_ok);
                 ret = ch37x_readBlockData(pCtx, pData + offset, len, &actualLen);
                 if (CH37X_SUCCESS != ret) {
                     LOG_ERR("[#%" PRIu32 "] Read data failed: %d", thisTransfer, ret);
                     return CH37X_HOST_ERROR;
                 }
-                LOG_DBG("[#%" PRIu32 "] Read SUCCESS: actual_len=%d", thisTransfer, actualLen);
+                TRACE_POINT(TRACE_EVT_IN_DATA, tracePoints_portOf(pCtx), actualLen, offset);
             }
         } else {
             ret = ch37x_writeBlockData(pCtx, pData + offset, len);
@@ -765,11 +884,6 @@ int ch375_hostBulkTransfer(struct USB_Device_t *pUdev, uint8_t ep, uint8_t *pDat
         }
 
         if (CH37X_USB_INT_SUCCESS == status) {
-            LOG_DBG("[#%" PRIu32 "] Transfer successful: offset=%d->%d residue=%d->%d tog=%d->%d",
-                    thisTransfer, offset, offset + actualLen, 
-                    resiLen, resiLen - actualLen,
-                    endpoint->data_toggle, !endpoint->data_toggle);
-            
             endpoint->data_toggle = !endpoint->data_toggle;
             offset += actualLen;
             resiLen -= actualLen;
@@ -778,21 +892,23 @@ int ch375_hostBulkTransfer(struct USB_Device_t *pUdev, uint8_t ep, uint8_t *pDat
         
         if (status == CH37X_PID2STATUS(USB_PID_NAK)){
             nakCount++;
-
-            if (nakCount <= 5 || nakCount % 100 == 0) {
-                LOG_DBG("[#%" PRIu32 "] NAK received (count=%" PRIu32 ", timeout=%" PRIu32 ", offset=%d)",
-                        thisTransfer, nakCount, timeout, offset);
+            if (EP_IN(ep)) {
+                CH37X_STATS_INC(pCtx, in_naks);
             }
             
             if (timeout == 0) {
-                LOG_DBG("[#%" PRIu32 "] NAK with timeout=0: returning TIMEOUT (offset=%d, NAKs=%" PRIu32 ")",
-                        thisTransfer, offset, nakCount);
-                
                 if (NULL != pActualLen) {
                     *pActualLen = offset;
                 }
+                // The short packet already ended the transfer, this NAK cost a token round trip
+                if (0 != offset) {
+                    CH37X_STATS_INC(pCtx, short_timeouts);
+                    TRACE_POINT(TRACE_EVT_IN_TIMEOUT, tracePoints_portOf(pCtx), offset, nakCount);
+                }
                 return CH37X_HOST_TIMEOUT;
             }
+            // Empty polls end above, only NAKs that are waited out are traced
+            TRACE_POINT(TRACE_EVT_IN_NAK, tracePoints_portOf(pCtx), nakCount, offset);
             timeout--;
             k_msleep(1);
         } else {
@@ -916,50 +1032,6 @@ static int get_config_descriptor(struct USB_Device_t *pUdev, uint8_t *pBuff, uin
     return CH37X_HOST_SUCCESS;
 }
 
-static int parse_config_descriptor(struct USB_Device_t *pUdev) {
-    
-    if ( NULL == pUdev || NULL == pUdev->raw_conf_desc || 0 == pUdev->raw_conf_desc_len) {
-        return CH37X_HOST_ERROR;
-    }
-
-    uint8_t *pDescStart = (uint8_t *)pUdev->raw_conf_desc;
-    uint8_t *pDescEnd = pDescStart + pUdev->raw_conf_desc_len;
-
-    while (pDescStart + sizeof(struct usb_desc_header) <= pDescEnd) {
-        struct usb_desc_header *pHdr = (struct usb_desc_header *)pDescStart;
-
-        if (0 == pHdr->bLength) {
-            LOG_ERR("Descriptor parsing error: %d length", pHdr->bLength);
-            return CH37X_HOST_ERROR;
-        }
-
-        if (pDescStart + pHdr->bLength > pDescEnd) {
-            LOG_ERR("Descriptor parsing error: %" PRIu32 " length exceed descriptor end. %" PRIu32 " bytes truncated", pHdr->bLength, (unsigned)(pDescEnd - pDescStart));
-            return CH37X_HOST_ERROR;
-        }
-
-        switch (pHdr->bDescriptorType) {
-            case USB_DESC_INTERFACE: {
-                parse_interface_descriptor(pUdev, (struct usb_if_descriptor *)pHdr);
-                break;
-            }
-            
-            case USB_DESC_ENDPOINT: {
-                parse_endpoint_descriptor(&pUdev->interfaces[pUdev->interface_count - 1], (struct usb_ep_descriptor  *)pHdr);
-                break;
-            }
-
-            default: {
-                break;
-            }
-        }
-
-        pDescStart += pHdr->bLength;
-    }
-
-    return CH37X_HOST_SUCCESS;
-}
-
 static void parse_interface_descriptor(struct USB_Device_t *pUdev, struct usb_if_descriptor *pDesc) {
     
     struct USB_Interface_t *interface = &pUdev->interfaces[pUdev->interface_count];
@@ -39,6 +39,12 @@ LOG_MODULE_REGISTER(ch375_uart, LOG_LEVEL_DBG);
                                 uint32_t initial_baudrate, 
                                 struct ch375_Context_t **ppCtxOut);
     extern int ch375_rp2_set_baudrate(struct ch375_Context_t *pCtx, uint32_t baudrate);
+#elif defined(CONFIG_ARCH_POSIX)
+    extern int ch375_sim_hw_init(const char *name, int uart_index, 
+                                const struct gpio_dt_spec *int_gpio, 
+                                uint32_t initial_baudrate, 
+                                struct ch375_Context_t **ppCtxOut);
+    extern int ch375_sim_set_baudrate(struct ch375_Context_t *pCtx, uint32_t baudrate);
 #else
     #error "Unsupported platform. Please build for a supported platform."
 #endif
@@ -57,6 +63,9 @@ int ch375_hwInitManual(const char *name, int usart_index, const struct gpio_dt_s
 #elif defined(CONFIG_SOC_RP2040)
     LOG_INF("Platform: RP2040 (RPI Pico)");
     return ch375_rp2_hw_init(name, usart_index, int_gpio, initial_baudrate, ppCtxOut);
+#elif defined(CONFIG_ARCH_POSIX)
+    LOG_INF("Platform: native_sim (simulated CH375)");
+    return ch375_sim_hw_init(name, usart_index, int_gpio, initial_baudrate, ppCtxOut);
 #else
     LOG_ERR("ERROR: No platform defined!");
     return -ENOTSUP;
@@ -74,6 +83,8 @@ int ch375_hwSetBaudrate(struct ch375_Context_t *pCtx, uint32_t baudrate)
     return ch375_stm32_set_baudrate(pCtx, baudrate);
 #elif defined(CONFIG_SOC_RP2350A_M33) || defined(CONFIG_SOC_RP2040) || defined(CONFIG_SOC_SERIES_RP2XXX)
     return ch375_rp2_set_baudrate(pCtx, baudrate);
+#elif defined(CONFIG_ARCH_POSIX)
+    return ch375_sim_set_baudrate(pCtx, baudrate);
 #else
     LOG_ERR("ERROR: No platform defined!");
     return -ENOTSUP;
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch375_uart_replay.c
+ * @brief          CH375 UART hardware interface (native_sim capture replay)
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Backs the CH375 callbacks with a link capture taken on hardware, built in
+ * from CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE. Port A plays the capture's port 0,
+ * port B its port 1. Used instead of ch375_uart_sim.c, so the app runs the
+ * unmodified cores against what the chip answered back then.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch375_uart.h"
+
+LOG_MODULE_DECLARE(ch375_uart);
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t gTrace[] = {
+#include "ch37x_replay_trace.inc"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static int ch375_write_cmd_cb(struct ch375_Context_t *pCtx, uint8_t cmd);
+static int ch375_write_data_cb(struct ch375_Context_t *pCtx, uint8_t data);
+static int ch375_read_data_cb(struct ch375_Context_t *pCtx, uint8_t *pData);
+static int ch375_query_int_cb(struct ch375_Context_t *pCtx);
+
+/**
+  * @brief Initialize a CH375 that replays one port of the built-in capture
+  * @param name the name of the port
+  * @param uart_idx CH375_A_USART_INDEX (port 0) or CH375_B_USART_INDEX (port 1)
+  * @param int_gpio unused
+  * @param baudrate the initial baud rate value
+  * @param ppCtxOut the context to initialize
+  * @retval 0 on success, error code otherwise
+  */
+int ch375_sim_hw_init(const char *name, int uart_idx, const struct gpio_dt_spec *int_gpio, uint32_t baudrate, struct ch375_Context_t **ppCtxOut) {
+
+    int ret = -1;
+    ch375_HwContext_t *hw = NULL;
+    struct ch375_Context_t *pCtx = NULL;
+
+    (void)(int_gpio);
+
+    if (CH375_A_USART_INDEX != uart_idx && CH375_B_USART_INDEX != uart_idx) {
+        LOG_ERR("Invalid UART index: %d (must be 0 or 1)", uart_idx);
+        return -EINVAL;
+    }
+
+    // Allocate context
+    hw = k_malloc(sizeof(ch375_HwContext_t));
+    if (NULL == hw) {
+        LOG_ERR("Failed to allocate hardware context");
+        return -ENOMEM;
+    }
+    memset(hw, 0x00, sizeof(ch375_HwContext_t));
+
+    hw->name = name;
+    hw->baudrate = baudrate;
+
+    ret = ch37xReplay_open(&hw->replay, gTrace, sizeof(gTrace), (uint8_t)uart_idx);
+    if (0 != ret || CH37X_CAPTURE_CHIP_CH375 != hw->replay.chip) {
+        LOG_ERR("%s: %s is not a CH375 capture", name, CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE);
+        k_free(hw);
+        return -EINVAL;
+    }
+
+    ret = ch375_openContext(&pCtx, ch375_write_cmd_cb, ch375_write_data_cb, ch375_read_data_cb, ch375_query_int_cb, hw);
+    if (CH375_SUCCESS != ret) {
+        LOG_ERR("%s: ch375_openContext failed: %d", name, ret);
+        k_free(hw);
+        return -EIO;
+    }
+
+    *ppCtxOut = pCtx;
+    LOG_INF("%s: replaying port %d of %s", name, uart_idx, CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE);
+    return 0;
+}
+
+/**
+  * @brief Set the baud rate of the MCU side of the link
+  * @param pCtx CH375 context
+  * @param baudrate Baud rate
+  * @retval 0 on success, error code otherwise
+  * @note The capture already holds what the chip answered at either rate.
+  */
+int ch375_sim_set_baudrate(struct ch375_Context_t *pCtx, uint32_t baudrate) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return -EINVAL;
+    }
+
+    hw->baudrate = baudrate;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * CH375 Callback functions
+ * -------------------------------------------------------------------------*/
+
+static int ch375_write_cmd_cb(struct ch375_Context_t *pCtx, uint8_t cmd) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH375_ERROR;
+    }
+
+    ch37xReplay_writeCmd(&hw->replay, cmd);
+    return CH375_SUCCESS;
+}
+
+static int ch375_write_data_cb(struct ch375_Context_t *pCtx, uint8_t data) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH375_ERROR;
+    }
+
+    ch37xReplay_writeData(&hw->replay, data);
+    return CH375_SUCCESS;
+}
+
+static int ch375_read_data_cb(struct ch375_Context_t *pCtx, uint8_t *pData) {
+
+    int ret = -1;
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw || NULL == pData) {
+        return CH375_ERROR;
+    }
+
+    ret = ch37xReplay_readData(&hw->replay, pData);
+    if (-ETIMEDOUT == ret) {
+        LOG_DBG("%s: Read timeout", hw->name);
+        return CH375_TIMEOUT;
+    }
+
+    return (0 == ret) ? CH375_SUCCESS : ret;
+}
+
+static int ch375_query_int_cb(struct ch375_Context_t *pCtx) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return 0;
+    }
+
+    return ch37xReplay_queryInt(&hw->replay);
+}
@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch375_uart_sim.c
+ * @brief          CH375 UART hardware interface (native_sim model)
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Backs the CH375 callbacks with the chip model in ch37x_sim.c instead of a
+ * 9-bit UART. Port A has the virtual mouse attached, port B the keyboard.
+ * There is no INT# pin, query_int samples the modelled line.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch375_uart.h"
+
+LOG_MODULE_DECLARE(ch375_uart);
+
+/* Private function prototypes -----------------------------------------------*/
+static int ch375_write_cmd_cb(struct ch375_Context_t *pCtx, uint8_t cmd);
+static int ch375_write_data_cb(struct ch375_Context_t *pCtx, uint8_t data);
+static int ch375_read_data_cb(struct ch375_Context_t *pCtx, uint8_t *pData);
+static int ch375_query_int_cb(struct ch375_Context_t *pCtx);
+
+/**
+  * @brief Initialize a simulated CH375 and its device
+  * @param name the name of the port
+  * @param uart_idx CH375_A_USART_INDEX (mouse) or CH375_B_USART_INDEX (keyboard)
+  * @param int_gpio unused
+  * @param baudrate the initial baud rate value
+  * @param ppCtxOut the context to initialize
+  * @retval 0 on success, error code otherwise
+  */
+int ch375_sim_hw_init(const char *name, int uart_idx, const struct gpio_dt_spec *int_gpio, uint32_t baudrate, struct ch375_Context_t **ppCtxOut) {
+
+    int ret = -1;
+    ch375_HwContext_t *hw = NULL;
+    struct ch375_Context_t *pCtx = NULL;
+
+    (void)(int_gpio);
+
+    if (CH375_A_USART_INDEX != uart_idx && CH375_B_USART_INDEX != uart_idx) {
+        LOG_ERR("Invalid UART index: %d (must be 0 or 1)", uart_idx);
+        return -EINVAL;
+    }
+
+    // Allocate context
+    hw = k_malloc(sizeof(ch375_HwContext_t));
+    if (NULL == hw) {
+        LOG_ERR("Failed to allocate hardware context");
+        return -ENOMEM;
+    }
+    memset(hw, 0x00, sizeof(ch375_HwContext_t));
+
+    hw->name = name;
+    hw->baudrate = baudrate;
+
+    ch37xSim_init(&hw->chip, CH37X_SIM_CH375, CH375_DEFAULT_BAUDRATE);
+    ch37xSim_setLinkBaudrate(&hw->chip, baudrate);
+
+    if (CH375_A_USART_INDEX == uart_idx) {
+        ch37xSimHid_initMouse(&hw->hid, CONFIG_GHOSTHIDE_CH37X_SIM_MOUSE_HZ);
+    } else {
+        ch37xSimHid_initKeyboard(&hw->hid, CONFIG_GHOSTHIDE_CH37X_SIM_KEYS_PER_SEC);
+    }
+    ch37xSim_attach(&hw->chip, &hw->hid.dev);
+
+    ret = ch375_openContext(&pCtx, ch375_write_cmd_cb, ch375_write_data_cb, ch375_read_data_cb, ch375_query_int_cb, hw);
+    if (CH375_SUCCESS != ret) {
+        LOG_ERR("%s: ch375_openContext failed: %d", name, ret);
+        k_free(hw);
+        return -EIO;
+    }
+
+    *ppCtxOut = pCtx;
+    LOG_INF("%s: simulated CH375 with a virtual %s", name, hw->hid.is_keyboard ? "keyboard" : "mouse");
+    return 0;
+}
+
+/**
+  * @brief Set the baud rate of the MCU side of the link
+  * @param pCtx CH375 context
+  * @param baudrate Baud rate
+  * @retval 0 on success, error code otherwise
+  */
+int ch375_sim_set_baudrate(struct ch375_Context_t *pCtx, uint32_t baudrate) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return -EINVAL;
+    }
+
+    ch37xSim_setLinkBaudrate(&hw->chip, baudrate);
+    hw->baudrate = baudrate;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * CH375 Callback functions
+ * -------------------------------------------------------------------------*/
+
+static int ch375_write_cmd_cb(struct ch375_Context_t *pCtx, uint8_t cmd) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH375_ERROR;
+    }
+
+    ch37xSim_writeCmd(&hw->chip, cmd);
+    return CH375_SUCCESS;
+}
+
+static int ch375_write_data_cb(struct ch375_Context_t *pCtx, uint8_t data) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH375_ERROR;
+    }
+
+    ch37xSim_writeData(&hw->chip, data);
+    return CH375_SUCCESS;
+}
+
+static int ch375_read_data_cb(struct ch375_Context_t *pCtx, uint8_t *pData) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw || NULL == pData) {
+        return CH375_ERROR;
+    }
+
+    if (0 != ch37xSim_readData(&hw->chip, pData)) {
+        LOG_DBG("%s: Read timeout", hw->name);
+        return CH375_TIMEOUT;
+    }
+
+    return CH375_SUCCESS;
+}
+
+static int ch375_query_int_cb(struct ch375_Context_t *pCtx) {
+
+    ch375_HwContext_t *hw = (ch375_HwContext_t *)ch375_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return 0;
+    }
+
+    return ch37xSim_queryInt(&hw->chip);
+}
@@ -488,15 +488,15 @@ static int ch375_configure_9bit_instance(USART_TypeDef *huart, uint32_t baudrate
     huart->BRR = usartDiv;
     LOG_INF("UART BRR set to: 0x%04X", usartDiv);
 
-    // Re-enable
+    // Re-enable, TE makes it send an idle frame first
     huart->CR1 |= USART_CR1_UE;
-    k_busy_wait(2000);
+    k_busy_wait(CH375_UART_FRAME_US(baudrate));
 
     // Clear all flags
     (void)huart->SR;
     (void)huart->DR;
 
-    k_msleep(5);
+    // Whether the chip listens at this rate is polled by ch375_hostWaitReady()
     return 0;
 }
 
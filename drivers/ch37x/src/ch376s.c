@@ -26,6 +26,10 @@
 
 LOG_MODULE_REGISTER(ch376s, LOG_LEVEL_DBG);
 
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+static ch37x_StatsCmd_e stats_cmd_slot(uint8_t cmd);
+#endif
+
 /* --------------------------------------------------------------------------
  * CH376S core functions
  * -------------------------------------------------------------------------*/
@@ -102,7 +106,7 @@ int ch376s_checkExist(struct ch376s_Context_t *pCtx) {
     uint8_t recvBuff = 0;
     int ret = -1;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_CHECK_EXIST);
     if (CH376S_SUCCESS != ret) {
@@ -144,7 +148,7 @@ int ch376s_getVersion(struct ch376s_Context_t *pCtx, uint8_t *pVersion) {
     uint8_t ver = 0;
     int ret = -1;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_GET_IC_VER);
     if (CH376S_SUCCESS != ret) {
@@ -217,7 +221,7 @@ int ch376s_setBaudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate) {
         }
     }
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_SET_BAUDRATE);
     if (CH376S_SUCCESS != ret) {
@@ -253,7 +257,7 @@ int ch376s_setUSBMode(struct ch376s_Context_t *pCtx, uint8_t mode) {
     int ret = -1;
     uint8_t usb_mode = 0;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_SET_USB_MODE);
     if (CH376S_SUCCESS != ret) {
@@ -295,7 +299,7 @@ int ch376s_getStatus(struct ch376s_Context_t *pCtx, uint8_t *pStatus) {
     int ret = -1;
     uint8_t status = -1;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_GET_STATUS);
     if (CH376S_SUCCESS != ret) {
@@ -325,7 +329,7 @@ int ch376s_abortNAK(struct ch376s_Context_t *pCtx) {
 
     int ret = -1;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_ABORT_NAK);
     k_mutex_unlock(&pCtx->lock);
 
@@ -336,11 +340,15 @@ int ch376s_abortNAK(struct ch376s_Context_t *pCtx) {
  * @brief Query INT pin
  */
 int ch376s_queryInt(struct ch376s_Context_t *pCtx) {
+    int ret = -1;
+
     if (NULL == pCtx) {
         LOG_ERR("Invalid context!");
         return 0;
     }
-    return pCtx->query_int(pCtx);
+    ret = pCtx->query_int(pCtx);
+    CH37X_CAPTURE(pCtx, CH37X_CAPTURE_INT, ret);
+    return ret;
 }
 
 /**
@@ -358,6 +366,9 @@ int ch376s_waitInt(struct ch376s_Context_t *pCtx, uint32_t timeout_ms) {
         return CH376S_PARAM_INVALID;
     }
 
+    CH37X_STATS_INC(pCtx, wait_ints);
+
+    CH37X_STATS_INC(pCtx, status_polls);
     ret = ch376s_getStatus(pCtx, &status);
     if (CH376S_SUCCESS == ret) {
         lastStatus = status;
@@ -372,6 +383,7 @@ int ch376s_waitInt(struct ch376s_Context_t *pCtx, uint32_t timeout_ms) {
 
     while ((k_uptime_get_32() - start) < timeout_ms) {
         pollCount++;
+        CH37X_STATS_INC(pCtx, status_polls);
         ret = ch376s_getStatus(pCtx, &status);
 
         if (CH376S_SUCCESS == ret) {
@@ -396,6 +408,7 @@ int ch376s_waitInt(struct ch376s_Context_t *pCtx, uint32_t timeout_ms) {
         }
     }
 
+    CH37X_STATS_INC(pCtx, status_polls);
     ret = ch376s_getStatus(pCtx, &status);
     LOG_ERR("Polling timeout after %u ms (%u polls, final_status=0x%02X, ret=%d)", 
             timeout_ms, pollCount, status, ret);
@@ -403,6 +416,25 @@ int ch376s_waitInt(struct ch376s_Context_t *pCtx, uint32_t timeout_ms) {
     return CH376S_TIMEOUT;
 }
 
+/**
+ * @brief Copy the UART link counters of a context
+ * @param pCtx The context
+ * @param pStats Pointer to the counters to fill
+ * @retval None
+ */
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+void ch376s_getLinkStats(struct ch376s_Context_t *pCtx, struct ch37x_LinkStats_t *pStats) {
+
+    if (NULL == pCtx || NULL == pStats) {
+        return;
+    }
+
+    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    *pStats = pCtx->stats;
+    k_mutex_unlock(&pCtx->lock);
+}
+#endif
+
 /* --------------------------------------------------------------------------
  * Host commands
  * -------------------------------------------------------------------------*/
@@ -420,7 +452,7 @@ int ch376s_testConnect(struct ch376s_Context_t *pCtx, uint8_t *pConnStatus) {
     uint8_t status = 0;
     uint8_t buff = 0;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_TEST_CONNECT);
     if (CH376S_SUCCESS != ret) {
@@ -462,7 +494,7 @@ int ch376s_getDevSpeed(struct ch376s_Context_t *pCtx, uint8_t *pSpeed) {
     int ret = -1;
     uint8_t devSpeed;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_GET_DEV_RATE);
     if (CH376S_SUCCESS != ret) {
@@ -507,7 +539,7 @@ int ch376s_setDevSpeed(struct ch376s_Context_t *pCtx, uint8_t speed) {
 
     devSpeed = (speed == USB_SPEED_SPEED_LS ? 0x02 : 0x00);
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_SET_USB_SPEED);
     if (CH376S_SUCCESS != ret) {
@@ -536,7 +568,7 @@ int ch376s_setUSBAddr(struct ch376s_Context_t *pCtx, uint8_t addr) {
 
     int ret = -1;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_SET_USB_ADDR);
     if (CH376S_SUCCESS != ret) {
@@ -566,7 +598,7 @@ int ch376s_setRetry(struct ch376s_Context_t *pCtx, uint8_t times) {
     int ret = -1;
     uint8_t param;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_SET_RETRY);
     if (CH376S_SUCCESS != ret) {
@@ -621,7 +653,7 @@ int ch376s_sendToken(struct ch376s_Context_t *pCtx, uint8_t ep, bool tog,
     togVal = tog ? 0xC0 : 0x00;
     epPID = (ep << 4) | pid;
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_ISSUE_TKN_X);
     if (CH376S_SUCCESS != ret) {
@@ -673,6 +705,9 @@ int ch376s_writeCmd(struct ch376s_Context_t *pCtx, uint8_t cmd) {
         LOG_ERR("Invalid context!");
         return CH376S_PARAM_INVALID;
     }
+    CH37X_STATS_INC(pCtx, tx_bytes);
+    CH37X_STATS_CMD(pCtx, stats_cmd_slot(cmd));
+    CH37X_CAPTURE(pCtx, CH37X_CAPTURE_CMD, cmd);
     return pCtx->write_data(pCtx, cmd);
 }
 
@@ -684,6 +719,8 @@ int ch376s_writeData(struct ch376s_Context_t *pCtx, uint8_t data) {
         LOG_ERR("Invalid context!");
         return CH376S_PARAM_INVALID;
     }
+    CH37X_STATS_INC(pCtx, tx_bytes);
+    CH37X_CAPTURE(pCtx, CH37X_CAPTURE_DATA, data);
     return pCtx->write_data(pCtx, data);
 }
 
@@ -691,11 +728,23 @@ int ch376s_writeData(struct ch376s_Context_t *pCtx, uint8_t data) {
  * @brief Read data
  */
 int ch376s_readData(struct ch376s_Context_t *pCtx, uint8_t *pData) {
+    int ret = -1;
+
     if (NULL == pCtx || NULL == pData) {
         LOG_ERR("Invalid parameters!");
         return CH376S_PARAM_INVALID;
     }
-    return pCtx->read_data(pCtx, pData);
+    ret = pCtx->read_data(pCtx, pData);
+    if (CH376S_SUCCESS == ret) {
+        CH37X_STATS_INC(pCtx, rx_bytes);
+        CH37X_CAPTURE(pCtx, CH37X_CAPTURE_RX, *pData);
+    } else {
+        if (CH376S_TIMEOUT == ret) {
+            CH37X_STATS_INC(pCtx, rx_timeouts);
+        }
+        CH37X_CAPTURE(pCtx, CH37X_CAPTURE_RX_ERR, -ret);
+    }
+    return ret;
 }
 
 /**
@@ -713,7 +762,7 @@ int ch376s_writeBlockData(struct ch376s_Context_t *pCtx, uint8_t *pBuff, uint8_t
         return CH376S_PARAM_INVALID;
     }
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_WR_USB_DATA7);
     if (CH376S_SUCCESS != ret) {
@@ -757,7 +806,7 @@ int ch376s_readBlockData(struct ch376s_Context_t *pCtx, uint8_t *pBuff,
         return CH376S_PARAM_INVALID;
     }
 
-    k_mutex_lock(&pCtx->lock, K_FOREVER);
+    CH37X_LOCK(pCtx);
 
     ret = ch376s_writeCmd(pCtx, CH376S_CMD_RD_USB_DATA);
     if (CH376S_SUCCESS != ret) {
@@ -795,3 +844,31 @@ int ch376s_readBlockData(struct ch376s_Context_t *pCtx, uint8_t *pBuff,
     k_mutex_unlock(&pCtx->lock);
     return CH376S_SUCCESS;
 }
+
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+static ch37x_StatsCmd_e stats_cmd_slot(uint8_t cmd) {
+
+    switch (cmd) {
+        case CH376S_CMD_GET_STATUS: {
+            return CH37X_STATS_CMD_STATUS;
+        }
+        case CH376S_CMD_ISSUE_TKN_X:
+        case CH376S_CMD_ISSUE_TOKEN: {
+            return CH37X_STATS_CMD_TOKEN;
+        }
+        case CH376S_CMD_RD_USB_DATA0:
+        case CH376S_CMD_RD_USB_DATA: {
+            return CH37X_STATS_CMD_RD_DATA;
+        }
+        case CH376S_CMD_WR_USB_DATA7: {
+            return CH37X_STATS_CMD_WR_DATA;
+        }
+        case CH376S_CMD_SET_RETRY: {
+            return CH37X_STATS_CMD_RETRY;
+        }
+        default: {
+            return CH37X_STATS_CMD_OTHER;
+        }
+    }
+}
+#endif
@@ -32,6 +32,12 @@ LOG_MODULE_REGISTER(ch376s_uart, LOG_LEVEL_DBG);
                                     uint32_t initial_baudrate,
                                     struct ch376s_Context_t **ppCtxOut);
     extern int ch376s_rp2_set_baudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate);
+#elif defined(CONFIG_ARCH_POSIX)
+    extern int ch376s_sim_hw_init(const char *name, int uart_index,
+                                    const struct gpio_dt_spec *int_gpio,
+                                    uint32_t initial_baudrate,
+                                    struct ch376s_Context_t **ppCtxOut);
+    extern int ch376s_sim_set_baudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate);
 #else
     #error "CH376S only supports RP2040/RP2350 platforms"
 #endif
@@ -49,6 +55,9 @@ int ch376s_hwInitManual(const char *name, int uart_index,
 #elif defined(CONFIG_SOC_RP2040)
     LOG_INF("Platform: RP2040 (RPI Pico) - CH376S 8-bit UART");
     return ch376s_rp2_hw_init(name, uart_index, int_gpio, initial_baudrate, ppCtxOut);
+#elif defined(CONFIG_ARCH_POSIX)
+    LOG_INF("Platform: native_sim (simulated CH376S)");
+    return ch376s_sim_hw_init(name, uart_index, int_gpio, initial_baudrate, ppCtxOut);
 #else
     LOG_ERR("ERROR: CH376S only supported on RP2040/RP2350!");
     return -ENOTSUP;
@@ -63,6 +72,8 @@ int ch376s_hwSetBaudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate) {
 
 #if defined(CONFIG_SOC_RP2350A_M33) || defined(CONFIG_SOC_RP2040) || defined(CONFIG_SOC_SERIES_RP2XXX)
     return ch376s_rp2_set_baudrate(pCtx, baudrate);
+#elif defined(CONFIG_ARCH_POSIX)
+    return ch376s_sim_set_baudrate(pCtx, baudrate);
 #else
     LOG_ERR("ERROR: No platform defined!");
     return -ENOTSUP;
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch376s_uart_replay.c
+ * @brief          CH376S UART hardware interface (native_sim capture replay)
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Backs the CH376S callbacks with a link capture taken on hardware, built in
+ * from CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE. Port A plays the capture's port 0,
+ * port B its port 1. The 8-bit link has no command flag, so a written byte
+ * matches a captured command or data byte alike.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch376s_uart.h"
+
+LOG_MODULE_DECLARE(ch376s_uart);
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t gTrace[] = {
+#include "ch37x_replay_trace.inc"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static int ch376s_write_data_cb(struct ch376s_Context_t *pCtx, uint8_t data);
+static int ch376s_read_data_cb(struct ch376s_Context_t *pCtx, uint8_t *pData);
+static int ch376s_query_int_cb(struct ch376s_Context_t *pCtx);
+
+/**
+  * @brief Initialize a CH376S that replays one port of the built-in capture
+  * @param name the name of the port
+  * @param uart_idx CH376S_A_USART_INDEX (port 0) or CH376S_B_USART_INDEX (port 1)
+  * @param int_gpio unused
+  * @param baudrate the initial baud rate value
+  * @param ppCtxOut the context to initialize
+  * @retval 0 on success, error code otherwise
+  */
+int ch376s_sim_hw_init(const char *name, int uart_idx, const struct gpio_dt_spec *int_gpio, uint32_t baudrate, struct ch376s_Context_t **ppCtxOut) {
+
+    int ret = -1;
+    ch376s_HwContext_t *hw = NULL;
+    struct ch376s_Context_t *pCtx = NULL;
+
+    (void)(int_gpio);
+
+    if (CH376S_A_USART_INDEX != uart_idx && CH376S_B_USART_INDEX != uart_idx) {
+        LOG_ERR("Invalid UART index: %d (must be 0 or 1)", uart_idx);
+        return -EINVAL;
+    }
+
+    // Allocate context
+    hw = k_malloc(sizeof(ch376s_HwContext_t));
+    if (NULL == hw) {
+        LOG_ERR("Failed to allocate hardware context");
+        return -ENOMEM;
+    }
+    memset(hw, 0x00, sizeof(ch376s_HwContext_t));
+
+    hw->name = name;
+    hw->baudrate = baudrate;
+
+    ret = ch37xReplay_open(&hw->replay, gTrace, sizeof(gTrace), (uint8_t)uart_idx);
+    if (0 != ret || CH37X_CAPTURE_CHIP_CH376S != hw->replay.chip) {
+        LOG_ERR("%s: %s is not a CH376S capture", name, CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE);
+        k_free(hw);
+        return -EINVAL;
+    }
+
+    ret = ch376s_openContext(&pCtx, ch376s_write_data_cb, ch376s_read_data_cb, ch376s_query_int_cb, hw);
+    if (CH376S_SUCCESS != ret) {
+        LOG_ERR("%s: ch376s_openContext failed: %d", name, ret);
+        k_free(hw);
+        return -EIO;
+    }
+
+    *ppCtxOut = pCtx;
+    LOG_INF("%s: replaying port %d of %s", name, uart_idx, CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE);
+    return 0;
+}
+
+/**
+  * @brief Set the baud rate of the MCU side of the link
+  * @param pCtx CH376S context
+  * @param baudrate Baud rate
+  * @retval 0 on success, error code otherwise
+  * @note The capture already holds what the chip answered at either rate.
+  */
+int ch376s_sim_set_baudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return -EINVAL;
+    }
+
+    hw->baudrate = baudrate;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * CH376S Callback functions
+ * -------------------------------------------------------------------------*/
+
+static int ch376s_write_data_cb(struct ch376s_Context_t *pCtx, uint8_t data) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH376S_ERROR;
+    }
+
+    ch37xReplay_writeByte(&hw->replay, data);
+    return CH376S_SUCCESS;
+}
+
+static int ch376s_read_data_cb(struct ch376s_Context_t *pCtx, uint8_t *pData) {
+
+    int ret = -1;
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw || NULL == pData) {
+        return CH376S_ERROR;
+    }
+
+    ret = ch37xReplay_readData(&hw->replay, pData);
+    if (-ETIMEDOUT == ret) {
+        LOG_DBG("%s: Read timeout", hw->name);
+        return CH376S_TIMEOUT;
+    }
+
+    return (0 == ret) ? CH376S_SUCCESS : ret;
+}
+
+static int ch376s_query_int_cb(struct ch376s_Context_t *pCtx) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return 0;
+    }
+
+    return ch37xReplay_queryInt(&hw->replay);
+}
@@ -137,6 +137,7 @@ static int load_pio_programs(ch376s_HwContext_t *hw);
 static int init_gpio_sequence(ch376s_HwContext_t *hw);
 static int configure_state_machines(ch376s_HwContext_t *hw, uint32_t baudrate);
 static void flush_startup_transients(ch376s_HwContext_t *hw);
+static int wait_tx_idle(ch376s_HwContext_t *hw);
 
 static int ch376s_write_data_cb(struct ch376s_Context_t *pCtx, uint8_t data);
 static int ch376s_read_data_cb(struct ch376s_Context_t *pCtx, uint8_t *pData);
@@ -246,12 +247,13 @@ int ch376s_rp2_set_baudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate) {
         return -EINVAL;
     }
 
+    // The SET_BAUDRATE frames must be out at the old rate before the SMs stop
+    (void)wait_tx_idle(hw);
+
     // Disable SMs
     pio_sm_set_enabled(hw->pio, hw->sm_tx, false);
     pio_sm_set_enabled(hw->pio, hw->sm_rx, false);
 
-    k_msleep(10);
-
     // Clear FIFOs
     pio_sm_clear_fifos(hw->pio, hw->sm_tx);
     pio_sm_clear_fifos(hw->pio, hw->sm_rx);
@@ -305,7 +307,8 @@ static int init_gpio_sequence(ch376s_HwContext_t *hw) {
     gpio_set_dir(hw->rx_pin, GPIO_IN);
     gpio_pull_up(hw->rx_pin);
 
-    k_msleep(5);
+    // Idle high for a frame, the chip's receiver must not see a start bit yet
+    k_busy_wait(CH376S_UART_FRAME_US(hw->baudrate));
 
     // Transfer to PIO
     pio_gpio_init(hw->pio, hw->tx_pin);
@@ -328,15 +331,35 @@ static int configure_state_machines(ch376s_HwContext_t *hw, uint32_t baudrate) {
 }
 
 static void flush_startup_transients(ch376s_HwContext_t *hw) {
+    int64_t start;
+
     pio_sm_put_blocking(hw->pio, hw->sm_tx, 0xFFu);
-    k_msleep(5);
+    (void)wait_tx_idle(hw);
 
-    for (int i = 0; i < 4; i++) {
+    // Drop what arrived, until two frame times pass without a byte. The chip
+    // itself is polled by ch375_hostWaitReady(), not waited for here
+    start = k_uptime_get();
+    do {
         pio_sm_clear_fifos(hw->pio, hw->sm_rx);
-        k_msleep(5);
+        k_busy_wait(2 * CH376S_UART_FRAME_US(hw->baudrate));
+    } while (true != pio_sm_is_rx_fifo_empty(hw->pio, hw->sm_rx) &&
+             (k_uptime_get() - start) <= PIO_UART_IDLE_TIMEOUT_MS);
+}
+
+// With the FIFO empty the TX SM stalls on its `pull`, line idle high
+static int wait_tx_idle(ch376s_HwContext_t *hw) {
+    int64_t start = k_uptime_get();
+
+    while (true != pio_sm_is_tx_fifo_empty(hw->pio, hw->sm_tx) ||
+           hw->offset_tx != pio_sm_get_pc(hw->pio, hw->sm_tx)) {
+        if ((k_uptime_get() - start) > PIO_UART_IDLE_TIMEOUT_MS) {
+            LOG_ERR("%s: TX idle timeout", hw->name);
+            return -ETIMEDOUT;
+        }
+        k_busy_wait(10);
     }
 
-    k_msleep(300);
+    return 0;
 }
 
 static int pio_write_8bit(ch376s_HwContext_t *hw, uint8_t data) {
@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch376s_uart_sim.c
+ * @brief          CH376S UART hardware interface (native_sim model)
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Backs the CH376S callbacks with the chip model in ch37x_sim.c instead of an
+ * 8-bit UART. Port A has the virtual mouse attached, port B the keyboard.
+ * There is no INT# pin, query_int samples the modelled line.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch376s_uart.h"
+
+LOG_MODULE_DECLARE(ch376s_uart);
+
+/* Private function prototypes -----------------------------------------------*/
+static int ch376s_write_data_cb(struct ch376s_Context_t *pCtx, uint8_t data);
+static int ch376s_read_data_cb(struct ch376s_Context_t *pCtx, uint8_t *pData);
+static int ch376s_query_int_cb(struct ch376s_Context_t *pCtx);
+
+/**
+  * @brief Initialize a simulated CH376S and its device
+  * @param name the name of the port
+  * @param uart_idx CH376S_A_USART_INDEX (mouse) or CH376S_B_USART_INDEX (keyboard)
+  * @param int_gpio unused
+  * @param baudrate the initial baud rate value
+  * @param ppCtxOut the context to initialize
+  * @retval 0 on success, error code otherwise
+  */
+int ch376s_sim_hw_init(const char *name, int uart_idx, const struct gpio_dt_spec *int_gpio, uint32_t baudrate, struct ch376s_Context_t **ppCtxOut) {
+
+    int ret = -1;
+    ch376s_HwContext_t *hw = NULL;
+    struct ch376s_Context_t *pCtx = NULL;
+
+    (void)(int_gpio);
+
+    if (CH376S_A_USART_INDEX != uart_idx && CH376S_B_USART_INDEX != uart_idx) {
+        LOG_ERR("Invalid UART index: %d (must be 0 or 1)", uart_idx);
+        return -EINVAL;
+    }
+
+    // Allocate context
+    hw = k_malloc(sizeof(ch376s_HwContext_t));
+    if (NULL == hw) {
+        LOG_ERR("Failed to allocate hardware context");
+        return -ENOMEM;
+    }
+    memset(hw, 0x00, sizeof(ch376s_HwContext_t));
+
+    hw->name = name;
+    hw->baudrate = baudrate;
+
+    ch37xSim_init(&hw->chip, CH37X_SIM_CH376S, CH376S_DEFAULT_BAUDRATE);
+    ch37xSim_setLinkBaudrate(&hw->chip, baudrate);
+
+    if (CH376S_A_USART_INDEX == uart_idx) {
+        ch37xSimHid_initMouse(&hw->hid, CONFIG_GHOSTHIDE_CH37X_SIM_MOUSE_HZ);
+    } else {
+        ch37xSimHid_initKeyboard(&hw->hid, CONFIG_GHOSTHIDE_CH37X_SIM_KEYS_PER_SEC);
+    }
+    ch37xSim_attach(&hw->chip, &hw->hid.dev);
+
+    ret = ch376s_openContext(&pCtx, ch376s_write_data_cb, ch376s_read_data_cb, ch376s_query_int_cb, hw);
+    if (CH376S_SUCCESS != ret) {
+        LOG_ERR("%s: ch376s_openContext failed: %d", name, ret);
+        k_free(hw);
+        return -EIO;
+    }
+
+    *ppCtxOut = pCtx;
+    LOG_INF("%s: simulated CH376S with a virtual %s", name, hw->hid.is_keyboard ? "keyboard" : "mouse");
+    return 0;
+}
+
+/**
+  * @brief Set the baud rate of the MCU side of the link
+  * @param pCtx CH376S context
+  * @param baudrate Baud rate
+  * @retval 0 on success, error code otherwise
+  */
+int ch376s_sim_set_baudrate(struct ch376s_Context_t *pCtx, uint32_t baudrate) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return -EINVAL;
+    }
+
+    ch37xSim_setLinkBaudrate(&hw->chip, baudrate);
+    hw->baudrate = baudrate;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * CH376S Callback functions
+ * -------------------------------------------------------------------------*/
+
+static int ch376s_write_data_cb(struct ch376s_Context_t *pCtx, uint8_t data) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return CH376S_ERROR;
+    }
+
+    ch37xSim_writeByte(&hw->chip, data);
+    return CH376S_SUCCESS;
+}
+
+static int ch376s_read_data_cb(struct ch376s_Context_t *pCtx, uint8_t *pData) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw || NULL == pData) {
+        return CH376S_ERROR;
+    }
+
+    if (0 != ch37xSim_readData(&hw->chip, pData)) {
+        LOG_DBG("%s: Read timeout", hw->name);
+        return CH376S_TIMEOUT;
+    }
+
+    return CH376S_SUCCESS;
+}
+
+static int ch376s_query_int_cb(struct ch376s_Context_t *pCtx) {
+
+    ch376s_HwContext_t *hw = (ch376s_HwContext_t *)ch376s_getPriv(pCtx);
+
+    if (NULL == hw) {
+        return 0;
+    }
+
+    return ch37xSim_queryInt(&hw->chip);
+}
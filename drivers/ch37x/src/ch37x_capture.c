@@ -0,0 +1,251 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_capture.c
+ * @brief          CH37x link capture implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Both ports record into one buffer under a spinlock, so records keep the
+ * order the bytes went over the two links and every delta is taken against
+ * the record before it. Delta cycles are 32 bit, a gap longer than the cycle
+ * counter period comes out short but in order. With CONFIG_SHELL `capture`
+ * dumps the buffer and `capture clear` empties and re-arms it.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch37x_capture.h"
+#include "mem_report.h"
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+/* Private macros ------------------------------------------------------------*/
+#define CAPTURE_DUMP_PER_LINE       16      // Records per console line
+
+#if defined(USE_CH376S)
+#define CAPTURE_CHIP                CH37X_CAPTURE_CHIP_CH376S
+#else
+#define CAPTURE_CHIP                CH37X_CAPTURE_CHIP_CH375
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static struct ch37x_CaptureRecord_t gRecords[CONFIG_GHOSTHIDE_LINK_CAPTURE_RECORDS];
+MEM_REPORT_STATIC(ch37x_capture, gRecords);
+static uint32_t gCount;
+static uint32_t gDropped;
+static uint32_t gLastCyc;
+static bool gIsStarted;
+static bool gIsPaused;
+static const void *gPortCtx[CH37X_CAPTURE_PORT_COUNT];
+static struct k_spinlock gLock;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t port_of(const void *pCtx);
+
+/**
+ * @brief Append a record, drop it once the buffer is full
+ * @param pCtx CH37x context the byte belongs to
+ * @param kind record kind, see ch37x_CaptureKind_e
+ * @param data byte written or read, or the kind's argument
+ * @return None
+ * @note Use CH37X_CAPTURE(), it compiles away without CONFIG_GHOSTHIDE_LINK_CAPTURE.
+ */
+void ch37xCapture_record(const void *pCtx, uint8_t kind, uint8_t data) {
+
+    k_spinlock_key_t key = k_spin_lock(&gLock);
+    uint32_t nowCyc = k_cycle_get_32();
+    uint32_t delta = gIsStarted ? (nowCyc - gLastCyc) : 0;
+    uint32_t need = (delta > UINT16_MAX) ? 2 : 1;
+
+    if (gIsPaused) {
+        k_spin_unlock(&gLock, key);
+        return;
+    }
+
+    if (gCount + need > CONFIG_GHOSTHIDE_LINK_CAPTURE_RECORDS) {
+        gDropped++;
+        k_spin_unlock(&gLock, key);
+        return;
+    }
+
+    if (2 == need) {
+        gRecords[gCount].dt = (uint16_t)(delta >> 16);
+        gRecords[gCount].kind_port = CH37X_CAPTURE_TIME;
+        gRecords[gCount].data = 0;
+        gCount++;
+    }
+
+    gRecords[gCount].dt = (uint16_t)delta;
+    gRecords[gCount].kind_port = (uint8_t)((port_of(pCtx) << 4) | (kind & 0x0F));
+    gRecords[gCount].data = data;
+    gCount++;
+
+    gLastCyc = nowCyc;
+    gIsStarted = true;
+
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Tell which port a CH37x context serves
+ * @param pCtx CH37x context
+ * @param port port index
+ * @return None
+ */
+void ch37xCapture_bindPort(const void *pCtx, uint8_t port) {
+
+    if (port >= CH37X_CAPTURE_PORT_COUNT) {
+        return;
+    }
+
+    gPortCtx[port] = pCtx;
+}
+
+/**
+ * @brief Drop every record and start over
+ * @return None
+ */
+void ch37xCapture_clear(void) {
+
+    k_spinlock_key_t key = k_spin_lock(&gLock);
+
+    gCount = 0;
+    gDropped = 0;
+    gIsStarted = false;
+
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Copy the capture out as a trace file
+ * @param pBuff destination, header and records
+ * @param size size of pBuff in bytes
+ * @return bytes written, -ENOMEM if pBuff is too small
+ */
+int ch37xCapture_export(uint8_t *pBuff, size_t size) {
+
+    struct ch37x_CaptureHeader_t header;
+    k_spinlock_key_t key = k_spin_lock(&gLock);
+    size_t len = sizeof(header) + (gCount * CH37X_CAPTURE_RECORD_SIZE);
+
+    if (NULL == pBuff || size < len) {
+        k_spin_unlock(&gLock, key);
+        return -ENOMEM;
+    }
+
+    memcpy(header.magic, "GHLC", sizeof(header.magic));
+    header.version = CH37X_CAPTURE_VERSION;
+    header.chip = CAPTURE_CHIP;
+    header.record_size = sys_cpu_to_le16(CH37X_CAPTURE_RECORD_SIZE);
+    header.hz = sys_cpu_to_le32(sys_clock_hw_cycles_per_sec());
+    header.count = sys_cpu_to_le32(gCount);
+    header.dropped = sys_cpu_to_le32(gDropped);
+
+    memcpy(pBuff, &header, sizeof(header));
+    for (uint32_t i = 0; i < gCount; i++) {
+        uint8_t *pRec = &pBuff[sizeof(header) + (i * CH37X_CAPTURE_RECORD_SIZE)];
+
+        sys_put_le16(gRecords[i].dt, pRec);
+        pRec[2] = gRecords[i].kind_port;
+        pRec[3] = gRecords[i].data;
+    }
+
+    k_spin_unlock(&gLock, key);
+
+    return (int)len;
+}
+
+/**
+ * @brief Print the capture as hex lines
+ * @return None
+ * @note Recording pauses while the dump runs. Feed the console output to
+ * scripts/capture_extract.py.
+ */
+void ch37xCapture_dump(void) {
+
+    uint32_t count;
+    k_spinlock_key_t key = k_spin_lock(&gLock);
+
+    gIsPaused = true;
+    count = gCount;
+    k_spin_unlock(&gLock, key);
+
+    printk("CAPTURE BEGIN v%u chip=%u hz=%u records=%u dropped=%u\n", CH37X_CAPTURE_VERSION, CAPTURE_CHIP,
+                                    sys_clock_hw_cycles_per_sec(), count, gDropped);
+
+    for (uint32_t i = 0; i < count; i += CAPTURE_DUMP_PER_LINE) {
+        printk("CAPTURE ");
+        for (uint32_t j = i; j < MIN(i + CAPTURE_DUMP_PER_LINE, count); j++) {
+            printk("%02x%02x%02x%02x", gRecords[j].dt & 0xFF, gRecords[j].dt >> 8,
+                                       gRecords[j].kind_port, gRecords[j].data);
+        }
+        printk("\n");
+    }
+
+    printk("CAPTURE END\n");
+
+    key = k_spin_lock(&gLock);
+    gIsPaused = false;
+    k_spin_unlock(&gLock, key);
+}
+
+/* --------------------------------------------------------------------------
+ * Private Helper Functions
+ * -------------------------------------------------------------------------*/
+
+static uint8_t port_of(const void *pCtx) {
+
+    for (uint8_t i = 0; i < CH37X_CAPTURE_PORT_COUNT; i++) {
+        if (pCtx == gPortCtx[i]) {
+            return i;
+        }
+    }
+
+    return CH37X_CAPTURE_PORT_NONE;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_capture_dump(const struct shell *pShell, size_t argc, char **argv) {
+
+    (void)(pShell);
+    (void)(argc);
+    (void)(argv);
+
+    ch37xCapture_dump();
+
+    return 0;
+}
+
+static int cmd_capture_clear(const struct shell *pShell, size_t argc, char **argv) {
+
+    (void)(argc);
+    (void)(argv);
+
+    ch37xCapture_clear();
+    shell_print(pShell, "Capture cleared, recording");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_capture,
+    SHELL_CMD(clear, NULL, "Drop every record and record again", cmd_capture_clear),
+    SHELL_SUBCMD_SET_END
+);
+SHELL_CMD_REGISTER(capture, &sub_capture, "Dump the CH37x link capture for scripts/capture_extract.py",
+                                                                                cmd_capture_dump);
+#endif
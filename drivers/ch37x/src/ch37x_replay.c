@@ -0,0 +1,328 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_replay.c
+ * @brief          CH37x link capture playback implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Both ports of a capture share one record stream. Each port walks it on its
+ * own, skipping the other port's records but still adding up their deltas,
+ * so every record is played at its capture time no matter which port wrote
+ * it. A record is only consumed once the cores asked for what it holds.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch37x_replay.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(ch37x_replay, LOG_LEVEL_INF);
+
+/* Private macros ------------------------------------------------------------*/
+#define REPLAY_HEADER_SIZE          sizeof(struct ch37x_CaptureHeader_t)
+#define REPLAY_ANY_WRITE            0xFF    // CMD or DATA, the CH376S link cannot tell
+
+/* Private function prototypes -----------------------------------------------*/
+static const uint8_t *peek_record(const struct CH37xReplay_t *pReplay, bool isSkipInt, uint64_t *pCyc, uint32_t *pNext);
+static void play_record(struct CH37xReplay_t *pReplay, uint64_t cyc, uint32_t next);
+static int replay_write(struct CH37xReplay_t *pReplay, uint8_t kind, uint8_t data);
+static void diverge(struct CH37xReplay_t *pReplay, uint32_t pos, const char *pWhat, uint8_t data);
+static uint64_t now_us(void);
+
+/**
+ * @brief Start playing one port of a trace file
+ * @param pReplay replay state to initialize
+ * @param pTrace trace file, header and records as written by ch37xCapture_export()
+ * @param len length of pTrace in bytes
+ * @param port port whose records to play
+ * @return 0 on success, -EINVAL if the trace is not a trace file of this version
+ * @note pTrace is not copied and must stay valid while the replay runs.
+ */
+int ch37xReplay_open(struct CH37xReplay_t *pReplay, const uint8_t *pTrace, size_t len, uint8_t port) {
+
+    uint32_t count;
+
+    if (NULL == pReplay || NULL == pTrace || port >= CH37X_CAPTURE_PORT_COUNT) {
+        return -EINVAL;
+    }
+
+    if (len < REPLAY_HEADER_SIZE || 0 != memcmp(pTrace, "GHLC", 4)) {
+        LOG_ERR("Not a link capture");
+        return -EINVAL;
+    }
+
+    if (CH37X_CAPTURE_VERSION != pTrace[4] || CH37X_CAPTURE_RECORD_SIZE != sys_get_le16(&pTrace[6])) {
+        LOG_ERR("Capture version %u not supported", pTrace[4]);
+        return -EINVAL;
+    }
+
+    count = sys_get_le32(&pTrace[12]);
+    if ((len - REPLAY_HEADER_SIZE) / CH37X_CAPTURE_RECORD_SIZE < count || 0 == sys_get_le32(&pTrace[8])) {
+        LOG_ERR("Capture truncated");
+        return -EINVAL;
+    }
+
+    memset(pReplay, 0x00, sizeof(struct CH37xReplay_t));
+    pReplay->pRecords = &pTrace[REPLAY_HEADER_SIZE];
+    pReplay->count = count;
+    pReplay->hz = sys_get_le32(&pTrace[8]);
+    pReplay->chip = pTrace[5];
+    pReplay->port = port;
+
+    if (0 != sys_get_le32(&pTrace[16])) {
+        LOG_WRN("Capture dropped %u records, replay ends early", sys_get_le32(&pTrace[16]));
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Play a command byte
+ * @param pReplay replay state
+ * @param cmd command the cores wrote
+ * @return 0, also after a divergence
+ */
+int ch37xReplay_writeCmd(struct CH37xReplay_t *pReplay, uint8_t cmd) {
+
+    return replay_write(pReplay, CH37X_CAPTURE_CMD, cmd);
+}
+
+/**
+ * @brief Play a data byte
+ * @param pReplay replay state
+ * @param data byte the cores wrote
+ * @return 0, also after a divergence
+ */
+int ch37xReplay_writeData(struct CH37xReplay_t *pReplay, uint8_t data) {
+
+    return replay_write(pReplay, CH37X_CAPTURE_DATA, data);
+}
+
+/**
+ * @brief Play a byte without a command/data flag
+ * @param pReplay replay state
+ * @param data byte the cores wrote
+ * @return 0, also after a divergence
+ * @note For the CH376S link, which sends commands as plain bytes after the sync code.
+ */
+int ch37xReplay_writeByte(struct CH37xReplay_t *pReplay, uint8_t data) {
+
+    return replay_write(pReplay, REPLAY_ANY_WRITE, data);
+}
+
+/**
+ * @brief Play a byte read back
+ * @param pReplay replay state
+ * @param pData pointer to the byte
+ * @return 0 on success, the captured error, or -ETIMEDOUT after
+ * CH37X_REPLAY_READ_TIMEOUT_US once the records ran out or diverged
+ */
+int ch37xReplay_readData(struct CH37xReplay_t *pReplay, uint8_t *pData) {
+
+    const uint8_t *pRec;
+    uint64_t cyc;
+    uint32_t next;
+    uint8_t kind;
+
+    if (NULL == pReplay || NULL == pData) {
+        return -EINVAL;
+    }
+
+    pRec = pReplay->is_diverged ? NULL : peek_record(pReplay, true, &cyc, &next);
+    if (NULL == pRec) {
+        k_busy_wait(CH37X_REPLAY_READ_TIMEOUT_US);
+        return -ETIMEDOUT;
+    }
+
+    kind = CH37X_CAPTURE_KIND(pRec[2]);
+    if (CH37X_CAPTURE_RX != kind && CH37X_CAPTURE_RX_ERR != kind) {
+        diverge(pReplay, next - 1, "read", 0);
+        k_busy_wait(CH37X_REPLAY_READ_TIMEOUT_US);
+        return -ETIMEDOUT;
+    }
+
+    play_record(pReplay, cyc, next);
+
+    if (CH37X_CAPTURE_RX_ERR == kind) {
+        return -(int)pRec[3];
+    }
+
+    *pData = pRec[3];
+    return 0;
+}
+
+/**
+ * @brief Play an INT# sample
+ * @param pReplay replay state
+ * @return the captured sample, 0 once the records ran out or diverged
+ * @note The cores poll INT# a varying number of times. A sample the capture
+ * does not have at this point is answered with 0 without consuming anything,
+ * and samples the cores did not repeat are passed over by the next write or
+ * read.
+ */
+int ch37xReplay_queryInt(struct CH37xReplay_t *pReplay) {
+
+    const uint8_t *pRec;
+    uint64_t cyc;
+    uint32_t next;
+
+    if (NULL == pReplay || pReplay->is_diverged) {
+        return 0;
+    }
+
+    pRec = peek_record(pReplay, false, &cyc, &next);
+    if (NULL == pRec || CH37X_CAPTURE_INT != CH37X_CAPTURE_KIND(pRec[2])) {
+        return 0;
+    }
+
+    play_record(pReplay, cyc, next);
+    return pRec[3];
+}
+
+/**
+ * @brief Tell whether every record of the port was played
+ * @param pReplay replay state
+ * @return true once the port's records ran out without a divergence
+ */
+bool ch37xReplay_isDone(struct CH37xReplay_t *pReplay) {
+
+    uint64_t cyc;
+    uint32_t next;
+
+    if (NULL == pReplay || pReplay->is_diverged) {
+        return false;
+    }
+
+    return NULL == peek_record(pReplay, true, &cyc, &next);
+}
+
+/* --------------------------------------------------------------------------
+ * Private Helper Functions
+ * -------------------------------------------------------------------------*/
+
+/**
+ * @brief Find the port's next record without consuming it
+ * @param isSkipInt pass over INT# samples
+ * @param pCyc capture time of the record
+ * @param pNext position after the record
+ * @return the record, NULL at the end of the trace
+ */
+static const uint8_t *peek_record(const struct CH37xReplay_t *pReplay, bool isSkipInt, uint64_t *pCyc, uint32_t *pNext) {
+
+    uint64_t cyc = pReplay->cyc;
+    uint32_t high = 0;
+
+    for (uint32_t pos = pReplay->pos; pos < pReplay->count; pos++) {
+        const uint8_t *pRec = &pReplay->pRecords[pos * CH37X_CAPTURE_RECORD_SIZE];
+        uint32_t dt = sys_get_le16(pRec);
+
+        if (CH37X_CAPTURE_TIME == CH37X_CAPTURE_KIND(pRec[2])) {
+            high = dt << 16;
+            continue;
+        }
+
+        cyc += high | dt;
+        high = 0;
+
+        if (pReplay->port == CH37X_CAPTURE_PORT(pRec[2]) &&
+            (true != isSkipInt || CH37X_CAPTURE_INT != CH37X_CAPTURE_KIND(pRec[2]))) {
+            *pCyc = cyc;
+            *pNext = pos + 1;
+            return pRec;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Consume a record, busy waiting until its capture time
+ */
+static void play_record(struct CH37xReplay_t *pReplay, uint64_t cyc, uint32_t next) {
+
+    uint64_t nowUs = now_us();
+
+    if (true != pReplay->is_started) {
+        pReplay->first_cyc = cyc;
+        pReplay->start_us = nowUs;
+        pReplay->is_started = true;
+    } else {
+        uint64_t dueUs = pReplay->start_us + (((cyc - pReplay->first_cyc) * 1000000U) / pReplay->hz);
+
+        if (nowUs < dueUs) {
+            k_busy_wait((uint32_t)(dueUs - nowUs));
+        }
+    }
+
+    pReplay->pos = next;
+    pReplay->cyc = cyc;
+    pReplay->records++;
+}
+
+static int replay_write(struct CH37xReplay_t *pReplay, uint8_t kind, uint8_t data) {
+
+    const uint8_t *pRec;
+    uint64_t cyc;
+    uint32_t next;
+    uint8_t recKind;
+
+    if (NULL == pReplay) {
+        return -EINVAL;
+    }
+
+    if (pReplay->is_diverged) {
+        return 0;
+    }
+
+    pRec = peek_record(pReplay, true, &cyc, &next);
+    if (NULL == pRec) {
+        diverge(pReplay, pReplay->count, "write past the end", data);
+        return 0;
+    }
+
+    recKind = CH37X_CAPTURE_KIND(pRec[2]);
+    if (REPLAY_ANY_WRITE == kind) {
+        kind = (CH37X_CAPTURE_CMD == recKind) ? CH37X_CAPTURE_CMD : CH37X_CAPTURE_DATA;
+    }
+
+    if (kind != recKind || data != pRec[3]) {
+        diverge(pReplay, next - 1, (CH37X_CAPTURE_CMD == kind) ? "cmd" : "data", data);
+        return 0;
+    }
+
+    play_record(pReplay, cyc, next);
+    return 0;
+}
+
+static void diverge(struct CH37xReplay_t *pReplay, uint32_t pos, const char *pWhat, uint8_t data) {
+
+    pReplay->is_diverged = true;
+    pReplay->diverge_pos = pos;
+
+    if (pos < pReplay->count) {
+        const uint8_t *pRec = &pReplay->pRecords[pos * CH37X_CAPTURE_RECORD_SIZE];
+
+        LOG_ERR("Port %u diverged at record %u: %s 0x%02X, capture has kind %u 0x%02X", pReplay->port, pos,
+                                                    pWhat, data, CH37X_CAPTURE_KIND(pRec[2]), pRec[3]);
+    } else {
+        LOG_ERR("Port %u diverged after %u records: %s 0x%02X", pReplay->port, pReplay->records, pWhat, data);
+    }
+}
+
+static uint64_t now_us(void) {
+
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+}
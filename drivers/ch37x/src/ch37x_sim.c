@@ -0,0 +1,765 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_sim.c
+ * @brief          Behavioral CH375/CH376S model implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * The chip answers a command as soon as its last parameter arrives, the
+ * answer bytes queue up for readData(). A token is evaluated against the
+ * device when it is issued and GET_STATUS reports busy until its bus time
+ * has passed. NAK retries are replayed lazily, each time the host looks at
+ * the status or the INT line, so a retried transaction completes on the
+ * first poll after the device has data rather than at the exact microsecond.
+ * Data toggles are not checked.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch37x_sim.h"
+#include "ch375.h"
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(ch37x_sim, LOG_LEVEL_INF);
+
+/* Private macros ------------------------------------------------------------*/
+#define SIM_SYNC_CODE1              0x57
+#define SIM_SYNC_CODE2              0xAB
+#define SIM_BAUD_TOLERANCE_PCT      3
+#define SIM_RETRY_PARAM             0x25
+#define SIM_RETRY_NAK               0x80    // Retry NAKed tokens
+#define SIM_RETRY_NAK_LIMITED       0x40    // ...for SIM_RETRY_LIMIT_US only
+#define SIM_RETRY_LIMIT_US          200000
+#define SIM_TOKEN_BITS              35      // SYNC, PID, ADDR, ENDP, CRC5, EOP
+#define SIM_HANDSHAKE_BITS          19      // SYNC, PID, EOP
+#define SIM_TURNAROUND_BITS         16
+#define SIM_DATA_OVERHEAD_BYTES     4       // SYNC, PID, CRC16
+#define SIM_DEV_SPEED_LS            0x10    // GET_DEV_RATE bit for a low speed device
+#define SIM_SPEED_LS                0x02    // SET_USB_SPEED value for low speed
+
+/* Private function prototypes -----------------------------------------------*/
+static bool link_ok(const struct CH37xSim_Chip_t *pChip);
+static void link_byte_time(const struct CH37xSim_Chip_t *pChip);
+static void cmd_start(struct CH37xSim_Chip_t *pChip, uint8_t cmd);
+static void cmd_param(struct CH37xSim_Chip_t *pChip, uint8_t data);
+static void cmd_execute(struct CH37xSim_Chip_t *pChip);
+static uint8_t cmd_param_count(uint8_t cmd);
+static uint32_t decode_baudrate(uint8_t div1, uint8_t div2);
+static void out_put(struct CH37xSim_Chip_t *pChip, uint8_t data);
+static void set_usb_mode(struct CH37xSim_Chip_t *pChip, uint8_t mode);
+static uint8_t connect_state(const struct CH37xSim_Chip_t *pChip);
+static void token_issue(struct CH37xSim_Chip_t *pChip, uint8_t epPid);
+static int token_run(struct CH37xSim_Chip_t *pChip, uint64_t nowUs, uint8_t *pStatus);
+static void token_update(struct CH37xSim_Chip_t *pChip);
+static void token_finish(struct CH37xSim_Chip_t *pChip, uint8_t status, uint64_t doneUs);
+static uint32_t bus_time_us(const struct CH37xSim_Chip_t *pChip, int dataLen);
+static int ep0_setup(struct CH37xSim_Chip_t *pChip);
+static int ep0_in(struct CH37xSim_Chip_t *pChip);
+static int ep0_out(struct CH37xSim_Chip_t *pChip);
+
+/**
+ * @brief Power up a chip in its reset state
+ * @param pChip chip to initialize
+ * @param chipType CH37X_SIM_CH375 or CH37X_SIM_CH376S
+ * @param baudrate serial rate after reset, both sides start at it
+ * @return None
+ */
+void ch37xSim_init(struct CH37xSim_Chip_t *pChip, uint8_t chipType, uint32_t baudrate) {
+
+    if (NULL == pChip) {
+        return;
+    }
+
+    memset(pChip, 0x00, sizeof(struct CH37xSim_Chip_t));
+    pChip->chip_type = chipType;
+    pChip->bits_per_byte = (CH37X_SIM_CH375 == chipType) ? 11 : 10;
+    pChip->chip_baud = baudrate;
+    pChip->link_baud = baudrate;
+    pChip->usb_mode = CH375_USB_MODE_INVALID;
+}
+
+/**
+ * @brief Plug a virtual device into the chip's USB port
+ * @param pChip chip
+ * @param pDev device, must stay valid until detached
+ * @return None
+ */
+void ch37xSim_attach(struct CH37xSim_Chip_t *pChip, struct CH37xSim_Device_t *pDev) {
+
+    if (NULL == pChip || NULL == pDev) {
+        return;
+    }
+
+    pChip->pDev = pDev;
+    pChip->is_bus_reset = false;
+    pDev->address = 0;
+    memset(&pChip->ctrl, 0x00, sizeof(pChip->ctrl));
+
+    if (CH375_USB_MODE_NO_SOF == pChip->usb_mode || CH375_USB_MODE_SOF_AUTO == pChip->usb_mode) {
+        if (true != pChip->is_busy) {
+            pChip->status = CH375_USB_INT_CONNECT;
+            pChip->is_int = true;
+        }
+    }
+}
+
+/**
+ * @brief Unplug the device, a running transaction ends with DISCONNECT
+ * @param pChip chip
+ * @return None
+ */
+void ch37xSim_detach(struct CH37xSim_Chip_t *pChip) {
+
+    if (NULL == pChip || NULL == pChip->pDev) {
+        return;
+    }
+
+    pChip->pDev = NULL;
+    pChip->is_busy = false;
+    pChip->is_retrying = false;
+    pChip->is_bus_reset = false;
+    pChip->status = CH375_USB_INT_DISCONNECT;
+    pChip->is_int = true;
+}
+
+/**
+ * @brief Change the rate the MCU side of the link runs at
+ * @param pChip chip
+ * @param baudrate new rate
+ * @return None
+ */
+void ch37xSim_setLinkBaudrate(struct CH37xSim_Chip_t *pChip, uint32_t baudrate) {
+
+    if (NULL == pChip || 0 == baudrate) {
+        return;
+    }
+
+    pChip->link_baud = baudrate;
+}
+
+/**
+ * @brief Get the rate the chip runs at after its last SET_BAUDRATE
+ * @param pChip chip
+ * @return baud rate
+ */
+uint32_t ch37xSim_getChipBaudrate(const struct CH37xSim_Chip_t *pChip) {
+
+    return (NULL != pChip) ? pChip->chip_baud : 0;
+}
+
+/**
+ * @brief Send a command byte (CH375, bit 8 set)
+ * @param pChip chip
+ * @param cmd command
+ * @return 0, the link has no way to report a lost byte
+ */
+int ch37xSim_writeCmd(struct CH37xSim_Chip_t *pChip, uint8_t cmd) {
+
+    link_byte_time(pChip);
+    if (true != link_ok(pChip)) {
+        return 0;
+    }
+
+    cmd_start(pChip, cmd);
+    return 0;
+}
+
+/**
+ * @brief Send a data byte (CH375, bit 8 clear)
+ * @param pChip chip
+ * @param data parameter byte
+ * @return 0, the link has no way to report a lost byte
+ */
+int ch37xSim_writeData(struct CH37xSim_Chip_t *pChip, uint8_t data) {
+
+    link_byte_time(pChip);
+    if (true != link_ok(pChip)) {
+        return 0;
+    }
+
+    if (0 != pChip->param_need) {
+        cmd_param(pChip, data);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Send an unflagged byte (CH376S)
+ * @param pChip chip
+ * @param data command or parameter byte, an optional 0x57 0xAB header is skipped
+ * @return 0, the link has no way to report a lost byte
+ * @note A byte is a parameter while the current command still expects one,
+ *       otherwise it starts a new command.
+ */
+int ch37xSim_writeByte(struct CH37xSim_Chip_t *pChip, uint8_t data) {
+
+    link_byte_time(pChip);
+    if (true != link_ok(pChip)) {
+        return 0;
+    }
+
+    if (0 != pChip->param_need) {
+        cmd_param(pChip, data);
+        return 0;
+    }
+
+    if (0 == pChip->sync_state && SIM_SYNC_CODE1 == data) {
+        pChip->sync_state = 1;
+        return 0;
+    }
+
+    if (1 == pChip->sync_state && SIM_SYNC_CODE2 == data) {
+        pChip->sync_state = 0;
+        return 0;
+    }
+
+    pChip->sync_state = 0;
+    cmd_start(pChip, data);
+    return 0;
+}
+
+/**
+ * @brief Receive one byte the chip answered with
+ * @param pChip chip
+ * @param pData pointer to the byte
+ * @return 0 on success, -ETIMEDOUT after the backend read timeout
+ */
+int ch37xSim_readData(struct CH37xSim_Chip_t *pChip, uint8_t *pData) {
+
+    if (NULL == pChip || NULL == pData) {
+        return -EINVAL;
+    }
+
+    if (true != link_ok(pChip) || pChip->out_pos >= pChip->out_len) {
+        k_busy_wait(CH37X_SIM_READ_TIMEOUT_US);
+        return -ETIMEDOUT;
+    }
+
+    link_byte_time(pChip);
+    *pData = pChip->out[pChip->out_pos++];
+    return 0;
+}
+
+/**
+ * @brief Sample the INT# line
+ * @param pChip chip
+ * @return 1 while an interrupt is pending, 0 otherwise
+ */
+int ch37xSim_queryInt(struct CH37xSim_Chip_t *pChip) {
+
+    if (NULL == pChip) {
+        return 0;
+    }
+
+    token_update(pChip);
+    return pChip->is_int ? 1 : 0;
+}
+
+/**
+ * @brief Simulated time the model runs on
+ * @return microseconds since boot
+ */
+uint64_t ch37xSim_nowUs(void) {
+
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+}
+
+/* --------------------------------------------------------------------------
+ * Private Helper Functions
+ * -------------------------------------------------------------------------*/
+
+/**
+ * @brief Check both ends of the link agree on the baud rate
+ */
+static bool link_ok(const struct CH37xSim_Chip_t *pChip) {
+
+    uint32_t diff;
+
+    if (pChip->chip_baud > pChip->link_baud) {
+        diff = pChip->chip_baud - pChip->link_baud;
+    } else {
+        diff = pChip->link_baud - pChip->chip_baud;
+    }
+
+    return ((uint64_t)diff * 100U) <= ((uint64_t)pChip->link_baud * SIM_BAUD_TOLERANCE_PCT);
+}
+
+/**
+ * @brief Spend one frame time at the MCU side rate
+ */
+static void link_byte_time(const struct CH37xSim_Chip_t *pChip) {
+
+    k_busy_wait((uint32_t)DIV_ROUND_UP((uint64_t)pChip->bits_per_byte * 1000000U, pChip->link_baud));
+}
+
+static void cmd_start(struct CH37xSim_Chip_t *pChip, uint8_t cmd) {
+
+    pChip->cmd = cmd;
+    pChip->param_count = 0;
+    pChip->param_need = cmd_param_count(cmd);
+    pChip->out_len = 0;
+    pChip->out_pos = 0;
+
+    if (0 == pChip->param_need) {
+        cmd_execute(pChip);
+    }
+}
+
+static void cmd_param(struct CH37xSim_Chip_t *pChip, uint8_t data) {
+
+    // WR_USB_DATA7 takes a length, then that many bytes
+    if (CH375_CMD_WR_USB_DATA7 == pChip->cmd) {
+        if (0 == pChip->param_count++) {
+            pChip->tx_len = 0;
+            pChip->tx_need = MIN(data, CH37X_SIM_BUFF_SIZE);
+            pChip->param_need = pChip->tx_need;
+            return;
+        }
+
+        pChip->tx_buff[pChip->tx_len++] = data;
+        pChip->param_need--;
+        return;
+    }
+
+    pChip->params[pChip->param_count++] = data;
+    pChip->param_need--;
+
+    if (0 == pChip->param_need) {
+        cmd_execute(pChip);
+    }
+}
+
+static uint8_t cmd_param_count(uint8_t cmd) {
+
+    switch (cmd) {
+    case CH375_CMD_SET_BAUDRATE:
+    case CH375_CMD_SET_RETRY:
+    case CH375_CMD_ISSUE_TKN_X:
+        return 2;
+    case CH375_CMD_SET_USB_SPEED:
+    case CH375_CMD_CHECK_EXIST:
+    case CH375_CMD_GET_DEV_RATE:
+    case CH375_CMD_SET_USB_ADDR:
+    case CH375_CMD_SET_USB_MODE:
+    case CH375_CMD_SET_ENDP6:
+    case CH375_CMD_SET_ENDP7:
+    case CH375_CMD_WR_USB_DATA7:
+    case CH375_CMD_ISSUE_TOKEN:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void cmd_execute(struct CH37xSim_Chip_t *pChip) {
+
+    uint32_t baudrate;
+
+    switch (pChip->cmd) {
+    case CH375_CMD_GET_IC_VER:
+        out_put(pChip, CH37X_SIM_IC_VER);
+        break;
+    case CH375_CMD_SET_BAUDRATE:
+        baudrate = decode_baudrate(pChip->params[0], pChip->params[1]);
+        if (0 != baudrate) {
+            LOG_DBG("Chip baud rate %u -> %u", pChip->chip_baud, baudrate);
+            pChip->chip_baud = baudrate;
+        }
+        break;
+    case CH375_CMD_SET_USB_SPEED:
+        pChip->is_low_speed = (SIM_SPEED_LS == pChip->params[0]);
+        break;
+    case CH375_CMD_CHECK_EXIST:
+        out_put(pChip, (uint8_t)~pChip->params[0]);
+        break;
+    case CH375_CMD_GET_DEV_RATE:
+        out_put(pChip, (NULL != pChip->pDev && pChip->pDev->is_low_speed) ? SIM_DEV_SPEED_LS : 0x00);
+        break;
+    case CH375_CMD_SET_RETRY:
+        if (SIM_RETRY_PARAM == pChip->params[0]) {
+            pChip->retry = pChip->params[1];
+        }
+        break;
+    case CH375_CMD_SET_USB_ADDR:
+        pChip->usb_addr = pChip->params[0] & 0x7F;
+        break;
+    case CH375_CMD_SET_USB_MODE:
+        set_usb_mode(pChip, pChip->params[0]);
+        break;
+    case CH375_CMD_TEST_CONNECT:
+        out_put(pChip, connect_state(pChip));
+        break;
+    case CH375_CMD_ABORT_NAK:
+        if (pChip->is_retrying) {
+            pChip->is_retrying = false;
+            pChip->is_busy = false;
+            pChip->status = CH375_PID2STATUS(USB_PID_NAK);
+        }
+        break;
+    case CH375_CMD_GET_STATUS:
+        token_update(pChip);
+        if (pChip->is_busy) {
+            out_put(pChip, CH37X_SIM_STATUS_BUSY);
+        } else {
+            out_put(pChip, pChip->status);
+            pChip->is_int = false;
+        }
+        break;
+    case CH375_CMD_UNLOCK_USB:
+        pChip->rx_len = 0;
+        break;
+    case CH375_CMD_RD_USB_DATA0:
+    case CH375_CMD_RD_USB_DATA:
+        out_put(pChip, pChip->rx_len);
+        for (uint8_t i = 0; i < pChip->rx_len; i++) {
+            out_put(pChip, pChip->rx_buff[i]);
+        }
+        pChip->rx_len = 0;
+        break;
+    case CH375_CMD_ISSUE_TKN_X:
+        token_issue(pChip, pChip->params[1]);
+        break;
+    case CH375_CMD_ISSUE_TOKEN:
+        token_issue(pChip, pChip->params[0]);
+        break;
+    default:
+        LOG_DBG("Command 0x%02X ignored", pChip->cmd);
+        break;
+    }
+}
+
+/**
+ * @brief Turn SET_BAUDRATE parameters back into a rate
+ * @note baud = clk / (256 - div2), div1 picks the clock, 0 if unknown.
+ */
+static uint32_t decode_baudrate(uint8_t div1, uint8_t div2) {
+
+    uint32_t clkHz;
+
+    switch (div1) {
+    case 0x01:
+        clkHz = 93750;
+        break;
+    case 0x02:
+        clkHz = 750000;
+        break;
+    case 0x03:
+        clkHz = 6000000;
+        break;
+    case 0x07:
+        clkHz = 12000000;
+        break;
+    default:
+        return 0;
+    }
+
+    return clkHz / (256U - div2);
+}
+
+static void out_put(struct CH37xSim_Chip_t *pChip, uint8_t data) {
+
+    if (pChip->out_len < sizeof(pChip->out)) {
+        pChip->out[pChip->out_len++] = data;
+    }
+}
+
+static void set_usb_mode(struct CH37xSim_Chip_t *pChip, uint8_t mode) {
+
+    uint8_t prevMode = pChip->usb_mode;
+
+    if (CH375_USB_MODE_NO_SOF != mode && CH375_USB_MODE_SOF_AUTO != mode && CH375_USB_MODE_RESET != mode) {
+        out_put(pChip, CH375_CMD_RET_FAILED);
+        return;
+    }
+
+    pChip->usb_mode = mode;
+    pChip->is_busy = false;
+    pChip->is_retrying = false;
+
+    if (NULL != pChip->pDev) {
+        if (CH375_USB_MODE_RESET == mode) {
+            pChip->pDev->address = 0;
+            pChip->is_bus_reset = false;
+            memset(&pChip->ctrl, 0x00, sizeof(pChip->ctrl));
+            if (NULL != pChip->pDev->ops->reset) {
+                pChip->pDev->ops->reset(pChip->pDev);
+            }
+        } else if (CH375_USB_MODE_RESET == prevMode) {
+            pChip->is_bus_reset = true;
+        }
+    }
+
+    out_put(pChip, CH375_CMD_RET_SUCCESS);
+}
+
+static uint8_t connect_state(const struct CH37xSim_Chip_t *pChip) {
+
+    if (NULL == pChip->pDev || CH375_USB_MODE_RESET == pChip->usb_mode) {
+        return CH375_USB_INT_DISCONNECT;
+    }
+
+    return pChip->is_bus_reset ? CH375_USB_INT_USB_READY : CH375_USB_INT_CONNECT;
+}
+
+/**
+ * @brief Start a transaction, GET_STATUS reads busy until it completes
+ */
+static void token_issue(struct CH37xSim_Chip_t *pChip, uint8_t epPid) {
+
+    uint64_t nowUs = ch37xSim_nowUs();
+    uint8_t status;
+    int len;
+
+    pChip->token = epPid;
+    pChip->is_busy = true;
+    pChip->is_int = false;
+    pChip->is_retrying = false;
+
+    if (NULL == pChip->pDev) {
+        token_finish(pChip, CH375_USB_INT_DISCONNECT, nowUs + CH37X_SIM_TOKEN_US);
+        return;
+    }
+
+    if ((CH375_USB_MODE_NO_SOF != pChip->usb_mode && CH375_USB_MODE_SOF_AUTO != pChip->usb_mode) ||
+        pChip->pDev->address != pChip->usb_addr || pChip->pDev->is_low_speed != pChip->is_low_speed) {
+        token_finish(pChip, CH37X_SIM_STATUS_NO_REPLY, nowUs + CH37X_SIM_TOKEN_US + bus_time_us(pChip, -1));
+        return;
+    }
+
+    len = token_run(pChip, nowUs, &status);
+
+    if (CH375_PID2STATUS(USB_PID_NAK) == status && 0 != (pChip->retry & SIM_RETRY_NAK)) {
+        pChip->is_retrying = true;
+        pChip->done_us = nowUs + CH37X_SIM_TOKEN_US + bus_time_us(pChip, -1);
+        pChip->retry_until_us = (0 != (pChip->retry & SIM_RETRY_NAK_LIMITED)) ?
+                                nowUs + SIM_RETRY_LIMIT_US : UINT64_MAX;
+        return;
+    }
+
+    token_finish(pChip, status, nowUs + CH37X_SIM_TOKEN_US + bus_time_us(pChip, len));
+}
+
+/**
+ * @brief Hand the token to the device
+ * @return data bytes on the bus, -1 for a handshake only
+ */
+static int token_run(struct CH37xSim_Chip_t *pChip, uint64_t nowUs, uint8_t *pStatus) {
+
+    struct CH37xSim_Device_t *pDev = pChip->pDev;
+    uint8_t ep = pChip->token >> 4;
+    uint8_t pid = pChip->token & 0x0F;
+    int ret;
+
+    switch (pid) {
+    case USB_PID_SETUP:
+        ret = ep0_setup(pChip);
+        if (ret < 0) {
+            *pStatus = CH37X_SIM_STATUS_NO_REPLY;
+            return -1;
+        }
+        *pStatus = CH375_USB_INT_SUCCESS;
+        return pChip->tx_len;
+    case USB_PID_IN:
+        ret = (0 == ep) ? ep0_in(pChip) : pDev->ops->in(pDev, ep, pChip->rx_buff, CH37X_SIM_BUFF_SIZE, nowUs);
+        if (ret < 0) {
+            *pStatus = CH375_PID2STATUS(USB_PID_STALL);
+            return -1;
+        }
+        if (0 == ret && 0 != ep) {
+            *pStatus = CH375_PID2STATUS(USB_PID_NAK);
+            return -1;
+        }
+        pChip->rx_len = (uint8_t)ret;
+        *pStatus = CH375_USB_INT_SUCCESS;
+        return ret;
+    case USB_PID_OUT:
+        ret = (0 == ep) ? ep0_out(pChip) : pDev->ops->out(pDev, ep, pChip->tx_buff, pChip->tx_len);
+        if (ret < 0) {
+            *pStatus = CH375_PID2STATUS(USB_PID_STALL);
+            return pChip->tx_len;
+        }
+        *pStatus = CH375_USB_INT_SUCCESS;
+        return pChip->tx_len;
+    default:
+        *pStatus = CH37X_SIM_STATUS_NO_REPLY;
+        return -1;
+    }
+}
+
+/**
+ * @brief Bring a transaction up to the current simulated time
+ */
+static void token_update(struct CH37xSim_Chip_t *pChip) {
+
+    uint64_t nowUs;
+    uint8_t status;
+    int len;
+
+    if (true != pChip->is_busy) {
+        return;
+    }
+
+    nowUs = ch37xSim_nowUs();
+
+    if (pChip->is_retrying) {
+        // Previous attempt still on the bus
+        if (nowUs < pChip->done_us) {
+            return;
+        }
+
+        len = token_run(pChip, nowUs, &status);
+        if (CH375_PID2STATUS(USB_PID_NAK) == status) {
+            if (nowUs < pChip->retry_until_us) {
+                pChip->done_us = nowUs + bus_time_us(pChip, -1);
+                return;
+            }
+            len = -1;
+        }
+
+        pChip->is_retrying = false;
+        token_finish(pChip, status, nowUs + bus_time_us(pChip, len));
+        return;
+    }
+
+    if (nowUs >= pChip->done_us) {
+        pChip->is_busy = false;
+        pChip->is_int = true;
+    }
+}
+
+static void token_finish(struct CH37xSim_Chip_t *pChip, uint8_t status, uint64_t doneUs) {
+
+    pChip->status = status;
+    pChip->done_us = doneUs;
+    pChip->is_busy = true;
+}
+
+/**
+ * @brief Time a transaction occupies the bus at the device speed
+ * @param dataLen data packet length, -1 for token and handshake only
+ */
+static uint32_t bus_time_us(const struct CH37xSim_Chip_t *pChip, int dataLen) {
+
+    uint32_t bits = SIM_TOKEN_BITS + SIM_HANDSHAKE_BITS + SIM_TURNAROUND_BITS;
+
+    if (dataLen >= 0) {
+        bits += 8U * ((uint32_t)dataLen + SIM_DATA_OVERHEAD_BYTES) + 3U + SIM_TURNAROUND_BITS;
+    }
+
+    // 1.5 Mbit/s low speed, 12 Mbit/s full speed
+    return pChip->is_low_speed ? DIV_ROUND_UP(bits * 2U, 3U) : DIV_ROUND_UP(bits, 12U);
+}
+
+/**
+ * @brief SETUP stage, IN requests are answered by the device right away
+ */
+static int ep0_setup(struct CH37xSim_Chip_t *pChip) {
+
+    struct CH37xSim_Ctrl_t *pCtrl = &pChip->ctrl;
+    struct CH37xSim_Device_t *pDev = pChip->pDev;
+    uint16_t wLength;
+    int ret;
+
+    if (sizeof(struct usb_setup_packet) != pChip->tx_len) {
+        return -1;
+    }
+
+    memset(pCtrl, 0x00, sizeof(struct CH37xSim_Ctrl_t));
+    memcpy(&pCtrl->setup, pChip->tx_buff, sizeof(struct usb_setup_packet));
+    pCtrl->setup.wValue = sys_le16_to_cpu(pCtrl->setup.wValue);
+    pCtrl->setup.wIndex = sys_le16_to_cpu(pCtrl->setup.wIndex);
+    pCtrl->setup.wLength = sys_le16_to_cpu(pCtrl->setup.wLength);
+    pCtrl->is_active = true;
+
+    if (0 == (pCtrl->setup.bmRequestType & USB_EP_DIR_IN)) {
+        return 0;
+    }
+
+    wLength = MIN(pCtrl->setup.wLength, CH37X_SIM_CTRL_SIZE);
+    ret = pDev->ops->control(pDev, &pCtrl->setup, NULL, pCtrl->data, wLength);
+    if (ret < 0) {
+        pCtrl->is_stalled = true;
+    } else {
+        pCtrl->len = MIN((uint16_t)ret, wLength);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief IN token on EP0: data stage of an IN request, status stage of an OUT one
+ * @return packet length, negative to STALL
+ */
+static int ep0_in(struct CH37xSim_Chip_t *pChip) {
+
+    struct CH37xSim_Ctrl_t *pCtrl = &pChip->ctrl;
+    struct CH37xSim_Device_t *pDev = pChip->pDev;
+    uint16_t chunk;
+    int ret;
+
+    if (true != pCtrl->is_active) {
+        return -1;
+    }
+
+    if (0 != (pCtrl->setup.bmRequestType & USB_EP_DIR_IN)) {
+        if (pCtrl->is_stalled) {
+            return -1;
+        }
+
+        chunk = MIN((uint16_t)pDev->ep0_max_packet, pCtrl->len - pCtrl->pos);
+        chunk = MIN(chunk, CH37X_SIM_BUFF_SIZE);
+        memcpy(pChip->rx_buff, &pCtrl->data[pCtrl->pos], chunk);
+        pCtrl->pos += chunk;
+        return chunk;
+    }
+
+    // Status stage, the request runs now that all its data is in
+    pCtrl->is_active = false;
+
+    if (USB_REQTYPE_TYPE_STANDARD == USB_REQTYPE_GET_TYPE(pCtrl->setup.bmRequestType) &&
+        USB_SREQ_SET_ADDRESS == pCtrl->setup.bRequest) {
+        pDev->address = pCtrl->setup.wValue & 0x7F;
+        return 0;
+    }
+
+    ret = pDev->ops->control(pDev, &pCtrl->setup, pCtrl->data, NULL, 0);
+    return (ret < 0) ? -1 : 0;
+}
+
+/**
+ * @brief OUT token on EP0: data stage of an OUT request, status stage of an IN one
+ * @return 0 to ACK, negative to STALL
+ */
+static int ep0_out(struct CH37xSim_Chip_t *pChip) {
+
+    struct CH37xSim_Ctrl_t *pCtrl = &pChip->ctrl;
+    uint16_t room;
+
+    if (true != pCtrl->is_active) {
+        return -1;
+    }
+
+    if (0 != (pCtrl->setup.bmRequestType & USB_EP_DIR_IN)) {
+        pCtrl->is_active = false;
+        return 0;
+    }
+
+    room = MIN(pCtrl->setup.wLength, CH37X_SIM_CTRL_SIZE) - pCtrl->len;
+    room = MIN(room, pChip->tx_len);
+    memcpy(&pCtrl->data[pCtrl->len], pChip->tx_buff, room);
+    pCtrl->len += room;
+    return 0;
+}
@@ -0,0 +1,476 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           ch37x_sim_hid.c
+ * @brief          Virtual HID devices implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Input reports are paced in simulated time: an IN token before the next
+ * report is due is NAKed, a late one gets the report and the schedule
+ * catches up instead of bursting. The keyboard only reports on a change,
+ * as a boot keyboard with an idle rate of 0 does. Profile devices report
+ * every bInterval, like a mouse that is held still but never goes quiet.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "ch37x_sim_hid.h"
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+/* Private macros ------------------------------------------------------------*/
+#define SIM_HID_DESC                0x21
+#define SIM_HID_REPORT_DESC         0x22
+#define SIM_HID_GET_REPORT          0x01
+#define SIM_HID_GET_IDLE            0x02
+#define SIM_HID_GET_PROTOCOL        0x03
+#define SIM_HID_SET_REPORT          0x09
+#define SIM_HID_SET_IDLE            0x0A
+#define SIM_HID_SET_PROTOCOL        0x0B
+#define SIM_HID_EP                  1
+#define SIM_HID_DESC_OFFSET         18      // HID descriptor inside the configuration
+#define SIM_HID_DESC_LEN            9
+#define SIM_MOUSE_REPORT_LEN        7
+#define SIM_KEYBOARD_REPORT_LEN     8
+#define SIM_KEY_F24                 0x73
+#define SIM_WHEEL_PERIOD            250     // Reports between wheel ticks
+#define SIM_HID_INTERFACE_CLASS     0x03
+#define SIM_HID_SUBCLASS_BOOT       0x01
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t gMouseDevDesc[] = {
+    0x12, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40,
+    0x09, 0x12, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x01
+};
+
+static const uint8_t gMouseReportDesc[] = {
+    0x05, 0x01,         // Usage Page (Generic Desktop)
+    0x09, 0x02,         // Usage (Mouse)
+    0xA1, 0x01,         // Collection (Application)
+    0x09, 0x01,         //   Usage (Pointer)
+    0xA1, 0x00,         //   Collection (Physical)
+    0x05, 0x09,         //     Usage Page (Button)
+    0x19, 0x01,         //     Usage Minimum (1)
+    0x29, 0x10,         //     Usage Maximum (16)
+    0x15, 0x00,         //     Logical Minimum (0)
+    0x25, 0x01,         //     Logical Maximum (1)
+    0x95, 0x10,         //     Report Count (16)
+    0x75, 0x01,         //     Report Size (1)
+    0x81, 0x02,         //     Input (Data, Var, Abs)
+    0x05, 0x01,         //     Usage Page (Generic Desktop)
+    0x16, 0x01, 0x80,   //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,   //     Logical Maximum (32767)
+    0x75, 0x10,         //     Report Size (16)
+    0x95, 0x02,         //     Report Count (2)
+    0x09, 0x30,         //     Usage (X)
+    0x09, 0x31,         //     Usage (Y)
+    0x81, 0x06,         //     Input (Data, Var, Rel)
+    0x15, 0x81,         //     Logical Minimum (-127)
+    0x25, 0x7F,         //     Logical Maximum (127)
+    0x75, 0x08,         //     Report Size (8)
+    0x95, 0x01,         //     Report Count (1)
+    0x09, 0x38,         //     Usage (Wheel)
+    0x81, 0x06,         //     Input (Data, Var, Rel)
+    0xC0,               //   End Collection
+    0xC0                // End Collection
+};
+
+static const uint8_t gMouseCfgDesc[] = {
+    0x09, 0x02, 0x22, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x02, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, sizeof(gMouseReportDesc), 0x00,
+    0x07, 0x05, 0x81, 0x03, 0x08, 0x00, 0x01
+};
+
+static const uint8_t gKeyboardDevDesc[] = {
+    0x12, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 0x08,
+    0x09, 0x12, 0x02, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x01
+};
+
+static const uint8_t gKeyboardReportDesc[] = {
+    0x05, 0x01,         // Usage Page (Generic Desktop)
+    0x09, 0x06,         // Usage (Keyboard)
+    0xA1, 0x01,         // Collection (Application)
+    0x05, 0x07,         //   Usage Page (Keyboard)
+    0x19, 0xE0,         //   Usage Minimum (Left Control)
+    0x29, 0xE7,         //   Usage Maximum (Right GUI)
+    0x15, 0x00,         //   Logical Minimum (0)
+    0x25, 0x01,         //   Logical Maximum (1)
+    0x75, 0x01,         //   Report Size (1)
+    0x95, 0x08,         //   Report Count (8)
+    0x81, 0x02,         //   Input (Data, Var, Abs)
+    0x95, 0x01,         //   Report Count (1)
+    0x75, 0x08,         //   Report Size (8)
+    0x81, 0x01,         //   Input (Const)
+    0x95, 0x05,         //   Report Count (5)
+    0x75, 0x01,         //   Report Size (1)
+    0x05, 0x08,         //   Usage Page (LEDs)
+    0x19, 0x01,         //   Usage Minimum (Num Lock)
+    0x29, 0x05,         //   Usage Maximum (Kana)
+    0x91, 0x02,         //   Output (Data, Var, Abs)
+    0x95, 0x01,         //   Report Count (1)
+    0x75, 0x03,         //   Report Size (3)
+    0x91, 0x01,         //   Output (Const)
+    0x95, 0x06,         //   Report Count (6)
+    0x75, 0x08,         //   Report Size (8)
+    0x15, 0x00,         //   Logical Minimum (0)
+    0x25, 0x65,         //   Logical Maximum (101)
+    0x05, 0x07,         //   Usage Page (Keyboard)
+    0x19, 0x00,         //   Usage Minimum (0)
+    0x29, 0x65,         //   Usage Maximum (101)
+    0x81, 0x00,         //   Input (Data, Array)
+    0xC0                // End Collection
+};
+
+static const uint8_t gKeyboardCfgDesc[] = {
+    0x09, 0x02, 0x22, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, sizeof(gKeyboardReportDesc), 0x00,
+    0x07, 0x05, 0x81, 0x03, 0x08, 0x00, 0x0A
+};
+
+// Quarter steps of a circle, radius 6
+static const int8_t gCircle[16] = {0, 2, 4, 5, 6, 5, 4, 2, 0, -2, -4, -5, -6, -5, -4, -2};
+
+/* Private function prototypes -----------------------------------------------*/
+static void hid_reset(struct CH37xSim_Device_t *pDev);
+static int hid_control(struct CH37xSim_Device_t *pDev, const struct usb_setup_packet *pSetup,
+                       const uint8_t *pOut, uint8_t *pIn, uint16_t inSize);
+static int hid_in(struct CH37xSim_Device_t *pDev, uint8_t ep, uint8_t *pData, uint8_t size, uint64_t nowUs);
+static int hid_out(struct CH37xSim_Device_t *pDev, uint8_t ep, const uint8_t *pData, uint8_t len);
+static int copy_in(uint8_t *pIn, uint16_t inSize, const uint8_t *pSrc, uint16_t len);
+static void mouse_next(struct CH37xSimHid_Device_t *pHid);
+static void keyboard_next(struct CH37xSimHid_Device_t *pHid);
+
+static const struct CH37xSim_DeviceOps_t gHidOps = {
+    .reset = hid_reset,
+    .control = hid_control,
+    .in = hid_in,
+    .out = hid_out,
+};
+
+/**
+ * @brief Set up the virtual mouse
+ * @param pHid device to initialize
+ * @param reportHz input reports per second, 1 to 1000
+ * @return None
+ */
+void ch37xSimHid_initMouse(struct CH37xSimHid_Device_t *pHid, uint32_t reportHz) {
+
+    if (NULL == pHid) {
+        return;
+    }
+
+    memset(pHid, 0x00, sizeof(struct CH37xSimHid_Device_t));
+    pHid->dev.ops = &gHidOps;
+    pHid->dev.is_low_speed = false;
+    pHid->dev.ep0_max_packet = gMouseDevDesc[7];
+    pHid->pDevDesc = gMouseDevDesc;
+    pHid->pCfgDesc = gMouseCfgDesc;
+    pHid->cfg_len = sizeof(gMouseCfgDesc);
+    pHid->pReportDesc = gMouseReportDesc;
+    pHid->report_desc_len = sizeof(gMouseReportDesc);
+    pHid->protocol = 1;
+    pHid->interval_us = 1000000U / CLAMP(reportHz, 1U, 1000U);
+    pHid->report_len = SIM_MOUSE_REPORT_LEN;
+}
+
+/**
+ * @brief Set up the virtual keyboard
+ * @param pHid device to initialize
+ * @param keysPerSec key taps per second, 0 for a keyboard that never types
+ * @return None
+ */
+void ch37xSimHid_initKeyboard(struct CH37xSimHid_Device_t *pHid, uint32_t keysPerSec) {
+
+    if (NULL == pHid) {
+        return;
+    }
+
+    memset(pHid, 0x00, sizeof(struct CH37xSimHid_Device_t));
+    pHid->dev.ops = &gHidOps;
+    pHid->dev.is_low_speed = true;
+    pHid->dev.ep0_max_packet = gKeyboardDevDesc[7];
+    pHid->pDevDesc = gKeyboardDevDesc;
+    pHid->pCfgDesc = gKeyboardCfgDesc;
+    pHid->cfg_len = sizeof(gKeyboardCfgDesc);
+    pHid->pReportDesc = gKeyboardReportDesc;
+    pHid->report_desc_len = sizeof(gKeyboardReportDesc);
+    pHid->is_keyboard = true;
+    pHid->protocol = 1;
+    // A tap is a press and a release
+    pHid->interval_us = (0 != keysPerSec) ? 500000U / keysPerSec : 0;
+    pHid->report_len = SIM_KEYBOARD_REPORT_LEN;
+}
+
+/**
+ * @brief Set up a virtual device from a profile
+ * @param pHid device to initialize
+ * @param pProfile speed, endpoints and report descriptor of the device
+ * @return 0 on success, -EINVAL if the profile does not fit the model
+ * @note The profile's report descriptor must outlive the device.
+ */
+int ch37xSimHid_initProfile(struct CH37xSimHid_Device_t *pHid, const struct CH37xSimHid_Profile_t *pProfile) {
+
+    uint8_t *pCfg;
+
+    if (NULL == pHid || NULL == pProfile || NULL == pProfile->pReportDesc) {
+        return -EINVAL;
+    }
+
+    if (0 == pProfile->report_len || pProfile->report_len > CH37X_SIM_HID_REPORT_MAX ||
+        pProfile->report_len > pProfile->ep_max_packet || 0 == pProfile->interval ||
+        (pProfile->is_low_speed && 8 != pProfile->ep0_max_packet)) {
+        return -EINVAL;
+    }
+
+    memset(pHid, 0x00, sizeof(struct CH37xSimHid_Device_t));
+
+    pHid->dev_desc[0] = CH37X_SIM_HID_DEV_DESC_LEN;
+    pHid->dev_desc[1] = USB_DESC_DEVICE;
+    sys_put_le16(pProfile->is_low_speed ? 0x0110 : 0x0200, &pHid->dev_desc[2]);
+    pHid->dev_desc[7] = pProfile->ep0_max_packet;
+    sys_put_le16(CH37X_SIM_HID_VID, &pHid->dev_desc[8]);
+    sys_put_le16(pProfile->pid, &pHid->dev_desc[10]);
+    sys_put_le16(0x0100, &pHid->dev_desc[12]);
+    pHid->dev_desc[17] = 1;
+
+    pCfg = pHid->cfg_desc;
+    pCfg[0] = 9;
+    pCfg[1] = USB_DESC_CONFIGURATION;
+    sys_put_le16(CH37X_SIM_HID_CFG_DESC_LEN, &pCfg[2]);
+    pCfg[4] = 1;
+    pCfg[5] = 1;
+    pCfg[7] = 0xA0;
+    pCfg[8] = 0x32;
+
+    pCfg += 9;
+    pCfg[0] = 9;
+    pCfg[1] = USB_DESC_INTERFACE;
+    pCfg[4] = 1;
+    pCfg[5] = SIM_HID_INTERFACE_CLASS;
+    pCfg[6] = (0 != pProfile->protocol) ? SIM_HID_SUBCLASS_BOOT : 0;
+    pCfg[7] = pProfile->protocol;
+
+    pCfg += 9;
+    pCfg[0] = SIM_HID_DESC_LEN;
+    pCfg[1] = SIM_HID_DESC;
+    sys_put_le16(0x0111, &pCfg[2]);
+    pCfg[5] = 1;
+    pCfg[6] = SIM_HID_REPORT_DESC;
+    sys_put_le16(pProfile->report_desc_len, &pCfg[7]);
+
+    pCfg += SIM_HID_DESC_LEN;
+    pCfg[0] = 7;
+    pCfg[1] = USB_DESC_ENDPOINT;
+    pCfg[2] = USB_EP_DIR_IN | SIM_HID_EP;
+    pCfg[3] = USB_EP_TYPE_INTERRUPT;
+    sys_put_le16(pProfile->ep_max_packet, &pCfg[4]);
+    pCfg[6] = pProfile->interval;
+
+    pHid->dev.ops = &gHidOps;
+    pHid->dev.is_low_speed = pProfile->is_low_speed;
+    pHid->dev.ep0_max_packet = pProfile->ep0_max_packet;
+    pHid->pDevDesc = pHid->dev_desc;
+    pHid->pCfgDesc = pHid->cfg_desc;
+    pHid->cfg_len = CH37X_SIM_HID_CFG_DESC_LEN;
+    pHid->pReportDesc = pProfile->pReportDesc;
+    pHid->report_desc_len = pProfile->report_desc_len;
+    pHid->is_keyboard = (1 == pProfile->protocol);
+    pHid->is_idle = true;
+    pHid->protocol = 1;
+    pHid->interval_us = pProfile->interval * 1000U;
+    pHid->report_len = pProfile->report_len;
+    pHid->report_id = pProfile->report_id;
+    pHid->report[0] = pProfile->report_id;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------
+ * Device callbacks
+ * -------------------------------------------------------------------------*/
+
+static void hid_reset(struct CH37xSim_Device_t *pDev) {
+
+    struct CH37xSimHid_Device_t *pHid = CONTAINER_OF(pDev, struct CH37xSimHid_Device_t, dev);
+
+    pHid->config = 0;
+    pHid->idle = 0;
+    pHid->protocol = 1;
+    pHid->next_us = 0;
+    memset(pHid->report, 0x00, sizeof(pHid->report));
+    pHid->report[0] = pHid->report_id;
+}
+
+static int hid_control(struct CH37xSim_Device_t *pDev, const struct usb_setup_packet *pSetup,
+                       const uint8_t *pOut, uint8_t *pIn, uint16_t inSize) {
+
+    struct CH37xSimHid_Device_t *pHid = CONTAINER_OF(pDev, struct CH37xSimHid_Device_t, dev);
+    uint8_t descType = pSetup->wValue >> 8;
+
+    if (USB_REQTYPE_TYPE_STANDARD == USB_REQTYPE_GET_TYPE(pSetup->bmRequestType)) {
+        switch (pSetup->bRequest) {
+        case USB_SREQ_GET_DESCRIPTOR:
+            if (USB_DESC_DEVICE == descType) {
+                return copy_in(pIn, inSize, pHid->pDevDesc, pHid->pDevDesc[0]);
+            } else if (USB_DESC_CONFIGURATION == descType) {
+                return copy_in(pIn, inSize, pHid->pCfgDesc, pHid->cfg_len);
+            } else if (SIM_HID_DESC == descType) {
+                return copy_in(pIn, inSize, &pHid->pCfgDesc[SIM_HID_DESC_OFFSET], SIM_HID_DESC_LEN);
+            } else if (SIM_HID_REPORT_DESC == descType) {
+                return copy_in(pIn, inSize, pHid->pReportDesc, pHid->report_desc_len);
+            }
+            return -1;
+        case USB_SREQ_SET_CONFIGURATION:
+            pHid->config = pSetup->wValue & 0xFF;
+            return 0;
+        case USB_SREQ_GET_CONFIGURATION:
+            return copy_in(pIn, inSize, &pHid->config, 1);
+        case USB_SREQ_GET_STATUS: {
+            static const uint8_t status[2] = {0x00, 0x00};
+            return copy_in(pIn, inSize, status, sizeof(status));
+        }
+        case USB_SREQ_CLEAR_FEATURE:
+        case USB_SREQ_SET_FEATURE:
+        case USB_SREQ_SET_INTERFACE:
+            return 0;
+        default:
+            return -1;
+        }
+    }
+
+    if (USB_REQTYPE_TYPE_CLASS != USB_REQTYPE_GET_TYPE(pSetup->bmRequestType)) {
+        return -1;
+    }
+
+    switch (pSetup->bRequest) {
+    case SIM_HID_SET_IDLE:
+        pHid->idle = pSetup->wValue >> 8;
+        return 0;
+    case SIM_HID_GET_IDLE:
+        return copy_in(pIn, inSize, &pHid->idle, 1);
+    case SIM_HID_SET_PROTOCOL:
+        pHid->protocol = pSetup->wValue & 0xFF;
+        return 0;
+    case SIM_HID_GET_PROTOCOL:
+        return copy_in(pIn, inSize, &pHid->protocol, 1);
+    case SIM_HID_SET_REPORT:
+        if (true != pHid->is_keyboard || 0 == pSetup->wLength) {
+            return -1;
+        }
+        pHid->leds = pOut[0];
+        return 0;
+    case SIM_HID_GET_REPORT:
+        return copy_in(pIn, inSize, pHid->report, pHid->report_len);
+    default:
+        return -1;
+    }
+}
+
+static int hid_in(struct CH37xSim_Device_t *pDev, uint8_t ep, uint8_t *pData, uint8_t size, uint64_t nowUs) {
+
+    struct CH37xSimHid_Device_t *pHid = CONTAINER_OF(pDev, struct CH37xSimHid_Device_t, dev);
+
+    if (SIM_HID_EP != ep || 0 == pHid->config) {
+        return -1;
+    }
+
+    if (0 == pHid->interval_us) {
+        return 0;
+    }
+
+    if (0 == pHid->next_us) {
+        pHid->next_us = nowUs;
+    }
+
+    if (nowUs < pHid->next_us) {
+        return 0;
+    }
+
+    // Catch up after a slow poll instead of bursting the missed reports
+    pHid->next_us += pHid->interval_us;
+    if (pHid->next_us <= nowUs) {
+        pHid->next_us = nowUs + pHid->interval_us;
+    }
+
+    // Profile devices keep the idle report set up at reset
+    if (true != pHid->is_idle) {
+        if (pHid->is_keyboard) {
+            keyboard_next(pHid);
+        } else {
+            mouse_next(pHid);
+        }
+    }
+    pHid->seq++;
+
+    return copy_in(pData, size, pHid->report, pHid->report_len);
+}
+
+static int hid_out(struct CH37xSim_Device_t *pDev, uint8_t ep, const uint8_t *pData, uint8_t len) {
+
+    (void)(pDev);
+    (void)(ep);
+    (void)(pData);
+    (void)(len);
+
+    // No OUT endpoint
+    return -1;
+}
+
+/* --------------------------------------------------------------------------
+ * Private Helper Functions
+ * -------------------------------------------------------------------------*/
+
+static int copy_in(uint8_t *pIn, uint16_t inSize, const uint8_t *pSrc, uint16_t len) {
+
+    len = MIN(len, inSize);
+    memcpy(pIn, pSrc, len);
+
+    return len;
+}
+
+/**
+ * @brief Next step around the circle, the wheel rocks one notch up and back
+ */
+static void mouse_next(struct CH37xSimHid_Device_t *pHid) {
+
+    uint32_t step = pHid->seq >> 2;
+    int16_t x = gCircle[(step + 4) & 0x0F];
+    int16_t y = gCircle[step & 0x0F];
+    int8_t wheel = 0;
+
+    if (0 == (pHid->seq % SIM_WHEEL_PERIOD)) {
+        wheel = (0 == ((pHid->seq / SIM_WHEEL_PERIOD) & 1)) ? 1 : -1;
+    }
+
+    sys_put_le16(0x0000, &pHid->report[0]);
+    sys_put_le16((uint16_t)x, &pHid->report[2]);
+    sys_put_le16((uint16_t)y, &pHid->report[4]);
+    pHid->report[6] = (uint8_t)wheel;
+}
+
+/**
+ * @brief Alternate between F24 down and all keys up
+ */
+static void keyboard_next(struct CH37xSimHid_Device_t *pHid) {
+
+    memset(pHid->report, 0x00, SIM_KEYBOARD_REPORT_LEN);
+
+    if (0 == (pHid->seq & 1)) {
+        pHid->report[2] = SIM_KEY_F24;
+    }
+}
@@ -49,6 +49,23 @@ extern "C" {
 #define HID_KBD_KEYS_OFFSET     2
 #define HID_KBD_MAX_KEYS        6
 
+/**
+ * @brief Key state bitmap, one bit per Keyboard/Keypad usage 0x00..0xFF
+ */
+#define HID_KBD_BITMAP_BYTES        32
+#define HID_KBD_USAGE_ERR_ROLLOVER  0x01
+#define HID_KBD_USAGE_FIRST_KEY     0x04
+#define HID_KBD_USAGE_LEFT_CTRL     0xE0
+#define HID_KBD_MAX_BITMAPS         4       // Runs of 1-bit key fields per report
+
+/**
+ * @brief Key event dispatch
+ */
+#define HID_KBD_MAX_ACTIONS         16
+#define HID_KBD_ACTION_NONE         0xFF
+#define HID_KEY_EVENT_PRESS         BIT(0)
+#define HID_KEY_EVENT_RELEASE       BIT(1)
+
 /**
  * @brief HID Keyboard key code macros
  */
@@ -57,14 +74,68 @@ extern "C" {
 #define HID_KBD_NUMBER(x) (((x) >= '1' && (x) <= '9') ? ((x) - '1' + 30) : \
                           ((x) == '0') ? 39 : 0)
 
+/**
+ * @brief Decoded keyboard report
+ * @note Bit n of `keys` is Keyboard/Keypad usage n, whatever the source
+ *       format (6KRO key array or NKRO usage bitmap). Modifiers are kept in
+ *       their own byte and never appear in `keys`.
+ */
+struct HID_KeyboardState_t {
+    uint8_t modifiers;
+    uint8_t key_count;
+    uint8_t keys[HID_KBD_BITMAP_BYTES];
+};
+
+/**
+ * @brief One run of consecutive key usages, one bit each at consecutive report bits
+ * @note Descriptors that list usages one by one compile into one field per
+ *       usage, contiguous ones are merged back into a single run.
+ */
+struct HID_KbdBitmap_t {
+    uint32_t report_bit_off;
+    uint16_t usage_min;
+    uint16_t count;
+};
+
 /**
  * @brief HID Keyboard Structure
  */
 struct HID_Keyboard_t {
     struct USBHID_Device_t *hid_dev;
     uint32_t report_length;
+    uint8_t report_id;
+    uint8_t report_id_offset;
     struct HID_DataDescriptor_t modifier;
     struct HID_DataDescriptor_t keys;
+    struct HID_KbdBitmap_t bitmaps[HID_KBD_MAX_BITMAPS];
+    uint8_t bitmap_count;
+    struct HID_KeyboardState_t last_state;      // Held across ErrorRollOver reports
+};
+
+/**
+ * @brief Key action callback
+ * @note Modifiers are reported as their usages (HID_KBD_USAGE_LEFT_CTRL + bit).
+ */
+typedef void (*HID_KeyActionCb_t)(uint8_t keyCode, bool isPressed, void *pUserData);
+
+/**
+ * @brief Bound action
+ */
+struct HID_KeyAction_t {
+    HID_KeyActionCb_t cb;
+    void *pUserData;
+    uint8_t event_mask;
+};
+
+/**
+ * @brief Key code -> action table plus the state events are diffed against
+ * @note `key_map` holds an index into `actions` (or HID_KBD_ACTION_NONE) for
+ *       every usage, so dispatch cost does not depend on the number of bindings.
+ */
+struct HID_KeyEventTable_t {
+    uint8_t key_map[HID_KBD_BITMAP_BYTES * 8];
+    struct HID_KeyAction_t actions[HID_KBD_MAX_ACTIONS];
+    struct HID_KeyboardState_t last;
 };
 
 /**
@@ -86,6 +157,59 @@ int hidKeyboard_SetKey(struct HID_Keyboard_t *pKbd, uint32_t keyCode, uint32_t v
 int hidKeyboard_GetModifier(struct HID_Keyboard_t *pKbd, uint32_t modNum, uint32_t *pValue, bool isLast);
 int hidKeyboard_SetModifier(struct HID_Keyboard_t *pKbd, uint32_t modNum, uint32_t value, bool isLast);
 
+/**
+ * @brief Whole report functions
+ */
+bool hidKeyboard_Decode(const struct HID_Keyboard_t *pKbd, const uint8_t *pReport,
+                                            struct HID_KeyboardState_t *pState);
+void hidKeyboard_Encode(const struct HID_Keyboard_t *pKbd, const struct HID_KeyboardState_t *pState,
+                                                                            uint8_t *pReport);
+int hidKeyboard_GetState(struct HID_Keyboard_t *pKbd, struct HID_KeyboardState_t *pState, bool isLast);
+
+/**
+ * @brief Key event functions
+ */
+void hidKeyboard_InitEvents(struct HID_KeyEventTable_t *pTable);
+int hidKeyboard_BindKey(struct HID_KeyEventTable_t *pTable, uint8_t keyCode, uint8_t eventMask,
+                                                    HID_KeyActionCb_t cb, void *pUserData);
+int hidKeyboard_UnbindKey(struct HID_KeyEventTable_t *pTable, uint8_t keyCode);
+uint32_t hidKeyboard_DispatchEvents(struct HID_KeyEventTable_t *pTable, const struct HID_KeyboardState_t *pState);
+
+/**
+ * @brief Check whether a key is held in a decoded report
+ * @param pState Pointer to the decoded keyboard state
+ * @param keyCode Key code to look for
+ * @return true if the key is pressed
+ */
+static inline bool hidKeyboard_StateHasKey(const struct HID_KeyboardState_t *pState, uint8_t keyCode)
+{
+    return 0 != (pState->keys[keyCode >> 3] & BIT(keyCode & 0x07));
+}
+
+/**
+ * @brief Press or release a key in a decoded report
+ * @param pState Pointer to the decoded keyboard state
+ * @param keyCode Key code to change
+ * @param isPressed true to press, false to release
+ */
+static inline void hidKeyboard_StateSetKey(struct HID_KeyboardState_t *pState, uint8_t keyCode, bool isPressed)
+{
+    uint8_t mask = BIT(keyCode & 0x07);
+    bool wasPressed = (0 != (pState->keys[keyCode >> 3] & mask));
+
+    if (isPressed == wasPressed) {
+        return;
+    }
+
+    if (true == isPressed) {
+        pState->keys[keyCode >> 3] |= mask;
+        pState->key_count++;
+    } else {
+        pState->keys[keyCode >> 3] &= ~mask;
+        pState->key_count--;
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,11 +37,6 @@ extern "C" {
 #include "ch375_host.h"
 #include "hid_parser.h"
 
-// define report ID byte used by your mouse if any
-#if 1
-#define MOUSE_REPORTID_BYTE 0x01
-#endif
-
 /**
  * @brief HID Mouse Button Definitions
  */
@@ -59,9 +54,12 @@ typedef enum {
 typedef enum {
     HID_MOUSE_AXIS_X        = 0,
     HID_MOUSE_AXIS_Y        = 1,
-    HID_MOUSE_AXIS_WHEEL    = 2
+    HID_MOUSE_AXIS_WHEEL    = 2,
+    HID_MOUSE_AXIS_COUNT
 } hidMouse_Axis_e;
 
+#define HID_MOUSE_MAX_BUTTONS   32
+
 // Forward declare USB device and HID descriptor
 struct USB_Device_t;
 struct USB_HID_Descriptor_t;
@@ -73,11 +71,26 @@ struct HID_Mouse_t {
     struct USBHID_Device_t *hid_dev;
     uint32_t report_len;
     bool has_report_id_declared;
+    uint8_t report_id;
     uint8_t report_id_offset;
     struct HID_DataDescriptor_t button;
-    struct HID_DataDescriptor_t orientation;
+    struct HID_DataDescriptor_t orientation;        // X, count covers both X and Y
+    struct HID_DataDescriptor_t orientation_y;      // Y, size and range may differ from X
     struct HID_DataDescriptor_t wheel;
     bool has_wheel;
+    uint32_t axis_bit_off[HID_MOUSE_AXIS_COUNT];
+};
+
+/**
+ * @brief Decoded mouse report
+ * @note Bit n of `buttons` is button n + 1, axes are sign-extended when the
+ *       field is signed or relative.
+ */
+struct HID_MouseState_t {
+    uint32_t buttons;
+    int32_t x;
+    int32_t y;
+    int32_t wheel;
 };
 
 /**
@@ -99,6 +112,13 @@ int hidMouse_SetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
 int hidMouse_GetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_t *pValue, bool isLast);
 int hidMouse_SetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_t value, bool isLast);
 
+/**
+ * @brief Whole report functions
+ */
+void hidMouse_Decode(const struct HID_Mouse_t *pMouse, const uint8_t *pReport, struct HID_MouseState_t *pState);
+void hidMouse_Encode(const struct HID_Mouse_t *pMouse, const struct HID_MouseState_t *pState, uint8_t *pReport);
+int hidMouse_GetState(struct HID_Mouse_t *pMouse, struct HID_MouseState_t *pState, bool isLast);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,14 +30,69 @@
 #include <stdbool.h>
 #include "usb_hid_proxy.h"
 #include "hid_mouse.h"
+#include "hid_keyboard.h"
 
 
 #define HID_OUTPUT_REPORT_SIZE 6
+#define HID_OUTPUT_PLAN_ZERO   0xFF    // Plan source: constant 0x00
+#define HID_OUTPUT_PLAN_SIGN   0x80    // Plan source flag: sign fill from that byte
+#define HID_OUTPUT_KBD_QUEUE_DEPTH  16  // Keyboard states waiting for the host, power of two
+#define HID_OUTPUT_MOUSE_RING_DEPTH 8   // Mouse samples waiting for the consumer, power of two
+#define HID_OUTPUT_SOF_FALLBACK_MS  4   // SOF_ALIGN: flush anyway after this long without a SOF
+
+/**
+ * @brief How a fetched mouse report is turned into the output report
+ */
+typedef enum {
+    HID_OUTPUT_PLAN_REMAP = 0,      // Decode and re-encode every field
+    HID_OUTPUT_PLAN_PERMUTE,        // Output byte i = input[src[i]] & mask[i] (or sign fill)
+    HID_OUTPUT_PLAN_IDENTITY        // Output is input[src[0]..src[0]+5], sent in place
+} HID_OutputPlanKind_e;
+
+/**
+ * @brief Translation plan, computed once when the mouse is opened
+ */
+struct HID_OutputPlan_t {
+    uint8_t kind;
+    uint8_t src[HID_OUTPUT_REPORT_SIZE];
+    uint8_t mask[HID_OUTPUT_REPORT_SIZE];
+};
+
+/**
+ * @brief Keyboard output queue counters
+ */
+struct HID_OutputQueueStats_t {
+    uint32_t depth;         // States waiting right now, the one held back by a full queue included
+    uint32_t high_water;    // Deepest the queue has been
+    uint32_t collapsed;     // States merged into a queued one without losing a transition
+    uint32_t overflowed;    // States merged into a full queue (transitions may be lost)
+};
+
+// Reset output state, call after usbhid_proxyInit()
+void hidOutput_init(void);
+
+// Work out the cheapest way to translate this mouse's reports
+void hidOutput_planMouse(const struct HID_Mouse_t *pMouse, struct HID_OutputPlan_t *pPlan);
+
+// Encode a decoded report into the output format
+void hidOutput_encodeMouseState(const struct HID_MouseState_t *pState, uint8_t *pOutReport);
 
 // Build translated report from any mouse format
 int hidOutput_buildMouseReport(struct HID_Mouse_t *pMouse, uint8_t *pOutReport);
 
-// Translate and send
+// Translate and send, motion is merged while the endpoint is busy
+int hidOutput_sendMouseState(const struct HID_MouseState_t *pState, uint32_t arrivalCyc);
 int hidOutput_sendMouseReport(struct HID_Mouse_t *pMouse);
 
+// Translate the fetched report with a plan and send it
+int hidOutput_sendMousePlanned(struct HID_Mouse_t *pMouse, const struct HID_OutputPlan_t *pPlan);
+
+// Encode a decoded keyboard state into the NKRO (or boot) report, returns its length
+size_t hidOutput_encodeKeyboardState(const struct HID_KeyboardState_t *pState, bool isBoot,
+                                                                        uint8_t *pOutReport);
+
+// Queue a keyboard state for the host, honouring the host's protocol
+int hidOutput_sendKeyboardState(const struct HID_KeyboardState_t *pState, uint32_t arrivalCyc);
+void hidOutput_getKeyboardQueueStats(struct HID_OutputQueueStats_t *pStats);
+
 #endif /* HID_OUTPUT_H */
\ No newline at end of file
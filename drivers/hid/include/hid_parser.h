@@ -43,6 +43,22 @@ extern "C" {
 #define HID_ITEM_TAG_LONG 15
 #define USB_CLASS_HID 0x03
 
+/* Compiled layout limits */
+#define HID_LAYOUT_MAX_FIELDS   32
+#define HID_LAYOUT_MAX_REPORTS  8
+#define HID_PARSER_MAX_USAGES   16
+#define HID_PARSER_STACK_DEPTH  4
+
+/* Compiled field flags (bits 0-2 mirror the Input/Output/Feature item data) */
+#define HID_FIELD_CONSTANT      0x01
+#define HID_FIELD_VARIABLE      0x02
+#define HID_FIELD_RELATIVE      0x04
+#define HID_FIELD_SIGNED        0x80
+
+/* Report ID lookup table */
+#define HID_REPORT_ID_COUNT     256
+#define HID_REPORT_INDEX_NONE   0xFF
+
 /**
  * @brief USBHID Device Types
  */
@@ -65,9 +81,70 @@ typedef enum {
     USBHID_NOT_SUPPORT      = -5,
     USBHID_NOT_HID_DEV      = -6,
     USBHID_BUFFER_NOT_ALLOC = -7,
-    USBHID_ALLOC_FAILED     = -8
+    USBHID_ALLOC_FAILED     = -8,
+    USBHID_REPORT_FILTERED  = -9,
+    USBHID_BUSY             = -10
 } usbHid_ErrNo_e;
 
+/**
+ * @brief What to do with an incoming report of a given Report ID
+ */
+typedef enum {
+    HID_REPORT_ROUTE_DROP   = 0,
+    HID_REPORT_ROUTE_ACCEPT = 1
+} HID_ReportRoute_e;
+
+/**
+ * @brief Compiled HID report field
+ * @note One entry describes `count` equally sized elements laid out back to back
+ *       starting at `bit_offset`. Variable fields map element i to
+ *       MIN(usage + i, usage_max), array fields carry usage indices in the
+ *       `usage`..`usage_max` range.
+ */
+struct HID_Field_t {
+    uint32_t usage;
+    uint32_t usage_max;
+    uint32_t app_usage;
+    int32_t logical_minimum;
+    int32_t logical_maximum;
+    uint16_t bit_offset;
+    uint16_t count;
+    uint8_t bit_size;
+    uint8_t report_id;
+    uint8_t report_type;
+    uint8_t flags;
+};
+
+/**
+ * @brief Per Report ID summary (sizes in bits, Report ID byte excluded)
+ * @note The fields of one report are stored contiguously in the layout's
+ *       field table starting at `field_first`.
+ */
+struct HID_ReportInfo_t {
+    uint8_t report_id;
+    uint8_t route;
+    uint8_t field_first;
+    uint8_t field_count;
+    uint32_t app_usage;
+    uint16_t input_bits;
+    uint16_t output_bits;
+    uint16_t feature_bits;
+};
+
+/**
+ * @brief Compiled HID report layout
+ */
+struct HID_ReportLayout_t {
+    struct HID_Field_t fields[HID_LAYOUT_MAX_FIELDS];
+    struct HID_ReportInfo_t reports[HID_LAYOUT_MAX_REPORTS];
+    uint8_t report_map[HID_REPORT_ID_COUNT];
+    uint8_t field_count;
+    uint8_t report_count;
+    uint8_t hid_type;
+    bool has_report_id;
+    bool is_compiled;
+};
+
 /**
  * @brief USBHID Device Structure
  */
@@ -87,6 +164,10 @@ struct USBHID_Device_t {
     uint32_t report_len;
     uint32_t report_buff_len;
     uint32_t report_buffer_last_offset;
+    uint32_t filtered_count;
+    uint32_t report_cyc;        // k_cycle_get_32() when the last report arrived
+
+    struct HID_ReportLayout_t layout;
 };
 
 /**
@@ -200,13 +281,91 @@ struct HID_DataDescriptor_t {
     uint32_t size;
     uint32_t count;
     uint32_t report_buf_off;
+    uint32_t report_bit_off;
+    bool is_signed;
 };
 
 /**
  * @brief Parsing functions
  */
 uint8_t *HID_fetchItem(uint8_t *pStart, uint8_t *pEnd, struct HID_Item_t *pItem);
-int HID_parseReportDescriptor(uint8_t *pReport, uint16_t len, uint8_t *pType);
+int HID_compileReportLayout(const uint8_t *pReport, uint16_t len, struct HID_ReportLayout_t *pLayout);
+const struct HID_Field_t *HID_findField(const struct HID_ReportLayout_t *pLayout, uint8_t reportType,
+                                        uint32_t appUsage, uint32_t usage, uint32_t *pIndex);
+const struct HID_Field_t *HID_findReportField(const struct HID_ReportLayout_t *pLayout, uint8_t reportID,
+                                        uint8_t reportType, uint32_t usage, uint32_t *pIndex);
+const struct HID_ReportInfo_t *HID_getReportInfo(const struct HID_ReportLayout_t *pLayout, uint8_t reportID);
+int HID_setReportRoute(struct HID_ReportLayout_t *pLayout, uint8_t reportID, uint8_t route);
+
+/**
+ * @brief Look up the layout of a received input report
+ * @param pLayout Pointer to the compiled layout
+ * @param pReport Pointer to the report data (Report ID in byte 0 if declared)
+ * @return Pointer to the report info or NULL if the Report ID is unknown
+ * @note Constant time, meant to be called for every report on the hot path.
+ */
+static inline const struct HID_ReportInfo_t *HID_routeReport(const struct HID_ReportLayout_t *pLayout,
+                                                                            const uint8_t *pReport)
+{
+    uint8_t index = pLayout->report_map[pLayout->has_report_id ? pReport[0] : 0];
+
+    return (HID_REPORT_INDEX_NONE == index) ? NULL : &pLayout->reports[index];
+}
+
+/**
+ * @brief Extract an unsigned bit field of arbitrary alignment from a report
+ * @param pBuff Pointer to the report data
+ * @param bitOff Bit offset of the field (LSB first, as in the HID spec)
+ * @param bitSize Field width in bits (1..32)
+ * @return Field value, zero-extended
+ */
+static inline uint32_t HID_extractBits(const uint8_t *pBuff, uint32_t bitOff, uint8_t bitSize)
+{
+    const uint8_t *pByte = pBuff + (bitOff >> 3);
+    uint32_t shift = bitOff & 0x07;
+    uint32_t byteCount = (shift + bitSize + 7) >> 3;
+    uint64_t raw = 0;
+
+    for (uint32_t i = 0; i < byteCount; i++) {
+        raw |= (uint64_t)pByte[i] << (8 * i);
+    }
+
+    return (uint32_t)((raw >> shift) & ((1ULL << bitSize) - 1));
+}
+
+/**
+ * @brief Extract a two's complement bit field and sign-extend it to 32 bits
+ * @param pBuff Pointer to the report data
+ * @param bitOff Bit offset of the field
+ * @param bitSize Field width in bits (1..32)
+ * @return Sign-extended field value
+ */
+static inline int32_t HID_extractSigned(const uint8_t *pBuff, uint32_t bitOff, uint8_t bitSize)
+{
+    uint32_t unusedBits = 32 - bitSize;
+
+    return (int32_t)(HID_extractBits(pBuff, bitOff, bitSize) << unusedBits) >> unusedBits;
+}
+
+/**
+ * @brief Insert a bit field of arbitrary alignment into a report
+ * @param pBuff Pointer to the report data
+ * @param bitOff Bit offset of the field
+ * @param bitSize Field width in bits (1..32)
+ * @param value Value to store, truncated to bitSize bits
+ */
+static inline void HID_insertBits(uint8_t *pBuff, uint32_t bitOff, uint8_t bitSize, uint32_t value)
+{
+    uint8_t *pByte = pBuff + (bitOff >> 3);
+    uint32_t shift = bitOff & 0x07;
+    uint32_t byteCount = (shift + bitSize + 7) >> 3;
+    uint64_t mask = ((1ULL << bitSize) - 1) << shift;
+    uint64_t bits = ((uint64_t)value << shift) & mask;
+
+    for (uint32_t i = 0; i < byteCount; i++) {
+        pByte[i] = (uint8_t)((pByte[i] & ~(mask >> (8 * i))) | (bits >> (8 * i)));
+    }
+}
 
 /**
  * @brief USB HID Core Functions
@@ -214,6 +373,10 @@ int HID_parseReportDescriptor(uint8_t *pReport, uint16_t len, uint8_t *pType);
 int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num,
                struct USBHID_Device_t *pDev);
 void USBHID_close(struct USBHID_Device_t *pDev);
+int USBHID_getHidDescriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum,
+                                        struct USB_HID_Descriptor_t **ppHID_Desc);
+int USBHID_setReport(struct USBHID_Device_t *pDev, uint8_t reportType, uint8_t reportID,
+                                                        uint8_t *pData, uint16_t len);
 void USBHID_freeReportBuffer(struct USBHID_Device_t *pDev);
 int USBHID_fetchReport(struct USBHID_Device_t *pDev);
 int USBHID_getReportBuffer(struct USBHID_Device_t *pDev, uint8_t **ppBuff,
@@ -13,7 +13,8 @@
  * @details
  * Implements keyboard-specific HID report parsing including modifier keys. 
  * This includes functions open keyboard, fetch reports, and get/set modifier 
- * keys and key codes.
+ * keys and key codes. Both 6KRO key arrays and NKRO usage bitmaps are mapped
+ * from the compiled report layout and decoded into a single key bitmap.
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -28,7 +29,13 @@
 LOG_MODULE_REGISTER(hid_keyboard, LOG_LEVEL_INF);
 
 /* Private function prototypes -----------------------------------------------*/
-static int parse_hid_report(struct HID_Keyboard_t *pKbd, uint8_t *pReport, uint16_t len);
+static int parse_hid_report(struct HID_Keyboard_t *pKbd, struct HID_ReportLayout_t *pLayout);
+static void set_boot_layout(struct HID_Keyboard_t *pKbd);
+static void fill_data_descriptor(struct HID_DataDescriptor_t *pDesc, const struct HID_Field_t *pField,
+                                                                                    uint32_t idBits);
+static void add_bitmap_field(struct HID_Keyboard_t *pKbd, const struct HID_Field_t *pField);
+static bool bitmap_bit_off(const struct HID_Keyboard_t *pKbd, uint32_t usage, uint32_t *pBitOff);
+static bool is_error_report(const struct HID_Keyboard_t *pKbd, const uint8_t *pReport);
 
 
 /**
@@ -54,7 +61,16 @@ int hidKeyboard_Open(struct USBHID_Device_t *pHIDDev, struct HID_Keyboard_t *pKb
     memset(pKbd, 0x00, sizeof(struct HID_Keyboard_t));
     pKbd->hid_dev = pHIDDev;
 
-    ret = parse_hid_report(pKbd, pHIDDev->raw_hid_report_desc, pHIDDev->raw_hid_report_desc_len);
+    // Layout is normally compiled by USBHID_open()
+    if (true != pHIDDev->layout.is_compiled) {
+        ret = HID_compileReportLayout(pHIDDev->raw_hid_report_desc, pHIDDev->raw_hid_report_desc_len,
+                                                                                &pHIDDev->layout);
+        if (ret < 0) {
+            LOG_WRN("Failed to compile HID report layout, assuming boot keyboard");
+        }
+    }
+
+    ret = parse_hid_report(pKbd, &pHIDDev->layout);
     if (ret < 0) {
         LOG_ERR("Failed to parse HID report");
         return USBHID_NOT_SUPPORT;
@@ -116,6 +132,7 @@ int hidKeyboard_GetKey(struct HID_Keyboard_t *pKbd, uint32_t keyCode, uint32_t *
     int ret = -1;
     uint8_t *pReportBuff;
     uint8_t *pKeysField;
+    uint32_t bitOff;
 
     if (NULL == pKbd || NULL == pVal) {
         return USBHID_PARAM_INVALID;
@@ -126,11 +143,17 @@ int hidKeyboard_GetKey(struct HID_Keyboard_t *pKbd, uint32_t keyCode, uint32_t *
         return ret;
     }
 
+    // NKRO keys are a single bit test
+    if (true == bitmap_bit_off(pKbd, keyCode, &bitOff)) {
+        *pVal = (pReportBuff[bitOff >> 3] >> (bitOff & 0x07)) & 0x01;
+        return USBHID_SUCCESS;
+    }
+
     pKeysField = pReportBuff + pKbd->keys.report_buf_off;
 
     // Go through keys array to find the key code
     *pVal = 0;
-    for (int i = 0; i < HID_KBD_MAX_KEYS; i++) {
+    for (uint32_t i = 0; i < pKbd->keys.count; i++) {
         if (pKeysField[i] == keyCode) {
             *pVal = 1;
             break;
@@ -153,21 +176,34 @@ int hidKeyboard_SetKey(struct HID_Keyboard_t *pKbd, uint32_t keyCode, uint32_t v
     int ret = -1;
     uint8_t *pReportBuff;
     uint8_t *pKeysField;
+    uint32_t keyCount;
+    uint32_t bitOff;
 
     if (NULL == pKbd) {
         return USBHID_PARAM_INVALID;
     }
 
+    keyCount = pKbd->keys.count;
+
     ret = USBHID_getReportBuffer(pKbd->hid_dev, &pReportBuff, NULL, isLast);
     if (USBHID_SUCCESS != ret) {
         return ret;
     }
 
+    if (true == bitmap_bit_off(pKbd, keyCode, &bitOff)) {
+        if (0 != value) {
+            pReportBuff[bitOff >> 3] |= BIT(bitOff & 0x07);
+        } else {
+            pReportBuff[bitOff >> 3] &= ~BIT(bitOff & 0x07);
+        }
+        return USBHID_SUCCESS;
+    }
+
     pKeysField = pReportBuff + pKbd->keys.report_buf_off;
 
     if (0 != value) {
         // Add a key if not present already
-        for (int i = 0; i < HID_KBD_MAX_KEYS; i++) {
+        for (uint32_t i = 0; i < keyCount; i++) {
             if (0 == pKeysField[i]) {
                 pKeysField[i] = keyCode;
                 break;
@@ -179,14 +215,14 @@ int hidKeyboard_SetKey(struct HID_Keyboard_t *pKbd, uint32_t keyCode, uint32_t v
         }
     } else {
         // Delete key
-        for (int i = 0; i < HID_KBD_MAX_KEYS; i++) {
+        for (uint32_t i = 0; i < keyCount; i++) {
             if (pKeysField[i] == keyCode) {
                 pKeysField[i] = 0;
                 // Need to shift left remaining keys to fill the gap
-                for (int j = i; j < (HID_KBD_MAX_KEYS - 1); j++) {
+                for (uint32_t j = i; j < (keyCount - 1); j++) {
                     pKeysField[j] = pKeysField[j + 1];
                 }
-                pKeysField[HID_KBD_MAX_KEYS - 1] = 0;
+                pKeysField[keyCount - 1] = 0;
                 break;
             }
         }
@@ -224,6 +260,11 @@ int hidKeyboard_GetModifier(struct HID_Keyboard_t *pKbd, uint32_t modNum, uint32
         return ret;
     }
 
+    // Some NKRO keyboards carry the modifiers inside the usage bitmap
+    if (0 == pKbd->modifier.count) {
+        return hidKeyboard_GetKey(pKbd, HID_KBD_USAGE_LEFT_CTRL + modNum, pValue, isLast);
+    }
+
     pModField = pReportBuff + pKbd->modifier.report_buf_off;
     *pValue = (*pModField & (1 << (modNum & 0x07))) ? 1: 0;
 
@@ -259,6 +300,10 @@ int hidKeyboard_SetModifier(struct HID_Keyboard_t *pKbd, uint32_t modNum, uint32
         return ret;
     }
 
+    if (0 == pKbd->modifier.count) {
+        return hidKeyboard_SetKey(pKbd, HID_KBD_USAGE_LEFT_CTRL + modNum, value, isLast);
+    }
+
     pModField = pReportBuff + pKbd->modifier.report_buf_off;
 
     if (0 != value) {
@@ -270,10 +315,378 @@ int hidKeyboard_SetModifier(struct HID_Keyboard_t *pKbd, uint32_t modNum, uint32
     return USBHID_SUCCESS;
 }
 
+/**
+ * @brief Decode a whole keyboard report in one pass
+ * @param pKbd Pointer to the HID keyboard structure (opened)
+ * @param pReport Pointer to the raw report, as fetched from the device
+ * @param pState Pointer to the state to fill
+ * @return true on success, false if the report is an ErrorRollOver report
+ * @note An ErrorRollOver (or other error usage) report says nothing about the
+ * keys, `pState` is left untouched so the caller keeps the previous state.
+ */
+bool hidKeyboard_Decode(const struct HID_Keyboard_t *pKbd, const uint8_t *pReport,
+                                            struct HID_KeyboardState_t *pState) {
+
+    const uint8_t *pKeysField = pReport + pKbd->keys.report_buf_off;
+    uint32_t count = 0;
+
+    if (true == is_error_report(pKbd, pReport)) {
+        return false;
+    }
+
+    memset(pState, 0x00, sizeof(struct HID_KeyboardState_t));
+
+    if (0 != pKbd->modifier.count) {
+        pState->modifiers = pReport[pKbd->modifier.report_buf_off];
+    }
+
+    for (uint32_t i = 0; i < pKbd->keys.count; i++) {
+        uint8_t keyCode = pKeysField[i];
+        pState->keys[keyCode >> 3] |= BIT(keyCode & 0x07);
+    }
+
+    for (uint32_t r = 0; r < pKbd->bitmap_count; r++) {
+        const struct HID_KbdBitmap_t *pBitmap = &pKbd->bitmaps[r];
+        uint32_t bitOff = pBitmap->report_bit_off;
+        uint32_t usage = pBitmap->usage_min;
+
+        // Byte aligned bitmaps are OR-ed in whole, anything else bit by bit
+        if (0 == (bitOff & 0x07) && 0 == (usage & 0x07) && 0 == (pBitmap->count & 0x07)) {
+            for (uint32_t i = 0; i < (pBitmap->count >> 3); i++) {
+                pState->keys[(usage >> 3) + i] |= pReport[(bitOff >> 3) + i];
+            }
+        } else {
+            for (uint32_t i = 0; i < pBitmap->count; i++, usage++) {
+                if (0 != HID_extractBits(pReport, bitOff + i, 1)) {
+                    pState->keys[usage >> 3] |= BIT(usage & 0x07);
+                }
+            }
+        }
+    }
+
+    // Modifier usages live in their own byte, No Event is not a key
+    pState->modifiers |= pState->keys[HID_KBD_USAGE_LEFT_CTRL >> 3];
+    pState->keys[HID_KBD_USAGE_LEFT_CTRL >> 3] = 0;
+    pState->keys[0] &= ~(BIT(HID_KBD_USAGE_FIRST_KEY) - 1);
+
+    for (uint32_t i = 0; i < HID_KBD_BITMAP_BYTES; i++) {
+        count += POPCOUNT(pState->keys[i]);
+    }
+    pState->key_count = count;
+
+    return true;
+}
+
+/**
+ * @brief Encode a keyboard state into the keyboard's report format
+ * @param pKbd Pointer to the HID keyboard structure (opened)
+ * @param pState Pointer to the state to encode
+ * @param pReport Pointer to the report buffer (`report_length` bytes)
+ * @return None
+ * @note Keys the format cannot hold turn a key array into ErrorRollOver.
+ */
+void hidKeyboard_Encode(const struct HID_Keyboard_t *pKbd, const struct HID_KeyboardState_t *pState,
+                                                                            uint8_t *pReport) {
+
+    uint8_t *pKeysField = pReport + pKbd->keys.report_buf_off;
+    uint32_t slot = 0;
+    uint32_t bitOff;
+    bool isOverflow = false;
+
+    memset(pReport, 0x00, pKbd->report_length);
+
+    if (0 != pKbd->report_id_offset) {
+        pReport[0] = pKbd->report_id;
+    }
+
+    for (uint32_t usage = HID_KBD_USAGE_FIRST_KEY; usage < (HID_KBD_BITMAP_BYTES * 8); usage++) {
+        if (true != hidKeyboard_StateHasKey(pState, usage)) {
+            continue;
+        }
+
+        if (true == bitmap_bit_off(pKbd, usage, &bitOff)) {
+            pReport[bitOff >> 3] |= BIT(bitOff & 0x07);
+        } else if (slot < pKbd->keys.count) {
+            pKeysField[slot++] = usage;
+        } else {
+            isOverflow = true;
+        }
+    }
+
+    if (0 != pKbd->modifier.count) {
+        pReport[pKbd->modifier.report_buf_off] = pState->modifiers;
+    } else {
+        for (uint32_t i = 0; i < 8; i++) {
+            if (0 != (pState->modifiers & BIT(i)) &&
+                        true == bitmap_bit_off(pKbd, HID_KBD_USAGE_LEFT_CTRL + i, &bitOff)) {
+                pReport[bitOff >> 3] |= BIT(bitOff & 0x07);
+            }
+        }
+    }
+
+    if (true == isOverflow) {
+        memset(pKeysField, HID_KBD_USAGE_ERR_ROLLOVER, pKbd->keys.count);
+    }
+}
+
+/**
+ * @brief Decode the current (or last) fetched report
+ * @param pKbd Pointer to the HID keyboard structure
+ * @param pState Pointer to the state to fill
+ * @param isLast Flag indicating whether this is the last report
+ * @return 0 on success, error code otherwise
+ * @note An ErrorRollOver report returns the state decoded before it.
+ */
+int hidKeyboard_GetState(struct HID_Keyboard_t *pKbd, struct HID_KeyboardState_t *pState, bool isLast) {
+
+    int ret = -1;
+    uint8_t *pReportBuff;
+
+    if (NULL == pKbd || NULL == pState) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    ret = USBHID_getReportBuffer(pKbd->hid_dev, &pReportBuff, NULL, isLast);
+    if (USBHID_SUCCESS != ret) {
+        return ret;
+    }
+
+    if (true != hidKeyboard_Decode(pKbd, pReportBuff, pState)) {
+        *pState = pKbd->last_state;
+    } else if (true != isLast) {
+        pKbd->last_state = *pState;
+    }
+
+    return USBHID_SUCCESS;
+}
+
+/**
+ * @brief Reset a key event table: no bindings, all keys released
+ * @param pTable Pointer to the key event table
+ * @return None
+ */
+void hidKeyboard_InitEvents(struct HID_KeyEventTable_t *pTable) {
+
+    if (NULL == pTable) {
+        return;
+    }
+
+    memset(pTable, 0x00, sizeof(struct HID_KeyEventTable_t));
+    memset(pTable->key_map, HID_KBD_ACTION_NONE, sizeof(pTable->key_map));
+}
+
+/**
+ * @brief Bind an action to a key, replacing any previous binding of that key
+ * @param pTable Pointer to the key event table
+ * @param keyCode Key code (modifiers as HID_KBD_USAGE_LEFT_CTRL + bit)
+ * @param eventMask HID_KEY_EVENT_PRESS and/or HID_KEY_EVENT_RELEASE
+ * @param cb Action to run
+ * @param pUserData Passed to the action as is
+ * @return 0 on success, error code otherwise
+ */
+int hidKeyboard_BindKey(struct HID_KeyEventTable_t *pTable, uint8_t keyCode, uint8_t eventMask,
+                                                    HID_KeyActionCb_t cb, void *pUserData) {
+
+    uint8_t slot = HID_KBD_ACTION_NONE;
+
+    if (NULL == pTable || NULL == cb || 0 == eventMask) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    slot = pTable->key_map[keyCode];
+
+    if (HID_KBD_ACTION_NONE == slot) {
+        for (uint8_t i = 0; i < HID_KBD_MAX_ACTIONS; i++) {
+            if (NULL == pTable->actions[i].cb) {
+                slot = i;
+                break;
+            }
+        }
+    }
+
+    if (HID_KBD_ACTION_NONE == slot) {
+        LOG_ERR("No free key action slot for key 0x%02X", keyCode);
+        return USBHID_ALLOC_FAILED;
+    }
+
+    pTable->actions[slot].cb = cb;
+    pTable->actions[slot].pUserData = pUserData;
+    pTable->actions[slot].event_mask = eventMask;
+    pTable->key_map[keyCode] = slot;
+
+    return USBHID_SUCCESS;
+}
+
+/**
+ * @brief Remove the action bound to a key
+ * @param pTable Pointer to the key event table
+ * @param keyCode Key code to unbind
+ * @return 0 on success, error code otherwise
+ */
+int hidKeyboard_UnbindKey(struct HID_KeyEventTable_t *pTable, uint8_t keyCode) {
+
+    uint8_t slot;
+
+    if (NULL == pTable) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    slot = pTable->key_map[keyCode];
+    if (HID_KBD_ACTION_NONE == slot) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    memset(&pTable->actions[slot], 0x00, sizeof(struct HID_KeyAction_t));
+    pTable->key_map[keyCode] = HID_KBD_ACTION_NONE;
+
+    return USBHID_SUCCESS;
+}
+
+/**
+ * @brief Diff a decoded state against the previous one and run bound actions
+ * @param pTable Pointer to the key event table
+ * @param pState Pointer to the new decoded keyboard state
+ * @return Number of keys (modifiers included) that changed
+ * @note Only changed bits are visited, in ascending key code order.
+ */
+uint32_t hidKeyboard_DispatchEvents(struct HID_KeyEventTable_t *pTable, const struct HID_KeyboardState_t *pState) {
+
+    uint32_t eventCount = 0;
+
+    if (NULL == pTable || NULL == pState) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < HID_KBD_BITMAP_BYTES; i++) {
+        uint8_t curr = pState->keys[i];
+        uint8_t diff = pTable->last.keys[i] ^ curr;
+
+        // Modifiers take the place of their (always empty) usage byte
+        if ((HID_KBD_USAGE_LEFT_CTRL >> 3) == i) {
+            curr = pState->modifiers;
+            diff = pTable->last.modifiers ^ curr;
+        }
+
+        while (0 != diff) {
+            uint8_t bit = find_lsb_set(diff) - 1;
+            uint8_t keyCode = (i << 3) | bit;
+            bool isPressed = (0 != (curr & BIT(bit)));
+            uint8_t slot = pTable->key_map[keyCode];
+
+            diff &= (diff - 1);
+            eventCount++;
+
+            if (HID_KBD_ACTION_NONE == slot) {
+                continue;
+            }
+
+            if (0 != (pTable->actions[slot].event_mask & (isPressed ? HID_KEY_EVENT_PRESS : HID_KEY_EVENT_RELEASE))) {
+                pTable->actions[slot].cb(keyCode, isPressed, pTable->actions[slot].pUserData);
+            }
+        }
+    }
+
+    pTable->last = *pState;
+
+    return eventCount;
+}
+
 /* --------------------------------------------------------------------------
  * HELPER FUNCTIONS
  * -------------------------------------------------------------------------*/
-static int parse_hid_report(struct HID_Keyboard_t *pKbd, uint8_t *pReport, uint16_t len) 
+static int parse_hid_report(struct HID_Keyboard_t *pKbd, struct HID_ReportLayout_t *pLayout)
+{
+    const struct HID_ReportInfo_t *pInfo = NULL;
+    const struct HID_Field_t *pMod = NULL;
+    const struct HID_Field_t *pKeys = NULL;
+    uint32_t idBits = 0;
+
+    if (true == pLayout->is_compiled) {
+        // The first report carrying Keyboard/Keypad input is the key report
+        for (uint32_t i = 0; i < pLayout->field_count; i++) {
+            const struct HID_Field_t *pField = &pLayout->fields[i];
+
+            if (HID_REPORT_TYPE_INPUT == pField->report_type && 0 == (pField->flags & HID_FIELD_CONSTANT) &&
+                                            HID_UP_KEYBOARD == (pField->usage & 0xFFFF0000)) {
+                pInfo = HID_getReportInfo(pLayout, pField->report_id);
+                break;
+            }
+        }
+    }
+
+    if (NULL == pInfo) {
+        set_boot_layout(pKbd);
+        return 0;
+    }
+
+    for (uint32_t i = pInfo->field_first; i < (uint32_t)(pInfo->field_first + pInfo->field_count); i++) {
+        const struct HID_Field_t *pField = &pLayout->fields[i];
+
+        if (HID_REPORT_TYPE_INPUT != pField->report_type || 0 != (pField->flags & HID_FIELD_CONSTANT) ||
+                                            HID_UP_KEYBOARD != (pField->usage & 0xFFFF0000)) {
+            continue;
+        }
+
+        if (0 == (pField->flags & HID_FIELD_VARIABLE)) {
+            // Key array, one byte per usage index
+            if (NULL == pKeys && 8 == pField->bit_size && 0 == (pField->bit_offset & 0x07) &&
+                        0 == pField->logical_minimum && 0 == (pField->usage & 0xFFFF)) {
+                pKeys = pField;
+            }
+        } else if (1 == pField->bit_size) {
+            if (NULL == pMod && (HID_UP_KEYBOARD | HID_KBD_USAGE_LEFT_CTRL) == pField->usage &&
+                                    8 == pField->count && 0 == (pField->bit_offset & 0x07)) {
+                pMod = pField;
+            } else {
+                add_bitmap_field(pKbd, pField);
+            }
+        }
+    }
+
+    if (NULL == pKeys && 0 == pKbd->bitmap_count) {
+        LOG_WRN("No key array or bitmap in report %d, assuming boot keyboard", pInfo->report_id);
+        set_boot_layout(pKbd);
+        return 0;
+    }
+
+    // The Report ID byte always leads the report on the wire
+    if (true == pLayout->has_report_id) {
+        pKbd->report_id_offset = 1;
+        idBits = 8;
+    }
+
+    pKbd->report_id = pInfo->report_id;
+    pKbd->report_length = pKbd->report_id_offset + (pInfo->input_bits + 7) / 8;
+
+    if (NULL != pMod) {
+        fill_data_descriptor(&pKbd->modifier, pMod, idBits);
+        LOG_INF("  -> MODIFIER: byte=%d", pKbd->modifier.report_buf_off);
+    }
+
+    if (NULL != pKeys) {
+        fill_data_descriptor(&pKbd->keys, pKeys, idBits);
+        LOG_INF("  -> KEYS: byte=%d count=%d", pKbd->keys.report_buf_off, pKbd->keys.count);
+    }
+
+    for (uint32_t r = 0; r < pKbd->bitmap_count; r++) {
+        pKbd->bitmaps[r].report_bit_off += idBits;
+        LOG_INF("  -> BITMAP: bit=%d usages=0x%02X..0x%02X", pKbd->bitmaps[r].report_bit_off,
+                        pKbd->bitmaps[r].usage_min, pKbd->bitmaps[r].usage_min + pKbd->bitmaps[r].count - 1);
+    }
+
+    // Only the key report is delivered, consumer / system control reports are dropped
+    if (true == pLayout->has_report_id) {
+        for (uint32_t i = 0; i < pLayout->report_count; i++) {
+            pLayout->reports[i].route = HID_REPORT_ROUTE_DROP;
+        }
+        HID_setReportRoute(pLayout, pKbd->report_id, HID_REPORT_ROUTE_ACCEPT);
+        LOG_INF("  -> REPORT ID: %d (%d reports in descriptor)", pKbd->report_id, pLayout->report_count);
+    }
+
+    return 0;
+}
+
+static void set_boot_layout(struct HID_Keyboard_t *pKbd)
 {
     struct HID_DataDescriptor_t *pKey = &pKbd->keys;
     struct HID_DataDescriptor_t *pMod = &pKbd->modifier;
@@ -299,6 +712,85 @@ static int parse_hid_report(struct HID_Keyboard_t *pKbd, uint8_t *pReport, uint1
     // Up to 6 simultaneous keys
     pKey->count = HID_KBD_MAX_KEYS;
     pKey->report_buf_off = HID_KBD_KEYS_OFFSET;
-    
-    return 0;
-}
\ No newline at end of file
+}
+
+static void fill_data_descriptor(struct HID_DataDescriptor_t *pDesc, const struct HID_Field_t *pField,
+                                                                                    uint32_t idBits)
+{
+    memset(pDesc, 0x00, sizeof(struct HID_DataDescriptor_t));
+    pDesc->logical_minimum = pField->logical_minimum;
+    pDesc->logical_maximum = pField->logical_maximum;
+    pDesc->size = pField->bit_size;
+    pDesc->count = pField->count;
+    pDesc->report_bit_off = idBits + pField->bit_offset;
+    pDesc->report_buf_off = pDesc->report_bit_off / 8;
+}
+
+static void add_bitmap_field(struct HID_Keyboard_t *pKbd, const struct HID_Field_t *pField)
+{
+    struct HID_KbdBitmap_t *pLast = NULL;
+    uint32_t usage = pField->usage & 0xFFFF;
+    uint32_t count;
+
+    // Usages past the state bitmap cannot be represented
+    if (usage >= (HID_KBD_BITMAP_BYTES * 8)) {
+        return;
+    }
+    count = MIN(pField->count, (HID_KBD_BITMAP_BYTES * 8) - usage);
+
+    // Offsets are report relative here, the Report ID byte is added once all runs are known
+    if (0 != pKbd->bitmap_count) {
+        pLast = &pKbd->bitmaps[pKbd->bitmap_count - 1];
+    }
+    if (NULL != pLast && pField->bit_offset == pLast->report_bit_off + pLast->count &&
+                                                    usage == (uint32_t)pLast->usage_min + pLast->count) {
+        pLast->count += count;
+        return;
+    }
+
+    if (pKbd->bitmap_count >= HID_KBD_MAX_BITMAPS) {
+        LOG_WRN("More than %d key bitmaps, ignoring usages 0x%02X..0x%02X", HID_KBD_MAX_BITMAPS,
+                                                                        usage, usage + count - 1);
+        return;
+    }
+
+    pKbd->bitmaps[pKbd->bitmap_count].report_bit_off = pField->bit_offset;
+    pKbd->bitmaps[pKbd->bitmap_count].usage_min = usage;
+    pKbd->bitmaps[pKbd->bitmap_count].count = count;
+    pKbd->bitmap_count++;
+}
+
+static bool bitmap_bit_off(const struct HID_Keyboard_t *pKbd, uint32_t usage, uint32_t *pBitOff)
+{
+    for (uint32_t r = 0; r < pKbd->bitmap_count; r++) {
+        const struct HID_KbdBitmap_t *pBitmap = &pKbd->bitmaps[r];
+
+        if (usage >= pBitmap->usage_min && usage < (uint32_t)(pBitmap->usage_min + pBitmap->count)) {
+            *pBitOff = pBitmap->report_bit_off + (usage - pBitmap->usage_min);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool is_error_report(const struct HID_Keyboard_t *pKbd, const uint8_t *pReport)
+{
+    const uint8_t *pKeysField = pReport + pKbd->keys.report_buf_off;
+    uint32_t bitOff;
+
+    // ErrorRollOver, POSTFail and ErrorUndefined fill the key array
+    for (uint32_t i = 0; i < pKbd->keys.count; i++) {
+        if (pKeysField[i] >= HID_KBD_USAGE_ERR_ROLLOVER && pKeysField[i] < HID_KBD_USAGE_FIRST_KEY) {
+            return true;
+        }
+    }
+
+    for (uint32_t usage = HID_KBD_USAGE_ERR_ROLLOVER; usage < HID_KBD_USAGE_FIRST_KEY; usage++) {
+        if (true == bitmap_bit_off(pKbd, usage, &bitOff) && 0 != HID_extractBits(pReport, bitOff, 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -27,7 +27,15 @@
 LOG_MODULE_REGISTER(hid_mouse, LOG_LEVEL_INF);
 
 /* Private function prototypes -----------------------------------------------*/
-static int parse_hid_report(struct HID_Mouse_t *pMouse, uint8_t *pReport, uint16_t len);
+static int map_layout_fields(struct HID_Mouse_t *pMouse, struct HID_ReportLayout_t *pLayout);
+static void fill_data_descriptor(struct HID_DataDescriptor_t *pDesc, const struct HID_Field_t *pField,
+                                            uint32_t index, uint32_t count, uint32_t idBits);
+static int read_axis(struct HID_Mouse_t *pMouse, const struct HID_DataDescriptor_t *pDesc,
+                                    uint32_t axisNum, int32_t *pValue, bool isLast);
+static inline int32_t decode_axis(const uint8_t *pReport, const struct HID_DataDescriptor_t *pDesc,
+                                                                            uint32_t bitOff);
+static inline void encode_axis(uint8_t *pReport, const struct HID_DataDescriptor_t *pDesc,
+                                                                uint32_t bitOff, int32_t value);
 
 /**
  * @brief HID Mouse Open
@@ -53,7 +61,17 @@ int hidMouse_Open(struct USBHID_Device_t *pHIDDev, struct HID_Mouse_t *pMouse) {
     pMouse->hid_dev = pHIDDev;
     pMouse->has_wheel = false;
 
-    ret = parse_hid_report(pMouse, pHIDDev->raw_hid_report_desc, pHIDDev->raw_hid_report_desc_len);
+    // Layout is normally compiled by USBHID_open()
+    if (true != pHIDDev->layout.is_compiled) {
+        ret = HID_compileReportLayout(pHIDDev->raw_hid_report_desc, pHIDDev->raw_hid_report_desc_len,
+                                                                                &pHIDDev->layout);
+        if (ret < 0) {
+            LOG_ERR("Failed to compile HID report layout");
+            return USBHID_NOT_SUPPORT;
+        }
+    }
+
+    ret = map_layout_fields(pMouse, &pHIDDev->layout);
 
     if (ret < 0) {
         LOG_ERR("Failed to parse HID report");
@@ -92,7 +110,8 @@ void hidMouse_Close(struct HID_Mouse_t *pMouse) {
 /**
  * @brief Fetch report from the device and parse it into a HID Mouse structure
  * @param pMouse Pointer to the HID device structure
- * @return 0 on success, error code otherwise
+ * @return 0 on success, USBHID_REPORT_FILTERED for reports that do not carry
+ * the pointer, error code otherwise
  */
 int hidMouse_FetchReport(struct HID_Mouse_t *pMouse) {
 
@@ -102,49 +121,9 @@ int hidMouse_FetchReport(struct HID_Mouse_t *pMouse) {
         return ret;
     }
 
+    // Reports with another Report ID are dropped by the layout routing
     ret = USBHID_fetchReport(pMouse->hid_dev);
-    
-    // Only run detection when Report ID exists in descriptor
-    if (USBHID_SUCCESS == ret && true == pMouse->has_report_id_declared && 0 == pMouse->report_id_offset) {
-        uint8_t *pReportBuff;
-        uint32_t actualReportLen;
-        uint8_t byte0 = 0;
-        uint8_t byte1 = 0;
-        bool isReportID = (1 == byte0);
-        bool isButtonsMaybe = (byte0 <= 0x1F);
-        bool isButtons = (byte1 <= 0x1F);
-        
-        if (USBHID_SUCCESS != USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, &actualReportLen, false)) {
-            return ret;
-        }
-        
-        byte0 = pReportBuff[0];
-        byte1 = pReportBuff[1];
-        
-        LOG_DBG("Report ID detection: byte0=0x%02X byte1=0x%02X", byte0, byte1);
-    
-        // If byte 0 is equal to a constant consistently, that's the Report ID
-        isReportID = (byte0 == 1);
-        isButtonsMaybe = (byte0 <= 0x1F);
-        isButtons = (byte1 <= 0x1F);
-        
-        if (true == isReportID && true  == isButtons) {
-            // Report ID is not stripped by CH375
-            // byte0 = Report ID, byte1 = actual button data
-            pMouse->report_id_offset = 1;
-            pMouse->button.report_buf_off += 1;
-            pMouse->orientation.report_buf_off += 1;
-            if (true == pMouse->has_wheel) {
-                pMouse->wheel.report_buf_off += 1;
-            }
-        
-            LOG_INF("  Adjusted offsets: BTN=%d ORIENT=%d WHEEL=%d", pMouse->button.report_buf_off, 
-                                pMouse->orientation.report_buf_off, pMouse->wheel.report_buf_off);
-        } else {
-            // Assume Report ID stripped by CH375
-            pMouse->report_id_offset = 0;
-        }
-    }
+
     return ret;
 }
 
@@ -161,9 +140,6 @@ int hidMouse_GetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
     int ret = -1;
     struct HID_DataDescriptor_t *pButtonDesc;
     uint8_t *pReportBuff;
-    uint8_t *pFieldBuff;
-    uint8_t byteOff = buttonNum / 8;
-    uint8_t bitOff = buttonNum % 8;
 
     if (NULL == pMouse || NULL == pValue) {
         return USBHID_PARAM_INVALID;
@@ -180,8 +156,8 @@ int hidMouse_GetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
     }
 
     pButtonDesc = &pMouse->button;
-    pFieldBuff = pReportBuff + pButtonDesc->report_buf_off;
-    *pValue = (pFieldBuff[byteOff] & (0x01 << bitOff)) ? 1 : 0;
+    *pValue = (0 != HID_extractBits(pReportBuff, pButtonDesc->report_bit_off + 
+                                    (buttonNum * pButtonDesc->size), pButtonDesc->size)) ? 1 : 0;
 
     return USBHID_SUCCESS;
 }
@@ -199,9 +175,6 @@ int hidMouse_SetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
     int ret = -1;
     struct HID_DataDescriptor_t *pButtonDesc;
     uint8_t *pReportBuff;
-    uint8_t *pFieldBuff;
-    uint8_t byteOff = buttonNum / 8;
-    uint8_t bitOff = buttonNum % 8;
 
     if (NULL == pMouse) {
         return USBHID_PARAM_INVALID;
@@ -218,13 +191,8 @@ int hidMouse_SetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
     }
 
     pButtonDesc = &pMouse->button;
-    pFieldBuff = pReportBuff + pButtonDesc->report_buf_off;
-
-    if (0 != value) {
-        pFieldBuff[byteOff] |= (0x01 << bitOff);
-    } else {
-        pFieldBuff[byteOff] &= ~(0x01 << bitOff);
-    }
+    HID_insertBits(pReportBuff, pButtonDesc->report_bit_off + (buttonNum * pButtonDesc->size),
+                                                    pButtonDesc->size, (0 != value) ? 1 : 0);
 
     return USBHID_SUCCESS;
 }
@@ -239,41 +207,15 @@ int hidMouse_SetButton(struct HID_Mouse_t *pMouse, uint32_t buttonNum, uint32_t
  */
 int hidMouse_GetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_t *pValue, bool isLast) {
 
-    int ret = -1;
-    struct HID_DataDescriptor_t *pDesc;
-    uint8_t *pReportBuff;
-    uint8_t *pFieldBuff;
-    uint8_t valueByteSize;
+    const struct HID_DataDescriptor_t *pOrientDesc;
 
     if (NULL == pMouse || NULL == pValue) {
         return USBHID_PARAM_INVALID;
     }
     
     // Wheel is stored separately
-    if (2 == axisNum && true == pMouse->has_wheel) {
-        pDesc = &pMouse->wheel;
-        
-        ret = USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, NULL, isLast);
-        if (USBHID_SUCCESS != ret) {
-            return ret;
-        }
-        
-        pFieldBuff = pReportBuff + pDesc->report_buf_off;
-        valueByteSize = pDesc->size / 8;
-        
-        // Wheel is typically 8-bit signed
-        if (1 == valueByteSize) {
-            *pValue = ((int8_t *)pFieldBuff)[0];
-        } else if (2 == valueByteSize) {
-            uint16_t raw;
-            memcpy(&raw, pFieldBuff, sizeof(raw));
-            raw = sys_le16_to_cpu(raw);
-            *pValue = (int32_t)(int16_t)raw;
-        } else {
-            *pValue = 0;
-        }
-        
-        return USBHID_SUCCESS;
+    if (HID_MOUSE_AXIS_WHEEL == axisNum && true == pMouse->has_wheel) {
+        return read_axis(pMouse, &pMouse->wheel, axisNum, pValue, isLast);
     }
 
     // X/Y axes (0 and 1)
@@ -282,53 +224,8 @@ int hidMouse_GetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_
         return USBHID_PARAM_INVALID;
     }
 
-    ret = USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, NULL, isLast);
-    if (USBHID_SUCCESS != ret) {
-        return ret;
-    }
-
-    pDesc = &pMouse->orientation;
-    pFieldBuff = pReportBuff + pDesc->report_buf_off;
-    valueByteSize = pDesc->size / 8;
-
-    if (0 == valueByteSize) {
-        LOG_ERR("Invalid value size: size=%d bits", pDesc->size);
-        return USBHID_ERROR;
-    }
-
-    switch (valueByteSize) {
-        case 1: {
-            *pValue = (int32_t)((int8_t)pFieldBuff[axisNum]);
-            break;
-        }
-
-        case 2: {
-            // Read 16-bit value as little-endian, then sign-extend to 32-bit
-            uint8_t *pAxisStart = pFieldBuff + (axisNum * 2);
-            uint16_t raw;
-            memcpy(&raw, pAxisStart, sizeof(raw));
-            raw = sys_le16_to_cpu(raw);
-            // Cast to int16_t for sign extension
-            *pValue = (int32_t)(int16_t)raw;
-            break;
-        }
-
-        case 4: {
-            // Read 32-bit value as little-endian
-            uint8_t *pAxisStart = pFieldBuff + (axisNum * 4);
-            uint32_t raw;
-            memcpy(&raw, pAxisStart, sizeof(raw));
-            *pValue = (int32_t)sys_le32_to_cpu(raw);
-            break;
-        }
-
-        default: {
-            LOG_ERR("Unexpected value size: %d", valueByteSize);
-            return USBHID_ERROR;
-        }
-    }
-
-    return USBHID_SUCCESS;
+    pOrientDesc = (HID_MOUSE_AXIS_Y == axisNum) ? &pMouse->orientation_y : &pMouse->orientation;
+    return read_axis(pMouse, pOrientDesc, axisNum, pValue, isLast);
 }
 
 /**
@@ -338,14 +235,13 @@ int hidMouse_GetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_
  * @param value Value to be set to the mouse orientation axes
  * @param isLast Flag indicating if this is the last report
  * @return 0 on success, error code otherwise
+ * @note The value is truncated to the field width, callers clamp if needed.
  */
 int hidMouse_SetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_t value, bool isLast) {
 
     int ret = -1;
     struct HID_DataDescriptor_t *pOrientDesc;
     uint8_t *pReportBuff;
-    uint8_t *pFieldBuff;
-    uint8_t valueByteSize;
 
     if (NULL == pMouse) {
         return USBHID_PARAM_INVALID;
@@ -356,288 +252,261 @@ int hidMouse_SetOrientation(struct HID_Mouse_t *pMouse, uint32_t axisNum, int32_
         return USBHID_PARAM_INVALID;
     }
 
+    pOrientDesc = (HID_MOUSE_AXIS_Y == axisNum) ? &pMouse->orientation_y : &pMouse->orientation;
+    if (0 == pOrientDesc->size || pOrientDesc->size > 32) {
+        LOG_ERR("Invalid value size: size=%d bits", pOrientDesc->size);
+        return USBHID_ERROR;
+    }
+
     ret = USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, NULL, isLast);
     if (USBHID_SUCCESS != ret) {
         return ret;
     }
 
-    pOrientDesc = &pMouse->orientation;
-    pFieldBuff = pReportBuff + pOrientDesc->report_buf_off;
-    valueByteSize = pOrientDesc->size / 8;
+    HID_insertBits(pReportBuff, pMouse->axis_bit_off[axisNum], pOrientDesc->size, (uint32_t)value);
 
-    if (0 == valueByteSize) {
-        LOG_ERR("Invalid value size: size=%d bits", pOrientDesc->size);
-        return USBHID_ERROR;
-    }
+    return USBHID_SUCCESS;
+}
 
-    switch (valueByteSize) {
-        case 1: {
-            ((int8_t *)pFieldBuff)[axisNum] = (int8_t)value;
-            break;
-        }
+/**
+ * @brief Decode a whole mouse report in one pass
+ * @param pMouse Pointer to the HID device structure (opened)
+ * @param pReport Pointer to the raw report, as fetched from the device
+ * @param pState Pointer to the state to fill
+ * @return None
+ * @note No validation on purpose, field sizes and offsets were checked by
+ * hidMouse_Open(). Buttons beyond HID_MOUSE_MAX_BUTTONS are ignored.
+ */
+void hidMouse_Decode(const struct HID_Mouse_t *pMouse, const uint8_t *pReport, struct HID_MouseState_t *pState) {
 
-        case 2: {
-            // Write as little-endian 16-bit
-            uint8_t *pAxisStart = pFieldBuff + (axisNum * 2);
-            uint16_t raw = sys_cpu_to_le16((uint16_t)(int16_t)value);
-            memcpy(pAxisStart, &raw, sizeof(raw));
-            break;
-        }
+    const struct HID_DataDescriptor_t *pBtn = &pMouse->button;
+    uint32_t buttonCount = MIN(pBtn->count, HID_MOUSE_MAX_BUTTONS);
 
-        case 4: {
-            // Write as little-endian 32-bit
-            uint8_t *pAxisStart = pFieldBuff + (axisNum * 4);
-            uint32_t raw = sys_cpu_to_le32((uint32_t)value);
-            memcpy(pAxisStart, &raw, sizeof(raw));
-            break;
+    // Usual case is a run of 1-bit buttons, fetch them with a single extraction
+    if (1 == pBtn->size) {
+        pState->buttons = (0 != buttonCount) ? HID_extractBits(pReport, pBtn->report_bit_off, buttonCount) : 0;
+    } else {
+        pState->buttons = 0;
+        for (uint32_t i = 0; i < buttonCount; i++) {
+            if (0 != HID_extractBits(pReport, pBtn->report_bit_off + (i * pBtn->size), pBtn->size)) {
+                pState->buttons |= BIT(i);
+            }
         }
+    }
+
+    pState->x = decode_axis(pReport, &pMouse->orientation, pMouse->axis_bit_off[HID_MOUSE_AXIS_X]);
+    pState->y = decode_axis(pReport, &pMouse->orientation_y, pMouse->axis_bit_off[HID_MOUSE_AXIS_Y]);
+    pState->wheel = (true == pMouse->has_wheel) ?
+                    decode_axis(pReport, &pMouse->wheel, pMouse->axis_bit_off[HID_MOUSE_AXIS_WHEEL]) : 0;
+}
 
-        default: {
-            LOG_ERR("Unexpected value size: %d", valueByteSize);
-            return USBHID_ERROR;
+/**
+ * @brief Encode a mouse state back into the device's own report format
+ * @param pMouse Pointer to the HID device structure (opened)
+ * @param pState Pointer to the state to encode
+ * @param pReport Pointer to the report to update in place
+ * @return None
+ * @note Only the button and axis bits are written, the Report ID and any
+ * other field keep their value. Axes are clamped to the logical range.
+ */
+void hidMouse_Encode(const struct HID_Mouse_t *pMouse, const struct HID_MouseState_t *pState, uint8_t *pReport) {
+
+    const struct HID_DataDescriptor_t *pBtn = &pMouse->button;
+    uint32_t buttonCount = MIN(pBtn->count, HID_MOUSE_MAX_BUTTONS);
+
+    if (1 == pBtn->size) {
+        if (0 != buttonCount) {
+            HID_insertBits(pReport, pBtn->report_bit_off, buttonCount, pState->buttons);
+        }
+    } else {
+        for (uint32_t i = 0; i < buttonCount; i++) {
+            HID_insertBits(pReport, pBtn->report_bit_off + (i * pBtn->size), pBtn->size,
+                                                    (0 != (pState->buttons & BIT(i))) ? 1 : 0);
         }
     }
 
+    encode_axis(pReport, &pMouse->orientation, pMouse->axis_bit_off[HID_MOUSE_AXIS_X], pState->x);
+    encode_axis(pReport, &pMouse->orientation_y, pMouse->axis_bit_off[HID_MOUSE_AXIS_Y], pState->y);
+    if (true == pMouse->has_wheel) {
+        encode_axis(pReport, &pMouse->wheel, pMouse->axis_bit_off[HID_MOUSE_AXIS_WHEEL], pState->wheel);
+    }
+}
+
+/**
+ * @brief Decode the current (or last) fetched report
+ * @param pMouse Pointer to the HID device structure
+ * @param pState Pointer to the state to fill
+ * @param isLast Flag indicating if this is the last report
+ * @return 0 on success, error code otherwise
+ */
+int hidMouse_GetState(struct HID_Mouse_t *pMouse, struct HID_MouseState_t *pState, bool isLast) {
+
+    int ret = -1;
+    uint8_t *pReportBuff;
+
+    if (NULL == pMouse || NULL == pState) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    ret = USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, NULL, isLast);
+    if (USBHID_SUCCESS != ret) {
+        return ret;
+    }
+
+    hidMouse_Decode(pMouse, pReportBuff, pState);
+
     return USBHID_SUCCESS;
 }
 
 /* --------------------------------------------------------------------------
  * HELPER FUNCTIONS
  * -------------------------------------------------------------------------*/
-static int parse_hid_report(struct HID_Mouse_t *pMouse, uint8_t *pReport, uint16_t len) 
+static int map_layout_fields(struct HID_Mouse_t *pMouse, struct HID_ReportLayout_t *pLayout)
 {
-    struct HID_Item_t item;
-    struct HID_DataDescriptor_t *pBtn = &pMouse->button;
-    struct HID_DataDescriptor_t *pOrient = &pMouse->orientation;
-    struct HID_DataDescriptor_t *pWheel = &pMouse->wheel;
-    uint8_t *pHIDRep = pReport;
-    uint8_t *pHIDRepEnd = pReport + len;
-    uint32_t usagePage = 0;
-    uint32_t usage = 0;
-    uint32_t usages[8];
-    uint32_t usageCount = 0;
-    int32_t logicalMin = 0;
-    int32_t logicalMax = 0;
-    uint32_t reportSize = 0;
-    uint32_t reportCount = 0;
-    uint32_t reportOffset = 0;
-    bool foundButtons = false;
-    bool foundOrientation = false;
-    bool foundWheel = false;
-    bool hasReportId = false;
-    uint8_t reportIdValue = 0;
-    bool inMouseCollection = false;
-    int collectionDepth = 0;
-
-    while (pHIDRep < pHIDRepEnd) {
-        uint8_t *oldPtr = pHIDRep;
-        pHIDRep = HID_fetchItem(pHIDRep, pHIDRepEnd, &item);
-        if (NULL == pHIDRep) {
-            LOG_ERR("Failed to fetch HID item at offset %d", (int)(oldPtr - pReport));
+    const struct HID_Field_t *pBtn;
+    const struct HID_Field_t *pX;
+    const struct HID_Field_t *pY;
+    const struct HID_Field_t *pWheel;
+    const struct HID_ReportInfo_t *pInfo;
+    uint32_t appUsage = 0;
+    uint32_t btnIdx = 0;
+    uint32_t xIdx = 0;
+    uint32_t yIdx = 0;
+    uint32_t wheelIdx = 0;
+    uint32_t idBits = 0;
+    uint8_t reportID;
+
+    // Prefer fields from the Mouse (or Pointer) application collection
+    for (uint32_t i = 0; i < pLayout->field_count; i++) {
+        uint32_t fieldApp = pLayout->fields[i].app_usage;
+
+        if (HID_GD_MOUSE == fieldApp) {
+            appUsage = HID_GD_MOUSE;
             break;
         }
 
-        switch(item.type) {
-            case HID_ITEM_TYPE_GLOBAL: {
-                switch(item.tag) {
-                    case HID_GLOBAL_ITEM_TAG_USAGE_PAGE: {
-                        usagePage = item.data.u32 << 16;
-                        LOG_INF("  Usage Page: 0x%08X", usagePage);
-                        break;
-                    }
-                    case HID_GLOBAL_ITEM_TAG_LOGICAL_MINIMUM: {
-                        if (1 == item.size) {
-                            logicalMin = (int8_t)item.data.u8;
-                        } else if (2 == item.size) {
-                            logicalMin = (int16_t)item.data.u16;
-                        } else {
-                            logicalMin = item.data.s32;
-                        }
-                        LOG_DBG("  Logical Min: %d", logicalMin);
-                        break;
-                    }
-                    case HID_GLOBAL_ITEM_TAG_LOGICAL_MAXIMUM: {
-                        if (1 == item.size) {
-                            logicalMax = (int8_t)item.data.u8;
-                        } else if (2 == item.size) {
-                            logicalMax = (int16_t)item.data.u16;
-                        } else {
-                            logicalMax = item.data.s32;
-                        }
-                        LOG_DBG("  Logical Max: %d", logicalMax);
-                        break;
-                    }
-                    case HID_GLOBAL_ITEM_TAG_REPORT_SIZE: {
-                        reportSize = item.data.u32;
-                        LOG_DBG("  Report Size: %d bits", reportSize);
-                        break;
-                    }
-                    case HID_GLOBAL_ITEM_TAG_REPORT_COUNT: {
-                        reportCount = item.data.u32;
-                        LOG_DBG("  Report Count: %d", reportCount);
-                        break;
-                    }
-                    case HID_GLOBAL_ITEM_TAG_REPORT_ID: {
-                        // Report ID actually exists but CH375 strips it from data, so we don't add to reportOffset
-                        hasReportId = true;
-                        reportIdValue = item.data.u8;
-                        break;
-                    }
-                }
-                break;
-            }
-
-            case HID_ITEM_TYPE_LOCAL: {
-                if (HID_LOCAL_ITEM_TAG_USAGE == item.tag) {
-                    usage = usagePage | item.data.u32;
-                    LOG_DBG("  Usage: 0x%08X", usage);
-                    
-                    // Store usage in array
-                    if (usageCount < 8) {
-                        usages[usageCount++] = usage;
-                    }
-                }
-                break;
-            }
-
-            case HID_ITEM_TYPE_MAIN: {
-                if (HID_MAIN_ITEM_TAG_BEGIN_COLLECTION == item.tag) {
-                    collectionDepth++;
-                    // Detect mouse collection
-                    if ((HID_GD_MOUSE == usage || HID_GD_POINTER == usage) && true != inMouseCollection) {
-                        inMouseCollection = true;
-                        LOG_INF("Mouse collection found at depth %d (Report ID %s)",
-                                collectionDepth,
-                                hasReportId ? "present but stripped" : "not present");
-                        
-                        foundButtons = false;
-                        foundOrientation = false;
-                        foundWheel = false;
-                        reportOffset = 0;
-                    }
-                }
-                else if (HID_MAIN_ITEM_TAG_END_COLLECTION == item.tag) {
-                    if (collectionDepth > 0) {
-                        collectionDepth--;
-                    }
-                    
-                    if (true == inMouseCollection && 0 == collectionDepth) {
-                        LOG_INF("Mouse collection ended at bit offset %d", reportOffset);
-                        inMouseCollection = false;
-                        
-                        if (true == foundButtons && true == foundOrientation) {
-                            LOG_INF("All required fields found, stopping parse");
-                            if (true != foundButtons || true != foundOrientation) {
-                                LOG_ERR("Failed to parse mouse fields: buttons=%d orientation=%d", foundButtons, foundOrientation);
-                                return -1;
-                            }
-
-                            pMouse->report_len = (reportOffset + 7) / 8;
-                            pMouse->has_report_id_declared = hasReportId;
-                            
-                            if (true == foundWheel) {
-                                LOG_INF("  Wheel at byte %d", pWheel->report_buf_off);
-                            }
-
-                            return 0;
-                        }
-                    }
-                }
-                else if (HID_MAIN_ITEM_TAG_INPUT == item.tag) {
-                    LOG_DBG("INPUT: offset=%d size=%d count=%d usageCount=%d inMouse=%d", 
-                            reportOffset, reportSize, reportCount, usageCount, inMouseCollection);
-                    
-                    if (true != inMouseCollection) {
-                        LOG_DBG("  Skipping INPUT (not in mouse collection)");
-                        reportOffset += reportSize * reportCount;
-                        usageCount = 0;
-                        usage = 0;
-                        break;
-                    }
-
-                    // Parse BUTTONS
-                    if (HID_UP_BUTTON == usagePage && true != foundButtons) {
-                        pBtn->logical_minimum = logicalMin;
-                        pBtn->logical_maximum = logicalMax;
-                        pBtn->size = reportSize;
-                        pBtn->count = reportCount;
-                        pBtn->report_buf_off = reportOffset / 8;
-                        foundButtons = true;
-                        LOG_INF("    -> BUTTONS: byte=%d size=%d count=%d", 
-                                pBtn->report_buf_off, pBtn->size, pBtn->count);
-                    }
-                    // Parse X/Y/Wheel
-                    else if (HID_UP_GENDESK == usagePage) {
-                        bool hasX = false;
-                        bool hasY = false;
-                        bool hasWheel = false;
-                        
-                        for (uint32_t i = 0; i < usageCount; i++) {
-                            if (usages[i] == HID_GD_X) hasX = true;
-                            if (usages[i] == HID_GD_Y) hasY = true;
-                            if (usages[i] == HID_GD_WHEEL) hasWheel = true;
-                        }
-                        
-                        // X and Y together
-                        if (true == hasX && true == hasY && true != foundOrientation) {
-                            pOrient->logical_minimum = logicalMin;
-                            pOrient->logical_maximum = logicalMax;
-                            pOrient->size = reportSize;
-                            pOrient->count = 2;
-                            pOrient->report_buf_off = reportOffset / 8;
-                            foundOrientation = true;
-                            LOG_INF("  -> ORIENTATION: byte=%d size=%d count=%d", 
-                                    pOrient->report_buf_off, pOrient->size, pOrient->count);
-                            
-                            // If wheel is included in same INPUT item
-                            if (true == hasWheel && reportCount >= 3) {
-                                pWheel->logical_minimum = logicalMin;
-                                pWheel->logical_maximum = logicalMax;
-                                pWheel->size = reportSize;
-                                pWheel->count = 1;
-                                pWheel->report_buf_off = (reportOffset + (2 * reportSize)) / 8;
-                                foundWheel = true;
-                                pMouse->has_wheel = true;
-                                LOG_INF("  -> WHEEL: byte=%d size=%d count=%d", 
-                                        pWheel->report_buf_off, pWheel->size, pWheel->count);
-                            }
-                        }
-                        // Standalone wheel
-                        else if (true == hasWheel && true != hasX && true != hasY && true != foundWheel) {
-                            pWheel->logical_minimum = logicalMin;
-                            pWheel->logical_maximum = logicalMax;
-                            pWheel->size = reportSize;
-                            pWheel->count = reportCount;
-                            pWheel->report_buf_off = reportOffset / 8;
-                            foundWheel = true;
-                            pMouse->has_wheel = true;
-                            LOG_INF("  -> WHEEL: byte=%d size=%d count=%d", 
-                                    pWheel->report_buf_off, pWheel->size, pWheel->count);
-                        }
-                    }
-
-                    reportOffset += reportSize * reportCount;
-                    usageCount = 0;
-                    // Clear local state
-                    usage = 0;
-                }
-                break;
-            }
+        if (HID_GD_POINTER == fieldApp) {
+            appUsage = HID_GD_POINTER;
         }
     }
 
-    if (true != foundButtons || true != foundOrientation) {
+    // The report carrying X is the pointer report, everything else is looked up inside it
+    pX = HID_findField(pLayout, HID_REPORT_TYPE_INPUT, appUsage, HID_GD_X, &xIdx);
+    if (NULL == pX) {
+        LOG_ERR("Failed to parse mouse fields: no X axis");
+        return -1;
+    }
+
+    reportID = pX->report_id;
+    pBtn = HID_findReportField(pLayout, reportID, HID_REPORT_TYPE_INPUT, HID_UP_BUTTON | 0x01, &btnIdx);
+    pY = HID_findReportField(pLayout, reportID, HID_REPORT_TYPE_INPUT, HID_GD_Y, &yIdx);
+    pWheel = HID_findReportField(pLayout, reportID, HID_REPORT_TYPE_INPUT, HID_GD_WHEEL, &wheelIdx);
+
+    if (NULL == pBtn || NULL == pY) {
         LOG_ERR("Failed to parse mouse fields: buttons=%d orientation=%d", 
-                foundButtons, foundOrientation);
+                (NULL != pBtn), (NULL != pY));
         return -1;
     }
 
-    pMouse->report_len = (reportOffset + 7) / 8;
-    pMouse->has_report_id_declared = hasReportId;
-    
-    if (true == foundWheel) {
-        LOG_INF("  Wheel at byte %d", pWheel->report_buf_off);
+    // The Report ID byte always leads the report on the wire
+    if (true == pLayout->has_report_id) {
+        pMouse->report_id_offset = 1;
+        idBits = 8;
+    }
+
+    fill_data_descriptor(&pMouse->button, pBtn, btnIdx, pBtn->count - btnIdx, idBits);
+    fill_data_descriptor(&pMouse->orientation, pX, xIdx, 2, idBits);
+    fill_data_descriptor(&pMouse->orientation_y, pY, yIdx, 1, idBits);
+    pMouse->axis_bit_off[HID_MOUSE_AXIS_X] = pMouse->orientation.report_bit_off;
+    pMouse->axis_bit_off[HID_MOUSE_AXIS_Y] = pMouse->orientation_y.report_bit_off;
+
+    LOG_INF("  -> BUTTONS: bit=%d size=%d count=%d", pMouse->button.report_bit_off,
+                                            pMouse->button.size, pMouse->button.count);
+    LOG_INF("  -> ORIENTATION: bit=%d/%d size=%d/%d", pMouse->axis_bit_off[HID_MOUSE_AXIS_X],
+                                pMouse->axis_bit_off[HID_MOUSE_AXIS_Y], pMouse->orientation.size,
+                                pMouse->orientation_y.size);
+
+    if (NULL != pWheel) {
+        fill_data_descriptor(&pMouse->wheel, pWheel, wheelIdx, 1, idBits);
+        pMouse->axis_bit_off[HID_MOUSE_AXIS_WHEEL] = pMouse->wheel.report_bit_off;
+        pMouse->has_wheel = true;
+        LOG_INF("  -> WHEEL: bit=%d size=%d", pMouse->wheel.report_bit_off, pMouse->wheel.size);
+    }
+
+    pInfo = HID_getReportInfo(pLayout, reportID);
+    if (NULL == pInfo) {
+        return -1;
+    }
+
+    pMouse->report_id = reportID;
+    pMouse->report_len = pMouse->report_id_offset + (pInfo->input_bits + 7) / 8;
+    pMouse->has_report_id_declared = pLayout->has_report_id;
+
+    // Only the pointer report is delivered, other collections on this endpoint are dropped
+    if (true == pLayout->has_report_id) {
+        for (uint32_t i = 0; i < pLayout->report_count; i++) {
+            pLayout->reports[i].route = HID_REPORT_ROUTE_DROP;
+        }
+        HID_setReportRoute(pLayout, reportID, HID_REPORT_ROUTE_ACCEPT);
+        LOG_INF("  -> REPORT ID: %d (%d reports in descriptor)", reportID, pLayout->report_count);
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+static void fill_data_descriptor(struct HID_DataDescriptor_t *pDesc, const struct HID_Field_t *pField,
+                                            uint32_t index, uint32_t count, uint32_t idBits)
+{
+    memset(pDesc, 0x00, sizeof(struct HID_DataDescriptor_t));
+    pDesc->logical_minimum = pField->logical_minimum;
+    pDesc->logical_maximum = pField->logical_maximum;
+    pDesc->size = pField->bit_size;
+    pDesc->count = count;
+    pDesc->report_bit_off = idBits + pField->bit_offset + (index * pField->bit_size);
+    pDesc->report_buf_off = pDesc->report_bit_off / 8;
+    // Relative axes are two's complement even when the descriptor says otherwise
+    pDesc->is_signed = (0 != (pField->flags & (HID_FIELD_SIGNED | HID_FIELD_RELATIVE)));
+}
+
+static int read_axis(struct HID_Mouse_t *pMouse, const struct HID_DataDescriptor_t *pDesc,
+                                    uint32_t axisNum, int32_t *pValue, bool isLast)
+{
+    int ret = -1;
+    uint8_t *pReportBuff;
+
+    if (0 == pDesc->size || pDesc->size > 32) {
+        LOG_ERR("Invalid value size: size=%d bits", pDesc->size);
+        return USBHID_ERROR;
+    }
+
+    ret = USBHID_getReportBuffer(pMouse->hid_dev, &pReportBuff, NULL, isLast);
+    if (USBHID_SUCCESS != ret) {
+        return ret;
+    }
+
+    *pValue = decode_axis(pReportBuff, pDesc, pMouse->axis_bit_off[axisNum]);
+
+    return USBHID_SUCCESS;
+}
+
+static inline int32_t decode_axis(const uint8_t *pReport, const struct HID_DataDescriptor_t *pDesc,
+                                                                            uint32_t bitOff)
+{
+    if (true == pDesc->is_signed) {
+        return HID_extractSigned(pReport, bitOff, pDesc->size);
+    }
+
+    return (int32_t)HID_extractBits(pReport, bitOff, pDesc->size);
+}
+
+static inline void encode_axis(uint8_t *pReport, const struct HID_DataDescriptor_t *pDesc,
+                                                                uint32_t bitOff, int32_t value)
+{
+    // Relative axes declared 0..255 are still two's complement, leave those alone
+    if (pDesc->logical_minimum < pDesc->logical_maximum &&
+        (pDesc->logical_minimum < 0 || true != pDesc->is_signed)) {
+        value = CLAMP(value, pDesc->logical_minimum, pDesc->logical_maximum);
+    }
+
+    HID_insertBits(pReport, bitOff, pDesc->size, (uint32_t)value);
+}
@@ -13,7 +13,8 @@
  * @details
  * Implements translation layer between the input HID devices and the USB 
  * device output. This includes translation of variable-format mouse reports 
- * into a standardized output format.
+ * into a standardized output format and of decoded keyboard states into the
+ * NKRO (or boot) keyboard report.
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -24,109 +25,261 @@
  */
 
 #include "hid_output.h"
+#include "mem_report.h"
 
-LOG_MODULE_REGISTER(hid_output, LOG_LEVEL_DBG);
+LOG_MODULE_REGISTER(hid_output, LOG_LEVEL_INF);
 
+/* Private types -------------------------------------------------------------*/
+/**
+ * @brief Mouse samples not yet taken by the host
+ * @note Single producer / single consumer ring like the keyboard queue. Each
+ *       mouse port has its own input thread, `prod_lock` makes them one
+ *       producer, the consumer never takes it. The consumer folds the ring
+ *       into the carry (x..has_carry) and sends what fits in one report.
+ *       `pressed` keeps button presses the host has not seen, so a click that
+ *       starts and ends while the endpoint is busy is still reported. The ovf_*
+ *       motion is producer-private and rides on the next sample that fits,
+ *       `ovf_buttons` ORs the buttons seen meanwhile so a click that came and
+ *       went while the ring was full gets a slot of its own.
+ *       `is_requested` is raised by every flush, a flush that finds the ring
+ *       claimed leaves its work to the holder that way.
+ */
+struct HID_MotionAccum_t {
+    struct HID_MouseState_t entries[HID_OUTPUT_MOUSE_RING_DEPTH];
+    uint32_t capture_cyc[HID_OUTPUT_MOUSE_RING_DEPTH];
+    struct k_spinlock prod_lock;
+    atomic_t head;
+    atomic_t tail;
+    atomic_t is_draining;
+    atomic_t is_requested;
+    int32_t x;
+    int32_t y;
+    int32_t wheel;
+    uint8_t buttons;
+    uint8_t pressed;
+    uint32_t carry_cyc;
+    volatile bool has_carry;
+    int32_t ovf_x;
+    int32_t ovf_y;
+    int32_t ovf_wheel;
+    uint8_t ovf_buttons;
+};
 
 /**
- * @brief Build a standardized HID mouse report from the input data
- * @param pMouse Pointer to the HID device structure
- * @param pOutReport Pointer to the output report
- * @return 0 on success, error code otherwise
+ * @brief Keyboard states waiting for the host, oldest at `tail`
+ * @note Single producer / single consumer ring, the keyboard input threads
+ *       serialize on `prod_lock` like the mouse producers. `is_draining`
+ *       keeps the thread and the ready callback from consuming at once, the
+ *       producer takes it too before rewriting a queued state. `is_requested`
+ *       works as for the mouse ring. A state that finds the queue full and
+ *       claimed waits in `latest` under `prod_lock`, the next enqueue or a
+ *       drain that freed a slot appends it, a newer one replaces it.
  */
-int hidOutput_buildMouseReport(struct HID_Mouse_t *pMouse, uint8_t *pOutReport) {
+struct HID_KbdQueue_t {
+    struct HID_KeyboardState_t entries[HID_OUTPUT_KBD_QUEUE_DEPTH];
+    uint32_t capture_cyc[HID_OUTPUT_KBD_QUEUE_DEPTH];
+    struct k_spinlock prod_lock;
+    atomic_t head;
+    atomic_t tail;
+    atomic_t is_draining;
+    atomic_t is_requested;
+    struct HID_KeyboardState_t latest;
+    uint32_t latest_cyc;
+    volatile bool has_latest;
+    uint32_t high_water;
+    uint32_t collapsed;
+    uint32_t overflowed;
+};
 
-    int ret = -1;
+/* Private variables ---------------------------------------------------------*/
+static struct HID_MotionAccum_t gMouseAccum;
+static struct HID_KbdQueue_t gKbdQueue;
+MEM_REPORT_STATIC(hid_output, gMouseAccum);
+MEM_REPORT_STATIC(hid_output, gKbdQueue);
 
-    if (NULL == pMouse || NULL == pOutReport) {
-        LOG_ERR("Invalid parameters");
-        return -EINVAL;
-    }
+/* Private function prototypes -----------------------------------------------*/
+static bool plan_axis(const struct HID_DataDescriptor_t *pDesc, uint32_t bitOff, uint8_t *pSrc);
+static void accumulate_mouse(const struct HID_MouseState_t *pState, uint32_t arrivalCyc);
+static bool mouse_is_pending(void);
+static void take_mouse_samples(void);
+static int flush_mouse(void);
+static void mouse_ready(uint8_t ifaceNum);
+static bool can_collapse(const struct HID_KeyboardState_t *pPrev, const struct HID_KeyboardState_t *pLast,
+                                                            const struct HID_KeyboardState_t *pNew);
+static void fold_latest_keyboard(void);
+static void drain_keyboard(void);
+static void keyboard_ready(uint8_t ifaceNum);
+#if defined(CONFIG_GHOSTHIDE_SOF_ALIGN)
+static void sof_received(void);
+static void sof_submit(struct k_timer *pTimer);
+static void sof_fallback(struct k_timer *pTimer);
 
-    if (true == pMouse->has_report_id_declared && 1 == pMouse->report_id_offset) {
-        uint8_t *pInputBuff = NULL;
-        uint32_t inputLen = 0;
+static K_TIMER_DEFINE(gSofTimer, sof_submit, NULL);
+static K_TIMER_DEFINE(gSofFallbackTimer, sof_fallback, NULL);
+static atomic_t gIsSofSeen;
 
-        // Get input buffer from the mouse device
-        ret = USBHID_getReportBuffer(pMouse->hid_dev, &pInputBuff, &inputLen, false);
-        if (NULL == pInputBuff || USBHID_SUCCESS != ret) {
-            LOG_ERR("Failed to get input buffer for Report ID check");
-            return -EIO;
-        }
+// A relative timeout is rounded up to a tick and one more tick is added, the
+// submission still has to land in the same frame and after the SOF
+#define HID_OUTPUT_SOF_TICK_US      (USEC_PER_SEC / CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+BUILD_ASSERT(CONFIG_GHOSTHIDE_SOF_LEAD_US >= 2 * HID_OUTPUT_SOF_TICK_US,
+             "CONFIG_GHOSTHIDE_SOF_LEAD_US must cover two system ticks");
+BUILD_ASSERT(USEC_PER_MSEC - CONFIG_GHOSTHIDE_SOF_LEAD_US >= 2 * HID_OUTPUT_SOF_TICK_US,
+             "The SOF submit delay must be at least two system ticks");
+#endif
 
-        // Check 0th byte of input buffer
-        uint8_t reportID = pInputBuff[0];
-        if (MOUSE_REPORTID_BYTE != reportID) {
-            // Ignore all other reports that are not related to movement/button click
-            static uint32_t ignoredCount = 0;
-            if (++ignoredCount <= 5) {
-                LOG_DBG("Ignoring non-movement Report ID: 0x%02X", reportID);
-            }
-            return -EAGAIN;
+/**
+ * @brief Reset output state and hook into the USB endpoint ready callbacks
+ * @return None
+ * @note Call after usbhid_proxyInit(), before the first report is sent.
+ */
+void hidOutput_init(void) {
+
+    memset(&gMouseAccum, 0x00, sizeof(gMouseAccum));
+    memset(&gKbdQueue, 0x00, sizeof(gKbdQueue));
+
+    usbhid_proxySetReadyCallback(0, mouse_ready);
+    usbhid_proxySetReadyCallback(1, keyboard_ready);
+#if defined(CONFIG_GHOSTHIDE_SOF_ALIGN)
+    atomic_clear(&gIsSofSeen);
+    usbhid_proxySetSofCallback(sof_received);
+    k_timer_start(&gSofFallbackTimer, K_MSEC(HID_OUTPUT_SOF_FALLBACK_MS), K_MSEC(HID_OUTPUT_SOF_FALLBACK_MS));
+#endif
+}
+
+/**
+ * @brief Compute the translation plan for a mouse
+ * @param pMouse Pointer to the HID device structure (opened)
+ * @param pPlan Pointer to the plan to fill
+ * @return None
+ * @note Buttons must start on a byte boundary, X/Y must be byte aligned signed
+ * 8 or 16-bit fields and the wheel a byte aligned signed 8-bit field (or
+ * absent) for a byte plan. Anything else falls back to HID_OUTPUT_PLAN_REMAP.
+ */
+void hidOutput_planMouse(const struct HID_Mouse_t *pMouse, struct HID_OutputPlan_t *pPlan) {
+
+    const struct HID_DataDescriptor_t *pBtn = &pMouse->button;
+    uint32_t xOff = pMouse->axis_bit_off[HID_MOUSE_AXIS_X];
+    uint32_t yOff = pMouse->axis_bit_off[HID_MOUSE_AXIS_Y];
+    uint32_t wheelOff = pMouse->axis_bit_off[HID_MOUSE_AXIS_WHEEL];
+    uint8_t wheelSrc[2];
+    bool isIdentity = true;
+
+    memset(pPlan, 0x00, sizeof(struct HID_OutputPlan_t));
+    pPlan->kind = HID_OUTPUT_PLAN_REMAP;
+
+    // X/Y [1:4], already little endian on the wire
+    if (1 != pBtn->size || 0 != (pBtn->report_bit_off % 8) ||
+        pMouse->report_len >= HID_OUTPUT_PLAN_SIGN ||
+        true != plan_axis(&pMouse->orientation, xOff, &pPlan->src[1]) ||
+        true != plan_axis(&pMouse->orientation_y, yOff, &pPlan->src[3])) {
+        LOG_INF("Output plan: remap");
+        return;
+    }
+
+    // Wheel [5], only the low byte of an 8-bit field is usable as is
+    if (true == pMouse->has_wheel) {
+        if (8 != pMouse->wheel.size || true != plan_axis(&pMouse->wheel, wheelOff, wheelSrc)) {
+            LOG_INF("Output plan: remap (wheel)");
+            return;
         }
+        pPlan->src[5] = wheelSrc[0];
+    } else {
+        pPlan->src[5] = HID_OUTPUT_PLAN_ZERO;
     }
 
-    memset(pOutReport, 0x00, HID_OUTPUT_REPORT_SIZE);
+    // Buttons [0], padding after fewer than 8 buttons is masked off
+    pPlan->src[0] = pBtn->report_bit_off / 8;
+    pPlan->mask[0] = (pBtn->count >= 8) ? 0xFF : (uint8_t)(BIT(pBtn->count) - 1);
 
-    // Buttons [0]
-    uint8_t buttons = 0;
+    for (uint32_t i = 1; i < HID_OUTPUT_REPORT_SIZE; i++) {
+        pPlan->mask[i] = (HID_OUTPUT_PLAN_ZERO == pPlan->src[i]) ? 0x00 : 0xFF;
+    }
 
-    for (uint32_t i = 0; i < 8 && i < pMouse->button.count; i++) {
-        uint32_t value;
-        ret = hidMouse_GetButton(pMouse, i, &value, false);
-        if (0 != value && USBHID_SUCCESS == ret) {
-            buttons |= (1 << i);
+    for (uint32_t i = 0; i < HID_OUTPUT_REPORT_SIZE; i++) {
+        if (pPlan->src[0] + i != pPlan->src[i] || 0xFF != pPlan->mask[i]) {
+            isIdentity = false;
+            break;
         }
     }
-    pOutReport[0] = buttons;
 
-    // X/Y axes [1:4]
-    int32_t xValue = 0;
-    int32_t yValue = 0;
+    if (true == isIdentity && pMouse->report_len >= pPlan->src[0] + HID_OUTPUT_REPORT_SIZE) {
+        pPlan->kind = HID_OUTPUT_PLAN_IDENTITY;
+        LOG_INF("Output plan: identity at byte %d", pPlan->src[0]);
+    } else {
+        pPlan->kind = HID_OUTPUT_PLAN_PERMUTE;
+        LOG_INF("Output plan: permute %d %d %d %d %d %d", pPlan->src[0], pPlan->src[1],
+                        pPlan->src[2], pPlan->src[3], pPlan->src[4], pPlan->src[5]);
+    }
+}
 
-    ret = hidMouse_GetOrientation(pMouse, HID_MOUSE_AXIS_X, &xValue, false);
-    if (USBHID_SUCCESS != ret) {
-        LOG_ERR("Failed to get X axis: %d", ret);
-        return -EIO;
+/**
+ * @brief Encode a decoded mouse state into the standardized output report
+ * @param pState Pointer to the decoded mouse state
+ * @param pOutReport Pointer to the output report (HID_OUTPUT_REPORT_SIZE bytes)
+ * @return None
+ * @note Output layout: buttons [0], X [1:2], Y [3:4] (16-bit LE), wheel [5].
+ */
+void hidOutput_encodeMouseState(const struct HID_MouseState_t *pState, uint8_t *pOutReport) {
+
+    pOutReport[0] = (uint8_t)pState->buttons;
+    sys_put_le16((uint16_t)CLAMP(pState->x, INT16_MIN, INT16_MAX), &pOutReport[1]);
+    sys_put_le16((uint16_t)CLAMP(pState->y, INT16_MIN, INT16_MAX), &pOutReport[3]);
+    pOutReport[5] = (uint8_t)(int8_t)CLAMP(pState->wheel, INT8_MIN, INT8_MAX);
+}
+
+/**
+ * @brief Build a standardized HID mouse report from the input data
+ * @param pMouse Pointer to the HID device structure
+ * @param pOutReport Pointer to the output report
+ * @return 0 on success, error code otherwise
+ */
+int hidOutput_buildMouseReport(struct HID_Mouse_t *pMouse, uint8_t *pOutReport) {
+
+    int ret = -1;
+    struct HID_MouseState_t state;
+
+    if (NULL == pMouse || NULL == pOutReport) {
+        LOG_ERR("Invalid parameters");
+        return -EINVAL;
     }
 
-    ret = hidMouse_GetOrientation(pMouse, HID_MOUSE_AXIS_Y, &yValue, false);
+    ret = hidMouse_GetState(pMouse, &state, false);
     if (USBHID_SUCCESS != ret) {
-        LOG_ERR("Failed to get Y axis: %d", ret);
+        LOG_ERR("Failed to decode mouse report: %d", ret);
         return -EIO;
     }
 
-    // Convert to LE
-    sys_put_le16((uint16_t)xValue, &pOutReport[1]);
-    sys_put_le16((uint16_t)yValue, &pOutReport[3]);
+    hidOutput_encodeMouseState(&state, pOutReport);
 
-    // Wheel [5]
-    int32_t wheelValue = 0;
+    return 0;
+}
 
-    if (true == pMouse->has_wheel) {
-        ret = hidMouse_GetOrientation(pMouse, HID_MOUSE_AXIS_WHEEL, &wheelValue, false);
-        if (USBHID_SUCCESS != ret) {
-            LOG_ERR("Failed to get wheel: %d", ret);
-            return -EIO;
-        }
+/**
+ * @brief Send a decoded mouse state to the host
+ * @param pState Pointer to the decoded mouse state
+ * @param arrivalCyc k_cycle_get_32() when the report the state came from arrived
+ * @return 0 on success (sent or merged into the pending motion), error code otherwise
+ * @note Never blocks. While the endpoint is busy the deltas are summed and
+ * sent from the endpoint ready callback. With CONFIG_GHOSTHIDE_SOF_ALIGN they
+ * are always summed and sent just before the host's next frame.
+ */
+int hidOutput_sendMouseState(const struct HID_MouseState_t *pState, uint32_t arrivalCyc) {
+
+    k_spinlock_key_t key;
 
-        // Clamp to int8_t
-        if (wheelValue > INT8_MAX) wheelValue = INT8_MAX;
-        if (wheelValue < INT8_MIN) wheelValue = INT8_MIN;
+    if (NULL == pState) {
+        return -EINVAL;
     }
 
-    pOutReport[5] = (uint8_t)(int8_t)wheelValue;
+    key = k_spin_lock(&gMouseAccum.prod_lock);
+    accumulate_mouse(pState, arrivalCyc);
+    k_spin_unlock(&gMouseAccum.prod_lock, key);
 
-    static int sampleCount = 0;
-    sampleCount++;
-    
-    if (sampleCount <= 10 || 0 != xValue || 0 != yValue || 0 != wheelValue || 0 != buttons) {
-        LOG_DBG("Output: BTN=0x%02X X=%d Y=%d WHEEL=%d", 
-                pOutReport[0], (int16_t)xValue, (int16_t)yValue, 
-                (int8_t)pOutReport[5]);
-    } 
+    if (true == IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN)) {
+        return 0;
+    }
 
-    return 0;
+    return flush_mouse();
 }
 
 /**
@@ -137,28 +290,500 @@ int hidOutput_buildMouseReport(struct HID_Mouse_t *pMouse, uint8_t *pOutReport)
 int hidOutput_sendMouseReport(struct HID_Mouse_t *pMouse) {
     
     int ret = -1;
-    uint8_t pReportBuff[HID_OUTPUT_REPORT_SIZE];
+    struct HID_MouseState_t state;
 
     if (NULL == pMouse) {
         LOG_ERR("Invalid mouse structure pointer");
         return -EINVAL;
     }
 
-    ret = hidOutput_buildMouseReport(pMouse, pReportBuff);
-    if (-EAGAIN == ret) {
-        // Probably just a non-movement report that got filtered
-        return 0;
-    }
-
+    ret = hidMouse_GetState(pMouse, &state, false);
     if (USBHID_SUCCESS != ret) {
         LOG_ERR("Failed to build output report: %d", ret);
         return ret;
     }
 
-    ret = usbhid_proxySendReport(0, pReportBuff, HID_OUTPUT_REPORT_SIZE);
-    if (USBHID_SUCCESS != ret) {
-        return ret;
+    return hidOutput_sendMouseState(&state, pMouse->hid_dev->report_cyc);
+}
+
+/**
+ * @brief Translate the fetched report with a precomputed plan and send it
+ * @param pMouse Pointer to the HID device structure
+ * @param pPlan Pointer to the plan from hidOutput_planMouse()
+ * @return 0 on success, error code otherwise
+ * @note Identity plans hand the fetched buffer itself to the USB stack. Only
+ * use this when nothing modifies the report, see hidOutput_sendMouseState().
+ */
+int hidOutput_sendMousePlanned(struct HID_Mouse_t *pMouse, const struct HID_OutputPlan_t *pPlan) {
+
+    int ret = -1;
+    uint8_t *pInputBuff;
+    uint8_t pReportBuff[HID_OUTPUT_REPORT_SIZE];
+
+    if (NULL == pMouse || NULL == pPlan) {
+        return -EINVAL;
+    }
+
+    // Motion still waiting for the host goes first, merge behind it
+    if (true == mouse_is_pending() || true == IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN)) {
+        return hidOutput_sendMouseReport(pMouse);
+    }
+
+    switch (pPlan->kind) {
+        case HID_OUTPUT_PLAN_IDENTITY: {
+            ret = USBHID_getReportBuffer(pMouse->hid_dev, &pInputBuff, NULL, false);
+            if (USBHID_SUCCESS != ret) {
+                return ret;
+            }
+
+            ret = usbhid_proxyTrySendReport(0, pInputBuff + pPlan->src[0], HID_OUTPUT_REPORT_SIZE,
+                                                                            pMouse->hid_dev->report_cyc);
+            break;
+        }
+
+        case HID_OUTPUT_PLAN_PERMUTE: {
+            ret = USBHID_getReportBuffer(pMouse->hid_dev, &pInputBuff, NULL, false);
+            if (USBHID_SUCCESS != ret) {
+                return ret;
+            }
+
+            for (uint32_t i = 0; i < HID_OUTPUT_REPORT_SIZE; i++) {
+                uint8_t src = pPlan->src[i];
+
+                if (HID_OUTPUT_PLAN_ZERO == src) {
+                    pReportBuff[i] = 0;
+                } else if (0 != (src & HID_OUTPUT_PLAN_SIGN)) {
+                    // High byte of a widened 8-bit axis
+                    pReportBuff[i] = (0 != (pInputBuff[src & ~HID_OUTPUT_PLAN_SIGN] & 0x80)) ? 0xFF : 0x00;
+                } else {
+                    pReportBuff[i] = pInputBuff[src] & pPlan->mask[i];
+                }
+            }
+
+            ret = usbhid_proxyTrySendReport(0, pReportBuff, HID_OUTPUT_REPORT_SIZE, pMouse->hid_dev->report_cyc);
+            break;
+        }
+
+        default: {
+            return hidOutput_sendMouseReport(pMouse);
+        }
+    }
+
+    // Endpoint busy, keep the motion for the ready callback
+    if (-EBUSY == ret) {
+        return hidOutput_sendMouseReport(pMouse);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Encode a decoded keyboard state into the keyboard interface report
+ * @param pState Pointer to the decoded keyboard state
+ * @param isBoot true to build the 8 byte boot report
+ * @param pOutReport Pointer to the output report (USBHID_PROXY_KBD_REPORT_SIZE bytes)
+ * @return Report length in bytes
+ * @note Report layout: modifiers [0], reserved [1], key array [2:7], bitmap of
+ * usages 0x00..0x7F [8:23]. The boot report reports ErrorRollOver once more
+ * than 6 keys are held.
+ */
+size_t hidOutput_encodeKeyboardState(const struct HID_KeyboardState_t *pState, bool isBoot,
+                                                                        uint8_t *pOutReport) {
+
+    uint8_t *pKeysField = &pOutReport[HID_KBD_KEYS_OFFSET];
+    uint32_t slot = 0;
+    uint32_t usage = isBoot ? HID_KBD_USAGE_FIRST_KEY : USBHID_PROXY_KBD_BITMAP_USAGES;
+    size_t len = isBoot ? USBHID_PROXY_KBD_BOOT_REPORT_SIZE : USBHID_PROXY_KBD_REPORT_SIZE;
+
+    memset(pOutReport, 0x00, len);
+    pOutReport[HID_KBD_MODIFIER_OFFSET] = pState->modifiers;
+
+    if (true != isBoot) {
+        memcpy(&pOutReport[USBHID_PROXY_KBD_BITMAP_OFFSET], pState->keys, USBHID_PROXY_KBD_BITMAP_USAGES / 8);
+        pOutReport[USBHID_PROXY_KBD_BITMAP_OFFSET] &= ~(BIT(HID_KBD_USAGE_FIRST_KEY) - 1);
+    }
+
+    // Whatever the bitmap does not cover goes to the key array
+    for (; usage < HID_KBD_USAGE_LEFT_CTRL; usage++) {
+        if (true != hidKeyboard_StateHasKey(pState, usage)) {
+            continue;
+        }
+
+        if (slot == HID_KBD_MAX_KEYS) {
+            memset(pKeysField, HID_KBD_USAGE_ERR_ROLLOVER, HID_KBD_MAX_KEYS);
+            break;
+        }
+
+        pKeysField[slot++] = usage;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Queue a decoded keyboard state for the host
+ * @param pState Pointer to the decoded keyboard state
+ * @param arrivalCyc k_cycle_get_32() when the report the state came from arrived
+ * @return 0 on success, -EINVAL on a NULL state
+ * @note Never blocks. States are sent in order, one per host poll. A queued
+ * state that no key changed in both directions since is replaced rather than
+ * followed, so press/release pairs always reach the host. On a full queue the
+ * newest state not yet sent is replaced, a press/release pair inside it is
+ * lost but the host always ends up in the current state. With
+ * CONFIG_GHOSTHIDE_SOF_ALIGN the queue is only drained just before a frame.
+ */
+int hidOutput_sendKeyboardState(const struct HID_KeyboardState_t *pState, uint32_t arrivalCyc) {
+
+    atomic_val_t head;
+    uint32_t count;
+    struct HID_KeyboardState_t *pLast;
+    bool isClaimed;
+    k_spinlock_key_t key;
+
+    if (NULL == pState) {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&gKbdQueue.prod_lock);
+    fold_latest_keyboard();
+    head = atomic_get(&gKbdQueue.head);
+    pLast = &gKbdQueue.entries[(head - 1) & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)];
+
+    // A queued state may only be rewritten while the consumer cannot be encoding it
+    isClaimed = atomic_cas(&gKbdQueue.is_draining, 0, 1);
+    count = head - atomic_get(&gKbdQueue.tail);
+
+    if (true == gKbdQueue.has_latest) {
+        // Still full, the held state is superseded before it was ever queued
+        gKbdQueue.latest = *pState;
+        gKbdQueue.latest_cyc = arrivalCyc;
+        gKbdQueue.overflowed++;
+        usbhid_proxyCountDropped(1);
+    } else if (true == isClaimed && count >= 2 &&
+        true == can_collapse(&gKbdQueue.entries[(head - 2) & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)], pLast, pState)) {
+        *pLast = *pState;
+        gKbdQueue.collapsed++;
+        usbhid_proxyCountCoalesced(1);
+    } else if (count < HID_OUTPUT_KBD_QUEUE_DEPTH) {
+        gKbdQueue.entries[head & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)] = *pState;
+        gKbdQueue.capture_cyc[head & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)] = arrivalCyc;
+        atomic_set(&gKbdQueue.head, head + 1);
+        gKbdQueue.high_water = MAX(gKbdQueue.high_water, count + 1);
+    } else if (true == isClaimed) {
+        *pLast = *pState;
+        gKbdQueue.overflowed++;
+        usbhid_proxyCountDropped(1);
+    } else {
+        // Full and being drained, nothing queued can be replaced safely. Hold it for the consumer
+        gKbdQueue.latest = *pState;
+        gKbdQueue.latest_cyc = arrivalCyc;
+        gKbdQueue.has_latest = true;
+        gKbdQueue.overflowed++;
+    }
+
+    if (true == isClaimed) {
+        atomic_clear(&gKbdQueue.is_draining);
+    }
+    k_spin_unlock(&gKbdQueue.prod_lock, key);
+
+    // A ready callback that found the queue claimed above left its work to us
+    if (true != IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN) || 0 != atomic_get(&gKbdQueue.is_requested)) {
+        drain_keyboard();
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Read the keyboard output queue counters
+ * @param pStats Pointer to the counters to fill
+ * @return None
+ */
+void hidOutput_getKeyboardQueueStats(struct HID_OutputQueueStats_t *pStats) {
+
+    if (NULL == pStats) {
+        return;
+    }
+
+    pStats->depth = atomic_get(&gKbdQueue.head) - atomic_get(&gKbdQueue.tail) + (gKbdQueue.has_latest ? 1 : 0);
+    pStats->high_water = gKbdQueue.high_water;
+    pStats->collapsed = gKbdQueue.collapsed;
+    pStats->overflowed = gKbdQueue.overflowed;
+}
+
+/* --------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ * -------------------------------------------------------------------------*/
+static void accumulate_mouse(const struct HID_MouseState_t *pState, uint32_t arrivalCyc)
+{
+    atomic_val_t head = atomic_get(&gMouseAccum.head);
+    uint32_t used = head - atomic_get(&gMouseAccum.tail);
+    uint8_t lostPress = gMouseAccum.ovf_buttons & ~(uint8_t)pState->buttons;
+    struct HID_MouseState_t *pEntry;
+
+    // Full ring (host not polling), keep the motion and the buttons for the next free slot
+    if (used + ((0 != lostPress) ? 2 : 1) > HID_OUTPUT_MOUSE_RING_DEPTH) {
+        gMouseAccum.ovf_x += pState->x;
+        gMouseAccum.ovf_y += pState->y;
+        gMouseAccum.ovf_wheel += pState->wheel;
+        gMouseAccum.ovf_buttons |= (uint8_t)pState->buttons;
+        // Nothing is lost, the sample rides on the next one that fits
+        usbhid_proxyCountCoalesced(0);
+        return;
+    }
+
+    // A press released while full goes first, the consumer turns it into a click
+    if (0 != lostPress) {
+        pEntry = &gMouseAccum.entries[head & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)];
+        pEntry->buttons = gMouseAccum.ovf_buttons;
+        pEntry->x = 0;
+        pEntry->y = 0;
+        pEntry->wheel = 0;
+        gMouseAccum.capture_cyc[head & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)] = arrivalCyc;
+        head++;
+    }
+
+    pEntry = &gMouseAccum.entries[head & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)];
+    *pEntry = *pState;
+    pEntry->x += gMouseAccum.ovf_x;
+    pEntry->y += gMouseAccum.ovf_y;
+    pEntry->wheel += gMouseAccum.ovf_wheel;
+    gMouseAccum.ovf_x = 0;
+    gMouseAccum.ovf_y = 0;
+    gMouseAccum.ovf_wheel = 0;
+    gMouseAccum.ovf_buttons = 0;
+    gMouseAccum.capture_cyc[head & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)] = arrivalCyc;
+
+    // Publishes the entries to the consumer
+    atomic_set(&gMouseAccum.head, head + 1);
+}
+
+static bool mouse_is_pending(void)
+{
+    return (true == gMouseAccum.has_carry ||
+                atomic_get(&gMouseAccum.head) != atomic_get(&gMouseAccum.tail));
+}
+
+static void take_mouse_samples(void)
+{
+    atomic_val_t head = atomic_get(&gMouseAccum.head);
+    atomic_val_t tail = atomic_get(&gMouseAccum.tail);
+
+    // Consumer side only, the caller holds is_draining
+    for (; tail != head; tail++) {
+        const struct HID_MouseState_t *pEntry = &gMouseAccum.entries[tail & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)];
+
+        if (true != gMouseAccum.has_carry) {
+            gMouseAccum.carry_cyc = gMouseAccum.capture_cyc[tail & (HID_OUTPUT_MOUSE_RING_DEPTH - 1)];
+        } else {
+            usbhid_proxyCountCoalesced(0);
+        }
+
+        gMouseAccum.x += pEntry->x;
+        gMouseAccum.y += pEntry->y;
+        gMouseAccum.wheel += pEntry->wheel;
+        gMouseAccum.pressed |= (uint8_t)pEntry->buttons & ~gMouseAccum.buttons;
+        gMouseAccum.buttons = (uint8_t)pEntry->buttons;
+        gMouseAccum.has_carry = true;
+    }
+
+    atomic_set(&gMouseAccum.tail, tail);
+}
+
+static int flush_mouse(void)
+{
+    int ret = -1;
+    struct HID_MouseState_t state;
+    uint8_t pReportBuff[HID_OUTPUT_REPORT_SIZE];
+    uint8_t pressed;
+    uint32_t captureCyc;
+
+    atomic_set(&gMouseAccum.is_requested, 1);
+
+    do {
+        // The holder picks up the request once it lets go
+        if (true != atomic_cas(&gMouseAccum.is_draining, 0, 1)) {
+            return 0;
+        }
+
+        atomic_clear(&gMouseAccum.is_requested);
+        take_mouse_samples();
+        ret = -ENODATA;
+
+        if (true == gMouseAccum.has_carry) {
+            // Take what fits in one report, the remainder goes out with the next one
+            state.buttons = gMouseAccum.buttons | gMouseAccum.pressed;
+            state.x = CLAMP(gMouseAccum.x, INT16_MIN, INT16_MAX);
+            state.y = CLAMP(gMouseAccum.y, INT16_MIN, INT16_MAX);
+            state.wheel = CLAMP(gMouseAccum.wheel, INT8_MIN, INT8_MAX);
+            pressed = gMouseAccum.pressed;
+            captureCyc = gMouseAccum.carry_cyc;
+
+            hidOutput_encodeMouseState(&state, pReportBuff);
+            ret = usbhid_proxyTrySendReport(0, pReportBuff, HID_OUTPUT_REPORT_SIZE, captureCyc);
+
+            // On -EBUSY everything stays in the carry, the ready callback sends it
+            if (0 == ret) {
+                gMouseAccum.x -= state.x;
+                gMouseAccum.y -= state.y;
+                gMouseAccum.wheel -= state.wheel;
+                gMouseAccum.pressed = 0;
+                // A press that is already released still owes the host its release
+                gMouseAccum.has_carry = (0 != gMouseAccum.x || 0 != gMouseAccum.y || 0 != gMouseAccum.wheel ||
+                                                            0 != (pressed & ~gMouseAccum.buttons));
+            }
+        }
+
+        atomic_clear(&gMouseAccum.is_draining);
+
+        // A sample pushed or an endpoint freed while we held the ring would otherwise wait
+    } while (0 != atomic_get(&gMouseAccum.is_requested));
+
+    return (-EBUSY == ret || -ENODATA == ret) ? 0 : ret;
+}
+
+static void mouse_ready(uint8_t ifaceNum)
+{
+    (void)(ifaceNum);
+    if (true != IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN)) {
+        flush_mouse();
+    }
+}
+
+static bool can_collapse(const struct HID_KeyboardState_t *pPrev, const struct HID_KeyboardState_t *pLast,
+                                                            const struct HID_KeyboardState_t *pNew)
+{
+    // Replacing pLast with pNew is lossless unless some key changes in both steps
+    if (0 != ((pPrev->modifiers ^ pLast->modifiers) & (pLast->modifiers ^ pNew->modifiers))) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < HID_KBD_BITMAP_BYTES; i++) {
+        if (0 != ((pPrev->keys[i] ^ pLast->keys[i]) & (pLast->keys[i] ^ pNew->keys[i]))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void fold_latest_keyboard(void)
+{
+    atomic_val_t head;
+
+    // Caller holds prod_lock
+    head = atomic_get(&gKbdQueue.head);
+    if (true != gKbdQueue.has_latest || head - atomic_get(&gKbdQueue.tail) >= HID_OUTPUT_KBD_QUEUE_DEPTH) {
+        return;
+    }
+
+    gKbdQueue.entries[head & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)] = gKbdQueue.latest;
+    gKbdQueue.capture_cyc[head & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)] = gKbdQueue.latest_cyc;
+    atomic_set(&gKbdQueue.head, head + 1);
+    gKbdQueue.high_water = MAX(gKbdQueue.high_water, head + 1 - atomic_get(&gKbdQueue.tail));
+    gKbdQueue.has_latest = false;
+}
+
+static void drain_keyboard(void)
+{
+    k_spinlock_key_t key;
+    int ret = -1;
+    uint8_t pReportBuff[USBHID_PROXY_KBD_REPORT_SIZE];
+    size_t len;
+    atomic_val_t tail;
+
+    atomic_set(&gKbdQueue.is_requested, 1);
+
+    do {
+        if (true != atomic_cas(&gKbdQueue.is_draining, 0, 1)) {
+            return;
+        }
+
+        atomic_clear(&gKbdQueue.is_requested);
+
+        // One state per poll, the ready callback sends the next one
+        tail = atomic_get(&gKbdQueue.tail);
+
+        if (tail != atomic_get(&gKbdQueue.head)) {
+            len = hidOutput_encodeKeyboardState(&gKbdQueue.entries[tail & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)],
+                                                    usbhid_proxyKbdIsBootProtocol(), pReportBuff);
+            ret = usbhid_proxyTrySendReport(1, pReportBuff, len,
+                                        gKbdQueue.capture_cyc[tail & (HID_OUTPUT_KBD_QUEUE_DEPTH - 1)]);
+            if (0 == ret) {
+                atomic_set(&gKbdQueue.tail, tail + 1);
+            }
+        }
+
+        // The slot just freed takes the state held back by a full queue
+        if (true == gKbdQueue.has_latest) {
+            key = k_spin_lock(&gKbdQueue.prod_lock);
+            fold_latest_keyboard();
+            k_spin_unlock(&gKbdQueue.prod_lock, key);
+        }
+
+        atomic_clear(&gKbdQueue.is_draining);
+
+        // A state queued or an endpoint freed while we held the queue would otherwise wait
+    } while (0 != atomic_get(&gKbdQueue.is_requested));
+}
+
+static void keyboard_ready(uint8_t ifaceNum)
+{
+    (void)(ifaceNum);
+    if (true != IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN)) {
+        drain_keyboard();
+    }
+}
+
+#if defined(CONFIG_GHOSTHIDE_SOF_ALIGN)
+static void sof_received(void)
+{
+    atomic_set(&gIsSofSeen, 1);
+
+    // Interrupt IN endpoints are polled early in the frame, land just before the next one.
+    // Restarting a pending timer would push it past this SOF's frame again and again
+    if (0 == k_timer_remaining_ticks(&gSofTimer)) {
+        k_timer_start(&gSofTimer, K_USEC(USEC_PER_MSEC - CONFIG_GHOSTHIDE_SOF_LEAD_US), K_NO_WAIT);
+    }
+}
+
+static void sof_submit(struct k_timer *pTimer)
+{
+    (void)(pTimer);
+    flush_mouse();
+    drain_keyboard();
+}
+
+static void sof_fallback(struct k_timer *pTimer)
+{
+    (void)(pTimer);
+
+    // No SOF for a whole period (suspend, or a host that stopped polling), don't hold the reports
+    if (0 == atomic_clear(&gIsSofSeen)) {
+        flush_mouse();
+        drain_keyboard();
+    }
+}
+#endif
+
+static bool plan_axis(const struct HID_DataDescriptor_t *pDesc, uint32_t bitOff, uint8_t *pSrc) {
+
+    // Unsigned fields would need a zero fix-up on widening, so they are remapped
+    if (true != pDesc->is_signed || 0 != (bitOff % 8)) {
+        return false;
+    }
+
+    if (16 == pDesc->size) {
+        pSrc[0] = bitOff / 8;
+        pSrc[1] = bitOff / 8 + 1;
+        return true;
+    }
+
+    if (8 == pDesc->size) {
+        pSrc[0] = bitOff / 8;
+        pSrc[1] = HID_OUTPUT_PLAN_SIGN | (bitOff / 8);
+        return true;
+    }
+
+    return false;
+}
@@ -27,16 +27,48 @@
 
 LOG_MODULE_REGISTER(hid_parser, LOG_LEVEL_DBG);
 
+/* Private types -------------------------------------------------------------*/
+struct HID_GlobalState_t {
+    uint32_t usage_page;
+    int32_t logical_minimum;
+    int32_t logical_maximum;
+    uint32_t logical_maximum_raw;
+    uint32_t report_size;
+    uint32_t report_count;
+    uint8_t report_id;
+};
+
+struct HID_LocalState_t {
+    uint32_t usages[HID_PARSER_MAX_USAGES];
+    uint32_t usage_count;
+    uint32_t usage_min;
+    uint32_t usage_max;
+    bool has_usage_range;
+    bool is_usage_truncated;    // More than HID_PARSER_MAX_USAGES listed
+};
+
 /* Private function prototypes -----------------------------------------------*/
-static int get_hid_descriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum, 
-                                        struct USB_HID_Descriptor_t **ppHID_Desc);
+static int32_t item_signed_data(const struct HID_Item_t *pItem);
+static uint32_t item_usage(const struct HID_Item_t *pItem, uint32_t usagePage);
+static void parse_global_item(const struct HID_Item_t *pItem, struct HID_GlobalState_t *pGlobal);
+static void parse_local_item(const struct HID_Item_t *pItem, const struct HID_GlobalState_t *pGlobal,
+                                                            struct HID_LocalState_t *pLocal);
+static struct HID_ReportInfo_t *get_report_info(struct HID_ReportLayout_t *pLayout, uint8_t reportID);
+static void add_field(struct HID_ReportLayout_t *pLayout, const struct HID_Field_t *pTemplate,
+                            uint32_t usage, uint32_t usageMax, uint16_t bitOffset, uint16_t count);
+static void compile_main_item(struct HID_ReportLayout_t *pLayout, const struct HID_GlobalState_t *pGlobal,
+                                const struct HID_LocalState_t *pLocal, uint8_t reportType,
+                                                            uint8_t itemFlags, uint32_t appUsage);
+static void group_report_fields(struct HID_ReportLayout_t *pLayout);
+static bool field_has_usage(const struct HID_Field_t *pField, uint8_t reportType,
+                                                uint32_t usage, uint32_t *pIndex);
 static void set_idle(struct USB_Device_t *pUdev, uint8_t interfaceNum, 
                                             uint8_t duration, uint8_t reportID);
 static int get_ep_in(struct USB_Device_t *pUdev, uint8_t interfaceNum, uint8_t *pEP);
 static int hid_get_class_descriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum, 
                                         uint8_t type, uint8_t *pBuff, uint16_t len);
-static int set_report(struct USB_Device_t *udev, uint8_t interfaceNum, 
-                                            uint8_t reportType, uint8_t reportID);
+static int set_report(struct USB_Device_t *udev, uint8_t interfaceNum, uint8_t reportType,
+                        uint8_t reportID, uint8_t *pData, uint16_t len, uint32_t timeout);
 static inline uint8_t *get_report_buffer(struct USBHID_Device_t *pDev, bool isLast);
 static int usbhid_read(struct USBHID_Device_t *pDev, uint8_t *pBuff, int len, int *pActualLen);
 
@@ -131,90 +163,272 @@ uint8_t *HID_fetchItem(uint8_t *pStart, uint8_t *pEnd, struct HID_Item_t *pItem)
 }
 
 /**
- * @brief Parse a report descriptor and return the type of the report descriptor.
- * @param pReport pointer to the report descriptor
- * @param len length of the report descriptor
- * @param pType pointer to the type handle of the report
- * @return 0 on success, error code otherwise
- * on error.
+ * @brief Compile a report descriptor into a flat field table in a single pass.
+ * @param pReport Pointer to the report descriptor
+ * @param len Length of the report descriptor
+ * @param pLayout Pointer to the layout to fill
+ * @return 0 on success, -EINVAL on bad parameters, -ENOTSUP if no device type
+ * could be determined
+ * @note Bit offsets are counted per Report ID and per report type and never
+ * include the Report ID byte itself. Constant (padding) items only advance
+ * the offset. Fields that do not fit in the table are dropped with a warning.
+ * Fields are grouped by Report ID and every report starts out routed as
+ * HID_REPORT_ROUTE_ACCEPT.
  */
-int HID_parseReportDescriptor(uint8_t *pReport, uint16_t len, uint8_t *pType)
+int HID_compileReportLayout(const uint8_t *pReport, uint16_t len, struct HID_ReportLayout_t *pLayout)
 {
-    struct HID_Item_t item = {0};
-    uint8_t *pEnd = pReport + len;
-    uint8_t *pCur = pReport;
-    uint32_t usagePage = 0;
-    uint32_t usage = 0;
-    bool deviceTypeFound = false;
-    
-    if (NULL == pReport || NULL == pType || len < 2) {
+    struct HID_Item_t item;
+    struct HID_GlobalState_t global;
+    struct HID_GlobalState_t globalStack[HID_PARSER_STACK_DEPTH];
+    struct HID_LocalState_t local;
+    uint32_t stackDepth = 0;
+    uint32_t appUsage = 0;
+    uint32_t collectionDepth = 0;
+    bool hasInput = false;
+    bool hasOutput = false;
+    uint8_t *pCur;
+    uint8_t *pEnd;
+
+    if (NULL == pReport || NULL == pLayout || len < 2) {
         return -EINVAL;
     }
-    
-    *pType = 0;
-    
-    // Iterate through the entire descriptor
-    while (pCur < pEnd && true != deviceTypeFound) {
+
+    memset(pLayout, 0x00, sizeof(struct HID_ReportLayout_t));
+    memset(pLayout->report_map, HID_REPORT_INDEX_NONE, sizeof(pLayout->report_map));
+    memset(&global, 0x00, sizeof(global));
+    memset(&local, 0x00, sizeof(local));
+
+    pCur = (uint8_t *)pReport;
+    pEnd = pCur + len;
+
+    while (pCur < pEnd) {
+        uint8_t *pItemStart = pCur;
+
         pCur = HID_fetchItem(pCur, pEnd, &item);
-        if (!pCur) break;
-        
-        if (HID_ITEM_TYPE_GLOBAL == item.type && HID_GLOBAL_ITEM_TAG_USAGE_PAGE == item.tag) {
-            usagePage = item.data.u32 << 16;
-        }
-        else if (HID_ITEM_TYPE_LOCAL == item.type && HID_LOCAL_ITEM_TAG_USAGE == item.tag) {
-            // Store usage
-            usage = usagePage | item.data.u32;
-        }
-        else if (HID_ITEM_TYPE_MAIN == item.type && HID_MAIN_ITEM_TAG_BEGIN_COLLECTION == item.tag) {
-            // Check if this is a standard HID app collection
-            if (HID_GD_MOUSE == usage) {
-                *pType = USBHID_TYPE_MOUSE;
-                deviceTypeFound = true;
-                LOG_INF("Detected HID Mouse (usage=0x%08X)", usage);
+        if (NULL == pCur) {
+            LOG_WRN("Malformed HID item at offset %d", (int)(pItemStart - pReport));
+            break;
+        }
+
+        if (HID_ITEM_FORMAT_LONG == item.format) {
+            continue;
+        }
+
+        switch (item.type) {
+            case HID_ITEM_TYPE_GLOBAL: {
+                if (HID_GLOBAL_ITEM_TAG_PUSH == item.tag) {
+                    if (stackDepth < HID_PARSER_STACK_DEPTH) {
+                        globalStack[stackDepth++] = global;
+                    } else {
+                        LOG_WRN("HID global stack overflow");
+                    }
+                } else if (HID_GLOBAL_ITEM_TAG_POP == item.tag) {
+                    if (stackDepth > 0) {
+                        global = globalStack[--stackDepth];
+                    } else {
+                        LOG_WRN("HID global stack underflow");
+                    }
+                } else {
+                    parse_global_item(&item, &global);
+                    if (HID_GLOBAL_ITEM_TAG_REPORT_ID == item.tag) {
+                        pLayout->has_report_id = true;
+                    }
+                }
+                break;
             }
-            else if (HID_GD_KEYBOARD == usage) {
-                *pType = USBHID_TYPE_KEYBOARD;
-                deviceTypeFound = true;
-                LOG_INF("Detected HID Keyboard (usage=0x%08X)", usage);
+
+            case HID_ITEM_TYPE_LOCAL: {
+                parse_local_item(&item, &global, &local);
+                break;
             }
-        }
-    }
-    
-    if (true != deviceTypeFound) {
-        pCur = pReport;
-        bool hasInput = false;
-        bool hasOutput = false;
-        int inputCount = 0;
-        
-        while (pCur < pEnd) {
-            pCur = HID_fetchItem(pCur, pEnd, &item);
-            if (!pCur) break;
-            
-            if (HID_ITEM_TYPE_MAIN == item.type) {
-                if (HID_MAIN_ITEM_TAG_INPUT == item.tag) {
-                    hasInput = true;
-                    inputCount++;
-                } else if (HID_MAIN_ITEM_TAG_OUTPUT == item.tag) {
-                    hasOutput = true;
+
+            case HID_ITEM_TYPE_MAIN: {
+                switch (item.tag) {
+                    case HID_MAIN_ITEM_TAG_BEGIN_COLLECTION: {
+                        uint32_t usage = (local.usage_count > 0) ? local.usages[0] : local.usage_min;
+
+                        collectionDepth++;
+
+                        if (USBHID_TYPE_NONE == pLayout->hid_type) {
+                            if (HID_GD_MOUSE == usage) {
+                                pLayout->hid_type = USBHID_TYPE_MOUSE;
+                                LOG_INF("Detected HID Mouse (usage=0x%08X)", usage);
+                            } else if (HID_GD_KEYBOARD == usage) {
+                                pLayout->hid_type = USBHID_TYPE_KEYBOARD;
+                                LOG_INF("Detected HID Keyboard (usage=0x%08X)", usage);
+                            }
+                        }
+
+                        // Application collection
+                        if (1 == collectionDepth && 0x01 == item.data.u8) {
+                            appUsage = usage;
+                        }
+                        break;
+                    }
+
+                    case HID_MAIN_ITEM_TAG_END_COLLECTION: {
+                        if (0 == collectionDepth) {
+                            LOG_WRN("Unbalanced END_COLLECTION");
+                            break;
+                        }
+
+                        collectionDepth--;
+                        if (0 == collectionDepth) {
+                            appUsage = 0;
+                        }
+                        break;
+                    }
+
+                    case HID_MAIN_ITEM_TAG_INPUT: {
+                        hasInput = true;
+                        compile_main_item(pLayout, &global, &local, HID_REPORT_TYPE_INPUT, item.data.u8, appUsage);
+                        break;
+                    }
+
+                    case HID_MAIN_ITEM_TAG_OUTPUT: {
+                        hasOutput = true;
+                        compile_main_item(pLayout, &global, &local, HID_REPORT_TYPE_OUTPUT, item.data.u8, appUsage);
+                        break;
+                    }
+
+                    case HID_MAIN_ITEM_TAG_FEATURE: {
+                        compile_main_item(pLayout, &global, &local, HID_REPORT_TYPE_FEATURE, item.data.u8, appUsage);
+                        break;
+                    }
+
+                    default: {
+                        break;
+                    }
                 }
+
+                // Local items only apply to the next main item
+                memset(&local, 0x00, sizeof(local));
+                break;
+            }
+
+            default: {
+                break;
             }
         }
-        
+    }
+
+    // No standard application collection, guess from the item kinds
+    if (USBHID_TYPE_NONE == pLayout->hid_type) {
         if (true == hasInput && true == hasOutput) {
-            *pType = USBHID_TYPE_KEYBOARD;
+            pLayout->hid_type = USBHID_TYPE_KEYBOARD;
             LOG_INF("Detected HID Device - likely a keyboard");
-            return 0;
-        }
-        else if (true == hasInput) {
-            *pType = USBHID_TYPE_MOUSE;
+        } else if (true == hasInput) {
+            pLayout->hid_type = USBHID_TYPE_MOUSE;
             LOG_INF("Detected HID device - likely a mouse");
-            return 0;
+        } else {
+            LOG_ERR("Unknown HID device type");
+            return -ENOTSUP;
         }
-        
-        LOG_ERR("Unknown HID device type");
-        return -ENOTSUP;
     }
-    
+
+    group_report_fields(pLayout);
+
+    pLayout->is_compiled = true;
+    LOG_INF("Compiled HID layout: %d fields, %d reports%s", pLayout->field_count,
+            pLayout->report_count, pLayout->has_report_id ? " (Report IDs)" : "");
+
+    return 0;
+}
+
+/**
+ * @brief Find the variable field that carries a usage
+ * @param pLayout Pointer to the compiled layout
+ * @param reportType HID_REPORT_TYPE_INPUT, _OUTPUT or _FEATURE
+ * @param appUsage Usage of the enclosing application collection, 0 for any
+ * @param usage Usage to look up (page << 16 | id)
+ * @param pIndex Optional pointer receiving the element index inside the field
+ * @return Pointer to the field or NULL if the usage is not present
+ */
+const struct HID_Field_t *HID_findField(const struct HID_ReportLayout_t *pLayout, uint8_t reportType,
+                                        uint32_t appUsage, uint32_t usage, uint32_t *pIndex)
+{
+    if (NULL == pLayout) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < pLayout->field_count; i++) {
+        const struct HID_Field_t *pField = &pLayout->fields[i];
+
+        if (0 != appUsage && appUsage != pField->app_usage) {
+            continue;
+        }
+
+        if (true == field_has_usage(pField, reportType, usage, pIndex)) {
+            return pField;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Find the variable field that carries a usage inside one report
+ * @param pLayout Pointer to the compiled layout
+ * @param reportID Report ID (0 when the descriptor declares none)
+ * @param reportType HID_REPORT_TYPE_INPUT, _OUTPUT or _FEATURE
+ * @param usage Usage to look up (page << 16 | id)
+ * @param pIndex Optional pointer receiving the element index inside the field
+ * @return Pointer to the field or NULL if the report does not carry the usage
+ */
+const struct HID_Field_t *HID_findReportField(const struct HID_ReportLayout_t *pLayout, uint8_t reportID,
+                                        uint8_t reportType, uint32_t usage, uint32_t *pIndex)
+{
+    const struct HID_ReportInfo_t *pInfo = HID_getReportInfo(pLayout, reportID);
+
+    if (NULL == pInfo) {
+        return NULL;
+    }
+
+    for (uint32_t i = pInfo->field_first; i < (uint32_t)pInfo->field_first + pInfo->field_count; i++) {
+        if (true == field_has_usage(&pLayout->fields[i], reportType, usage, pIndex)) {
+            return &pLayout->fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get the summary of a report
+ * @param pLayout Pointer to the compiled layout
+ * @param reportID Report ID (0 when the descriptor declares none)
+ * @return Pointer to the report info or NULL if the ID is unknown
+ */
+const struct HID_ReportInfo_t *HID_getReportInfo(const struct HID_ReportLayout_t *pLayout, uint8_t reportID)
+{
+    uint8_t index;
+
+    if (NULL == pLayout) {
+        return NULL;
+    }
+
+    index = pLayout->report_map[reportID];
+
+    return (HID_REPORT_INDEX_NONE == index) ? NULL : &pLayout->reports[index];
+}
+
+/**
+ * @brief Choose whether reports with a given Report ID are delivered or dropped
+ * @param pLayout Pointer to the compiled layout
+ * @param reportID Report ID (0 when the descriptor declares none)
+ * @param route HID_REPORT_ROUTE_ACCEPT or HID_REPORT_ROUTE_DROP
+ * @return 0 on success, -EINVAL if the Report ID is not part of the layout
+ */
+int HID_setReportRoute(struct HID_ReportLayout_t *pLayout, uint8_t reportID, uint8_t route)
+{
+    struct HID_ReportInfo_t *pInfo = (struct HID_ReportInfo_t *)HID_getReportInfo(pLayout, reportID);
+
+    if (NULL == pInfo) {
+        return -EINVAL;
+    }
+
+    pInfo->route = route;
+
     return 0;
 }
 
@@ -231,13 +445,10 @@ int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num, struct USBHID
     struct USB_HID_Descriptor_t *pHID_Desc = NULL;
     uint8_t *pRawHIDReportDesc = NULL;
     uint16_t rawHIDReportDescLen = 0;
-    struct HID_Item_t item;
     uint8_t hidType = USBHID_TYPE_NONE;
     uint8_t epIN;
-    uint8_t *pCur;
-    uint8_t *pEnd;
     
-    ret = get_hid_descriptor(pUdev, interface_num, &pHID_Desc);
+    ret = USBHID_getHidDescriptor(pUdev, interface_num, &pHID_Desc);
     if ( ret < 0) {
         LOG_ERR("Cannot find HID descriptor for interface %d", interface_num);
         return USBHID_NOT_HID_DEV;
@@ -251,25 +462,15 @@ int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num, struct USBHID
         return USBHID_NOT_SUPPORT;
     }
 
-    pCur = pRawHIDReportDesc;
-    pEnd = pCur + rawHIDReportDescLen;
-    memset(&item, 0x00, sizeof(struct HID_Item_t));
-    
-    while (pCur < pEnd) {
-        pCur = HID_fetchItem(pCur, pEnd, &item);
-        if (NULL == pCur) {
-            break;
-        }
-        
-        if (HID_ITEM_TYPE_GLOBAL == item.type && HID_GLOBAL_ITEM_TAG_REPORT_ID == item.tag) {
-            break;
-        }
-    }
-
     memset(pDev, 0x00, sizeof(struct USBHID_Device_t));
     set_idle(pUdev, interface_num, 0, 0);
     
     rawHIDReportDescLen = sys_le16_to_cpu(pHID_Desc->wClassDescriptorLength);
+    if (0 == rawHIDReportDescLen) {
+        LOG_ERR("Empty report descriptor on interface %d", interface_num);
+        return USBHID_NOT_SUPPORT;
+    }
+
     pRawHIDReportDesc = k_malloc(rawHIDReportDescLen);
     if (NULL == pRawHIDReportDesc) {
         LOG_ERR("Failed to allocate HID report buffer (len=%d)", rawHIDReportDescLen);
@@ -308,11 +509,13 @@ int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num, struct USBHID
         return USBHID_NOT_SUPPORT;
     }
 
-    // Parse report descriptor to determine device type
-    ret = HID_parseReportDescriptor(pRawHIDReportDesc, rawHIDReportDescLen, &hidType);
+    // Compile the report descriptor once, this also determines the device type
+    ret = HID_compileReportLayout(pRawHIDReportDesc, rawHIDReportDescLen, &pDev->layout);
     if (ret < 0) {
         LOG_WRN("Failed to parse report descriptor, trying interface protocol fallback");
         hidType = USBHID_TYPE_NONE;
+    } else {
+        hidType = pDev->layout.hid_type;
     }
 
     // Fallback to interface protocol if parsing failed
@@ -328,11 +531,12 @@ int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num, struct USBHID
     }
 
     if (USBHID_TYPE_KEYBOARD == hidType) {
-        ret = set_report(pUdev, interface_num, HID_REPORT_TYPE_OUTPUT, 0);
-        if (USBHID_SUCCESS != ret) {
-            LOG_ERR("Set report failed");
-            k_free(pRawHIDReportDesc);
-            return USBHID_IO_ERROR;
+        uint8_t dataFragment = 0x00;
+
+        ret = set_report(pUdev, interface_num, HID_REPORT_TYPE_OUTPUT, 0, &dataFragment,
+                                                sizeof(dataFragment), TRANSFER_TIMEOUT);
+        if (CH37X_HOST_SUCCESS != ret) {
+            LOG_WRN("Set report failed (this may be normal for some devices): %d", ret);
         }
     }
 
@@ -348,6 +552,41 @@ int USBHID_open(struct USB_Device_t *pUdev, uint8_t interface_num, struct USBHID
     return USBHID_SUCCESS;
 }
 
+/**
+ * @brief Send an output or feature report to the device without waiting
+ * @param pDev Pointer to the HID device
+ * @param reportType HID_REPORT_TYPE_OUTPUT or HID_REPORT_TYPE_FEATURE
+ * @param reportID Report ID, 0 if the device uses none
+ * @param pData Report data, starting with the ID byte if reportID is not 0
+ * @param len Length of the report data
+ * @return 0 on success, USBHID_BUSY if the device NAKed, error code otherwise
+ * @note Each stage gets a single attempt, so the poll loop is held for one
+ *       SET_REPORT at most. Retry later on USBHID_BUSY.
+ */
+int USBHID_setReport(struct USBHID_Device_t *pDev, uint8_t reportType, uint8_t reportID,
+                                                        uint8_t *pData, uint16_t len) {
+
+    int ret = -1;
+
+    if (NULL == pDev || NULL == pDev->pUdev || NULL == pData || 0 == len) {
+        return USBHID_PARAM_INVALID;
+    }
+
+    ret = set_report(pDev->pUdev, pDev->interface_num, reportType, reportID, pData, len, 0);
+    if (CH37X_HOST_TIMEOUT == ret) {
+        return USBHID_BUSY;
+    }
+    if (CH37X_HOST_DEV_DISCONNECT == ret) {
+        return USBHID_NO_DEV;
+    }
+    if (CH37X_HOST_SUCCESS != ret) {
+        LOG_DBG("SET_REPORT %u/%u failed: %d", reportType, reportID, ret);
+        return USBHID_IO_ERROR;
+    }
+
+    return USBHID_SUCCESS;
+}
+
 /**
  * @brief Close the HID device
  * @param pDev Pointer to the HID device
@@ -408,6 +647,18 @@ int USBHID_fetchReport(struct USBHID_Device_t *pDev) {
     ret = usbhid_read(pDev, pLastReportBuff, pDev->report_len, &actualLen);
 
     if (USBHID_SUCCESS == ret) {
+        pDev->report_cyc = k_cycle_get_32();
+
+        // Reports nobody consumes never reach the double buffer
+        if (true == pDev->layout.has_report_id && actualLen > 0) {
+            const struct HID_ReportInfo_t *pInfo = HID_routeReport(&pDev->layout, pLastReportBuff);
+
+            if (NULL == pInfo || HID_REPORT_ROUTE_ACCEPT != pInfo->route) {
+                pDev->filtered_count++;
+                return USBHID_REPORT_FILTERED;
+            }
+        }
+
         if (0 != pDev->report_buffer_last_offset) {
             pDev->report_buffer_last_offset = 0;
         } else {
@@ -499,35 +750,53 @@ int USBHID_allocReportBuffer(struct USBHID_Device_t *pDev, uint32_t len) {
     return USBHID_SUCCESS;
 }
 
-/* --------------------------------------------------------------------------
- * HELPER FUNCTIONS
- * -------------------------------------------------------------------------*/
-static int get_hid_descriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum, 
+/**
+ * @brief Find the HID class descriptor of an interface in the raw configuration descriptor
+ * @param pUdev Pointer to the USB device
+ * @param interfaceNum Interface number
+ * @param ppHID_Desc Pointer to the descriptor found, points into raw_conf_desc
+ * @return 0 on success, -1 if there is none or the configuration descriptor is malformed
+ * @note A HID descriptor is only taken from inside an interface and only if it
+ * is long enough for a report descriptor length.
+ */
+int USBHID_getHidDescriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum,
                                         struct USB_HID_Descriptor_t **ppHID_Desc) {
     
-    if (NULL == pUdev || NULL == pUdev->raw_conf_desc) {
+    if (NULL == pUdev || NULL == pUdev->raw_conf_desc || NULL == ppHID_Desc) {
         return -1;
     }
 
-    struct usb_desc_header *pDesc = (struct usb_desc_header *)pUdev->raw_conf_desc;
-    void *pRawConfDescEnd = (uint8_t *)pUdev->raw_conf_desc + pUdev->raw_conf_desc_len;
+    uint8_t *pCur = (uint8_t *)pUdev->raw_conf_desc;
+    uint8_t *pEnd = pCur + pUdev->raw_conf_desc_len;
+    bool isInInterface = false;
     uint8_t curInterfaceNum = 0;
 
-    while ((void *)pDesc < pRawConfDescEnd) {
+    while (pCur + sizeof(struct usb_desc_header) <= pEnd) {
+        struct usb_desc_header *pDesc = (struct usb_desc_header *)pCur;
+
         if (0 == pDesc->bLength) {
             LOG_ERR("Descriptor with zero length encountered");
             return -1;
         }
 
+        if (pCur + pDesc->bLength > pEnd) {
+            LOG_ERR("Descriptor runs past the configuration descriptor end");
+            return -1;
+        }
+
         switch (pDesc->bDescriptorType) {
             
             case USB_DESC_INTERFACE: {
-                curInterfaceNum = ((struct usb_if_descriptor *)pDesc)->bInterfaceNumber;
+                isInInterface = (pDesc->bLength >= sizeof(struct usb_if_descriptor));
+                if (isInInterface) {
+                    curInterfaceNum = ((struct usb_if_descriptor *)pDesc)->bInterfaceNumber;
+                }
                 break;
             }
 
             case USB_DESC_HID: {
-                if (curInterfaceNum == interfaceNum) {
+                if (isInInterface && curInterfaceNum == interfaceNum &&
+                            pDesc->bLength >= sizeof(struct USB_HID_Descriptor_t)) {
                     *ppHID_Desc = (struct USB_HID_Descriptor_t *)pDesc;
                     return 0;
                 }
@@ -541,12 +810,15 @@ static int get_hid_descriptor(struct USB_Device_t *pUdev, uint8_t interfaceNum,
 
         }
 
-        pDesc = (struct usb_desc_header *)((uint8_t *)pDesc + pDesc->bLength);
+        pCur += pDesc->bLength;
     }
 
     return -1;
 }
 
+/* --------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ * -------------------------------------------------------------------------*/
 static void set_idle(struct USB_Device_t *pUdev, uint8_t interfaceNum, uint8_t duration, uint8_t reportID) {
 
     int ret = -1;
@@ -597,18 +869,18 @@ static int hid_get_class_descriptor(struct USB_Device_t *pUdev, uint8_t interfac
                 return USBHID_SUCCESS;
             }
             
-            // Try to get the rest
+            // Try to get the rest. GET_DESCRIPTOR always starts at offset 0,
+            // so ask for the whole descriptor again rather than the tail
             if (len > actualLen) {
-                int remainingLen = len - actualLen;
-                int additionalLen = 0;
+                int fullLen = 0;
                 
-                LOG_DBG("Attempting to read remaining %d bytes", remainingLen);
+                LOG_DBG("Attempting to read all %d bytes", len);
                 ret = ch375_hostControlTransfer(pUdev, USB_REQ_TYPE(USB_DIR_IN, USB_TYPE_STANDARD, USB_RECIP_INTERFACE),
-                USB_SREQ_GET_DESCRIPTOR, (type << 8) | 0, interfaceNum, pBuff + actualLen, remainingLen, 
-                                                                                    &additionalLen, TRANSFER_TIMEOUT);
+                USB_SREQ_GET_DESCRIPTOR, (type << 8) | 0, interfaceNum, pBuff, len, 
+                                                                                    &fullLen, TRANSFER_TIMEOUT);
                 
-                if (CH37X_HOST_SUCCESS == ret && additionalLen > 0) {
-                    LOG_INF(" Got additional %d bytes, total %d", additionalLen, actualLen + additionalLen);
+                if (CH37X_HOST_SUCCESS == ret && fullLen > actualLen) {
+                    LOG_INF(" Got %d bytes in full", fullLen);
                     return USBHID_SUCCESS;
                 }
             }
@@ -659,24 +931,15 @@ static int hid_get_class_descriptor(struct USB_Device_t *pUdev, uint8_t interfac
     return USBHID_ERROR;
 }
 
-static int set_report(struct USB_Device_t *pUdev, uint8_t interfaceNum, uint8_t reportType, 
-                                                                        uint8_t reportID) {
+static int set_report(struct USB_Device_t *pUdev, uint8_t interfaceNum, uint8_t reportType,
+                        uint8_t reportID, uint8_t *pData, uint16_t len, uint32_t timeout) {
     
-    int ret = -1;
     int actualLen = 0;
-    uint8_t dataFragment = 0x00;
 
     // 0x21 | CLASS | INTERFACE
-    ret = ch375_hostControlTransfer(pUdev, USB_REQ_TYPE(USB_DIR_OUT, USB_TYPE_CLASS, USB_RECIP_INTERFACE),
-    HID_SET_REPORT, (reportType << 8) | reportID, interfaceNum, &dataFragment, sizeof(dataFragment), 
-                                                                            &actualLen, TRANSFER_TIMEOUT);
-        
-    if (CH37X_HOST_SUCCESS != ret) {
-        LOG_WRN("Set report failed (this may be normal for some devices): %d", ret);
-        return USBHID_SUCCESS;
-    }
-
-    return USBHID_SUCCESS;
+    return ch375_hostControlTransfer(pUdev, USB_REQ_TYPE(USB_DIR_OUT, USB_TYPE_CLASS, USB_RECIP_INTERFACE),
+                    HID_SET_REPORT, (reportType << 8) | reportID, interfaceNum, pData, len, 
+                                                                            &actualLen, timeout);
 }
 
 static inline uint8_t *get_report_buffer(struct USBHID_Device_t *pDev, bool isLast) {
@@ -749,4 +1012,284 @@ static int usbhid_read(struct USBHID_Device_t *pDev, uint8_t *pBuff, int len, in
     }
 
     return USBHID_IO_ERROR;
-}
\ No newline at end of file
+}
+
+static int32_t item_signed_data(const struct HID_Item_t *pItem) {
+
+    switch (pItem->size) {
+        case 1: {
+            return pItem->data.s8;
+        }
+
+        case 2: {
+            return pItem->data.s16;
+        }
+
+        case 4: {
+            return pItem->data.s32;
+        }
+
+        default: {
+            return 0;
+        }
+    }
+}
+
+static uint32_t item_usage(const struct HID_Item_t *pItem, uint32_t usagePage) {
+
+    // 4-byte usages are extended usages and carry their own page
+    if (4 == pItem->size) {
+        return pItem->data.u32;
+    }
+
+    return usagePage | (pItem->data.u32 & 0xFFFF);
+}
+
+static void parse_global_item(const struct HID_Item_t *pItem, struct HID_GlobalState_t *pGlobal) {
+
+    switch (pItem->tag) {
+        case HID_GLOBAL_ITEM_TAG_USAGE_PAGE: {
+            pGlobal->usage_page = pItem->data.u32 << 16;
+            break;
+        }
+
+        case HID_GLOBAL_ITEM_TAG_LOGICAL_MINIMUM: {
+            pGlobal->logical_minimum = item_signed_data(pItem);
+            break;
+        }
+
+        case HID_GLOBAL_ITEM_TAG_LOGICAL_MAXIMUM: {
+            pGlobal->logical_maximum = item_signed_data(pItem);
+            pGlobal->logical_maximum_raw = pItem->data.u32;
+            break;
+        }
+
+        case HID_GLOBAL_ITEM_TAG_REPORT_SIZE: {
+            pGlobal->report_size = pItem->data.u32;
+            break;
+        }
+
+        case HID_GLOBAL_ITEM_TAG_REPORT_COUNT: {
+            pGlobal->report_count = pItem->data.u32;
+            break;
+        }
+
+        case HID_GLOBAL_ITEM_TAG_REPORT_ID: {
+            pGlobal->report_id = pItem->data.u8;
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+}
+
+static void parse_local_item(const struct HID_Item_t *pItem, const struct HID_GlobalState_t *pGlobal,
+                                                            struct HID_LocalState_t *pLocal) {
+
+    switch (pItem->tag) {
+        case HID_LOCAL_ITEM_TAG_USAGE: {
+            if (pLocal->usage_count < HID_PARSER_MAX_USAGES) {
+                pLocal->usages[pLocal->usage_count++] = item_usage(pItem, pGlobal->usage_page);
+            } else {
+                pLocal->is_usage_truncated = true;
+            }
+            break;
+        }
+
+        case HID_LOCAL_ITEM_TAG_USAGE_MINIMUM: {
+            pLocal->usage_min = item_usage(pItem, pGlobal->usage_page);
+            pLocal->has_usage_range = true;
+            break;
+        }
+
+        case HID_LOCAL_ITEM_TAG_USAGE_MAXIMUM: {
+            pLocal->usage_max = item_usage(pItem, pGlobal->usage_page);
+            pLocal->has_usage_range = true;
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+}
+
+static struct HID_ReportInfo_t *get_report_info(struct HID_ReportLayout_t *pLayout, uint8_t reportID) {
+
+    struct HID_ReportInfo_t *pInfo = (struct HID_ReportInfo_t *)HID_getReportInfo(pLayout, reportID);
+
+    if (NULL != pInfo) {
+        return pInfo;
+    }
+
+    if (pLayout->report_count >= HID_LAYOUT_MAX_REPORTS) {
+        LOG_WRN("Too many Report IDs, ignoring ID %d", reportID);
+        return NULL;
+    }
+
+    pLayout->report_map[reportID] = pLayout->report_count;
+    pInfo = &pLayout->reports[pLayout->report_count++];
+    memset(pInfo, 0x00, sizeof(struct HID_ReportInfo_t));
+    pInfo->report_id = reportID;
+    pInfo->route = HID_REPORT_ROUTE_ACCEPT;
+
+    return pInfo;
+}
+
+static void add_field(struct HID_ReportLayout_t *pLayout, const struct HID_Field_t *pTemplate,
+                            uint32_t usage, uint32_t usageMax, uint16_t bitOffset, uint16_t count) {
+
+    struct HID_Field_t *pField;
+
+    if (pLayout->field_count >= HID_LAYOUT_MAX_FIELDS) {
+        LOG_WRN("HID layout full, dropping usage 0x%08X", usage);
+        return;
+    }
+
+    pField = &pLayout->fields[pLayout->field_count++];
+    *pField = *pTemplate;
+    pField->usage = usage;
+    pField->usage_max = usageMax;
+    pField->bit_offset = bitOffset;
+    pField->count = count;
+
+    LOG_DBG("  field: usage=0x%08X..0x%08X id=%d type=%d bit=%d size=%d count=%d", usage, usageMax,
+            pField->report_id, pField->report_type, bitOffset, pField->bit_size, count);
+}
+
+static void compile_main_item(struct HID_ReportLayout_t *pLayout, const struct HID_GlobalState_t *pGlobal,
+                                const struct HID_LocalState_t *pLocal, uint8_t reportType,
+                                                            uint8_t itemFlags, uint32_t appUsage) {
+
+    struct HID_ReportInfo_t *pInfo;
+    struct HID_Field_t field;
+    uint16_t *pBitCursor;
+    uint64_t totalBits = (uint64_t)pGlobal->report_size * pGlobal->report_count;
+    uint32_t count = pGlobal->report_count;
+
+    if (0 == totalBits) {
+        return;
+    }
+
+    pInfo = get_report_info(pLayout, pGlobal->report_id);
+    if (NULL == pInfo) {
+        return;
+    }
+
+    if (HID_REPORT_TYPE_INPUT == reportType) {
+        pBitCursor = &pInfo->input_bits;
+    } else if (HID_REPORT_TYPE_OUTPUT == reportType) {
+        pBitCursor = &pInfo->output_bits;
+    } else {
+        pBitCursor = &pInfo->feature_bits;
+    }
+
+    if (*pBitCursor + totalBits > UINT16_MAX) {
+        LOG_WRN("Report %d too long, ignoring item", pGlobal->report_id);
+        return;
+    }
+
+    // Padding and fields wider than 32 bits only take up space
+    if (0 != (itemFlags & HID_FIELD_CONSTANT) || pGlobal->report_size > 32) {
+        *pBitCursor += totalBits;
+        return;
+    }
+
+    memset(&field, 0x00, sizeof(field));
+    field.app_usage = appUsage;
+    field.logical_minimum = pGlobal->logical_minimum;
+    field.logical_maximum = pGlobal->logical_maximum;
+    field.bit_size = pGlobal->report_size;
+    field.report_id = pGlobal->report_id;
+    field.report_type = reportType;
+    field.flags = itemFlags & (HID_FIELD_CONSTANT | HID_FIELD_VARIABLE | HID_FIELD_RELATIVE);
+
+    // Logical Maximum written as an unsigned byte (e.g. 0xFF) with a positive minimum
+    if (field.logical_minimum >= 0 && field.logical_maximum < field.logical_minimum) {
+        field.logical_maximum = (int32_t)pGlobal->logical_maximum_raw;
+    }
+
+    if (field.logical_minimum < 0) {
+        field.flags |= HID_FIELD_SIGNED;
+    }
+
+    if (0 != (itemFlags & HID_FIELD_VARIABLE) && pLocal->usage_count > 0) {
+        // One entry per listed usage, the last usage covers the remaining elements
+        // unless the list was cut short, then those stay unmapped
+        if (pLocal->is_usage_truncated) {
+            LOG_WRN("Usage list longer than %d, mapping the first %d elements only", HID_PARSER_MAX_USAGES,
+                                                                                HID_PARSER_MAX_USAGES);
+        }
+
+        for (uint32_t i = 0; i < pLocal->usage_count && i < count; i++) {
+            bool isLast = (i == pLocal->usage_count - 1) && (true != pLocal->is_usage_truncated);
+            uint32_t elemCount = isLast ? (count - i) : 1;
+
+            add_field(pLayout, &field, pLocal->usages[i], pLocal->usages[i],
+                        *pBitCursor + i * pGlobal->report_size, elemCount);
+        }
+    } else if (true == pLocal->has_usage_range) {
+        add_field(pLayout, &field, pLocal->usage_min, pLocal->usage_max, *pBitCursor, count);
+    } else {
+        uint32_t usage = (pLocal->usage_count > 0) ? pLocal->usages[0] : 0;
+        uint32_t usageMax = (pLocal->usage_count > 0) ? pLocal->usages[pLocal->usage_count - 1] : 0;
+
+        add_field(pLayout, &field, usage, usageMax, *pBitCursor, count);
+    }
+
+    *pBitCursor += totalBits;
+}
+
+static void group_report_fields(struct HID_ReportLayout_t *pLayout) {
+
+    // Stable insertion sort keeps the descriptor order inside each report
+    for (uint32_t i = 1; i < pLayout->field_count; i++) {
+        struct HID_Field_t field = pLayout->fields[i];
+        uint32_t j = i;
+
+        while (j > 0 && pLayout->fields[j - 1].report_id > field.report_id) {
+            pLayout->fields[j] = pLayout->fields[j - 1];
+            j--;
+        }
+        pLayout->fields[j] = field;
+    }
+
+    for (uint32_t i = 0; i < pLayout->field_count; i++) {
+        const struct HID_Field_t *pField = &pLayout->fields[i];
+        struct HID_ReportInfo_t *pInfo = (struct HID_ReportInfo_t *)HID_getReportInfo(pLayout,
+                                                                                pField->report_id);
+
+        if (NULL == pInfo) {
+            continue;
+        }
+
+        if (0 == pInfo->field_count) {
+            pInfo->field_first = i;
+        }
+        pInfo->field_count++;
+
+        if (0 == pInfo->app_usage) {
+            pInfo->app_usage = pField->app_usage;
+        }
+    }
+}
+
+static bool field_has_usage(const struct HID_Field_t *pField, uint8_t reportType,
+                                                uint32_t usage, uint32_t *pIndex) {
+
+    if (reportType != pField->report_type || 0 == (pField->flags & HID_FIELD_VARIABLE)) {
+        return false;
+    }
+
+    if (usage < pField->usage || usage > pField->usage_max) {
+        return false;
+    }
+
+    if (NULL != pIndex) {
+        *pIndex = MIN(usage - pField->usage, (uint32_t)pField->count - 1);
+    }
+
+    return true;
+}
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           boot_timeline.h
+ * @brief          Power-on to first forwarded report, phase by phase
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Each boot phase is stamped the first time it is reached, in microseconds
+ * since reset. Phases that happen per CH37x port are stamped per port, the
+ * phase itself once every port got there. Later sessions (reconnects) do not
+ * move the stamps. The timeline is logged once the first report went out to
+ * the host, the `boot` shell command prints it at any time.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define BOOT_TIMELINE_PORT_COUNT    2
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Boot phases, in the order they are reached
+ */
+typedef enum {
+    BOOT_PHASE_MAIN = 0,        // main() entered, kernel and drivers are up
+    BOOT_PHASE_LINK_READY,      // CH37x answers at the work baud rate (per port)
+    BOOT_PHASE_CONNECTED,       // Upstream device attached (per port)
+    BOOT_PHASE_ENUMERATED,      // Upstream device opened (per port)
+    BOOT_PHASE_USB_READY,       // Host configured the proxy
+    BOOT_PHASE_FIRST_REPORT,    // First report submitted to the host
+    BOOT_PHASE_COUNT
+} BootPhase_e;
+
+/**
+ * @brief Every stamp, in us since reset
+ */
+struct BootTimeline_t {
+    uint32_t reached;                                           // Bit per BootPhase_e
+    uint64_t phase_us[BOOT_PHASE_COUNT];
+    uint8_t port_reached[BOOT_PHASE_COUNT];                     // Bit per port
+    uint64_t port_us[BOOT_PHASE_COUNT][BOOT_TIMELINE_PORT_COUNT];
+};
+
+/* Function prototypes ------------------------------------------------------*/
+void bootTimeline_mark(BootPhase_e phase);
+void bootTimeline_markPort(BootPhase_e phase, uint8_t port);
+void bootTimeline_get(struct BootTimeline_t *pTimeline);
+void bootTimeline_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_TIMELINE_H */
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           fwd_stats.h
+ * @brief          Forwarding meters: report rates, drops and coalescing
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * One place to read how reports flow through the proxy. Input reports and
+ * filtered (non-pointer) reports are counted per CH37x port here, output
+ * reports, busy endpoints, failed writes and drops come from the proxy and
+ * the keyboard queue. Nothing on the forwarding path logs, the counters are
+ * read by the rate log and the `stats` shell command.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef FWD_STATS_H
+#define FWD_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include "usb_hid_proxy.h"
+
+/* Macros -------------------------------------------------------------------*/
+#define FWD_STATS_PORT_COUNT    2
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Every forwarding counter at one point in time, all wrap around
+ */
+struct FwdStats_Counters_t {
+    uint32_t in_reports[FWD_STATS_PORT_COUNT];      // Reports fetched from the port
+    uint32_t in_filtered[FWD_STATS_PORT_COUNT];     // Reports the layout routing dropped (other Report ID)
+    struct USBHID_ProxySendStats_t out[USBHID_PROXY_IFACE_COUNT];
+    uint32_t out_queue_drops;                       // Host to device reports lost to a full queue
+    uint32_t kbd_collapsed;
+    uint32_t kbd_overflowed;
+};
+
+/**
+ * @brief Measurement window, owned by whoever reports rates over it
+ */
+struct FwdStats_Window_t {
+    struct FwdStats_Counters_t base;
+    int64_t start_ms;
+};
+
+/* Function prototypes ------------------------------------------------------*/
+void fwdStats_setPortName(uint8_t port, const char *pName);
+void fwdStats_countInput(uint8_t port, int fetchRet);
+void fwdStats_get(struct FwdStats_Counters_t *pCounters);
+void fwdStats_getTotals(struct FwdStats_Counters_t *pTotals);
+void fwdStats_reset(void);
+void fwdStats_windowStart(struct FwdStats_Window_t *pWin, int64_t nowMs);
+int64_t fwdStats_windowRoll(struct FwdStats_Window_t *pWin, int64_t nowMs, struct FwdStats_Counters_t *pDelta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FWD_STATS_H */
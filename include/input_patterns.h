@@ -36,6 +36,7 @@ extern "C" {
 #include <string.h>
 
 /* Macros -------------------------------------------------------------------*/
+// Recoil pattern step in ms, independent of the USB poll interval
 #define USB_REPORT_INTERVAL             8
 #define RECOIL_COMP_DEFAULT_COEFF       1.0f
 #define RECOIL_COMP_DEFAULT_SENS        2.5f
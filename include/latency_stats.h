@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           latency_stats.h
+ * @brief          Report latency histograms from CH37x arrival to host delivery
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Every forwarded report is timed from the moment its CH37x transfer completed.
+ * Each stage it passes (decode, endpoint submit, host took it) is kept in a
+ * fixed-bucket histogram per interface, all measured from that arrival.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define LATENCY_STATS_IFACE_COUNT   2
+#define LATENCY_STATS_BUCKET_US     125     // One eighth of a full speed frame
+#define LATENCY_STATS_BUCKETS       32      // Last bucket collects everything older
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Point of the pipeline a report reached, each timed from its arrival
+ */
+typedef enum {
+    LATENCY_STAGE_DECODE,       // Report decoded into a state
+    LATENCY_STAGE_SUBMIT,       // Report written to the IN endpoint
+    LATENCY_STAGE_HOST,         // Host took the report (int_in_ready)
+    LATENCY_STAGE_COUNT
+} LatencyStage_e;
+
+/**
+ * @brief Histogram of one stage of one interface
+ */
+struct LatencyStats_Hist_t {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t buckets[LATENCY_STATS_BUCKETS];
+};
+
+/**
+ * @brief Percentiles of a histogram, p50/p99 are bucket upper bounds
+ */
+struct LatencyStats_Summary_t {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+/* Function prototypes ------------------------------------------------------*/
+void latencyStats_reset(void);
+void latencyStats_record(uint8_t ifaceNum, LatencyStage_e stage, uint32_t arrivalCyc);
+void latencyStats_get(uint8_t ifaceNum, LatencyStage_e stage, struct LatencyStats_Hist_t *pHist);
+int latencyStats_summarize(uint8_t ifaceNum, LatencyStage_e stage, struct LatencyStats_Summary_t *pSummary);
+void latencyStats_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_STATS_H */
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           mem_report.h
+ * @brief          Stack, heap and static RAM report
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * With CONFIG_GHOSTHIDE_MEM_REPORT the RAM in use can be read at run time:
+ * the high-water mark of every thread stack (and of the interrupt stacks),
+ * current and peak use of the system heap, and
+ * the static RAM of each module. A module declares its large buffers with
+ * MEM_REPORT_STATIC() next to their definition, the rest of the image is
+ * reported as one remainder. main logs the report once after the first
+ * successful enumeration, the `mem` shell command prints it at any time.
+ * Without the option MEM_REPORT_STATIC() expands to nothing.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define MEM_REPORT_MAX_STACKS   16      // Threads and interrupt stacks reported
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief High-water mark of one stack
+ */
+struct MemReport_Stack_t {
+    const char *name;
+    size_t size;
+    size_t used;                // Deepest use since the thread started
+};
+
+/**
+ * @brief System heap use, in bytes
+ */
+struct MemReport_Heap_t {
+    size_t size;                // Free plus allocated, chunk headers excluded
+    size_t used;
+    size_t peak;                // Most ever allocated at once
+};
+
+/**
+ * @brief Static RAM of one buffer, see MEM_REPORT_STATIC()
+ */
+struct MemReport_Static_t {
+    const char *module;
+    const char *symbol;
+    size_t size;
+};
+
+/**
+ * @brief Whole image RAM, in bytes
+ */
+struct MemReport_Image_t {
+    size_t ram_size;            // Chosen SRAM, 0 when unknown
+    size_t image;               // data, bss and noinit together
+    size_t data;
+    size_t bss;
+    size_t declared;            // Sum of every MEM_REPORT_STATIC()
+};
+
+#if defined(CONFIG_GHOSTHIDE_MEM_REPORT)
+/**
+ * @brief Account a static buffer to a module
+ * @param _module module name, a bare token
+ * @param _var the buffer, at file scope after its definition
+ */
+#define MEM_REPORT_STATIC(_module, _var)                                        \
+    static const STRUCT_SECTION_ITERABLE(MemReport_Static_t,                    \
+                                          gMemReport_##_module##_##_var) = {   \
+        .module = #_module,                                                     \
+        .symbol = #_var,                                                        \
+        .size = sizeof(_var),                                                   \
+    }
+#else
+#define MEM_REPORT_STATIC(_module, _var)
+#endif
+
+/* Function prototypes ------------------------------------------------------*/
+int memReport_getStacks(struct MemReport_Stack_t *pStacks, int maxCount);
+int memReport_getHeap(struct MemReport_Heap_t *pHeap);
+void memReport_getImage(struct MemReport_Image_t *pImage);
+size_t memReport_getModuleStatic(const char *pModule);
+void memReport_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_REPORT_H */
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           trace_points.h
+ * @brief          Binary trace points for the forwarding path
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * With CONFIG_GHOSTHIDE_TRACE every TRACE_POINT() writes one 16 byte record
+ * (cycle timestamp, event, port, two arguments) into a RAM ring, the newest
+ * records overwrite the oldest. The ring is dumped as hex lines on the console
+ * and decoded on the host with scripts/trace_decode.py, which reads the event
+ * names from the enum below, so keep new events at the end. Without the option
+ * TRACE_POINT() expands to nothing and its arguments are never evaluated.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef TRACE_POINTS_H
+#define TRACE_POINTS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/* Macros -------------------------------------------------------------------*/
+#define TRACE_POINTS_PORT_COUNT     2
+#define TRACE_POINTS_PORT_NONE      0xFF    // Context not bound to a port
+
+/* Type Definitions ---------------------------------------------------------*/
+/**
+ * @brief Trace events, arguments in brackets
+ * @note `port` is the CH37x port, for device side events the interface.
+ */
+typedef enum {
+    TRACE_EVT_NONE = 0,
+    TRACE_EVT_FETCH,            // Report fetched (result, length)
+    TRACE_EVT_IN_DATA,          // Interrupt IN data read (length, offset before it)
+    TRACE_EVT_IN_NAK,           // Interrupt IN NAKed (NAKs so far, offset)
+    TRACE_EVT_IN_TIMEOUT,       // Interrupt IN ended by a NAK after a short packet (offset, NAKs)
+    TRACE_EVT_CTRL_PACKET,      // Control IN data packet (length, total so far)
+    TRACE_EVT_CTRL_NAK,         // Control IN data stage NAKed (NAKs so far, total so far)
+    TRACE_EVT_SUBMIT,           // Report written to the IN endpoint (length, result)
+    TRACE_EVT_EP_READY,         // Host took the report from the IN endpoint
+    TRACE_EVT_RECOIL,           // Recoil compensation switched by LMB (on, 0)
+    TRACE_EVT_COUNT
+} TracePoints_Event_e;
+
+/**
+ * @brief One ring entry, little endian as dumped
+ */
+struct TracePoints_Record_t {
+    uint32_t cyc;
+    uint16_t event;
+    uint8_t port;
+    uint8_t reserved;
+    int32_t arg0;
+    int32_t arg1;
+};
+
+#if defined(CONFIG_GHOSTHIDE_TRACE)
+#define TRACE_POINT(event, port, arg0, arg1)                                    \
+    tracePoints_record((event), (port), (int32_t)(arg0), (int32_t)(arg1))
+#else
+#define TRACE_POINT(event, port, arg0, arg1)    do { } while (0)
+#endif
+
+/* Function prototypes ------------------------------------------------------*/
+void tracePoints_record(uint16_t event, uint8_t port, int32_t arg0, int32_t arg1);
+void tracePoints_bindPort(const void *pCtx, uint8_t port);
+uint8_t tracePoints_portOf(const void *pCtx);
+void tracePoints_clear(void);
+void tracePoints_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_POINTS_H */
@@ -13,14 +13,19 @@
  * @details
  * USB HID proxy implementing a composite HID device exposing separate mouse 
  * and keyboard interfaces. This module:
- *  - Registers standard HID report descriptors for a multi-button mouse 
- *      (8-button, 16-bit X/Y, 8-bit wheel) and a standard 6-key keyboard
+ *  - Registers HID report descriptors for a mouse with 1..8 buttons, set at
+ *      runtime from the enumerated mouse (16-bit X/Y, 8-bit wheel), and an
+ *      NKRO keyboard whose report starts with a boot-compatible 8-byte prefix
  * 
  * - Binds to Zephyr HID device instances ("HID_0" and "HID_1"), registers 
  *      descriptors and initializes the HID class devices.
  * 
- * - Provides a thread-safe send API (USB_HID_proxySendReport) using semaphores
- *      that start at 1 to coordinate endpoint writes and the INT callbacks
+ * - Provides a non-blocking send API (usbhid_proxyTrySendReport). A busy IN
+ *      endpoint is reported back, the caller keeps the report and resends it
+ *      from the ready callback
+ * 
+ * - Runs on the legacy usb_device stack by default, or on USBD (device_next)
+ *      with CONFIG_GHOSTHIDE_USBD, which only exposes the enumerated inputs
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -35,8 +40,13 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
+#if defined(CONFIG_GHOSTHIDE_USBD)
+#include <zephyr/usb/usbd.h>
+#include <zephyr/usb/class/usbd_hid.h>
+#else
 #include <zephyr/usb/usb_device.h>
 #include <zephyr/usb/class/usb_hid.h>
+#endif
 #include <zephyr/logging/log.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -47,14 +57,113 @@ extern "C" {
 #endif
 
 /**
- * @brief Initialize USB HID
+ * @brief Keyboard interface report layout (NKRO, boot report compatible)
+ */
+#define USBHID_PROXY_KBD_REPORT_SIZE        24
+#define USBHID_PROXY_KBD_BOOT_REPORT_SIZE   8
+#define USBHID_PROXY_KBD_BITMAP_OFFSET      8
+#define USBHID_PROXY_KBD_BITMAP_USAGES      128
+
+#define USBHID_PROXY_MOUSE_REPORT_SIZE      6
+
+#define USBHID_PROXY_IFACE_COUNT            2
+#define USBHID_PROXY_REPORT_MAX             32      // Largest report of any interface
+
+#define USBHID_PROXY_OUT_REPORT_MAX         8       // Host to device report payload
+#define USBHID_PROXY_OUT_QUEUE_DEPTH        4
+
+/**
+ * @brief Output or feature report the host sent to an interface
+ * @note `type` is HID_REPORT_TYPE_OUTPUT or HID_REPORT_TYPE_FEATURE, `data`
+ *       starts with the ID byte if `id` is not 0.
+ */
+struct USBHID_ProxyOutReport_t {
+    uint8_t iface;
+    uint8_t type;
+    uint8_t id;
+    uint8_t len;
+    uint8_t data[USBHID_PROXY_OUT_REPORT_MAX];
+};
+
+/**
+ * @brief Interfaces to expose, worked out from the enumerated inputs
+ * @note The legacy backend always exposes both interfaces, USBD only the ones
+ *       present. The mouse descriptor declares `mouse_buttons` buttons (1..8).
+ */
+struct USBHID_ProxyLayout_t {
+    bool has_mouse;
+    bool has_keyboard;
+    uint8_t mouse_buttons;
+};
+
+/**
+ * @brief Device side send counters of one interface since usbhid_proxyInit(), all wrap around
+ */
+struct USBHID_ProxySendStats_t {
+    uint32_t sent;          // Reports written to the IN endpoint
+    uint32_t busy;          // Writes that found the endpoint in flight (retried later)
+    uint32_t failed;        // Writes the USB stack rejected
+    uint32_t not_ready;     // Reports offered before the host configured the device
+    uint32_t coalesced;     // Reports merged into one still waiting for the host
+    uint32_t dropped;       // Reports lost to a full output queue, never reach the host
+};
+
+/**
+ * @brief Called from USB context when an interface's IN endpoint is free again
+ */
+typedef void (*usbhid_proxyReadyCb_t)(uint8_t ifaceNum);
+
+/**
+ * @brief Called from USB context on every start of frame
+ */
+typedef void (*usbhid_proxySofCb_t)(void);
+
+/**
+ * @brief Initialize USB HID, NULL layout exposes both interfaces with 8 buttons
  */
-int usbhid_proxyInit(void);
+int usbhid_proxyInit(const struct USBHID_ProxyLayout_t *pLayout);
 
 /**
- * @brief Send HID report
+ * @brief Send HID report if the endpoint is free, never blocks
  */
-int usbhid_proxySendReport(uint8_t ifaceNum, uint8_t *pReport, size_t len);
+int usbhid_proxyTrySendReport(uint8_t ifaceNum, uint8_t *pReport, size_t len, uint32_t captureCyc);
+
+/**
+ * @brief Register the endpoint ready hook of an interface
+ */
+void usbhid_proxySetReadyCallback(uint8_t ifaceNum, usbhid_proxyReadyCb_t cb);
+
+/**
+ * @brief Register the start of frame hook
+ */
+void usbhid_proxySetSofCallback(usbhid_proxySofCb_t cb);
+
+/**
+ * @brief Copy the send counters of an interface
+ */
+void usbhid_proxyGetSendStats(uint8_t ifaceNum, struct USBHID_ProxySendStats_t *pStats);
+
+/**
+ * @brief Count reports the output layer merged or could not queue
+ */
+void usbhid_proxyCountCoalesced(uint8_t ifaceNum);
+void usbhid_proxyCountDropped(uint8_t ifaceNum);
+
+/**
+ * @brief Take the oldest queued host to device report of an interface
+ * @return 0 if one was taken, -EAGAIN if none is queued
+ */
+int usbhid_proxyTakeOutReport(uint8_t ifaceNum, struct USBHID_ProxyOutReport_t *pOut);
+
+/**
+ * @brief Put a report taken with usbhid_proxyTakeOutReport() back at the head
+ */
+void usbhid_proxyRequeueOutReport(const struct USBHID_ProxyOutReport_t *pOut);
+
+/**
+ * @brief Host to device reports dropped because the queue was full
+ */
+uint32_t usbhid_proxyGetOutReportDrops(void);
 
 /**
  * @brief USB disable and reset of globals and semaphopres
@@ -66,6 +175,11 @@ void usbhid_proxyCleanup(void);
  */
 bool usbhid_proxyIsReady(void);
 
+/**
+ * @brief Check whether the keyboard interface runs in boot protocol
+ */
+bool usbhid_proxyKbdIsBootProtocol(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Extract GhostHIDe benchmark results from a console log.
+
+Run tests/benchmark on native_sim and feed its console (twister keeps it as
+handler.log) to this script:
+
+    scripts/bench_extract.py --json bench.json --csv bench.csv handler.log
+    scripts/bench_extract.py --baseline tests/benchmark/src/bench_baseline.h run1.log run2.log
+    scripts/bench_extract.py --parse parse.json handler.log
+
+--parse writes the descriptor parse times over tests/corpus and the
+per-directory throughput. With several logs the baseline keeps the worst value of every metric, which
+is the way to absorb the noise of the CPU time metrics on a shared runner. Only rows with status
+"regressed" make the exit code non-zero, CPU times are "info" unless the run gated them.
+"""
+
+import argparse
+import csv
+import json
+import re
+import sys
+from pathlib import Path
+
+JSON_RE = re.compile(r"BENCH_JSON (\{.*\})\s*$")
+CSV_RE = re.compile(r"BENCH_CSV (.+?)\s*$")
+PARSE_RE = re.compile(r"BENCH_PARSE (\{.*\})\s*$")
+SUMMARY_RE = re.compile(r"BENCH_PARSE_SUMMARY (\{.*\})\s*$")
+# Field order of struct bench_Result_t, with the BENCH_JSON key of each
+METRICS = [
+    ("parse_ns", "parse_ns", 1),
+    ("decode_ns", "decode_ns", 1),
+    ("encode_ns", "encode_ns", 1),
+    ("uart_bytes", "uart_bytes_per_report", 100),
+    ("uart_cmds", "uart_cmds_per_report", 100),
+    ("enum_us", "enum_us", 1),
+]
+
+
+def read_results(lines):
+    """Return ({device: result}, [csv rows], {descriptor: parse result}, [summaries]) of one log."""
+    results, rows, parses, summaries = {}, [], {}, []
+    for line in lines:
+        match = JSON_RE.search(line)
+        if match:
+            result = json.loads(match.group(1))
+            results[result["device"]] = result
+            continue
+        match = PARSE_RE.search(line)
+        if match:
+            result = json.loads(match.group(1))
+            parses[result["descriptor"]] = result
+            continue
+        match = SUMMARY_RE.search(line)
+        if match:
+            summaries.append(json.loads(match.group(1)))
+            continue
+        match = CSV_RE.search(line)
+        if match and not match.group(1).startswith("device,"):
+            rows.append(match.group(1).split(","))
+    return results, rows, parses, summaries
+
+
+def write_baseline(path, runs, parse_runs):
+    """Write bench_baseline.h with the worst value of each metric over all runs."""
+    devices, descriptors = [], []
+    for results in runs:
+        devices += [name for name in results if name not in devices]
+    for parses in parse_runs:
+        descriptors += [name for name in parses if name not in descriptors]
+
+    lines = [
+        "/* SPDX-License-Identifier: GPL-3.0-or-later */",
+        "/*",
+        " * Benchmark baseline, generated by:",
+        " *   scripts/bench_extract.py --baseline tests/benchmark/src/bench_baseline.h handler.log",
+        " * Regenerate it on the machine that runs the benchmark when a change is",
+        " * meant to move a number, and commit it together with that change.",
+        " */",
+        "",
+        "#ifndef BENCH_BASELINE_H",
+        "#define BENCH_BASELINE_H",
+        "",
+        '#include "bench_corpus.h"',
+        "",
+        "static const struct bench_Baseline_t gBenchBaseline[] = {",
+        "    //  device                   " + " ".join(name for name, _, _ in METRICS),
+    ]
+    for name in devices:
+        values = []
+        for _, key, scale in METRICS:
+            worst = max(round(results[name][key] * scale) for results in runs if name in results)
+            values.append(str(worst))
+        lines.append("    {%-24s {%s}}," % ('"%s",' % name, ", ".join(values)))
+    lines += ["};", "", "static const struct bench_ParseBaseline_t gBenchParseBaseline[] = {",
+              "    //  descriptor                            parse_ns"]
+    for name in descriptors:
+        worst = max(parses[name]["parse_ns"] for parses in parse_runs if name in parses)
+        lines.append("    {%-40s %d}," % ('"%s",' % name, worst))
+    lines += ["};", "", "#endif /* BENCH_BASELINE_H */", ""]
+    path.write_text("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("logs", nargs="*", type=argparse.FileType("r"), default=[sys.stdin],
+                        help="console captures, stdin if omitted")
+    parser.add_argument("--json", type=Path, help="write the results of the last log as JSON")
+    parser.add_argument("--csv", type=Path, help="write the baseline comparison of the last log as CSV")
+    parser.add_argument("--baseline", type=Path, help="regenerate bench_baseline.h from the logs")
+    parser.add_argument("--parse", type=Path, help="write the corpus parse results of the last log as JSON")
+    args = parser.parse_args()
+
+    runs, rows, parse_runs, summaries = [], [], [], []
+    for log in args.logs:
+        results, rows, parses, summaries = read_results(log)
+        if not results:
+            sys.exit(f"{log.name}: no BENCH_JSON lines")
+        runs.append(results)
+        parse_runs.append(parses)
+
+    if args.json:
+        args.json.write_text(json.dumps(list(runs[-1].values()), indent=2) + "\n")
+    if args.csv:
+        with args.csv.open("w", newline="") as out:
+            writer = csv.writer(out)
+            writer.writerow(["device", "metric", "value", "baseline", "limit", "status"])
+            writer.writerows(rows)
+    if args.parse:
+        args.parse.write_text(json.dumps({"summary": summaries, "descriptors": list(parse_runs[-1].values())},
+                                         indent=2) + "\n")
+    if args.baseline:
+        write_baseline(args.baseline, runs, parse_runs)
+    if not (args.json or args.csv or args.baseline or args.parse):
+        json.dump(list(runs[-1].values()), sys.stdout, indent=2)
+        print()
+
+    regressed = [row for row in rows if row[-1] == "regressed"]
+    for row in regressed:
+        print(f"{row[0]}: {row[1]} {row[2]} over limit {row[4]} (baseline {row[3]})", file=sys.stderr)
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Turn a GhostHIDe CH37x link capture dump into a trace file.
+
+Capture the console while running `capture` (or while a session ends with
+CONFIG_GHOSTHIDE_LINK_CAPTURE=y) and feed the log to this script:
+
+    scripts/capture_extract.py console.log -o mouse.ghlc
+    scripts/capture_extract.py --list console.log
+
+The trace file is what CONFIG_GHOSTHIDE_CH37X_REPLAY_FILE plays back on
+native_sim. With several dumps in the log the last one is used. Record kind
+names are read from drivers/ch37x/include/ch37x_capture.h.
+"""
+
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+HEADER = struct.Struct("<4sBBHIII")
+RECORD_SIZE = 4
+VERSION = 1
+CHIPS = ["CH375", "CH376S"]
+PORT_NONE = 0x0F
+BEGIN_RE = re.compile(r"CAPTURE BEGIN v(\d+) chip=(\d+) hz=(\d+) records=(\d+) dropped=(\d+)")
+RECORDS_RE = re.compile(r"CAPTURE ((?:[0-9a-fA-F]{8})+)\s*$")
+DEFAULT_HEADER = Path(__file__).resolve().parent.parent / "drivers" / "ch37x" / "include" / "ch37x_capture.h"
+
+
+def load_kind_names(header):
+    """Return the ch37x_CaptureKind_e names in enum order."""
+    text = header.read_text()
+    body = re.search(r"typedef enum \{(.*?)\} ch37x_CaptureKind_e;", text, re.S)
+    if body is None:
+        sys.exit(f"{header}: ch37x_CaptureKind_e not found")
+    return [name for name in re.findall(r"^\s*CH37X_CAPTURE_(\w+)", body.group(1), re.M)
+            if name != "KIND_COUNT"]
+
+
+def read_dumps(lines):
+    """Yield (chip, hz, dropped, records bytes) for every complete dump in the log."""
+    meta, data = None, None
+    for line in lines:
+        begin = BEGIN_RE.search(line)
+        if begin:
+            if int(begin.group(1)) != VERSION:
+                sys.exit(f"capture version {begin.group(1)} not supported")
+            meta, data = begin, bytearray()
+            continue
+        if data is None:
+            continue
+        if "CAPTURE END" in line:
+            count = int(meta.group(4))
+            if len(data) != count * RECORD_SIZE:
+                sys.exit(f"dump has {len(data) // RECORD_SIZE} of {count} records, console lost lines")
+            yield int(meta.group(2)), int(meta.group(3)), int(meta.group(5)), bytes(data)
+            data = None
+            continue
+        match = RECORDS_RE.search(line)
+        if match:
+            data += bytes.fromhex(match.group(1))
+
+
+def list_records(chip, hz, dropped, data, names):
+    """Print one line per record, times in microseconds since the first."""
+    count = len(data) // RECORD_SIZE
+    print(f"# {CHIPS[chip] if chip < len(CHIPS) else chip}: {count} records, {dropped} dropped, {hz} Hz")
+    cyc, high = 0, 0
+    for i in range(count):
+        dt, kind_port, value = struct.unpack_from("<HBB", data, i * RECORD_SIZE)
+        kind, port = kind_port & 0x0F, kind_port >> 4
+        if kind == 0:
+            high = dt << 16
+            continue
+        cyc += high | dt
+        high = 0
+        name = names[kind] if kind < len(names) else f"KIND{kind}"
+        where = "-" if port == PORT_NONE else port
+        print(f"{i:6d} {cyc * 1000000 // hz:12d} {where} {name:<7s} 0x{value:02X}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="console capture, stdin if omitted")
+    parser.add_argument("-o", "--output", type=Path, help="trace file to write")
+    parser.add_argument("--list", action="store_true", help="print the records instead")
+    parser.add_argument("--header", type=Path, default=DEFAULT_HEADER,
+                        help="ch37x_capture.h to take the kind names from")
+    args = parser.parse_args()
+
+    dumps = list(read_dumps(args.log))
+    if not dumps:
+        sys.exit("no complete CAPTURE dump found")
+    chip, hz, dropped, data = dumps[-1]
+
+    if args.list or not args.output:
+        list_records(chip, hz, dropped, data, load_kind_names(args.header))
+    if args.output:
+        header = HEADER.pack(b"GHLC", VERSION, chip, RECORD_SIZE, hz, len(data) // RECORD_SIZE, dropped)
+        args.output.write_bytes(header + data)
+    if dropped:
+        print(f"warning: {dropped} records dropped, the replay ends early", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-3.0-or-later
+"""Decode a GhostHIDe trace ring dump.
+
+Capture the console while running `trace` (or while a session ends with
+CONFIG_GHOSTHIDE_TRACE=y) and feed the log to this script:
+
+    scripts/trace_decode.py console.log
+    scripts/trace_decode.py --csv console.log > trace.csv
+
+Event names are read from include/trace_points.h, so the script always
+matches the firmware it was checked out with. Times are in microseconds,
+relative to the oldest record of each dump.
+"""
+
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+RECORD = struct.Struct("<IHBBii")
+HEADER_RE = re.compile(r"TRACE BEGIN v1 hz=(\d+) depth=(\d+) records=(\d+) lost=(\d+)")
+RECORD_RE = re.compile(r"TRACE ([0-9a-fA-F]{%d})\s*$" % (RECORD.size * 2))
+DEFAULT_HEADER = Path(__file__).resolve().parent.parent / "include" / "trace_points.h"
+
+
+def load_event_names(header):
+    """Return the TracePoints_Event_e names in enum order."""
+    text = header.read_text()
+    body = re.search(r"typedef enum \{(.*?)\} TracePoints_Event_e;", text, re.S)
+    if body is None:
+        sys.exit(f"{header}: TracePoints_Event_e not found")
+    return re.findall(r"^\s*TRACE_EVT_(\w+)", body.group(1), re.M)
+
+
+def read_dumps(lines):
+    """Yield (hz, lost, [records]) for every complete dump in the log."""
+    hz, lost, records = None, 0, None
+    for line in lines:
+        header = HEADER_RE.search(line)
+        if header:
+            hz, lost, records = int(header.group(1)), int(header.group(4)), []
+            continue
+        if records is None:
+            continue
+        if "TRACE END" in line:
+            yield hz, lost, records
+            records = None
+            continue
+        match = RECORD_RE.search(line)
+        if match:
+            records.append(RECORD.unpack(bytes.fromhex(match.group(1))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="console capture, stdin if omitted")
+    parser.add_argument("--header", type=Path, default=DEFAULT_HEADER,
+                        help="trace_points.h to take the event names from")
+    parser.add_argument("--csv", action="store_true", help="print CSV instead of a table")
+    args = parser.parse_args()
+
+    names = load_event_names(args.header)
+    found = False
+
+    for index, (hz, lost, records) in enumerate(read_dumps(args.log)):
+        found = True
+        if args.csv:
+            print("dump,time_us,port,event,arg0,arg1")
+        else:
+            print(f"# dump {index}: {len(records)} records, {lost} overwritten, {hz} Hz cycle counter")
+
+        if not records:
+            continue
+
+        # Sum the gaps, the 32 bit counter may wrap within one dump
+        prev, ticks = records[0][0], 0
+        for cyc, event, port, _, arg0, arg1 in records:
+            ticks += (cyc - prev) & 0xFFFFFFFF
+            prev = cyc
+            time_us = ticks * 1_000_000 / hz
+            name = names[event] if event < len(names) else f"EVT_{event}"
+            port_text = "-" if port == 0xFF else str(port)
+            if args.csv:
+                print(f"{index},{time_us:.1f},{port_text},{name},{arg0},{arg1}")
+            else:
+                print(f"{time_us:12.1f} us  port {port_text:>2}  {name:<12} {arg0:>8} {arg1:>8}")
+
+    if not found:
+        sys.exit("no complete TRACE BEGIN/END block in the input")
+
+
+if __name__ == "__main__":
+    main()
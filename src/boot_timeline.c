@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           boot_timeline.c
+ * @brief          Boot timeline implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Phases are marked from main, from the input threads bringing their port up
+ * and from USB callback context, a spinlock keeps each stamp whole. The first
+ * report is marked in callback context on every report sent, so the timeline
+ * is logged from the system work queue, and an atomic copy of the reached
+ * bits lets a phase already stamped return before the clock read and the lock.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "boot_timeline.h"
+#include <zephyr/logging/log.h>
+#include <inttypes.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(boot_timeline, LOG_LEVEL_INF);
+
+/* Private variables ---------------------------------------------------------*/
+static struct k_spinlock gLock;
+static struct BootTimeline_t gTimeline;
+static atomic_t gReached;                   // gTimeline.reached, read without gLock
+static const char *const gPhaseNames[BOOT_PHASE_COUNT] = {
+    "main", "link ready", "connected", "enumerated", "USB ready", "first report"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void log_work_handler(struct k_work *pWork);
+
+static K_WORK_DEFINE(gLogWork, log_work_handler);
+
+/**
+ * @brief Stamp a phase, only the first call counts
+ * @param phase phase reached now
+ * @return None
+ * @note Safe from ISR context. Once the phase is stamped this is one atomic read.
+ */
+void bootTimeline_mark(BootPhase_e phase) {
+
+    uint64_t nowUs;
+    bool isFirst = false;
+    k_spinlock_key_t key;
+
+    if (phase >= BOOT_PHASE_COUNT) {
+        return;
+    }
+
+    if (0 != (atomic_get(&gReached) & BIT(phase))) {
+        return;
+    }
+
+    nowUs = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    key = k_spin_lock(&gLock);
+    if (0 == (gTimeline.reached & BIT(phase))) {
+        gTimeline.reached |= BIT(phase);
+        gTimeline.phase_us[phase] = nowUs;
+        atomic_or(&gReached, BIT(phase));
+        isFirst = true;
+    }
+    k_spin_unlock(&gLock, key);
+
+    if (isFirst && BOOT_PHASE_FIRST_REPORT == phase) {
+        k_work_submit(&gLogWork);
+    }
+}
+
+/**
+ * @brief Stamp a phase of one port, the phase itself once every port reached it
+ * @param phase phase reached now
+ * @param port CH37x port index
+ * @return None
+ */
+void bootTimeline_markPort(BootPhase_e phase, uint8_t port) {
+
+    uint64_t nowUs = k_ticks_to_us_floor64(k_uptime_ticks());
+    bool isAll = false;
+    k_spinlock_key_t key;
+
+    if (phase >= BOOT_PHASE_COUNT || port >= BOOT_TIMELINE_PORT_COUNT) {
+        return;
+    }
+
+    key = k_spin_lock(&gLock);
+    if (0 == (gTimeline.port_reached[phase] & BIT(port))) {
+        gTimeline.port_reached[phase] |= BIT(port);
+        gTimeline.port_us[phase][port] = nowUs;
+        isAll = (BIT_MASK(BOOT_TIMELINE_PORT_COUNT) == gTimeline.port_reached[phase]);
+    }
+    k_spin_unlock(&gLock, key);
+
+    if (isAll) {
+        bootTimeline_mark(phase);
+    }
+}
+
+/**
+ * @brief Copy the timeline
+ * @param pTimeline pointer to the timeline to fill
+ * @return None
+ */
+void bootTimeline_get(struct BootTimeline_t *pTimeline) {
+
+    k_spinlock_key_t key;
+
+    if (NULL == pTimeline) {
+        return;
+    }
+
+    key = k_spin_lock(&gLock);
+    *pTimeline = gTimeline;
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Log every phase reached so far, with the time spent since the previous one
+ * @return None
+ */
+void bootTimeline_log(void) {
+
+    struct BootTimeline_t timeline;
+    uint64_t prevUs = 0;
+
+    bootTimeline_get(&timeline);
+
+    for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+        if (0 == (timeline.reached & BIT(p))) {
+            continue;
+        }
+
+        LOG_INF("Boot %-12s at %6" PRIu64 " us (+%" PRIu64 " us)", gPhaseNames[p], timeline.phase_us[p],
+                timeline.phase_us[p] - prevUs);
+        prevUs = timeline.phase_us[p];
+
+        for (uint8_t i = 0; i < BOOT_TIMELINE_PORT_COUNT; i++) {
+            if (0 != (timeline.port_reached[p] & BIT(i))) {
+                LOG_INF("  port %u at %6" PRIu64 " us", i, timeline.port_us[p][i]);
+            }
+        }
+    }
+}
+
+static void log_work_handler(struct k_work *pWork) {
+
+    (void)(pWork);
+
+    bootTimeline_log();
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_boot(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct BootTimeline_t timeline;
+    uint64_t prevUs = 0;
+
+    (void)(argc);
+    (void)(argv);
+
+    bootTimeline_get(&timeline);
+
+    for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+        if (0 == (timeline.reached & BIT(p))) {
+            shell_print(pShell, "%-12s not reached", gPhaseNames[p]);
+            continue;
+        }
+
+        shell_print(pShell, "%-12s %8" PRIu64 " us  +%" PRIu64 " us", gPhaseNames[p], timeline.phase_us[p],
+                    timeline.phase_us[p] - prevUs);
+        prevUs = timeline.phase_us[p];
+
+        for (uint8_t i = 0; i < BOOT_TIMELINE_PORT_COUNT; i++) {
+            if (0 != (timeline.port_reached[p] & BIT(i))) {
+                shell_print(pShell, "  port %u    %8" PRIu64 " us", i, timeline.port_us[p][i]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+SHELL_CMD_REGISTER(boot, NULL, "Print the boot timeline, reset to first forwarded report", cmd_boot);
+#endif
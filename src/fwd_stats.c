@@ -0,0 +1,289 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           fwd_stats.c
+ * @brief          Forwarding meters implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Counters are only ever incremented, readers keep a base copy and work with
+ * differences, so the input threads and the USB callbacks never take a lock.
+ * Totals are kept against a reset base, rates against a window the reader
+ * owns. With CONFIG_SHELL `stats` prints both, `stats reset` starts over.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "fwd_stats.h"
+#include "hid_output.h"
+#include "hid_parser.h"
+#include "latency_stats.h"
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static atomic_t gInReports[FWD_STATS_PORT_COUNT];
+static atomic_t gInFiltered[FWD_STATS_PORT_COUNT];
+static const char *gPortNames[FWD_STATS_PORT_COUNT];
+static struct k_spinlock gLock;
+static struct FwdStats_Window_t gResetBase;
+#if defined(CONFIG_SHELL)
+static struct FwdStats_Window_t gShellWin;
+static const char *const gIfaceNames[USBHID_PROXY_IFACE_COUNT] = {"Mouse", "Keyboard"};
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void counters_sub(const struct FwdStats_Counters_t *pNow, const struct FwdStats_Counters_t *pBase,
+                                                                    struct FwdStats_Counters_t *pDelta);
+
+/**
+ * @brief Name a port for the shell output
+ * @param port port index
+ * @param pName name, must stay valid
+ * @return None
+ */
+void fwdStats_setPortName(uint8_t port, const char *pName) {
+
+    if (port >= FWD_STATS_PORT_COUNT) {
+        return;
+    }
+
+    gPortNames[port] = pName;
+}
+
+/**
+ * @brief Account the outcome of one report fetch
+ * @param port port index
+ * @param fetchRet return value of the fetch
+ * @return None
+ * @note Only new and filtered reports count, NAKs and errors are ignored.
+ */
+void fwdStats_countInput(uint8_t port, int fetchRet) {
+
+    if (port >= FWD_STATS_PORT_COUNT) {
+        return;
+    }
+
+    if (USBHID_SUCCESS == fetchRet) {
+        atomic_inc(&gInReports[port]);
+    } else if (USBHID_REPORT_FILTERED == fetchRet) {
+        atomic_inc(&gInFiltered[port]);
+    }
+}
+
+/**
+ * @brief Read every counter as it is now
+ * @param pCounters pointer to the counters to fill
+ * @return None
+ */
+void fwdStats_get(struct FwdStats_Counters_t *pCounters) {
+
+    struct HID_OutputQueueStats_t kbdStats;
+
+    if (NULL == pCounters) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < FWD_STATS_PORT_COUNT; i++) {
+        pCounters->in_reports[i] = (uint32_t)atomic_get(&gInReports[i]);
+        pCounters->in_filtered[i] = (uint32_t)atomic_get(&gInFiltered[i]);
+    }
+
+    for (uint8_t i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        usbhid_proxyGetSendStats(i, &pCounters->out[i]);
+    }
+
+    pCounters->out_queue_drops = usbhid_proxyGetOutReportDrops();
+
+    hidOutput_getKeyboardQueueStats(&kbdStats);
+    pCounters->kbd_collapsed = kbdStats.collapsed;
+    pCounters->kbd_overflowed = kbdStats.overflowed;
+}
+
+/**
+ * @brief Read the counters accumulated since the last reset
+ * @param pTotals pointer to the counters to fill
+ * @return None
+ */
+void fwdStats_getTotals(struct FwdStats_Counters_t *pTotals) {
+
+    struct FwdStats_Counters_t now;
+    k_spinlock_key_t key;
+
+    if (NULL == pTotals) {
+        return;
+    }
+
+    fwdStats_get(&now);
+
+    key = k_spin_lock(&gLock);
+    counters_sub(&now, &gResetBase.base, pTotals);
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Start counting totals from zero
+ * @return None
+ * @note Call after usbhid_proxyInit() and hidOutput_init(), they clear their own counters.
+ */
+void fwdStats_reset(void) {
+
+    struct FwdStats_Counters_t now;
+    int64_t nowMs = k_uptime_get();
+    k_spinlock_key_t key;
+
+    fwdStats_get(&now);
+
+    key = k_spin_lock(&gLock);
+    gResetBase.base = now;
+    gResetBase.start_ms = nowMs;
+#if defined(CONFIG_SHELL)
+    gShellWin = gResetBase;
+#endif
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Open a rate measurement window
+ * @param pWin window to open
+ * @param nowMs current uptime in ms
+ * @return None
+ */
+void fwdStats_windowStart(struct FwdStats_Window_t *pWin, int64_t nowMs) {
+
+    if (NULL == pWin) {
+        return;
+    }
+
+    fwdStats_get(&pWin->base);
+    pWin->start_ms = nowMs;
+}
+
+/**
+ * @brief Close a window and open the next one where it ended
+ * @param pWin window to roll
+ * @param nowMs current uptime in ms
+ * @param pDelta pointer to the counts seen in the window
+ * @return length of the window in ms, at least 1
+ */
+int64_t fwdStats_windowRoll(struct FwdStats_Window_t *pWin, int64_t nowMs, struct FwdStats_Counters_t *pDelta) {
+
+    struct FwdStats_Counters_t now;
+    int64_t elapsedMs;
+
+    if (NULL == pWin || NULL == pDelta) {
+        return 1;
+    }
+
+    fwdStats_get(&now);
+    counters_sub(&now, &pWin->base, pDelta);
+    elapsedMs = MAX(nowMs - pWin->start_ms, 1);
+
+    pWin->base = now;
+    pWin->start_ms = nowMs;
+
+    return elapsedMs;
+}
+
+static void counters_sub(const struct FwdStats_Counters_t *pNow, const struct FwdStats_Counters_t *pBase,
+                                                                    struct FwdStats_Counters_t *pDelta) {
+
+    for (uint8_t i = 0; i < FWD_STATS_PORT_COUNT; i++) {
+        pDelta->in_reports[i] = pNow->in_reports[i] - pBase->in_reports[i];
+        pDelta->in_filtered[i] = pNow->in_filtered[i] - pBase->in_filtered[i];
+    }
+
+    for (uint8_t i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        const struct USBHID_ProxySendStats_t *pN = &pNow->out[i];
+        const struct USBHID_ProxySendStats_t *pB = &pBase->out[i];
+        struct USBHID_ProxySendStats_t *pD = &pDelta->out[i];
+
+        pD->sent = pN->sent - pB->sent;
+        pD->busy = pN->busy - pB->busy;
+        pD->failed = pN->failed - pB->failed;
+        pD->not_ready = pN->not_ready - pB->not_ready;
+        pD->coalesced = pN->coalesced - pB->coalesced;
+        pD->dropped = pN->dropped - pB->dropped;
+    }
+
+    pDelta->out_queue_drops = pNow->out_queue_drops - pBase->out_queue_drops;
+    pDelta->kbd_collapsed = pNow->kbd_collapsed - pBase->kbd_collapsed;
+    pDelta->kbd_overflowed = pNow->kbd_overflowed - pBase->kbd_overflowed;
+}
+
+#if defined(CONFIG_SHELL)
+static uint32_t per_second(uint32_t count, int64_t elapsedMs) {
+
+    return (uint32_t)(((uint64_t)count * 1000U) / elapsedMs);
+}
+
+static int cmd_stats_show(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct FwdStats_Counters_t rate;
+    struct FwdStats_Counters_t total;
+    int64_t nowMs = k_uptime_get();
+    int64_t windowMs;
+    int64_t totalMs;
+    k_spinlock_key_t key;
+
+    (void)(argc);
+    (void)(argv);
+
+    key = k_spin_lock(&gLock);
+    windowMs = fwdStats_windowRoll(&gShellWin, nowMs, &rate);
+    totalMs = nowMs - gResetBase.start_ms;
+    k_spin_unlock(&gLock, key);
+    fwdStats_getTotals(&total);
+
+    shell_print(pShell, "Rates over the last %" PRId64 " ms, totals over %" PRId64 " ms", windowMs, totalMs);
+
+    for (uint8_t i = 0; i < FWD_STATS_PORT_COUNT; i++) {
+        shell_print(pShell, "%-8s in %5" PRIu32 "/s, filtered %5" PRIu32 "/s | total in %" PRIu32 ", filtered %" PRIu32,
+                    (NULL != gPortNames[i]) ? gPortNames[i] : "-", per_second(rate.in_reports[i], windowMs),
+                    per_second(rate.in_filtered[i], windowMs), total.in_reports[i], total.in_filtered[i]);
+    }
+
+    for (uint8_t i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        const struct USBHID_ProxySendStats_t *pOut = &total.out[i];
+
+        shell_print(pShell, "%-8s out %5" PRIu32 "/s | total sent %" PRIu32 ", busy %" PRIu32 ", coalesced %" PRIu32
+                    ", dropped %" PRIu32 ", failed %" PRIu32 ", not ready %" PRIu32, gIfaceNames[i],
+                    per_second(rate.out[i].sent, windowMs), pOut->sent, pOut->busy, pOut->coalesced,
+                    pOut->dropped, pOut->failed, pOut->not_ready);
+    }
+
+    shell_print(pShell, "Keyboard queue collapsed %" PRIu32 ", overflowed %" PRIu32 ", host to device drops %" PRIu32,
+                total.kbd_collapsed, total.kbd_overflowed, total.out_queue_drops);
+
+    return 0;
+}
+
+static int cmd_stats_reset(const struct shell *pShell, size_t argc, char **argv) {
+
+    (void)(argc);
+    (void)(argv);
+
+    fwdStats_reset();
+    latencyStats_reset();
+    shell_print(pShell, "Forwarding counters and latency histograms cleared");
+
+    return 0;
+}
+
+SHELL_SUBCMD_SET_CREATE(sub_stats, (stats));
+SHELL_SUBCMD_ADD((stats), reset, NULL, "Clear the counters and latency histograms", cmd_stats_reset, 1, 0);
+SHELL_CMD_REGISTER(stats, &sub_stats, "Report rates since the last call, drop and coalesce totals since reset",
+                                                                                            cmd_stats_show);
+#endif
@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           latency_stats.c
+ * @brief          Report latency histograms implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Stages are recorded from the input threads and from USB callback context, a
+ * spinlock keeps each update whole. With CONFIG_SHELL `stats latency` prints
+ * the summaries, `stats reset` (fwd_stats.c) starts a new measurement.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "latency_stats.h"
+#include "mem_report.h"
+#include <zephyr/logging/log.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(latency_stats, LOG_LEVEL_INF);
+
+/* Private variables ---------------------------------------------------------*/
+static struct k_spinlock gLock;
+static struct LatencyStats_Hist_t gHist[LATENCY_STATS_IFACE_COUNT][LATENCY_STAGE_COUNT];
+MEM_REPORT_STATIC(latency_stats, gHist);
+static const char *const gIfaceNames[LATENCY_STATS_IFACE_COUNT] = {"Mouse", "Keyboard"};
+static const char *const gStageNames[LATENCY_STAGE_COUNT] = {"decode", "submit", "host"};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t bucket_percentile(const struct LatencyStats_Hist_t *pHist, uint32_t percent);
+
+/**
+ * @brief Clear all histograms
+ * @return None
+ */
+void latencyStats_reset(void) {
+
+    k_spinlock_key_t key = k_spin_lock(&gLock);
+
+    memset(gHist, 0x00, sizeof(gHist));
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Account that a report reached a stage now
+ * @param ifaceNum interface number
+ * @param stage stage the report reached
+ * @param arrivalCyc k_cycle_get_32() when the report's CH37x transfer completed
+ * @return None
+ * @note Safe from ISR context.
+ */
+void latencyStats_record(uint8_t ifaceNum, LatencyStage_e stage, uint32_t arrivalCyc) {
+
+    uint32_t latencyUs = k_cyc_to_us_floor32(k_cycle_get_32() - arrivalCyc);
+    struct LatencyStats_Hist_t *pHist;
+    k_spinlock_key_t key;
+
+    if (ifaceNum >= LATENCY_STATS_IFACE_COUNT || stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    pHist = &gHist[ifaceNum][stage];
+
+    key = k_spin_lock(&gLock);
+    pHist->buckets[MIN(latencyUs / LATENCY_STATS_BUCKET_US, LATENCY_STATS_BUCKETS - 1)]++;
+    if (0 == pHist->count || latencyUs < pHist->min_us) {
+        pHist->min_us = latencyUs;
+    }
+    pHist->max_us = MAX(pHist->max_us, latencyUs);
+    pHist->count++;
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Copy the histogram of one stage
+ * @param ifaceNum interface number
+ * @param stage stage to read
+ * @param pHist pointer to the histogram to fill
+ * @return None
+ */
+void latencyStats_get(uint8_t ifaceNum, LatencyStage_e stage, struct LatencyStats_Hist_t *pHist) {
+
+    k_spinlock_key_t key;
+
+    if (NULL == pHist || ifaceNum >= LATENCY_STATS_IFACE_COUNT || stage >= LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    key = k_spin_lock(&gLock);
+    *pHist = gHist[ifaceNum][stage];
+    k_spin_unlock(&gLock, key);
+}
+
+/**
+ * @brief Work out min/p50/p99/max of one stage
+ * @param ifaceNum interface number
+ * @param stage stage to summarize
+ * @param pSummary pointer to the summary to fill
+ * @return 0 on success, -ENODATA if nothing was recorded, -EINVAL on bad arguments
+ * @note Percentiles are bucket upper bounds, the last bucket reports the maximum.
+ */
+int latencyStats_summarize(uint8_t ifaceNum, LatencyStage_e stage, struct LatencyStats_Summary_t *pSummary) {
+
+    struct LatencyStats_Hist_t hist;
+
+    if (NULL == pSummary || ifaceNum >= LATENCY_STATS_IFACE_COUNT || stage >= LATENCY_STAGE_COUNT) {
+        return -EINVAL;
+    }
+
+    latencyStats_get(ifaceNum, stage, &hist);
+    if (0 == hist.count) {
+        return -ENODATA;
+    }
+
+    pSummary->count = hist.count;
+    pSummary->min_us = hist.min_us;
+    pSummary->p50_us = bucket_percentile(&hist, 50);
+    pSummary->p99_us = bucket_percentile(&hist, 99);
+    pSummary->max_us = hist.max_us;
+
+    return 0;
+}
+
+/**
+ * @brief Log the summary of every stage that saw reports
+ * @return None
+ */
+void latencyStats_log(void) {
+
+    struct LatencyStats_Summary_t sum;
+
+    for (uint8_t i = 0; i < LATENCY_STATS_IFACE_COUNT; i++) {
+        for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+            if (0 != latencyStats_summarize(i, s, &sum)) {
+                continue;
+            }
+
+            LOG_INF("%s %s (%s): %" PRIu32 " reports, min %" PRIu32 " us, p50 <= %" PRIu32 " us, p99 <= %" PRIu32
+                    " us, max %" PRIu32 " us", gIfaceNames[i], gStageNames[s],
+                    IS_ENABLED(CONFIG_GHOSTHIDE_SOF_ALIGN) ? "SOF aligned" : "immediate",
+                    sum.count, sum.min_us, sum.p50_us, sum.p99_us, sum.max_us);
+        }
+    }
+}
+
+static uint32_t bucket_percentile(const struct LatencyStats_Hist_t *pHist, uint32_t percent) {
+
+    uint64_t target = ((uint64_t)pHist->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    uint32_t b = 0;
+
+    for (; b < LATENCY_STATS_BUCKETS - 1; b++) {
+        seen += pHist->buckets[b];
+        if (seen >= target) {
+            break;
+        }
+    }
+
+    if (LATENCY_STATS_BUCKETS - 1 == b) {
+        return pHist->max_us;
+    }
+
+    // The bucket bound can overshoot what was actually seen
+    return MIN((b + 1) * LATENCY_STATS_BUCKET_US, pHist->max_us);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_latency_show(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct LatencyStats_Summary_t sum;
+
+    (void)(argc);
+    (void)(argv);
+
+    for (uint8_t i = 0; i < LATENCY_STATS_IFACE_COUNT; i++) {
+        for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+            if (0 != latencyStats_summarize(i, s, &sum)) {
+                shell_print(pShell, "%-8s %-6s no reports", gIfaceNames[i], gStageNames[s]);
+                continue;
+            }
+
+            shell_print(pShell, "%-8s %-6s n=%" PRIu32 " min=%" PRIu32 " p50<=%" PRIu32 " p99<=%" PRIu32 " max=%" PRIu32 " us",
+                        gIfaceNames[i], gStageNames[s], sum.count, sum.min_us, sum.p50_us, sum.p99_us, sum.max_us);
+        }
+    }
+
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((stats), latency, NULL, "Report latency from CH37x arrival, min/p50/p99/max", cmd_latency_show, 1, 0);
+#endif
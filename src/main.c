@@ -14,6 +14,10 @@
  * Main application demonstrating USB HID device enumeration, descriptor
  * parsing, and real-time input forwarding. Manages dual CH375 USB host
  * controllers for mouse and keyboard passthrough.
+ *
+ * With CONFIG_GHOSTHIDE_INPUT_THREADS every port is polled by its own thread,
+ * the mouse one above the keyboard one, both above main. Main only supervises
+ * the session and logs. Otherwise one superloop polls the ports in turn.
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -33,20 +37,32 @@
 #include "hid_output.h"
 #include "hid_keyboard.h"
 #include "input_patterns.h"
+#include "latency_stats.h"
+#include "fwd_stats.h"
+#include "trace_points.h"
+#include "mem_report.h"
+#include "boot_timeline.h"
 
 LOG_MODULE_REGISTER(main, LOG_LEVEL_INF);
 
 /* Defines -------------------------------------------------------------------*/
 #define CH375_MODULE_COUNT 2
-#define DEFAULT_REPORT_INTERVAL_MS 8
-#define MAIN_LOOP_SLEEP_MS 1
 #define KEYBOARD_BREAK_TIMEOUT_MS 50
 #define ENUMERATION_WAIT_TIMEOUT_MS 10000
+#define USB_READY_POLL_MS 5
+#define CONNECT_POLL_MS 10
 #define IFACE_MOUSE     0
 #define IFACE_KEYBOARD  1
+#define OUT_REPORT_RETRIES 8
+#define SESSION_EVT_DISCONNECT BIT(0)
+#define RC_REQ_PRESET_MASK  0xFFU       // Requested preset index + 1, 0 if none
+#define RC_REQ_COEF_UP      BIT(8)
+#define RC_REQ_COEF_DOWN    BIT(9)
+#define RC_REQ_SENS_UP      BIT(10)
+#define RC_REQ_SENS_DOWN    BIT(11)
 
 /* Type Deffinitions ---------------------------------------------------------*/
-typedef struct {
+typedef struct DeviceInput {
     
     const char *name;
     struct gpio_dt_spec intGpio;
@@ -58,20 +74,64 @@ typedef struct {
         struct HID_Mouse_t mouse;
         struct HID_Keyboard_t keyboard;
     };
+    struct HID_OutputPlan_t mousePlan;
 
     bool isConnected;
     uint8_t interfaceNum;
+    uint8_t portNum;
+
+    int64_t nextPollMs;
+    uint32_t pollIntervalMs;
+    uint8_t outReportTries;
+
+    uint32_t lateCount;
+    uint32_t lateMaxUs;
+    uint64_t lateSumUs;
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+    struct ch37x_LinkStats_t linkBase;
+#endif
 
-    uint32_t lastReportTimestampMs;
-    uint32_t reportIntervalMs;
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+    struct k_thread thread;
+    struct k_sem startSem;
+    struct k_sem parkedSem;
+    uint8_t cpuId;
+    int (*job)(struct DeviceInput *pDevIn);     // Bring-up step to run instead of a session
+    int jobRet;
+#endif
     
 } DeviceInput_t;
 
+typedef int (*PortJob_t)(DeviceInput_t *pDevIn);
+
+typedef struct {
+    uint8_t keyCode;
+    HID_KeyActionCb_t cb;
+    uintptr_t arg;
+} Hotkey_t;
+
 /* Private variables ---------------------------------------------------------*/
 static DeviceInput_t gDeviceInputs[CH375_MODULE_COUNT];
 static struct RecoilComp_Context_t *gRecoilCompCtx = NULL;
-static bool gRcEnabled;
-static bool gRcActive;
+static atomic_t gRcEnabled;
+static atomic_t gRcRequests;                                            // RC_REQ_*, posted by the hotkeys
+static bool gRcActive[CH375_MODULE_COUNT];                              // Per port, owned by its mouse thread
+static struct HID_KeyEventTable_t gKeyEvents[CH375_MODULE_COUNT];     // Per port, each tracks its own keyboard
+static bool gKbdResend[CH375_MODULE_COUNT];                            // Per port, last state was not taken
+static struct FwdStats_Window_t gRateWindow;
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+static K_THREAD_STACK_ARRAY_DEFINE(gInputStacks, CH375_MODULE_COUNT, CONFIG_GHOSTHIDE_INPUT_STACK_SIZE);
+static K_EVENT_DEFINE(gSessionEvents);
+static atomic_t gSessionActive;
+MEM_REPORT_STATIC(main, gInputStacks);
+#endif
+MEM_REPORT_STATIC(main, gDeviceInputs);
+MEM_REPORT_STATIC(main, gKeyEvents);
+static const char *const gPresetNames[] = {
+    [TEMPLATE_NONE] = "NONE",
+    [TEMPLATE_OW2_SOLDIER76] = "SOLDIER 76",
+    [TEMPLATE_OW2_CASSIDY] = "CASSIDY",
+};
 
 static const char banner[] = 
 "                                                                      \n"
@@ -85,14 +145,55 @@ static const char banner[] =
 static int initCh375Device(DeviceInput_t *pDevIn, const char *pName, 
                             int usartIndex, const struct gpio_dt_spec *pIntGpio, 
                             uint8_t interfaceNum);
+static int initCh375Link(DeviceInput_t *pDevIn);
+static int runOnAllPorts(PortJob_t job);
 static int openDeviceInput(DeviceInput_t *pDevIn);
+static int openPortJob(DeviceInput_t *pDevIn);
 static void waitAllDevicesConnect(void);
 static int openAllDeviceInputs(void);
+static void getProxyLayout(struct USBHID_ProxyLayout_t *pLayout);
 static void loopHandleDevices(void);
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+static void startInputThreads(void);
+static void inputThread(void *p1, void *p2, void *p3);
+#if defined(CONFIG_GHOSTHIDE_CPU_PINNING)
+static void pinInputThreads(void);
+#endif
+#endif
+static int pollDeviceInput(DeviceInput_t *pDevIn, int64_t wakeMs);
+static void recordPollLateness(DeviceInput_t *pDevIn);
+static uint32_t getPollIntervalMs(const DeviceInput_t *pDevIn);
+static int serviceOutReport(DeviceInput_t *pDevIn);
+static void resetReportRates(int64_t nowMs);
+static void logReportRates(int64_t nowMs);
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+static void logLinkStats(DeviceInput_t *pDevIn, uint32_t inCount, int64_t elapsedMs);
+#endif
 static int handleMouseInput(DeviceInput_t *pDevIn);
 static int handleKeyboardInput(DeviceInput_t *pDevIn);
 static void closeAllDevices(void);
 static int initInputPatterns(void);
+static int bindHotkeys(void);
+static void postRcRequest(atomic_val_t clearMask, atomic_val_t setMask);
+static void applyRcRequests(void);
+static void onRecoilToggleKey(uint8_t keyCode, bool isPressed, void *pUserData);
+static void onPresetKey(uint8_t keyCode, bool isPressed, void *pUserData);
+static void onCoefficientKey(uint8_t keyCode, bool isPressed, void *pUserData);
+static void onSensitivityKey(uint8_t keyCode, bool isPressed, void *pUserData);
+
+/* Hotkeys, bound on every (re)connection -----------------------------------*/
+static const Hotkey_t gHotkeys[] = {
+    { HID_KEY_PAGEUP,       onRecoilToggleKey,  true },
+    { HID_KEY_PAGEDOWN,     onRecoilToggleKey,  false },
+    { HID_KBD_NUMBER('1'),  onPresetKey,        TEMPLATE_OW2_SOLDIER76 },
+    { HID_KBD_NUMBER('2'),  onPresetKey,        TEMPLATE_OW2_CASSIDY },
+    // Coefficient adjustment
+    { HID_KEY_EQUAL,        onCoefficientKey,   true },
+    { HID_KEY_MINUS,        onCoefficientKey,   false },
+    // Sensitivity adjustment
+    { HID_KEY_COMMA,        onSensitivityKey,   true },
+    { HID_KEY_DOT,          onSensitivityKey,   false },
+};
 
 /**
   * @brief  The application entry point.
@@ -101,6 +202,11 @@ static int initInputPatterns(void);
 int main(void)
 {
     int ret = -1;
+#if defined(CONFIG_GHOSTHIDE_MEM_REPORT)
+    bool isMemReported = false;
+#endif
+
+    bootTimeline_mark(BOOT_PHASE_MAIN);
 
     // Print banner
     printk("%s%s%s", "\x1b[36m", banner, "\x1b[0m");
@@ -134,11 +240,15 @@ int main(void)
     //     return -1;
     // }
 
+#elif defined(CONFIG_ARCH_POSIX)
+
+    // Simulated CH37x chips and devices, nothing to bring up
+
 #else
     #error "Unsupported platform"
 #endif
 
-    // Initialize CH375 USB host controllers
+    // Bring up the UARTs one after the other, they share clock and PIO setup
     ret = initCh375Device(&gDeviceInputs[0], "CH375A", CH37X_A_USART_INDEX, NULL, IFACE_MOUSE);
     if (0 != ret) {
         return ret;
@@ -149,6 +259,16 @@ int main(void)
         return ret;
     }
 
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+    startInputThreads();
+#endif
+
+    // Then wait for both chips at once
+    ret = runOnAllPorts(initCh375Link);
+    if (0 != ret) {
+        return ret;
+    }
+
     while (1) {
         LOG_INF("Waiting for USB devices...");
         waitAllDevicesConnect();
@@ -170,7 +290,9 @@ int main(void)
         }
 
         LOG_INF("Initializing USB device output...");
-        ret = usbhid_proxyInit();
+        struct USBHID_ProxyLayout_t layout;
+        getProxyLayout(&layout);
+        ret = usbhid_proxyInit(&layout);
         if (USBHID_SUCCESS != ret) {
             LOG_ERR("[ FAILED ] USB HID proxy initialization failed: %d", ret);
             recoilComp_close(gRecoilCompCtx);
@@ -178,12 +300,13 @@ int main(void)
             k_msleep(1000);
             continue;
         }
+        hidOutput_init();
+        fwdStats_reset();
 
         LOG_INF("Waiting for USB enumeration...");
-        int enumerationAttempts = 0;
-        while (true != usbhid_proxyIsReady() && enumerationAttempts < 100) {
-            k_msleep(100);
-            enumerationAttempts++;
+        int64_t enumerationDeadlineMs = k_uptime_get() + ENUMERATION_WAIT_TIMEOUT_MS;
+        while (true != usbhid_proxyIsReady() && k_uptime_get() < enumerationDeadlineMs) {
+            k_msleep(USB_READY_POLL_MS);
         }
 
         if (true != usbhid_proxyIsReady()) {
@@ -196,9 +319,30 @@ int main(void)
             continue;
         }
 
+        bootTimeline_mark(BOOT_PHASE_USB_READY);
         LOG_INF("[ OK ] USB ready - starting forwarding");
+#if defined(CONFIG_GHOSTHIDE_MEM_REPORT)
+        // Once, enumeration and USB bring-up have run through their deepest paths by now
+        if (true != isMemReported) {
+            memReport_log();
+            isMemReported = true;
+        }
+#endif
         loopHandleDevices();
 
+        struct HID_OutputQueueStats_t kbdStats;
+        hidOutput_getKeyboardQueueStats(&kbdStats);
+        LOG_INF("Keyboard queue: high-water %" PRIu32 "/%d, collapsed %" PRIu32 ", overflowed %" PRIu32,
+                kbdStats.high_water, HID_OUTPUT_KBD_QUEUE_DEPTH, kbdStats.collapsed, kbdStats.overflowed);
+        latencyStats_log();
+#if defined(CONFIG_GHOSTHIDE_TRACE)
+        // The last records lead up to the disconnect
+        tracePoints_dump();
+#endif
+#if defined(CONFIG_GHOSTHIDE_LINK_CAPTURE)
+        ch37xCapture_dump();
+#endif
+
         LOG_WRN("Device disconnected, restarting...");
         usbhid_proxyCleanup();
         recoilComp_close(gRecoilCompCtx);
@@ -225,6 +369,8 @@ static int initCh375Device(DeviceInput_t *pDevIn, const char *pName, int usartIn
 
     pDevIn->name = pName;
     pDevIn->interfaceNum = interfaceNum;
+    pDevIn->portNum = (uint8_t)(pDevIn - gDeviceInputs);
+    fwdStats_setPortName(pDevIn->portNum, pName);
     
     // Store INT GPIO (NULL for polling mode)
     if (NULL != pIntGpio) {
@@ -234,8 +380,8 @@ static int initCh375Device(DeviceInput_t *pDevIn, const char *pName, int usartIn
         memset(&pDevIn->intGpio, 0, sizeof(pDevIn->intGpio));
     }
     
-    pDevIn->lastReportTimestampMs = 0;
-    pDevIn->reportIntervalMs = DEFAULT_REPORT_INTERVAL_MS;
+    pDevIn->nextPollMs = 0;
+    pDevIn->pollIntervalMs = CONFIG_GHOSTHIDE_POLL_INTERVAL_MS;
     pDevIn->isConnected = false;
 
     ret = ch37x_hwInitManual(pName, usartIndex, pIntGpio, CH37X_DEFAULT_BAUDRATE, &pDevIn->ch37xCtx);
@@ -243,23 +389,87 @@ static int initCh375Device(DeviceInput_t *pDevIn, const char *pName, int usartIn
         LOG_ERR("[ FAILED ] %s: Hardware init failed: %d", pName, ret);
         return ret;
     }
+#if defined(CONFIG_GHOSTHIDE_TRACE)
+    tracePoints_bindPort(pDevIn->ch37xCtx, pDevIn->portNum);
+#endif
+#if defined(CONFIG_GHOSTHIDE_LINK_CAPTURE)
+    ch37xCapture_bindPort(pDevIn->ch37xCtx, pDevIn->portNum);
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief Bring the CH375 up at the work baud rate
+ * @param pDevIn Device input structure, hardware already initialized
+ * @return 0 on success, negative error code otherwise
+ * @note Runs on the port's input thread, both ports wait for their chip at once.
+ */
+static int initCh375Link(DeviceInput_t *pDevIn) {
+
+    int ret = -1;
 
     ret = ch375_hostInit(pDevIn->ch37xCtx, CH37X_WORK_BAUDRATE);
     if (CH37X_HOST_SUCCESS != ret) {
-        LOG_ERR("[ FAILED ] %s: CH375 host init failed: %d", pName, ret);
+        LOG_ERR("[ FAILED ] %s: CH375 host init failed: %d", pDevIn->name, ret);
         return -EIO;
     }
 
     ret = ch37x_hwSetBaudrate(pDevIn->ch37xCtx, CH37X_WORK_BAUDRATE);
     if (ret < 0) {
-        LOG_ERR("%s: Baudrate switch failed: %d", pName, ret);
+        LOG_ERR("%s: Baudrate switch failed: %d", pDevIn->name, ret);
         return ret;
     }
 
-    LOG_INF("[ OK ] %s: Initialized successfully!", pName);
+    // The chip switches once SET_BAUDRATE is answered, make sure it listens at the new rate
+    ret = ch375_hostWaitReady(pDevIn->ch37xCtx, CH375_HOST_READY_TIMEOUT_MS);
+    if (CH37X_HOST_SUCCESS != ret) {
+        LOG_ERR("[ FAILED ] %s: No answer at the work baud rate: %d", pDevIn->name, ret);
+        return -EIO;
+    }
+
+    bootTimeline_markPort(BOOT_PHASE_LINK_READY, pDevIn->portNum);
+    LOG_INF("[ OK ] %s: Initialized successfully!", pDevIn->name);
     return 0;
 }
 
+/**
+ * @brief Run a bring-up step on every port at once
+ * @param job step to run, gets the port's DeviceInput_t
+ * @return 0 if every port succeeded, the first port's error otherwise
+ * @note With CONFIG_GHOSTHIDE_INPUT_THREADS each port runs it on its parked input
+ *       thread, so one port's waits overlap the other's. Otherwise in turn.
+ */
+static int runOnAllPorts(PortJob_t job) {
+
+    int ret = 0;
+
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        gDeviceInputs[i].job = job;
+        k_sem_give(&gDeviceInputs[i].startSem);
+    }
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        k_sem_take(&gDeviceInputs[i].parkedSem, K_FOREVER);
+        gDeviceInputs[i].job = NULL;
+        if (0 == ret && gDeviceInputs[i].jobRet < 0) {
+            ret = gDeviceInputs[i].jobRet;
+        }
+    }
+#else
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        int jobRet = job(&gDeviceInputs[i]);
+
+        if (0 == ret && jobRet < 0) {
+            ret = jobRet;
+        }
+    }
+#endif
+
+    return ret;
+}
+
 /**
  * @brief Open and enumerate USB HID device
  * @param pDevIn Device input structure
@@ -287,7 +497,7 @@ static int openDeviceInput(DeviceInput_t *pDevIn) {
         return USBHID_ERROR;
     }
 
-    pDevIn->reportIntervalMs = DEFAULT_REPORT_INTERVAL_MS;
+    pDevIn->pollIntervalMs = getPollIntervalMs(pDevIn);
 
     if (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) {
         ret = hidMouse_Open(&pDevIn->hidDev, &pDevIn->mouse);
@@ -297,6 +507,7 @@ static int openDeviceInput(DeviceInput_t *pDevIn) {
             ch375_hostUdevClose(&pDevIn->usbDev);
             return USBHID_ERROR;
         }
+        hidOutput_planMouse(&pDevIn->mouse, &pDevIn->mousePlan);
         LOG_INF("[ OK ] %s: Mouse opened", pDevIn->name);
     } 
     else if (USBHID_TYPE_KEYBOARD == pDevIn->hidDev.hid_type) {
@@ -319,9 +530,30 @@ static int openDeviceInput(DeviceInput_t *pDevIn) {
     return 0;
 }
 
+/**
+ * @brief Open a port's device and stamp the boot timeline
+ * @param pDevIn Device input structure
+ * @return 0 on success, negative error code otherwise
+ */
+static int openPortJob(DeviceInput_t *pDevIn) {
+
+    int ret = openDeviceInput(pDevIn);
+
+    if (ret < 0) {
+        LOG_ERR("[ FAILED ] %s: Failed to enumerate", pDevIn->name);
+        return ret;
+    }
+
+    pDevIn->isConnected = true;
+    bootTimeline_markPort(BOOT_PHASE_ENUMERATED, pDevIn->portNum);
+
+    return 0;
+}
+
 /**
  * @brief Wait for all configured USB devices to connect
- * @note Blocks until all devices are connected
+ * @note Blocks until all devices are connected. Every port is asked once per
+ *       pass, so a device that is already there is never kept waiting on the other.
  */
 static void waitAllDevicesConnect(void) {
     
@@ -338,11 +570,11 @@ static void waitAllDevicesConnect(void) {
                 continue;
             }
 
-            // 500ms timeout
-            ret = ch375_hostWaitDeviceConnect(pDevIn->ch37xCtx, 500);
+            ret = ch375_hostWaitDeviceConnect(pDevIn->ch37xCtx, 1);
             if (CH37X_HOST_SUCCESS == ret) {
                 LOG_INF("[ OK ] %s: Device connected", pDevIn->name);
                 pDevIn->isConnected = true;
+                bootTimeline_markPort(BOOT_PHASE_CONNECTED, pDevIn->portNum);
             } 
             else if (CH37X_HOST_ERROR == ret) {
                 LOG_ERR("[ FAILED ] %s: Error waiting for device", pDevIn->name);
@@ -356,32 +588,199 @@ static void waitAllDevicesConnect(void) {
             break;
         }
 
-        k_msleep(100);
+        k_msleep(CONNECT_POLL_MS);
     }
 
     LOG_INF("[ OK ] All devices connected!");
 }
 
 /**
- * @brief Enumerate all connected USB devices
+ * @brief Enumerate all connected USB devices, both at once
  * @return 0 on success, negative error code on failure
  */
 static int openAllDeviceInputs(void) {
     
-    int ret = -1;
+    return runOnAllPorts(openPortJob);
+}
+
+/**
+ * @brief Describe the device side interfaces the enumerated inputs need
+ * @param pLayout layout to fill
+ */
+static void getProxyLayout(struct USBHID_ProxyLayout_t *pLayout) {
+
+    memset(pLayout, 0x00, sizeof(*pLayout));
 
     for (int i = 0; i < CH375_MODULE_COUNT; i++) {
-        ret = openDeviceInput(&gDeviceInputs[i]);
-        if (ret < 0) {
-            LOG_ERR("[ FAILED ] %s: Failed to enumerate", gDeviceInputs[i].name);
-            return ret;
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+
+        if (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) {
+            pLayout->has_mouse = true;
+            pLayout->mouse_buttons = MAX(pLayout->mouse_buttons,
+                                    CLAMP(pDevIn->mouse.button.count, 1, 8));
+        }
+        else if (USBHID_TYPE_KEYBOARD == pDevIn->hidDev.hid_type) {
+            pLayout->has_keyboard = true;
         }
-        gDeviceInputs[i].isConnected = true;
     }
+}
 
-    return 0;
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+/**
+ * @brief Run one forwarding session on the input threads
+ * @note Returns once a port reports its device gone and every thread is parked.
+ */
+static void loopHandleDevices(void) {
+
+    int64_t nowMs = 0;
+    k_timeout_t logPeriod = K_FOREVER;
+
+    LOG_INF("HID processing started on %d input threads", CH375_MODULE_COUNT);
+
+    if (0 < CONFIG_GHOSTHIDE_REPORT_RATE_LOG_MS) {
+        logPeriod = K_MSEC(CONFIG_GHOSTHIDE_REPORT_RATE_LOG_MS);
+    }
+
+    nowMs = k_uptime_get();
+    resetReportRates(nowMs);
+    k_event_clear(&gSessionEvents, SESSION_EVT_DISCONNECT);
+    atomic_set(&gSessionActive, 1);
+#if defined(CONFIG_GHOSTHIDE_CPU_PINNING)
+    pinInputThreads();
+#endif
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+
+        if (true != pDevIn->isConnected) {
+            continue;
+        }
+
+        // Mouse motion goes first, keyboard and control transfers fill the gaps
+        k_thread_priority_set(&pDevIn->thread, (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) ?
+                                CONFIG_GHOSTHIDE_MOUSE_PRIORITY : CONFIG_GHOSTHIDE_KEYBOARD_PRIORITY);
+        pDevIn->nextPollMs = nowMs;
+        pDevIn->outReportTries = 0;
+        k_sem_give(&pDevIn->startSem);
+    }
+
+    // Main only wakes up for the rate log
+    while (0 == k_event_wait(&gSessionEvents, SESSION_EVT_DISCONNECT, false, logPeriod)) {
+        logReportRates(k_uptime_get());
+    }
+
+    atomic_clear(&gSessionActive);
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        if (true == gDeviceInputs[i].isConnected) {
+            k_sem_take(&gDeviceInputs[i].parkedSem, K_FOREVER);
+        }
+    }
+}
+
+/**
+ * @brief Create the parked input thread of every port
+ */
+static void startInputThreads(void) {
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+
+        k_sem_init(&pDevIn->startSem, 0, 1);
+        k_sem_init(&pDevIn->parkedSem, 0, 1);
+        k_thread_create(&pDevIn->thread, gInputStacks[i], K_THREAD_STACK_SIZEOF(gInputStacks[i]),
+                        inputThread, pDevIn, NULL, NULL, CONFIG_GHOSTHIDE_KEYBOARD_PRIORITY, 0, K_FOREVER);
+        k_thread_name_set(&pDevIn->thread, pDevIn->name);
+#if defined(CONFIG_GHOSTHIDE_CPU_PINNING)
+        // One port per core for the bring-up, pinInputThreads() assigns the roles once enumerated
+        k_thread_cpu_pin(&pDevIn->thread, i % arch_num_cpus());
+#endif
+        k_thread_start(&pDevIn->thread);
+    }
 }
 
+#if defined(CONFIG_GHOSTHIDE_CPU_PINNING)
+/**
+ * @brief Pin the input threads by role, the mouse on CPU 0 and the keyboard on CPU 1
+ * @note Two devices of the same kind keep one port per core. A thread may still
+ * be on its way back to startSem, it is suspended while its CPU mask changes.
+ */
+static void pinInputThreads(void) {
+
+    bool hasMouse = false;
+    bool hasKeyboard = false;
+    int cpu = 0;
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        if (true == gDeviceInputs[i].isConnected) {
+            hasMouse |= (USBHID_TYPE_MOUSE == gDeviceInputs[i].hidDev.hid_type);
+            hasKeyboard |= (USBHID_TYPE_KEYBOARD == gDeviceInputs[i].hidDev.hid_type);
+        }
+    }
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+
+        if (true != pDevIn->isConnected) {
+            continue;
+        }
+
+        cpu = i;
+        if (true == hasMouse && true == hasKeyboard) {
+            cpu = (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) ? 0 : 1;
+        }
+
+        k_thread_suspend(&pDevIn->thread);
+        k_thread_cpu_pin(&pDevIn->thread, cpu % arch_num_cpus());
+        k_thread_resume(&pDevIn->thread);
+    }
+}
+#endif
+
+/**
+ * @brief Poll one port on its own grid while the session is active
+ * @param p1 DeviceInput_t of the port
+ * @note Between sessions it also runs the bring-up steps of runOnAllPorts().
+ */
+static void inputThread(void *p1, void *p2, void *p3) {
+
+    DeviceInput_t *pDevIn = (DeviceInput_t *)p1;
+    int ret = -1;
+
+    (void)(p2);
+    (void)(p3);
+
+    while (1) {
+        k_sem_take(&pDevIn->startSem, K_FOREVER);
+        pDevIn->cpuId = arch_curr_cpu()->id;
+
+        if (NULL != pDevIn->job) {
+            pDevIn->jobRet = pDevIn->job(pDevIn);
+            k_sem_give(&pDevIn->parkedSem);
+            continue;
+        }
+
+        while (0 != atomic_get(&gSessionActive)) {
+            pDevIn->nextPollMs += pDevIn->pollIntervalMs;
+            if (pDevIn->nextPollMs <= k_uptime_get()) {
+                pDevIn->nextPollMs = k_uptime_get() + pDevIn->pollIntervalMs;
+            }
+
+            ret = pollDeviceInput(pDevIn, pDevIn->nextPollMs);
+            if (USBHID_NO_DEV == ret) {
+                LOG_ERR("%s: Device disconnected", pDevIn->name);
+                k_event_post(&gSessionEvents, SESSION_EVT_DISCONNECT);
+                break;
+            }
+
+            k_sleep(K_TIMEOUT_ABS_MS(pDevIn->nextPollMs));
+            recordPollLateness(pDevIn);
+        }
+
+        k_sem_give(&pDevIn->parkedSem);
+    }
+}
+
+#else
 /**
  * @brief Main HID input forwarding loop
  * @note Runs until device disconnection is detected
@@ -389,10 +788,22 @@ static int openAllDeviceInputs(void) {
 static void loopHandleDevices(void) {
     
     int ret = -1;
+    int64_t nowMs = 0;
+    int64_t wakeMs = 0;
 
     LOG_INF("HID processing loop started");
 
+    nowMs = k_uptime_get();
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        gDeviceInputs[i].nextPollMs = nowMs;
+        gDeviceInputs[i].outReportTries = 0;
+    }
+    resetReportRates(nowMs);
+
     while (1) {
+        nowMs = k_uptime_get();
+        wakeMs = nowMs + CONFIG_GHOSTHIDE_POLL_INTERVAL_MS;
+
         for (int i = 0; i < CH375_MODULE_COUNT; i++) {
             DeviceInput_t *pDevIn = &gDeviceInputs[i];
 
@@ -400,28 +811,287 @@ static void loopHandleDevices(void) {
                 continue;
             }
 
-            if (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) {
-                ret = handleMouseInput(pDevIn);
-
-                if (USBHID_NO_DEV == ret) {
-                    LOG_ERR("%s: Device disconnected", pDevIn->name);
-                    return;
-                }
+            if (nowMs < pDevIn->nextPollMs) {
+                wakeMs = MIN(wakeMs, pDevIn->nextPollMs);
+                continue;
             }
+            recordPollLateness(pDevIn);
 
-            else if (USBHID_TYPE_KEYBOARD == pDevIn->hidDev.hid_type) {
-                ret = handleKeyboardInput(pDevIn);
+            // Stay on the poll grid so a 1 ms device really gets 1000 polls per second, resync after a stall
+            pDevIn->nextPollMs += pDevIn->pollIntervalMs;
+            if (pDevIn->nextPollMs <= nowMs) {
+                pDevIn->nextPollMs = nowMs + pDevIn->pollIntervalMs;
+            }
+            wakeMs = MIN(wakeMs, pDevIn->nextPollMs);
 
-                if (USBHID_NO_DEV == ret) {
-                    LOG_ERR("%s: Device disconnected", pDevIn->name);
-                    return;
-                }
+            ret = pollDeviceInput(pDevIn, wakeMs);
+            if (USBHID_NO_DEV == ret) {
+                LOG_ERR("%s: Device disconnected", pDevIn->name);
+                return;
             }
         }
 
-        k_msleep(MAIN_LOOP_SLEEP_MS);
+        if (0 < CONFIG_GHOSTHIDE_REPORT_RATE_LOG_MS) {
+            logReportRates(nowMs);
+        }
+
+        k_sleep(K_TIMEOUT_ABS_MS(wakeMs));
     }
 }
+#endif
+
+/**
+ * @brief Poll a port once and forward what it produced
+ * @param pDevIn Device input structure
+ * @param wakeMs When the caller polls next, host to device reports only use the time before it
+ * @return 0 on success, USBHID_NO_DEV on disconnection
+ */
+static int pollDeviceInput(DeviceInput_t *pDevIn, int64_t wakeMs) {
+
+    int ret = 0;
+
+    if (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) {
+        ret = handleMouseInput(pDevIn);
+    }
+    else if (USBHID_TYPE_KEYBOARD == pDevIn->hidDev.hid_type) {
+        ret = handleKeyboardInput(pDevIn);
+    }
+
+    if (USBHID_NO_DEV == ret) {
+        return ret;
+    }
+
+    // Host to device reports only go out in the slack before the next poll
+    if (k_uptime_get() < wakeMs) {
+        ret = serviceOutReport(pDevIn);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Account how late a poll started against its slot on the poll grid
+ * @param pDevIn Device input structure, nextPollMs still the slot being started
+ */
+static void recordPollLateness(DeviceInput_t *pDevIn) {
+
+    int64_t lateUs = k_ticks_to_us_floor64(k_uptime_ticks()) - pDevIn->nextPollMs * USEC_PER_MSEC;
+
+    if (lateUs < 0) {
+        lateUs = 0;
+    }
+
+    pDevIn->lateCount++;
+    pDevIn->lateSumUs += lateUs;
+    pDevIn->lateMaxUs = MAX(pDevIn->lateMaxUs, (uint32_t)lateUs);
+}
+
+/**
+ * @brief Forward one queued host to device report (e.g. keyboard LEDs) to a port
+ * @param pDevIn Device input structure, the port that owns the target interface
+ * @return 0 if nothing failed hard, USBHID_NO_DEV if the device is gone
+ * @note At most one SET_REPORT per call, and it fails on the first NAK instead
+ *       of waiting, so interrupt polling is never held for longer than that.
+ */
+static int serviceOutReport(DeviceInput_t *pDevIn) {
+
+    int ret = -1;
+    struct USBHID_ProxyOutReport_t out;
+    uint8_t buff[USBHID_PROXY_OUT_REPORT_MAX + 1];
+    uint8_t iface = (USBHID_TYPE_MOUSE == pDevIn->hidDev.hid_type) ? IFACE_MOUSE : IFACE_KEYBOARD;
+    uint16_t len = 0;
+    uint8_t reportID = 0;
+
+    if (0 != usbhid_proxyTakeOutReport(iface, &out)) {
+        return 0;
+    }
+
+    // Our keyboard has no report IDs, the upstream one may put its LEDs behind one
+    reportID = out.id;
+    if (IFACE_KEYBOARD == iface && 0 == out.id && 0 != pDevIn->keyboard.report_id) {
+        reportID = pDevIn->keyboard.report_id;
+        buff[len++] = reportID;
+    }
+    memcpy(&buff[len], out.data, out.len);
+    len += out.len;
+
+    ret = USBHID_setReport(&pDevIn->hidDev, out.type, reportID, buff, len);
+    if (USBHID_BUSY == ret && ++pDevIn->outReportTries < OUT_REPORT_RETRIES) {
+        usbhid_proxyRequeueOutReport(&out);
+        return 0;
+    }
+
+    pDevIn->outReportTries = 0;
+
+    if (USBHID_NO_DEV == ret) {
+        return ret;
+    }
+
+    if (USBHID_SUCCESS != ret) {
+        LOG_WRN("%s: SET_REPORT type %u id %u not delivered: %d", pDevIn->name, out.type, reportID, ret);
+        return 0;
+    }
+
+    LOG_DBG("%s: SET_REPORT type %u id %u, %u bytes", pDevIn->name, out.type, reportID, len);
+
+    return 0;
+}
+
+/**
+ * @brief Pick the poll period of a device from its interrupt IN endpoint
+ * @param pDevIn Device input structure, HID device already open
+ * @return Poll period in ms
+ */
+static uint32_t getPollIntervalMs(const DeviceInput_t *pDevIn) {
+
+    uint32_t intervalMs = CONFIG_GHOSTHIDE_POLL_INTERVAL_MS;
+    uint8_t epInterval = 0;
+
+    // Low and full speed bInterval counts 1 ms frames
+    if (NULL != pDevIn->hidDev.endpoint) {
+        epInterval = pDevIn->hidDev.endpoint->interval;
+    }
+
+    if (true == IS_ENABLED(CONFIG_GHOSTHIDE_POLL_MATCH_UPSTREAM) && epInterval > intervalMs) {
+        intervalMs = epInterval;
+    }
+
+    LOG_INF("%s: Upstream bInterval %u ms, polling every %" PRIu32 " ms",
+            pDevIn->name, epInterval, intervalMs);
+
+    return intervalMs;
+}
+
+/**
+ * @brief Start a new report rate measurement window
+ * @param nowMs Current uptime in ms
+ */
+static void resetReportRates(int64_t nowMs) {
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+
+        pDevIn->lateCount = 0;
+        pDevIn->lateMaxUs = 0;
+        pDevIn->lateSumUs = 0;
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+        if (NULL != pDevIn->ch37xCtx) {
+            ch37x_getLinkStats(pDevIn->ch37xCtx, &pDevIn->linkBase);
+        }
+#endif
+    }
+
+    fwdStats_windowStart(&gRateWindow, nowMs);
+}
+
+/**
+ * @brief Log upstream and USB report rates once the measurement window has passed
+ * @param nowMs Current uptime in ms
+ */
+static void logReportRates(int64_t nowMs) {
+
+    struct FwdStats_Counters_t delta;
+    int64_t elapsedMs = nowMs - gRateWindow.start_ms;
+    uint32_t totalIn = 0;
+    uint32_t totalOut = 0;
+
+    if (elapsedMs < CONFIG_GHOSTHIDE_REPORT_RATE_LOG_MS) {
+        return;
+    }
+
+    elapsedMs = fwdStats_windowRoll(&gRateWindow, nowMs, &delta);
+
+    for (int i = 0; i < CH375_MODULE_COUNT; i++) {
+        DeviceInput_t *pDevIn = &gDeviceInputs[i];
+        const struct USBHID_ProxySendStats_t *pOut = &delta.out[pDevIn->interfaceNum];
+        uint32_t inCount = delta.in_reports[pDevIn->portNum];
+        uint32_t outCount = pOut->sent;
+
+        totalIn += inCount;
+        totalOut += outCount;
+#if defined(CONFIG_GHOSTHIDE_INPUT_THREADS)
+        LOG_INF("%s: in %" PRIu32 " Hz, out %" PRIu32 " Hz (poll %" PRIu32 " ms, cpu %u)", pDevIn->name,
+                (uint32_t)(((uint64_t)inCount * 1000U) / elapsedMs),
+                (uint32_t)(((uint64_t)outCount * 1000U) / elapsedMs),
+                pDevIn->pollIntervalMs, pDevIn->cpuId);
+#else
+        LOG_INF("%s: in %" PRIu32 " Hz, out %" PRIu32 " Hz (poll %" PRIu32 " ms)", pDevIn->name,
+                (uint32_t)(((uint64_t)inCount * 1000U) / elapsedMs),
+                (uint32_t)(((uint64_t)outCount * 1000U) / elapsedMs),
+                pDevIn->pollIntervalMs);
+#endif
+        if (0 != delta.in_filtered[pDevIn->portNum] || 0 != pOut->dropped || 0 != pOut->failed) {
+            LOG_INF("%s: filtered %" PRIu32 ", coalesced %" PRIu32 ", busy %" PRIu32 ", dropped %" PRIu32
+                    ", failed %" PRIu32, pDevIn->name, delta.in_filtered[pDevIn->portNum], pOut->coalesced,
+                    pOut->busy, pOut->dropped, pOut->failed);
+        }
+        if (0 != pDevIn->lateCount) {
+            LOG_INF("%s: poll start late avg %" PRIu32 " us, max %" PRIu32 " us", pDevIn->name,
+                    (uint32_t)(pDevIn->lateSumUs / pDevIn->lateCount), pDevIn->lateMaxUs);
+        }
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+        logLinkStats(pDevIn, inCount, elapsedMs);
+#endif
+    }
+    LOG_INF("All ports: in %" PRIu32 " Hz, out %" PRIu32 " Hz", (uint32_t)(((uint64_t)totalIn * 1000U) / elapsedMs),
+            (uint32_t)(((uint64_t)totalOut * 1000U) / elapsedMs));
+    latencyStats_log();
+
+    resetReportRates(nowMs);
+}
+
+#if defined(CONFIG_GHOSTHIDE_LINK_STATS)
+/**
+ * @brief Log where a port's UART time went, per forwarded report and per second
+ * @param pDevIn Device input structure
+ * @param inCount Reports forwarded in the window
+ * @param elapsedMs Length of the window in ms
+ * @note Ratios are printed with two decimals.
+ */
+static void logLinkStats(DeviceInput_t *pDevIn, uint32_t inCount, int64_t elapsedMs) {
+
+    struct ch37x_LinkStats_t now;
+    const struct ch37x_LinkStats_t *pBase = &pDevIn->linkBase;
+    uint32_t txBytes, rxBytes, cmds = 0, perReport, perCmd[3];
+    uint32_t polls, waits, naks, ins, lockUs;
+
+    if (NULL == pDevIn->ch37xCtx || true != pDevIn->isConnected) {
+        return;
+    }
+
+    ch37x_getLinkStats(pDevIn->ch37xCtx, &now);
+    txBytes = now.tx_bytes - pBase->tx_bytes;
+    rxBytes = now.rx_bytes - pBase->rx_bytes;
+    for (int c = 0; c < CH37X_STATS_CMD_COUNT; c++) {
+        cmds += now.cmds[c] - pBase->cmds[c];
+    }
+    polls = now.status_polls - pBase->status_polls;
+    waits = now.wait_ints - pBase->wait_ints;
+    naks = now.in_naks - pBase->in_naks;
+    ins = now.in_ok - pBase->in_ok;
+    lockUs = (uint32_t)k_cyc_to_us_floor64(now.lock_wait_cyc - pBase->lock_wait_cyc);
+
+    // x100 fixed point, an idle window has nothing to divide by
+    inCount = MAX(inCount, 1U);
+    perReport = (uint32_t)(((uint64_t)(txBytes + rxBytes) * 100U) / inCount);
+    perCmd[0] = (uint32_t)(((uint64_t)cmds * 100U) / inCount);
+    perCmd[1] = (uint32_t)(((uint64_t)(now.cmds[CH37X_STATS_CMD_STATUS] - pBase->cmds[CH37X_STATS_CMD_STATUS]) * 100U) / inCount);
+    perCmd[2] = (uint32_t)(((uint64_t)(now.cmds[CH37X_STATS_CMD_TOKEN] - pBase->cmds[CH37X_STATS_CMD_TOKEN]) * 100U) / inCount);
+
+    LOG_INF("%s: UART tx %" PRIu32 " B/s, rx %" PRIu32 " B/s, per report %" PRIu32 ".%02" PRIu32 " B, %" PRIu32
+            ".%02" PRIu32 " cmds (%" PRIu32 ".%02" PRIu32 " status, %" PRIu32 ".%02" PRIu32 " token)", pDevIn->name,
+            (uint32_t)(((uint64_t)txBytes * 1000U) / elapsedMs), (uint32_t)(((uint64_t)rxBytes * 1000U) / elapsedMs),
+            perReport / 100, perReport % 100, perCmd[0] / 100, perCmd[0] % 100, perCmd[1] / 100, perCmd[1] % 100,
+            perCmd[2] / 100, perCmd[2] % 100);
+
+    polls = (uint32_t)(((uint64_t)polls * 100U) / MAX(waits, 1U));
+    naks = (uint32_t)(((uint64_t)naks * 100U) / MAX(ins, 1U));
+    LOG_INF("%s: %" PRIu32 ".%02" PRIu32 " status polls/wait, %" PRIu32 ".%02" PRIu32 " NAKs/IN, %" PRIu32
+            " rx timeouts, %" PRIu32 " short packet timeouts, lock wait %" PRIu32 " us/s", pDevIn->name,
+            polls / 100, polls % 100, naks / 100, naks % 100, now.rx_timeouts - pBase->rx_timeouts,
+            now.short_timeouts - pBase->short_timeouts, (uint32_t)(((uint64_t)lockUs * 1000U) / elapsedMs));
+}
+#endif
 
 /**
  * @brief Handle mouse input and forward to USB output
@@ -431,8 +1101,9 @@ static void loopHandleDevices(void) {
 static int handleMouseInput(DeviceInput_t *pDevIn) {
     
     int ret = -1;
-    uint32_t buttonVal = 0;
+    struct HID_MouseState_t state;
     bool needSend = false;
+    bool isModified = false;
 
     // Fetch new report from device
     ret = hidMouse_FetchReport(&pDevIn->mouse);
@@ -441,42 +1112,52 @@ static int handleMouseInput(DeviceInput_t *pDevIn) {
         return ret;
     }
 
+    fwdStats_countInput(pDevIn->portNum, ret);
+    if (USBHID_SUCCESS == ret || USBHID_REPORT_FILTERED == ret) {
+        TRACE_POINT(TRACE_EVT_FETCH, pDevIn->portNum, ret, pDevIn->hidDev.report_len);
+    }
+
+    // Decode once, everything below works on the snapshot
+    if (USBHID_SUCCESS != hidMouse_GetState(&pDevIn->mouse, &state, false)) {
+        return 0;
+    }
+    if (USBHID_SUCCESS == ret) {
+        latencyStats_record(IFACE_MOUSE, LATENCY_STAGE_DECODE, pDevIn->hidDev.report_cyc);
+    }
+
+    // Without a new report only the held buttons carry over, motion is relative
+    if (USBHID_SUCCESS != ret) {
+        state.x = 0;
+        state.y = 0;
+        state.wheel = 0;
+    }
+
+    // Hotkeys change the pattern from the keyboard port, their requests are applied here
+    applyRcRequests();
+
     // Check LMB state
-    hidMouse_GetButton(&pDevIn->mouse, HID_MOUSE_BUTTON_LEFT, &buttonVal, false);
-    if (0 != buttonVal) {
+    if (0 != (state.buttons & BIT(HID_MOUSE_BUTTON_LEFT))) {
         // Start/continue compensation if pressed
-        if  (true != gRcActive) {
-            gRcActive = true;
+        if  (true != gRcActive[pDevIn->portNum]) {
+            gRcActive[pDevIn->portNum] = true;
             recoilComp_restart(gRecoilCompCtx);
-            LOG_INF("[ OK ] Recoil compensation ENABLED.");
+            TRACE_POINT(TRACE_EVT_RECOIL, pDevIn->portNum, 1, 0);
         }
 
         // Get compensaton if ready
-        if (true == gRcEnabled) {
+        if (0 != atomic_get(&gRcEnabled)) {
             struct PatternCompensation_t compData;
-            ret = recoilComp_getNextData(gRecoilCompCtx, &compData);
 
-            if (0 == ret) {
-                int32_t mouseX;
-                int32_t mouseY;
-                int32_t finalX;
-                int32_t finalY;
-
-                // Get actual mouse movement
-                hidMouse_GetOrientation(&pDevIn->mouse, HID_MOUSE_AXIS_X, &mouseX, false);
-                hidMouse_GetOrientation(&pDevIn->mouse, HID_MOUSE_AXIS_Y, &mouseY, false);
-
-                finalX = mouseX + compData.x;
-                finalY = mouseY + compData.y;
-
-                // Apply compensation
-                hidMouse_SetOrientation(&pDevIn->mouse, HID_MOUSE_AXIS_X, finalX, false);
-                hidMouse_SetOrientation(&pDevIn->mouse, HID_MOUSE_AXIS_Y, finalY, false);
+            if (0 == recoilComp_getNextData(gRecoilCompCtx, &compData)) {
+                // Apply compensation on top of the actual mouse movement
+                state.x += compData.x;
+                state.y += compData.y;
 
                 needSend = true;
+                isModified = true;
             } else {
                 // Just forward mouse data
-                needSend = (USBHID_SUCCESS == hidMouse_FetchReport(&pDevIn->mouse)) ? true : false;
+                needSend = (USBHID_SUCCESS == ret) ? true : false;
             }
         } else {
             // Compensation disabled - just forward as is
@@ -484,19 +1165,21 @@ static int handleMouseInput(DeviceInput_t *pDevIn) {
         }
     } else {
         // LMB released
-        if ( true == gRcActive) {
-            gRcActive = false;
-            LOG_INF("[ OK ] Recoil compensation DISABLED");
+        if ( true == gRcActive[pDevIn->portNum]) {
+            gRcActive[pDevIn->portNum] = false;
+            TRACE_POINT(TRACE_EVT_RECOIL, pDevIn->portNum, 0, 0);
         }
 
         needSend = (USBHID_SUCCESS == ret) ? true : false;
     }
 
-    // Send report if we have data
+    // Send report if we have data, untouched reports go straight from the fetch buffer
     if (true == needSend) {
-        ret = hidOutput_sendMouseReport(&pDevIn->mouse);
-        if (USBHID_SUCCESS != ret) {
-            LOG_WRN("%s: Failed to send report: %d", pDevIn->name, ret);
+        // Drops and failures are counted by the proxy, see fwd_stats
+        if (true == isModified) {
+            (void)hidOutput_sendMouseState(&state, pDevIn->hidDev.report_cyc);
+        } else {
+            (void)hidOutput_sendMousePlanned(&pDevIn->mouse, &pDevIn->mousePlan);
         }
     }
 
@@ -511,16 +1194,7 @@ static int handleMouseInput(DeviceInput_t *pDevIn) {
 static int handleKeyboardInput(DeviceInput_t *pDevIn) {
     
     int ret = -1;
-    struct USBHID_Device_t *pHidDev;
-    uint8_t *pReportBuff;
-    size_t reportLen;
-    uint32_t value;
-
-    static uint8_t lastSentReport[8] = {0};
-    static uint8_t lastKeyboardReport[8] = {0};
-
-    pHidDev = pDevIn->keyboard.hid_dev;
-    reportLen = pHidDev ? pHidDev->report_len : 0;
+    struct HID_KeyboardState_t state;
 
     // Fetch new report
     ret = hidKeyboard_FetchReport(&pDevIn->keyboard);
@@ -529,83 +1203,33 @@ static int handleKeyboardInput(DeviceInput_t *pDevIn) {
         return USBHID_NO_DEV;
     }
 
+    fwdStats_countInput(pDevIn->portNum, ret);
+    if (USBHID_SUCCESS == ret || USBHID_REPORT_FILTERED == ret) {
+        TRACE_POINT(TRACE_EVT_FETCH, pDevIn->portNum, ret, pDevIn->hidDev.report_len);
+    }
+
     // No new data
     if (USBHID_SUCCESS != ret) {
         return 0;
     }
 
-    // Get report buffer
-    ret = USBHID_getReportBuffer(pHidDev, &pReportBuff, NULL, false);
-    if (USBHID_SUCCESS != ret || NULL == pReportBuff) {
+    // Decode once, 6KRO and NKRO keyboards end up in the same key bitmap
+    ret = hidKeyboard_GetState(&pDevIn->keyboard, &state, false);
+    if (USBHID_SUCCESS != ret) {
         return 0;
     }
+    latencyStats_record(IFACE_KEYBOARD, LATENCY_STAGE_DECODE, pDevIn->hidDev.report_cyc);
 
-    // Skip if no chnages
-    if (memcmp(pReportBuff, lastKeyboardReport, reportLen) == 0) {
+    // Run hotkeys on press, skip if no changes unless the last state still has to go out
+    if (0 == hidKeyboard_DispatchEvents(&gKeyEvents[pDevIn->portNum], &state) &&
+                                                    true != gKbdResend[pDevIn->portNum]) {
         return 0;
     }
 
-    memcpy(lastKeyboardReport, pReportBuff, reportLen);
-
-    // Process ctrl keys
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_PAGEUP, &value, false);
-    if (0 != value) {
-        gRcEnabled = true;
-        LOG_INF("Recoil compensation profile ACTIVATED");
-    }
-
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_PAGEDOWN, &value, false);
-    if (0 != value) {
-        gRcEnabled = false;
-        LOG_INF("Recoil compensation profile DEACTIVATED");
-    }
-
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KBD_NUMBER('1'), &value, false);
-    if (0 != value) {
-        int res = recoilComp_setPreset(gRecoilCompCtx, TEMPLATE_OW2_SOLDIER76);
-        if (0 == res) {
-            LOG_INF("[ OK ] Selected: SOLDIER 76");
-        }
-    }
-
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KBD_NUMBER('2'), &value, false);
-    if (0 != value) {
-        int res = recoilComp_setPreset(gRecoilCompCtx, TEMPLATE_OW2_CASSIDY);
-        if (0 == res) {
-            LOG_INF("[ OK ] Selected: CASSIDY");
-        }
-    }
-
-    // Coefficient adjustment
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_EQUAL, &value, false);
-    if (0 != value) {
-        recoilComp_changeCoefficient(gRecoilCompCtx, true);
-    }
-
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_MINUS, &value, false);
-    if (0 != value) {
-        recoilComp_changeCoefficient(gRecoilCompCtx, false);
-    }
-
-    // Sensitivity adjustment
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_COMMA, &value, false);
-    if (0 != value) {
-        recoilComp_changeSensitivity(gRecoilCompCtx, true);
-    }
-
-    hidKeyboard_GetKey(&pDevIn->keyboard, HID_KEY_DOT, &value, false);
-    if (0 != value) {
-        recoilComp_changeSensitivity(gRecoilCompCtx, false);
-    }
-
-    // Forward to USB output
-    ret = usbhid_proxySendReport(pDevIn->interfaceNum, pReportBuff, reportLen);
-
-    if (0 == ret) {
-        memcpy(lastSentReport, pReportBuff, reportLen);
-    } else {
-        LOG_ERR("Keyboard send failed: %d", ret);
-    }
+    // Forward to USB output. The event table already took this state, if the output
+    // refused it the next report is forwarded even when nothing changed
+    ret = hidOutput_sendKeyboardState(&state, pDevIn->hidDev.report_cyc);
+    gKbdResend[pDevIn->portNum] = (0 != ret);
 
     return 0;
 }
@@ -645,9 +1269,125 @@ static int initInputPatterns(void) {
         return ret;
     }
 
-    gRcEnabled = false;
-    gRcActive = false;
+    atomic_clear(&gRcEnabled);
+    atomic_clear(&gRcRequests);
+    memset(gRcActive, 0x00, sizeof(gRcActive));
+
+    ret = bindHotkeys();
+    if (ret < 0) {
+        LOG_ERR("[ FAILED ] Failed to bind hotkeys: %d", ret);
+        recoilComp_close(gRecoilCompCtx);
+        gRecoilCompCtx = NULL;
+        return ret;
+    }
 
     LOG_INF("[ OK ] Recoil compensation pattern initialized");
     return 0;
+}
+
+/**
+ * @brief Reset the key event table and bind the hotkeys
+ * @return 0 on success, negative error code otherwise
+ */
+static int bindHotkeys(void) {
+
+    int ret = -1;
+
+    for (int port = 0; port < CH375_MODULE_COUNT; port++) {
+        hidKeyboard_InitEvents(&gKeyEvents[port]);
+        gKbdResend[port] = false;
+
+        for (uint32_t i = 0; i < ARRAY_SIZE(gHotkeys); i++) {
+            ret = hidKeyboard_BindKey(&gKeyEvents[port], gHotkeys[i].keyCode, HID_KEY_EVENT_PRESS,
+                                            gHotkeys[i].cb, (void *)gHotkeys[i].arg);
+            if (USBHID_SUCCESS != ret) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Post a hotkey request for the mouse path
+ * @param clearMask RC_REQ_* bits to replace
+ * @param setMask RC_REQ_* bits to set
+ * @return None
+ */
+static void postRcRequest(atomic_val_t clearMask, atomic_val_t setMask) {
+
+    atomic_val_t old;
+
+    do {
+        old = atomic_get(&gRcRequests);
+    } while (true != atomic_cas(&gRcRequests, old, (old & ~clearMask) | setMask));
+}
+
+/**
+ * @brief Apply the posted hotkey requests to the compensation pattern
+ * @return None
+ * @note Runs on the mouse path, the only place the pattern is stepped, so a
+ * poll never waits on a keyboard thread.
+ */
+static void applyRcRequests(void) {
+
+    atomic_val_t req;
+    uint32_t preset;
+
+    if (0 == atomic_get(&gRcRequests)) {
+        return;
+    }
+
+    req = atomic_clear(&gRcRequests);
+
+    if (0 != (req & RC_REQ_PRESET_MASK)) {
+        preset = (req & RC_REQ_PRESET_MASK) - 1;
+        if (0 == recoilComp_setPreset(gRecoilCompCtx, preset)) {
+            LOG_INF("[ OK ] Selected: %s", gPresetNames[preset]);
+        }
+    }
+
+    if (0 != (req & RC_REQ_COEF_UP)) {
+        recoilComp_changeCoefficient(gRecoilCompCtx, true);
+    }
+    if (0 != (req & RC_REQ_COEF_DOWN)) {
+        recoilComp_changeCoefficient(gRecoilCompCtx, false);
+    }
+    if (0 != (req & RC_REQ_SENS_UP)) {
+        recoilComp_changeSensitivity(gRecoilCompCtx, true);
+    }
+    if (0 != (req & RC_REQ_SENS_DOWN)) {
+        recoilComp_changeSensitivity(gRecoilCompCtx, false);
+    }
+}
+
+static void onRecoilToggleKey(uint8_t keyCode, bool isPressed, void *pUserData) {
+
+    bool isEnabled = (0 != (uintptr_t)pUserData);
+
+    atomic_set(&gRcEnabled, isEnabled ? 1 : 0);
+    LOG_INF("Recoil compensation profile %s", isEnabled ? "ACTIVATED" : "DEACTIVATED");
+}
+
+static void onPresetKey(uint8_t keyCode, bool isPressed, void *pUserData) {
+
+    uint32_t preset = (uint32_t)(uintptr_t)pUserData;
+
+    if (preset >= ARRAY_SIZE(gPresetNames)) {
+        return;
+    }
+
+    // The latest preset wins if several are pressed before the mouse path runs
+    postRcRequest(RC_REQ_PRESET_MASK, (preset + 1) & RC_REQ_PRESET_MASK);
+}
+
+static void onCoefficientKey(uint8_t keyCode, bool isPressed, void *pUserData) {
+
+    postRcRequest(0, (0 != (uintptr_t)pUserData) ? RC_REQ_COEF_UP : RC_REQ_COEF_DOWN);
+}
+
+static void onSensitivityKey(uint8_t keyCode, bool isPressed, void *pUserData) {
+
+    postRcRequest(0, (0 != (uintptr_t)pUserData) ? RC_REQ_SENS_UP : RC_REQ_SENS_DOWN);
 }
\ No newline at end of file
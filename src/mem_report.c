@@ -0,0 +1,364 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           mem_report.c
+ * @brief          Stack, heap and static RAM report implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Stacks are painted when a thread starts (CONFIG_INIT_STACKS), the high-water
+ * mark is where the paint ends. Heap figures are the sys_heap runtime stats,
+ * read without allocating, so the report never competes with the input path
+ * for the heap lock or memory. Static RAM comes from the MEM_REPORT_STATIC() table and, on hardware, from the
+ * linker's section bounds. With CONFIG_SHELL `mem` prints everything,
+ * `mem stacks`, `mem heap` and `mem static` one part each.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mem_report.h"
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/devicetree.h>
+#include <string.h>
+#if !defined(CONFIG_ARCH_POSIX)
+#include <zephyr/linker/linker-defs.h>
+#endif
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(mem_report, LOG_LEVEL_INF);
+
+/* Private macros ------------------------------------------------------------*/
+#define MEM_REPORT_STACK_PAINT      0xAA    // CONFIG_INIT_STACKS fill byte
+#define MEM_REPORT_MAX_MODULES      16
+
+#if DT_HAS_CHOSEN(zephyr_sram)
+#define MEM_REPORT_RAM_SIZE         DT_REG_SIZE(DT_CHOSEN(zephyr_sram))
+#else
+#define MEM_REPORT_RAM_SIZE         0
+#endif
+
+/* Private types -------------------------------------------------------------*/
+struct MemReport_StackWalk_t {
+    struct MemReport_Stack_t *pStacks;
+    int maxCount;
+    int count;
+};
+
+/* Private variables ---------------------------------------------------------*/
+#if K_HEAP_MEM_POOL_SIZE > 0
+extern struct k_heap _system_heap;
+#endif
+
+#if !defined(CONFIG_ARCH_POSIX)
+K_KERNEL_STACK_ARRAY_DECLARE(z_interrupt_stacks, CONFIG_MP_MAX_NUM_CPUS, CONFIG_ISR_STACK_SIZE);
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void stack_walk(const struct k_thread *pThread, void *pUserData);
+static int module_totals(const char **ppModules, size_t *pSizes, int maxCount);
+
+/**
+ * @brief Read the high-water mark of every thread stack and interrupt stack
+ * @param pStacks array to fill
+ * @param maxCount size of pStacks
+ * @return number of stacks filled in
+ * @note Threads past maxCount are left out.
+ */
+int memReport_getStacks(struct MemReport_Stack_t *pStacks, int maxCount) {
+
+    struct MemReport_StackWalk_t walk = {
+        .pStacks = pStacks,
+        .maxCount = maxCount,
+        .count = 0,
+    };
+
+    if (NULL == pStacks || maxCount <= 0) {
+        return 0;
+    }
+
+    k_thread_foreach_unlocked(stack_walk, &walk);
+
+#if !defined(CONFIG_ARCH_POSIX)
+    // Interrupt stacks are not threads, scan their paint directly
+    for (unsigned int i = 0; i < arch_num_cpus() && walk.count < maxCount; i++) {
+        static const char *const isrNames[] = {"isr0", "isr1", "isr2", "isr3"};
+        const uint8_t *pBuff = K_KERNEL_STACK_BUFFER(z_interrupt_stacks[i]);
+        size_t size = K_KERNEL_STACK_SIZEOF(z_interrupt_stacks[i]);
+        size_t unused = 0;
+
+        while (unused < size && MEM_REPORT_STACK_PAINT == pBuff[unused]) {
+            unused++;
+        }
+
+        pStacks[walk.count].name = (i < ARRAY_SIZE(isrNames)) ? isrNames[i] : "isr";
+        pStacks[walk.count].size = size;
+        pStacks[walk.count].used = size - unused;
+        walk.count++;
+    }
+#endif
+
+    return walk.count;
+}
+
+/**
+ * @brief Read the use of the system heap
+ * @param pHeap pointer to the figures to fill
+ * @return 0 on success, -ENOTSUP without a system heap
+ */
+int memReport_getHeap(struct MemReport_Heap_t *pHeap) {
+
+#if K_HEAP_MEM_POOL_SIZE > 0
+    struct sys_memory_stats stats;
+
+    if (NULL == pHeap) {
+        return -EINVAL;
+    }
+
+    if (0 != sys_heap_runtime_stats_get(&_system_heap.heap, &stats)) {
+        return -EIO;
+    }
+
+    pHeap->size = stats.free_bytes + stats.allocated_bytes;
+    pHeap->used = stats.allocated_bytes;
+    pHeap->peak = stats.max_allocated_bytes;
+
+    return 0;
+#else
+    ARG_UNUSED(pHeap);
+    return -ENOTSUP;
+#endif
+}
+
+/**
+ * @brief Read the RAM taken by the image
+ * @param pImage pointer to the figures to fill
+ * @return None
+ * @note On native_sim only the declared total is known, the rest reads 0.
+ */
+void memReport_getImage(struct MemReport_Image_t *pImage) {
+
+    if (NULL == pImage) {
+        return;
+    }
+
+    memset(pImage, 0x00, sizeof(struct MemReport_Image_t));
+
+#if !defined(CONFIG_ARCH_POSIX)
+    pImage->ram_size = MEM_REPORT_RAM_SIZE;
+    pImage->image = (size_t)(_image_ram_end - _image_ram_start);
+    pImage->data = (size_t)(__data_region_end - __data_region_start);
+    pImage->bss = (size_t)(__bss_end - __bss_start);
+#endif
+
+    STRUCT_SECTION_FOREACH(MemReport_Static_t, pEntry) {
+        pImage->declared += pEntry->size;
+    }
+}
+
+/**
+ * @brief Add up the static RAM a module declared
+ * @param pModule module name as given to MEM_REPORT_STATIC()
+ * @return bytes, 0 for a module that declared nothing
+ */
+size_t memReport_getModuleStatic(const char *pModule) {
+
+    size_t total = 0;
+
+    if (NULL == pModule) {
+        return 0;
+    }
+
+    STRUCT_SECTION_FOREACH(MemReport_Static_t, pEntry) {
+        if (0 == strcmp(pEntry->module, pModule)) {
+            total += pEntry->size;
+        }
+    }
+
+    return total;
+}
+
+/**
+ * @brief Log the whole report
+ * @return None
+ */
+void memReport_log(void) {
+
+    struct MemReport_Stack_t stacks[MEM_REPORT_MAX_STACKS];
+    struct MemReport_Heap_t heap;
+    struct MemReport_Image_t image;
+    const char *modules[MEM_REPORT_MAX_MODULES];
+    size_t sizes[MEM_REPORT_MAX_MODULES];
+    int count = memReport_getStacks(stacks, ARRAY_SIZE(stacks));
+
+    for (int i = 0; i < count; i++) {
+        LOG_INF("Stack %-12s %5zu/%5zu B (%u%%)", stacks[i].name, stacks[i].used, stacks[i].size,
+                (unsigned int)((stacks[i].used * 100U) / MAX(stacks[i].size, 1)));
+    }
+
+    if (0 == memReport_getHeap(&heap)) {
+        LOG_INF("Heap %zu/%zu B, peak %zu B", heap.used, heap.size, heap.peak);
+    }
+
+    memReport_getImage(&image);
+    if (0 != image.image) {
+        LOG_INF("Static RAM %zu of %zu B (data %zu, bss %zu, noinit %zu), %zu B declared by modules", image.image,
+                image.ram_size, image.data, image.bss, image.image - image.data - image.bss, image.declared);
+    }
+
+    count = module_totals(modules, sizes, ARRAY_SIZE(modules));
+    for (int i = 0; i < count; i++) {
+        LOG_INF("Static %-14s %6zu B", modules[i], sizes[i]);
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * Private Helper Functions
+ * -------------------------------------------------------------------------*/
+
+static void stack_walk(const struct k_thread *pThread, void *pUserData) {
+
+    struct MemReport_StackWalk_t *pWalk = pUserData;
+    struct MemReport_Stack_t *pStack;
+    const char *pName;
+    size_t unused = 0;
+
+    if (pWalk->count >= pWalk->maxCount) {
+        return;
+    }
+
+    if (0 != k_thread_stack_space_get(pThread, &unused)) {
+        return;
+    }
+
+    pName = k_thread_name_get((k_tid_t)pThread);
+
+    pStack = &pWalk->pStacks[pWalk->count++];
+    pStack->name = (NULL != pName && '\0' != pName[0]) ? pName : "-";
+    pStack->size = pThread->stack_info.size;
+    pStack->used = pThread->stack_info.size - unused;
+}
+
+/**
+ * @brief Group the MEM_REPORT_STATIC() table by module, in table order
+ * @return number of modules
+ */
+static int module_totals(const char **ppModules, size_t *pSizes, int maxCount) {
+
+    int count = 0;
+
+    STRUCT_SECTION_FOREACH(MemReport_Static_t, pEntry) {
+        int i;
+
+        for (i = 0; i < count; i++) {
+            if (0 == strcmp(ppModules[i], pEntry->module)) {
+                break;
+            }
+        }
+
+        if (i == count) {
+            if (count >= maxCount) {
+                continue;
+            }
+            ppModules[count] = pEntry->module;
+            pSizes[count] = 0;
+            count++;
+        }
+
+        pSizes[i] += pEntry->size;
+    }
+
+    return count;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_mem_stacks(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct MemReport_Stack_t stacks[MEM_REPORT_MAX_STACKS];
+    int count = memReport_getStacks(stacks, ARRAY_SIZE(stacks));
+
+    (void)(argc);
+    (void)(argv);
+
+    shell_print(pShell, "%-14s %6s %6s %6s %4s", "stack", "size", "used", "free", "use");
+    for (int i = 0; i < count; i++) {
+        shell_print(pShell, "%-14s %6zu %6zu %6zu %3u%%", stacks[i].name, stacks[i].size, stacks[i].used,
+                    stacks[i].size - stacks[i].used,
+                    (unsigned int)((stacks[i].used * 100U) / MAX(stacks[i].size, 1)));
+    }
+
+    return 0;
+}
+
+static int cmd_mem_heap(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct MemReport_Heap_t heap;
+
+    (void)(argc);
+    (void)(argv);
+
+    if (0 != memReport_getHeap(&heap)) {
+        shell_print(pShell, "No system heap");
+        return 0;
+    }
+
+    shell_print(pShell, "Heap %zu B: used %zu, peak %zu, free %zu", heap.size, heap.used, heap.peak,
+                heap.size - heap.used);
+
+    return 0;
+}
+
+static int cmd_mem_static(const struct shell *pShell, size_t argc, char **argv) {
+
+    struct MemReport_Image_t image;
+
+    (void)(argc);
+    (void)(argv);
+
+    memReport_getImage(&image);
+    if (0 != image.image) {
+        shell_print(pShell, "Image %zu of %zu B RAM: data %zu, bss %zu, noinit %zu", image.image, image.ram_size,
+                    image.data, image.bss, image.image - image.data - image.bss);
+    }
+
+    STRUCT_SECTION_FOREACH(MemReport_Static_t, pEntry) {
+        shell_print(pShell, "%-14s %-20s %6zu", pEntry->module, pEntry->symbol, pEntry->size);
+    }
+
+    shell_print(pShell, "%-35s %6zu", "declared", image.declared);
+    if (0 != image.image) {
+        shell_print(pShell, "%-35s %6zu", "rest of the image", image.image - image.declared);
+    }
+
+    return 0;
+}
+
+static int cmd_mem_show(const struct shell *pShell, size_t argc, char **argv) {
+
+    cmd_mem_stacks(pShell, argc, argv);
+    cmd_mem_heap(pShell, argc, argv);
+    cmd_mem_static(pShell, argc, argv);
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_mem,
+    SHELL_CMD(stacks, NULL, "Stack size and high-water mark of every thread", cmd_mem_stacks),
+    SHELL_CMD(heap, NULL, "System heap use and peak", cmd_mem_heap),
+    SHELL_CMD(static, NULL, "Static RAM declared by each module", cmd_mem_static),
+    SHELL_SUBCMD_SET_END
+);
+SHELL_CMD_REGISTER(mem, &sub_mem, "Stack, heap and static RAM report", cmd_mem_show);
+#endif
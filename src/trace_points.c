@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           trace_points.c
+ * @brief          Binary trace ring implementation
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Writers claim a slot with one atomic increment and never wait, so trace
+ * points are safe from the input threads and from USB callback context. The
+ * dump pauses recording while it prints, a record written concurrently with
+ * the pause may come out torn. With CONFIG_SHELL `trace` dumps the ring and
+ * `trace clear` empties it.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "trace_points.h"
+#include "mem_report.h"
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#if (CONFIG_GHOSTHIDE_TRACE_DEPTH & (CONFIG_GHOSTHIDE_TRACE_DEPTH - 1)) != 0
+#error "CONFIG_GHOSTHIDE_TRACE_DEPTH must be a power of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static struct TracePoints_Record_t gRing[CONFIG_GHOSTHIDE_TRACE_DEPTH];
+MEM_REPORT_STATIC(trace_points, gRing);
+static atomic_t gHead;
+static atomic_t gIsPaused;
+static const void *gPortCtx[TRACE_POINTS_PORT_COUNT];
+
+/**
+ * @brief Append a record, overwriting the oldest once the ring is full
+ * @param event event ID, see TracePoints_Event_e
+ * @param port CH37x port or interface
+ * @param arg0 first event argument
+ * @param arg1 second event argument
+ * @return None
+ * @note Use TRACE_POINT(), it compiles away without CONFIG_GHOSTHIDE_TRACE.
+ */
+void tracePoints_record(uint16_t event, uint8_t port, int32_t arg0, int32_t arg1) {
+
+    struct TracePoints_Record_t *pRec;
+
+    if (0 != atomic_get(&gIsPaused)) {
+        return;
+    }
+
+    pRec = &gRing[(uint32_t)atomic_inc(&gHead) & (CONFIG_GHOSTHIDE_TRACE_DEPTH - 1)];
+    pRec->cyc = k_cycle_get_32();
+    pRec->event = event;
+    pRec->port = port;
+    pRec->reserved = 0;
+    pRec->arg0 = arg0;
+    pRec->arg1 = arg1;
+}
+
+/**
+ * @brief Tell which port a CH37x context serves, for trace points in the drivers
+ * @param pCtx CH37x context
+ * @param port port index
+ * @return None
+ */
+void tracePoints_bindPort(const void *pCtx, uint8_t port) {
+
+    if (port >= TRACE_POINTS_PORT_COUNT) {
+        return;
+    }
+
+    gPortCtx[port] = pCtx;
+}
+
+/**
+ * @brief Look up the port a CH37x context was bound to
+ * @param pCtx CH37x context
+ * @return port index, TRACE_POINTS_PORT_NONE if unbound
+ */
+uint8_t tracePoints_portOf(const void *pCtx) {
+
+    for (uint8_t i = 0; i < TRACE_POINTS_PORT_COUNT; i++) {
+        if (pCtx == gPortCtx[i]) {
+            return i;
+        }
+    }
+
+    return TRACE_POINTS_PORT_NONE;
+}
+
+/**
+ * @brief Drop every record
+ * @return None
+ */
+void tracePoints_clear(void) {
+
+    atomic_set(&gIsPaused, 1);
+    memset(gRing, 0x00, sizeof(gRing));
+    atomic_clear(&gHead);
+    atomic_clear(&gIsPaused);
+}
+
+/**
+ * @brief Print the ring oldest first, one hex encoded record per line
+ * @return None
+ * @note Feed the console output to scripts/trace_decode.py.
+ */
+void tracePoints_dump(void) {
+
+    uint32_t head;
+    uint32_t count;
+
+    atomic_set(&gIsPaused, 1);
+    head = (uint32_t)atomic_get(&gHead);
+    count = MIN(head, CONFIG_GHOSTHIDE_TRACE_DEPTH);
+
+    printk("TRACE BEGIN v1 hz=%u depth=%u records=%u lost=%u\n", sys_clock_hw_cycles_per_sec(),
+                            CONFIG_GHOSTHIDE_TRACE_DEPTH, count, head - count);
+
+    for (uint32_t i = head - count; i != head; i++) {
+        const uint8_t *pRaw = (const uint8_t *)&gRing[i & (CONFIG_GHOSTHIDE_TRACE_DEPTH - 1)];
+
+        printk("TRACE ");
+        for (size_t b = 0; b < sizeof(struct TracePoints_Record_t); b++) {
+            printk("%02x", pRaw[b]);
+        }
+        printk("\n");
+    }
+
+    printk("TRACE END\n");
+    atomic_clear(&gIsPaused);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_trace_dump(const struct shell *pShell, size_t argc, char **argv) {
+
+    (void)(pShell);
+    (void)(argc);
+    (void)(argv);
+
+    tracePoints_dump();
+
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *pShell, size_t argc, char **argv) {
+
+    (void)(argc);
+    (void)(argv);
+
+    tracePoints_clear();
+    shell_print(pShell, "Trace ring cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_trace,
+    SHELL_CMD(clear, NULL, "Drop every record", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END
+);
+SHELL_CMD_REGISTER(trace, &sub_trace, "Dump the trace ring for scripts/trace_decode.py", cmd_trace_dump);
+#endif
@@ -28,6 +28,12 @@
  *
  * Migration to USBD would require architectural
  * changes incompatible with the dynamic device proxy model.
+ *
+ * CONFIG_GHOSTHIDE_USBD builds an optional USBD backend next to it. It registers
+ * only the HID instances the enumerated inputs need, submits with the asynchronous
+ * hid_device_submit_report() and tears the stack down with usbd_shutdown() so the
+ * next usbd_init() after a reconnect starts clean. The HID instances come from the
+ * ghosthide-usbd snippet. Everything above the backend helpers is shared.
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -38,31 +44,143 @@
  */
 
 #include "usb_hid_proxy.h"
+#include "latency_stats.h"
+#include "trace_points.h"
+#include "mem_report.h"
+#include "boot_timeline.h"
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
 
 LOG_MODULE_REGISTER(usb_hid_proxy, LOG_LEVEL_INF);
 
+/* Private defines -----------------------------------------------------------*/
+#define MOUSE_DESC_BUTTON_MAX_IDX       11      // Usage Maximum (Button n) value
+#define MOUSE_DESC_BUTTON_COUNT_IDX     17      // Report Count (n) value
+#define MOUSE_DESC_BUTTONS_END          22      // After the buttons Input item
+#define MOUSE_DESC_PADDING_LEN          6
+#define REPORT_TYPE_INPUT               0x01    // wValue high byte of GET/SET_REPORT
+
+#if defined(CONFIG_GHOSTHIDE_USBD)
+#define USBD_MAX_POWER                  50      // 100 mA, the legacy stack default
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
+static int backend_init(const struct USBHID_ProxyLayout_t *pLayout);
+static int backend_write(uint8_t ifaceNum, const uint8_t *pReport, size_t len);
+static void backend_cleanup(void);
+static void on_in_ready(uint8_t ifaceNum);
+static size_t build_mouse_report_desc(uint8_t buttonCount, uint8_t *pDesc);
+#if defined(CONFIG_GHOSTHIDE_USBD)
+static int usbd_ifaceOf(const struct device *pDev);
+static void usbd_iface_ready(const struct device *pDev, const bool isReady);
+static int usbd_get_report(const struct device *pDev, const uint8_t type, const uint8_t id,
+                                                const uint16_t len, uint8_t *const pBuf);
+static int usbd_set_report(const struct device *pDev, const uint8_t type, const uint8_t id,
+                                                const uint16_t len, const uint8_t *const pBuf);
+static void usbd_set_protocol(const struct device *pDev, const uint8_t proto);
+static void usbd_input_report_done(const struct device *pDev, const uint8_t *const pReport);
+static void usbd_sof(const struct device *pDev);
+static void usbd_msg_cb(struct usbd_context *const pCtx, const struct usbd_msg *const pMsg);
+#else
 static void mouse_int_in_ready(const struct device *pDev);
 static void kbd_int_in_ready(const struct device *pDev);
+static void kbd_protocol_change(const struct device *pDev, uint8_t protocol);
+static int kbd_set_report(const struct device *pDev, struct usb_setup_packet *pSetup,
+                                                        int32_t *pLen, uint8_t **ppData);
+#endif
+static int send_report(uint8_t ifaceNum, const uint8_t *pReport, size_t len, uint32_t captureCyc);
+static void reset_endpoints(void);
+static int queue_out_report(uint8_t ifaceNum, uint8_t type, uint8_t id, const uint8_t *pData, size_t len);
+static void reset_out_queue(void);
+#if !defined(CONFIG_GHOSTHIDE_USBD)
 void usb_status_cb(enum usb_dc_status_code status, const uint8_t *pParam);
+#endif
+
+/* Private types -------------------------------------------------------------*/
+/**
+ * @brief Host to device reports waiting for the forwarding loop
+ * @note One entry per interface/type/ID, a newer report replaces the queued one.
+ */
+struct ProxyOutQueue_t {
+    struct k_spinlock lock;
+    struct USBHID_ProxyOutReport_t entries[USBHID_PROXY_OUT_QUEUE_DEPTH];
+    uint8_t head;
+    uint8_t count;
+    uint32_t drops;
+};
+
+/**
+ * @brief Send counters of one interface, bumped from any context
+ */
+struct ProxySendCounters_t {
+    atomic_t sent;
+    atomic_t busy;
+    atomic_t failed;
+    atomic_t not_ready;
+    atomic_t coalesced;
+    atomic_t dropped;
+};
 
 /* Private variables ---------------------------------------------------------*/
-static const struct device *pHidDevMouse = NULL;
-static const struct device *pHidDevKbd = NULL;
-static K_SEM_DEFINE(mouseSem, 1, 1);
-static K_SEM_DEFINE(kbdSem, 1, 1);
-static volatile enum usb_dc_status_code gUsbStatus = USB_DC_UNKNOWN;
+static const struct device *gHidDev[USBHID_PROXY_IFACE_COUNT] = {NULL, NULL};
+static atomic_t gIsBusy[USBHID_PROXY_IFACE_COUNT];
 static volatile bool isUsbConfigured = false;
+static volatile uint8_t gKbdProtocol = HID_PROTOCOL_REPORT;
+static usbhid_proxyReadyCb_t gReadyCb[USBHID_PROXY_IFACE_COUNT] = {NULL, NULL};
+static struct ProxySendCounters_t gSendStats[USBHID_PROXY_IFACE_COUNT];
+static uint32_t gInflightCyc[USBHID_PROXY_IFACE_COUNT];
+static usbhid_proxySofCb_t gSofCb = NULL;
+static struct ProxyOutQueue_t gOutQueue;
+MEM_REPORT_STATIC(usb_hid_proxy, gOutQueue);
+
+#if defined(CONFIG_GHOSTHIDE_USBD)
+USBD_DEVICE_DEFINE(gUsbdCtx, DEVICE_DT_GET(DT_NODELABEL(zephyr_udc0)),
+                    CONFIG_GHOSTHIDE_USBD_VID, CONFIG_GHOSTHIDE_USBD_PID);
+USBD_DESC_LANG_DEFINE(gUsbdLang);
+USBD_DESC_MANUFACTURER_DEFINE(gUsbdMfr, CONFIG_GHOSTHIDE_USBD_MANUFACTURER);
+USBD_DESC_PRODUCT_DEFINE(gUsbdProduct, CONFIG_GHOSTHIDE_USBD_PRODUCT);
+USBD_DESC_CONFIG_DEFINE(gUsbdCfgDesc, "HID Configuration");
+USBD_CONFIGURATION_DEFINE(gUsbdConfig, USB_SCD_REMOTE_WAKEUP, USBD_MAX_POWER, &gUsbdCfgDesc);
+
+static const struct device *const gUsbdHidDev[USBHID_PROXY_IFACE_COUNT] = {
+    DEVICE_DT_GET(DT_NODELABEL(ghosthide_mouse)),
+    DEVICE_DT_GET(DT_NODELABEL(ghosthide_kbd)),
+};
+
+// USBD names HID classes after the devicetree instance, the snippet overlay keeps mouse first
+static const char *const gUsbdClassName[USBHID_PROXY_IFACE_COUNT] = {"hid_0", "hid_1"};
+
+// The stack reads from the buffer until input_report_done
+static uint8_t gUsbdInflight[USBHID_PROXY_IFACE_COUNT][USBHID_PROXY_REPORT_MAX];
+static size_t gUsbdInflightLen[USBHID_PROXY_IFACE_COUNT];
+MEM_REPORT_STATIC(usb_hid_proxy, gUsbdInflight);
+static bool gUsbdIsRegistered[USBHID_PROXY_IFACE_COUNT];
+static atomic_t gUsbdReadyMask;
+
+static const struct hid_device_ops gUsbdHidOps = {
+    .iface_ready = usbd_iface_ready,
+    .get_report = usbd_get_report,
+    .set_report = usbd_set_report,
+    .set_protocol = usbd_set_protocol,
+    .input_report_done = usbd_input_report_done,
+    .sof = usbd_sof,
+};
+#else
+static volatile enum usb_dc_status_code gUsbStatus = USB_DC_UNKNOWN;
 static const struct hid_ops mouseOps = {
     .int_in_ready = mouse_int_in_ready,
 };
 
 static const struct hid_ops kbdOps = {
     .int_in_ready = kbd_int_in_ready,
+    .set_report = kbd_set_report,
+    .protocol_change = kbd_protocol_change,
 };
+#endif
 
 /**
  * @brief Generic HID Mouse Report Descriptor
+ * @note Template for the runtime descriptor, see build_mouse_report_desc().
  */
 static const uint8_t hidMouseReportDesc[] = {
     0x05, 0x01,        // Usage Page (Generic Desktop)
@@ -97,6 +215,13 @@ static const uint8_t hidMouseReportDesc[] = {
     0xC0               // End Collection
 };
 
+/**
+ * @brief NKRO HID Keyboard Report Descriptor
+ * @note The first 8 bytes are the boot keyboard report, so a BIOS that never
+ *       parses this descriptor still reads modifiers + 6 keys. Usages 0x00..0x7F
+ *       follow as a bitmap, the key array only carries usages above that.
+ *       The 1 byte LED output report matches the boot keyboard one.
+ */
 static const uint8_t hidKbdReportDesc[] = {
     0x05, 0x01,        // Usage Page (Generic Desktop)
     0x09, 0x06,        // Usage (Keyboard)
@@ -115,17 +240,34 @@ static const uint8_t hidKbdReportDesc[] = {
     0x95, 0x06,        //   Report Count (6)
     0x75, 0x08,        //   Report Size (8)
     0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x65,        //   Logical Maximum (101)
+    0x26, 0xE7, 0x00,  //   Logical Maximum (231)
     0x05, 0x07,        //   Usage Page (Key Codes)
     0x19, 0x00,        //   Usage Minimum (0)
-    0x29, 0x65,        //   Usage Maximum (101)
+    0x29, 0xE7,        //   Usage Maximum (231)
     0x81, 0x00,        //   Input (Data, Array)
+    0x05, 0x07,        //   Usage Page (Key Codes)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0x7F,        //   Usage Maximum (127)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x80,        //   Report Count (128)
+    0x81, 0x02,        //   Input (Data, Variable, Absolute)
+    0x05, 0x08,        //   Usage Page (LEDs)
+    0x19, 0x01,        //   Usage Minimum (Num Lock)
+    0x29, 0x05,        //   Usage Maximum (Kana)
+    0x95, 0x05,        //   Report Count (5)
+    0x91, 0x02,        //   Output (Data, Variable, Absolute)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x03,        //   Report Size (3)
+    0x91, 0x01,        //   Output (Constant)
     0xC0               // End Collection
 };
 
-/**
- * @brief Generic HID Keyboard Report Descriptor
- */
+static uint8_t gMouseReportDesc[sizeof(hidMouseReportDesc) + MOUSE_DESC_PADDING_LEN];
+static size_t gMouseReportDescLen;
+MEM_REPORT_STATIC(usb_hid_proxy, gMouseReportDesc);
+
 
 /* --------------------------------------------------------------------------
  * Public API
@@ -133,53 +275,38 @@ static const uint8_t hidKbdReportDesc[] = {
 
 /**
   * @brief Initialize USB HID devices
+  * @param pLayout interfaces to expose, NULL for mouse (8 buttons) + keyboard
   * @retval 0 on success, error code otherwise
   */
-int usbhid_proxyInit(void) {
+int usbhid_proxyInit(const struct USBHID_ProxyLayout_t *pLayout) {
     
     int ret = -1;
+    struct USBHID_ProxyLayout_t layout = {
+        .has_mouse = true,
+        .has_keyboard = true,
+        .mouse_buttons = 8,
+    };
 
-    // Reset first
-    isUsbConfigured = false;
-    gUsbStatus = USB_DC_UNKNOWN;
-
-
-    // Get bindings for both devices
-    pHidDevMouse = device_get_binding("HID_0");
-    if (NULL == pHidDevMouse) {
-        LOG_ERR("HID_0 device not found");
-        return -ENODEV;
+    if (NULL != pLayout) {
+        layout = *pLayout;
     }
 
-    pHidDevKbd = device_get_binding("HID_1");
-    if (NULL == pHidDevKbd) {
-        LOG_ERR("HID_1 device not found");
-        return -ENODEV;
+    if (true != layout.has_mouse && true != layout.has_keyboard) {
+        return -EINVAL;
     }
 
-    // Register descriptors
-    usb_hid_register_device(pHidDevMouse, hidMouseReportDesc, sizeof(hidMouseReportDesc), &mouseOps);
-    LOG_INF("Mouse descriptor registered (HID_0)");
-    usb_hid_register_device(pHidDevKbd, hidKbdReportDesc, sizeof(hidKbdReportDesc), &kbdOps);
-    LOG_INF("Keyboard descriptor registered (HID_1)");
-
-    // Initialize each HID device
-    ret = usb_hid_init(pHidDevMouse);
-    if (0 != ret) {
-        LOG_ERR("Failed to initialize HID device: %d", ret);
-        return -ENODEV;
-    }
+    // Reset first
+    isUsbConfigured = false;
+    memset(gSendStats, 0x00, sizeof(gSendStats));
+    latencyStats_reset();
+    reset_endpoints();
+    reset_out_queue();
+    gKbdProtocol = HID_PROTOCOL_REPORT;
 
-    ret = usb_hid_init(pHidDevKbd);
-    if (0 != ret) {
-        LOG_ERR("Failed to initialize HID device: %d", ret);
-        return -ENODEV;
-    }
+    gMouseReportDescLen = build_mouse_report_desc(layout.mouse_buttons, gMouseReportDesc);
 
-    // Enable USB
-    ret = usb_enable(usb_status_cb);
+    ret = backend_init(&layout);
     if (0 != ret) {
-        LOG_ERR("Failed to enable USB: %d", ret);
         return ret;
     }
 
@@ -198,118 +325,742 @@ bool usbhid_proxyIsReady(void)
 }
 
 /**
- * @brief Send report ot endpoint
+ * @brief Check whether the host switched the keyboard to boot protocol
+ * @return true if only the 8 byte boot report may be sent
+ */
+bool usbhid_proxyKbdIsBootProtocol(void)
+{
+    return (HID_PROTOCOL_BOOT == gKbdProtocol);
+}
+
+/**
+ * @brief Send report to endpoint without waiting for it
  * @param ifaceNum interface number
- * @param pReport pointer to the report descriptor
- * @param len size of the report descriptor
+ * @param pReport pointer to the report
+ * @param len size of the report
+ * @param captureCyc k_cycle_get_32() when the oldest data in the report arrived from the CH37x
+ * @return 0 on success, -EBUSY if the previous report is still in flight,
+ * error code otherwise
+ * @note Safe to call from the ready callback.
+ */
+int usbhid_proxyTrySendReport(uint8_t ifaceNum, uint8_t *pReport, size_t len, uint32_t captureCyc) {
+
+    return send_report(ifaceNum, pReport, len, captureCyc);
+}
+
+/**
+ * @brief Register a function called each time an interface's IN endpoint is free again
+ * @param ifaceNum interface number
+ * @param cb callback, NULL to remove
+ * @return None
+ * @note Runs in USB callback context, it must not block.
+ */
+void usbhid_proxySetReadyCallback(uint8_t ifaceNum, usbhid_proxyReadyCb_t cb) {
+
+    if (ifaceNum < USBHID_PROXY_IFACE_COUNT) {
+        gReadyCb[ifaceNum] = cb;
+    }
+}
+
+/**
+ * @brief Register a function called on every USB start of frame
+ * @param cb callback, NULL to remove
+ * @return None
+ * @note Needs CONFIG_USB_DEVICE_SOF. Runs in USB interrupt context once per ms.
+ */
+void usbhid_proxySetSofCallback(usbhid_proxySofCb_t cb) {
+
+    gSofCb = cb;
+}
+
+/**
+ * @brief Copy the send counters of an interface
+ * @param ifaceNum interface number
+ * @param pStats pointer to the counters to fill
+ * @return None
+ * @note Sample it periodically and divide the deltas by the elapsed time to get rates.
+ */
+void usbhid_proxyGetSendStats(uint8_t ifaceNum, struct USBHID_ProxySendStats_t *pStats) {
+
+    const struct ProxySendCounters_t *pCnt;
+
+    if (NULL == pStats || ifaceNum >= USBHID_PROXY_IFACE_COUNT) {
+        return;
+    }
+
+    pCnt = &gSendStats[ifaceNum];
+    pStats->sent = (uint32_t)atomic_get(&pCnt->sent);
+    pStats->busy = (uint32_t)atomic_get(&pCnt->busy);
+    pStats->failed = (uint32_t)atomic_get(&pCnt->failed);
+    pStats->not_ready = (uint32_t)atomic_get(&pCnt->not_ready);
+    pStats->coalesced = (uint32_t)atomic_get(&pCnt->coalesced);
+    pStats->dropped = (uint32_t)atomic_get(&pCnt->dropped);
+}
+
+/**
+ * @brief Count a report merged into one still waiting for the host
+ * @param ifaceNum interface number
+ * @return None
+ * @note Safe from any context.
+ */
+void usbhid_proxyCountCoalesced(uint8_t ifaceNum) {
+
+    if (ifaceNum < USBHID_PROXY_IFACE_COUNT) {
+        atomic_inc(&gSendStats[ifaceNum].coalesced);
+    }
+}
+
+/**
+ * @brief Count a report that found the output queue full
+ * @param ifaceNum interface number
+ * @return None
+ * @note Safe from any context.
+ */
+void usbhid_proxyCountDropped(uint8_t ifaceNum) {
+
+    if (ifaceNum < USBHID_PROXY_IFACE_COUNT) {
+        atomic_inc(&gSendStats[ifaceNum].dropped);
+    }
+}
+
+/**
+ * @brief Take the oldest queued host to device report of an interface
+ * @param ifaceNum interface whose report to take
+ * @param pOut where to copy the report
+ * @return 0 if one was taken, -EAGAIN if none is queued
+ * @note Every port takes its own interface's reports, the rest keep their order.
+ */
+int usbhid_proxyTakeOutReport(uint8_t ifaceNum, struct USBHID_ProxyOutReport_t *pOut) {
+
+    k_spinlock_key_t key;
+    int ret = -EAGAIN;
+
+    if (NULL == pOut) {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&gOutQueue.lock);
+    for (uint8_t i = 0; i < gOutQueue.count; i++) {
+        uint8_t idx = (gOutQueue.head + i) % USBHID_PROXY_OUT_QUEUE_DEPTH;
+
+        if (gOutQueue.entries[idx].iface != ifaceNum) {
+            continue;
+        }
+
+        *pOut = gOutQueue.entries[idx];
+
+        // Close the gap towards the head, entries before it move up by one
+        for (uint8_t j = i; j > 0; j--) {
+            gOutQueue.entries[(gOutQueue.head + j) % USBHID_PROXY_OUT_QUEUE_DEPTH] =
+                        gOutQueue.entries[(gOutQueue.head + j - 1) % USBHID_PROXY_OUT_QUEUE_DEPTH];
+        }
+        gOutQueue.head = (gOutQueue.head + 1) % USBHID_PROXY_OUT_QUEUE_DEPTH;
+        gOutQueue.count--;
+        ret = 0;
+        break;
+    }
+    k_spin_unlock(&gOutQueue.lock, key);
+
+    return ret;
+}
+
+/**
+ * @brief Put a report back at the head of the queue, e.g. after the device NAKed it
+ * @param pOut report returned by usbhid_proxyTakeOutReport()
+ * @note Dropped if the host has sent a newer report for the same slot meanwhile.
+ */
+void usbhid_proxyRequeueOutReport(const struct USBHID_ProxyOutReport_t *pOut) {
+
+    k_spinlock_key_t key;
+    uint8_t idx;
+
+    if (NULL == pOut) {
+        return;
+    }
+
+    key = k_spin_lock(&gOutQueue.lock);
+    for (uint8_t i = 0; i < gOutQueue.count; i++) {
+        const struct USBHID_ProxyOutReport_t *pEntry =
+                        &gOutQueue.entries[(gOutQueue.head + i) % USBHID_PROXY_OUT_QUEUE_DEPTH];
+
+        if (pEntry->iface == pOut->iface && pEntry->type == pOut->type && pEntry->id == pOut->id) {
+            k_spin_unlock(&gOutQueue.lock, key);
+            return;
+        }
+    }
+
+    if (USBHID_PROXY_OUT_QUEUE_DEPTH == gOutQueue.count) {
+        gOutQueue.drops++;
+    } else {
+        idx = (gOutQueue.head + USBHID_PROXY_OUT_QUEUE_DEPTH - 1) % USBHID_PROXY_OUT_QUEUE_DEPTH;
+        gOutQueue.entries[idx] = *pOut;
+        gOutQueue.head = idx;
+        gOutQueue.count++;
+    }
+    k_spin_unlock(&gOutQueue.lock, key);
+}
+
+/**
+ * @brief Host to device reports dropped because the queue was full
+ * @return drop count since init
+ */
+uint32_t usbhid_proxyGetOutReportDrops(void) {
+
+    return gOutQueue.drops;
+}
+
+/**
+ * @brief Send report ot endpoint
  * @return 0 on success, error code otherwise
  */
-int usbhid_proxySendReport(uint8_t ifaceNum, uint8_t *pReport, size_t len) {
+void usbhid_proxyCleanup(void) {
+    
+    backend_cleanup();
+    isUsbConfigured = false;
+    gKbdProtocol = HID_PROTOCOL_REPORT;
+    gHidDev[0] = NULL;
+    gHidDev[1] = NULL;
+    
+    reset_endpoints();
+    reset_out_queue();
+}
+
+/* --------------------------------------------------------------------------
+ * HELPER FUNCTIONS
+ * -------------------------------------------------------------------------*/
+static void on_in_ready(uint8_t ifaceNum) {
+
+    latencyStats_record(ifaceNum, LATENCY_STAGE_HOST, gInflightCyc[ifaceNum]);
+    atomic_clear(&gIsBusy[ifaceNum]);
+    TRACE_POINT(TRACE_EVT_EP_READY, ifaceNum, 0, 0);
+
+    if (NULL != gReadyCb[ifaceNum]) {
+        gReadyCb[ifaceNum](ifaceNum);
+    }
+}
+
+static size_t build_mouse_report_desc(uint8_t buttonCount, uint8_t *pDesc) {
+
+    size_t len = MOUSE_DESC_BUTTONS_END;
+
+    buttonCount = CLAMP(buttonCount, 1, 8);
+    memcpy(pDesc, hidMouseReportDesc, MOUSE_DESC_BUTTONS_END);
+    pDesc[MOUSE_DESC_BUTTON_MAX_IDX] = buttonCount;
+    pDesc[MOUSE_DESC_BUTTON_COUNT_IDX] = buttonCount;
+
+    // Pad the button byte, the report layout stays the same
+    if (buttonCount < 8) {
+        pDesc[len++] = 0x95;                // Report Count (8 - n)
+        pDesc[len++] = 8 - buttonCount;
+        pDesc[len++] = 0x75;                // Report Size (1 bit)
+        pDesc[len++] = 0x01;
+        pDesc[len++] = 0x81;                // Input (Constant)
+        pDesc[len++] = 0x01;
+    }
+
+    memcpy(&pDesc[len], &hidMouseReportDesc[MOUSE_DESC_BUTTONS_END],
+                                sizeof(hidMouseReportDesc) - MOUSE_DESC_BUTTONS_END);
+
+    return len + sizeof(hidMouseReportDesc) - MOUSE_DESC_BUTTONS_END;
+}
+
+static int send_report(uint8_t ifaceNum, const uint8_t *pReport, size_t len, uint32_t captureCyc) {
     
     int ret = -1;
-    static uint32_t sendCount[2] = {0,0};
     const struct device *pDev;
-    struct k_sem *semaphore;
 
-    if (NULL == pReport || 0 == len) {
+    if (NULL == pReport || 0 == len || ifaceNum >= USBHID_PROXY_IFACE_COUNT) {
         return -EINVAL;
     }
     
     if (true != isUsbConfigured) {
-        static uint32_t not_ready_count = 0;
-        if (++not_ready_count % 100 == 0) {
-            LOG_WRN("USB not configured (%" PRIu32 " times)", not_ready_count);
-        }
+        atomic_inc(&gSendStats[ifaceNum].not_ready);
         return -EAGAIN;
     }
-    
-    if (0 == ifaceNum) {
-        pDev = pHidDevMouse;
-        semaphore = &mouseSem;
-    }
-    else if (1 == ifaceNum) {
-        pDev = pHidDevKbd;
-        semaphore = &kbdSem;
-    } else {
-        return -EINVAL;
-    }
 
+    pDev = gHidDev[ifaceNum];
     if (NULL == pDev) {
         return -ENODEV;
     }
     
-    sendCount[ifaceNum]++;
-    
-    // Wait for EP to be ready
-    if (0 != k_sem_take(semaphore, K_MSEC(100))) {
-        static uint32_t busyCount[2] = {0, 0};
-        if (++busyCount[ifaceNum] % 50 == 0) {
-            LOG_WRN("Interface %d: Semaphore busy (%" PRIu32 " times)", ifaceNum, busyCount[ifaceNum]);
-        }
+    // Claim the EP, int_in_ready releases it
+    if (true != atomic_cas(&gIsBusy[ifaceNum], 0, 1)) {
+        atomic_inc(&gSendStats[ifaceNum].busy);
         return -EBUSY;
     }
+    gInflightCyc[ifaceNum] = captureCyc;
     
     // Write report
-    ret = hid_int_ep_write(pDev, pReport, len, NULL);
+    ret = backend_write(ifaceNum, pReport, len);
+    TRACE_POINT(TRACE_EVT_SUBMIT, ifaceNum, len, ret);
     
     if (0 != ret) {
-        // Give semaphore back on failure
-        k_sem_give(semaphore);
-        
-        static uint32_t writeFailCount[2] = {0, 0};
-        if (++writeFailCount[ifaceNum] % 50 == 0) {
-            LOG_ERR("Interface %d: Write failed %" PRIu32 " times (last ret=%d)", ifaceNum, writeFailCount[ifaceNum], ret);
-        }
-        
+        // Release the EP on failure
+        atomic_clear(&gIsBusy[ifaceNum]);
+        atomic_inc(&gSendStats[ifaceNum].failed);
         return ret;
     }
     
-    // Sample successful sends
-    if (sendCount[ifaceNum] % 100 == 0) {
-        LOG_DBG("Interface %d: Send #%" PRIu32 " successful", ifaceNum, sendCount[ifaceNum]);
-    }
+    atomic_inc(&gSendStats[ifaceNum].sent);
+    latencyStats_record(ifaceNum, LATENCY_STAGE_SUBMIT, captureCyc);
+    bootTimeline_mark(BOOT_PHASE_FIRST_REPORT);
     
     return 0;
 }
 
-/**
- * @brief Send report ot endpoint
- * @return 0 on success, error code otherwise
- */
-void usbhid_proxyCleanup(void) {
-    
-    usb_disable();
-    isUsbConfigured = false;
-    pHidDevMouse = NULL;
-    pHidDevKbd = NULL;
-    
-    // Reset semaphore
-    k_sem_reset(&mouseSem);
-    k_sem_give(&mouseSem);
-    k_sem_reset(&kbdSem);
-    k_sem_give(&kbdSem);
+static void reset_endpoints(void) {
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        atomic_clear(&gIsBusy[i]);
+    }
+}
+
+static int queue_out_report(uint8_t ifaceNum, uint8_t type, uint8_t id, const uint8_t *pData, size_t len) {
+
+    k_spinlock_key_t key;
+    struct USBHID_ProxyOutReport_t *pEntry = NULL;
+
+    if (NULL == pData || 0 == len || len > USBHID_PROXY_OUT_REPORT_MAX) {
+        return -EINVAL;
+    }
+
+    key = k_spin_lock(&gOutQueue.lock);
+
+    // Reports carry state, the newest one for a slot is all the device needs
+    for (uint8_t i = 0; i < gOutQueue.count; i++) {
+        struct USBHID_ProxyOutReport_t *pQueued =
+                        &gOutQueue.entries[(gOutQueue.head + i) % USBHID_PROXY_OUT_QUEUE_DEPTH];
+
+        if (pQueued->iface == ifaceNum && pQueued->type == type && pQueued->id == id) {
+            pEntry = pQueued;
+            break;
+        }
+    }
+
+    if (NULL == pEntry) {
+        if (USBHID_PROXY_OUT_QUEUE_DEPTH == gOutQueue.count) {
+            gOutQueue.drops++;
+            k_spin_unlock(&gOutQueue.lock, key);
+            return -ENOMEM;
+        }
+        pEntry = &gOutQueue.entries[(gOutQueue.head + gOutQueue.count) % USBHID_PROXY_OUT_QUEUE_DEPTH];
+        gOutQueue.count++;
+    }
+
+    pEntry->iface = ifaceNum;
+    pEntry->type = type;
+    pEntry->id = id;
+    pEntry->len = len;
+    memcpy(pEntry->data, pData, len);
+
+    k_spin_unlock(&gOutQueue.lock, key);
+
+    return 0;
+}
+
+static void reset_out_queue(void) {
+
+    k_spinlock_key_t key = k_spin_lock(&gOutQueue.lock);
+
+    gOutQueue.head = 0;
+    gOutQueue.count = 0;
+    gOutQueue.drops = 0;
+
+    k_spin_unlock(&gOutQueue.lock, key);
 }
 
 /* --------------------------------------------------------------------------
- * HELPER FUNCTIONS
+ * BACKEND: USBD (device_next)
+ * -------------------------------------------------------------------------*/
+#if defined(CONFIG_GHOSTHIDE_USBD)
+static int backend_init(const struct USBHID_ProxyLayout_t *pLayout) {
+
+    int ret = -1;
+    bool isWanted[USBHID_PROXY_IFACE_COUNT] = {pLayout->has_mouse, pLayout->has_keyboard};
+    const uint8_t *pDesc[USBHID_PROXY_IFACE_COUNT] = {gMouseReportDesc, hidKbdReportDesc};
+    uint16_t descLen[USBHID_PROXY_IFACE_COUNT] = {gMouseReportDescLen, sizeof(hidKbdReportDesc)};
+    struct usbd_desc_node *const pStrings[] = {&gUsbdLang, &gUsbdMfr, &gUsbdProduct};
+
+    atomic_clear(&gUsbdReadyMask);
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (true != isWanted[i]) {
+            continue;
+        }
+
+        if (true != device_is_ready(gUsbdHidDev[i])) {
+            LOG_ERR("HID device %s not ready", gUsbdHidDev[i]->name);
+            return -ENODEV;
+        }
+
+        ret = hid_device_register(gUsbdHidDev[i], pDesc[i], descLen[i], &gUsbdHidOps);
+        if (0 != ret) {
+            LOG_ERR("Failed to register HID descriptor %d: %d", i, ret);
+            return -ENODEV;
+        }
+        gHidDev[i] = gUsbdHidDev[i];
+    }
+
+    // Descriptors and configuration survive usbd_shutdown(), only add them once
+    for (size_t i = 0; i < ARRAY_SIZE(pStrings); i++) {
+        ret = usbd_add_descriptor(&gUsbdCtx, pStrings[i]);
+        if (0 != ret && -EALREADY != ret) {
+            LOG_ERR("Failed to add string descriptor: %d", ret);
+            return ret;
+        }
+    }
+
+    ret = usbd_add_configuration(&gUsbdCtx, USBD_SPEED_FS, &gUsbdConfig);
+    if (0 != ret && -EALREADY != ret) {
+        LOG_ERR("Failed to add configuration: %d", ret);
+        return ret;
+    }
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (true != isWanted[i]) {
+            continue;
+        }
+
+        ret = usbd_register_class(&gUsbdCtx, gUsbdClassName[i], USBD_SPEED_FS, 1);
+        if (0 != ret && -EALREADY != ret) {
+            LOG_ERR("Failed to register %s: %d", gUsbdClassName[i], ret);
+            return ret;
+        }
+        gUsbdIsRegistered[i] = true;
+    }
+
+    // Class codes live in the interface descriptors
+    usbd_device_set_code_triple(&gUsbdCtx, USBD_SPEED_FS, 0, 0, 0);
+
+    ret = usbd_msg_register_cb(&gUsbdCtx, usbd_msg_cb);
+    if (0 != ret && -EALREADY != ret) {
+        LOG_ERR("Failed to register message callback: %d", ret);
+        return ret;
+    }
+
+    ret = usbd_init(&gUsbdCtx);
+    if (0 != ret) {
+        LOG_ERR("Failed to initialize USBD: %d", ret);
+        return ret;
+    }
+
+    // With VBUS detection the message callback enables the device
+    if (true != usbd_can_detect_vbus(&gUsbdCtx)) {
+        ret = usbd_enable(&gUsbdCtx);
+        if (0 != ret) {
+            LOG_ERR("Failed to enable USB: %d", ret);
+            return ret;
+        }
+    }
+
+    LOG_INF("USBD: %s%s%s", pLayout->has_mouse ? "mouse" : "",
+                (pLayout->has_mouse && pLayout->has_keyboard) ? " + " : "",
+                pLayout->has_keyboard ? "keyboard" : "");
+
+    return 0;
+}
+
+static int backend_write(uint8_t ifaceNum, const uint8_t *pReport, size_t len) {
+
+    if (len > sizeof(gUsbdInflight[0])) {
+        return -EINVAL;
+    }
+
+    // The endpoint is claimed, nothing else touches this buffer until it completes
+    memcpy(gUsbdInflight[ifaceNum], pReport, len);
+    gUsbdInflightLen[ifaceNum] = len;
+
+    return hid_device_submit_report(gHidDev[ifaceNum], len, gUsbdInflight[ifaceNum]);
+}
+
+static void backend_cleanup(void) {
+
+    int ret = -1;
+
+    ret = usbd_disable(&gUsbdCtx);
+    if (0 != ret && -EALREADY != ret) {
+        LOG_WRN("Failed to disable USBD: %d", ret);
+    }
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (true != gUsbdIsRegistered[i]) {
+            continue;
+        }
+
+        ret = usbd_unregister_class(&gUsbdCtx, gUsbdClassName[i], USBD_SPEED_FS, 1);
+        if (0 != ret) {
+            LOG_WRN("Failed to unregister %s: %d", gUsbdClassName[i], ret);
+        }
+        gUsbdIsRegistered[i] = false;
+    }
+
+    ret = usbd_shutdown(&gUsbdCtx);
+    if (0 != ret) {
+        LOG_WRN("Failed to shut down USBD: %d", ret);
+    }
+
+    atomic_clear(&gUsbdReadyMask);
+}
+
+static int usbd_ifaceOf(const struct device *pDev) {
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (pDev == gUsbdHidDev[i]) {
+            return i;
+        }
+    }
+
+    return -ENODEV;
+}
+
+static void usbd_iface_ready(const struct device *pDev, const bool isReady) {
+
+    int iface = usbd_ifaceOf(pDev);
+    atomic_val_t registered = 0;
+
+    if (iface < 0) {
+        return;
+    }
+
+    if (true == isReady) {
+        atomic_set_bit(&gUsbdReadyMask, iface);
+        if (1 == iface) {
+            gKbdProtocol = HID_PROTOCOL_REPORT;
+        }
+    } else {
+        // An interface that went away never completes its report
+        atomic_clear_bit(&gUsbdReadyMask, iface);
+        atomic_clear(&gIsBusy[iface]);
+    }
+
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (true == gUsbdIsRegistered[i]) {
+            registered |= BIT(i);
+        }
+    }
+
+    isUsbConfigured = (0 != registered && registered == atomic_get(&gUsbdReadyMask));
+    LOG_INF("Interface %d %s", iface, isReady ? "ready" : "not ready");
+}
+
+static int usbd_get_report(const struct device *pDev, const uint8_t type, const uint8_t id,
+                                                const uint16_t len, uint8_t *const pBuf) {
+
+    int iface = usbd_ifaceOf(pDev);
+    size_t reportLen;
+
+    (void)(id);
+
+    if (iface < 0 || REPORT_TYPE_INPUT != type) {
+        return -ENOTSUP;
+    }
+
+    // Last report the host was given, all zero before the first one
+    reportLen = (0 != gUsbdInflightLen[iface]) ? gUsbdInflightLen[iface] :
+                    ((0 == iface) ? USBHID_PROXY_MOUSE_REPORT_SIZE : USBHID_PROXY_KBD_REPORT_SIZE);
+    reportLen = MIN(reportLen, len);
+    memcpy(pBuf, gUsbdInflight[iface], reportLen);
+
+    return reportLen;
+}
+
+static int usbd_set_report(const struct device *pDev, const uint8_t type, const uint8_t id,
+                                                const uint16_t len, const uint8_t *const pBuf) {
+
+    int iface = usbd_ifaceOf(pDev);
+
+    if (iface < 0 || REPORT_TYPE_INPUT == type) {
+        return -ENOTSUP;
+    }
+
+    // Never touch the CH37x from here, the forwarding loop sends it between polls
+    return queue_out_report(iface, type, id, pBuf, len);
+}
+
+static void usbd_set_protocol(const struct device *pDev, const uint8_t proto) {
+
+    if (1 != usbd_ifaceOf(pDev)) {
+        return;
+    }
+
+    gKbdProtocol = proto;
+    LOG_INF("Keyboard switched to %s protocol", (HID_PROTOCOL_BOOT == proto) ? "boot" : "report");
+}
+
+static void usbd_input_report_done(const struct device *pDev, const uint8_t *const pReport) {
+
+    int iface = usbd_ifaceOf(pDev);
+
+    (void)(pReport);
+
+    if (iface >= 0) {
+        on_in_ready(iface);
+    }
+}
+
+static void usbd_sof(const struct device *pDev) {
+
+    // Every HID instance sees the frame, pass it on once
+    for (int i = 0; i < USBHID_PROXY_IFACE_COUNT; i++) {
+        if (true != gUsbdIsRegistered[i]) {
+            continue;
+        }
+
+        if (pDev == gUsbdHidDev[i] && NULL != gSofCb) {
+            gSofCb();
+        }
+        break;
+    }
+}
+
+static void usbd_msg_cb(struct usbd_context *const pCtx, const struct usbd_msg *const pMsg) {
+
+    LOG_INF("USBD message: %s", usbd_msg_type_string(pMsg->type));
+
+    switch (pMsg->type) {
+        case USBD_MSG_VBUS_READY: {
+            if (0 != usbd_enable(pCtx)) {
+                LOG_ERR("Failed to enable USB on VBUS");
+            }
+            break;
+        }
+
+        case USBD_MSG_VBUS_REMOVED: {
+            (void)usbd_disable(pCtx);
+            break;
+        }
+
+        case USBD_MSG_RESET: {
+            // Hosts expect report protocol after a bus reset
+            gKbdProtocol = HID_PROTOCOL_REPORT;
+            break;
+        }
+
+        default: {
+            break;
+        }
+    }
+}
+
+#else
+/* --------------------------------------------------------------------------
+ * BACKEND: legacy usb_device
  * -------------------------------------------------------------------------*/
+static int backend_init(const struct USBHID_ProxyLayout_t *pLayout) {
+
+    int ret = -1;
+
+    // Both HID instances always exist here (CONFIG_USB_HID_DEVICE_COUNT)
+    (void)(pLayout);
+    gUsbStatus = USB_DC_UNKNOWN;
+
+    // Get bindings for both devices
+    gHidDev[0] = device_get_binding("HID_0");
+    if (NULL == gHidDev[0]) {
+        LOG_ERR("HID_0 device not found");
+        return -ENODEV;
+    }
+
+    gHidDev[1] = device_get_binding("HID_1");
+    if (NULL == gHidDev[1]) {
+        LOG_ERR("HID_1 device not found");
+        return -ENODEV;
+    }
+
+    // Register descriptors
+    usb_hid_register_device(gHidDev[0], gMouseReportDesc, gMouseReportDescLen, &mouseOps);
+    LOG_INF("Mouse descriptor registered (HID_0)");
+    usb_hid_register_device(gHidDev[1], hidKbdReportDesc, sizeof(hidKbdReportDesc), &kbdOps);
+    LOG_INF("Keyboard descriptor registered (HID_1)");
+
+#if defined(CONFIG_USB_HID_BOOT_PROTOCOL)
+    // Boot interface so the BIOS can switch it to the 8 byte report
+    ret = usb_hid_set_proto_code(gHidDev[1], HID_BOOT_IFACE_CODE_KEYBOARD);
+    if (0 != ret) {
+        LOG_WRN("Failed to set keyboard boot protocol code: %d", ret);
+    }
+#endif
+
+    // Initialize each HID device
+    ret = usb_hid_init(gHidDev[0]);
+    if (0 != ret) {
+        LOG_ERR("Failed to initialize HID device: %d", ret);
+        return -ENODEV;
+    }
+
+    ret = usb_hid_init(gHidDev[1]);
+    if (0 != ret) {
+        LOG_ERR("Failed to initialize HID device: %d", ret);
+        return -ENODEV;
+    }
+
+    // Enable USB
+    ret = usb_enable(usb_status_cb);
+    if (0 != ret) {
+        LOG_ERR("Failed to enable USB: %d", ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int backend_write(uint8_t ifaceNum, const uint8_t *pReport, size_t len) {
+
+    return hid_int_ep_write(gHidDev[ifaceNum], pReport, len, NULL);
+}
+
+static void backend_cleanup(void) {
+
+    usb_disable();
+}
+
 static void mouse_int_in_ready(const struct device *pDev) {
     
     (void)(pDev);
-    k_sem_give(&mouseSem);
-    LOG_DBG("Mouse endpoint ready");
+    on_in_ready(0);
 }
 
 static void kbd_int_in_ready(const struct device *pDev) {
     
     (void)(pDev);
-    k_sem_give(&kbdSem);
-    LOG_DBG("Keyboard endpoint ready");
+    on_in_ready(1);
+}
+
+static void kbd_protocol_change(const struct device *pDev, uint8_t protocol) {
+
+    (void)(pDev);
+    gKbdProtocol = protocol;
+    LOG_INF("Keyboard switched to %s protocol", (HID_PROTOCOL_BOOT == protocol) ? "boot" : "report");
+}
+
+static int kbd_set_report(const struct device *pDev, struct usb_setup_packet *pSetup,
+                                                        int32_t *pLen, uint8_t **ppData) {
+
+    uint8_t type = pSetup->wValue >> 8;
+    uint8_t id = pSetup->wValue & 0xFF;
+
+    (void)(pDev);
+
+    if (REPORT_TYPE_INPUT == type) {
+        return -ENOTSUP;
+    }
+
+    // Never touch the CH37x from here, the forwarding loop sends it between polls
+    return queue_out_report(1, type, id, *ppData, *pLen);
 }
 
 void usb_status_cb(enum usb_dc_status_code status, const uint8_t *pParam) {
     
     (void)(pParam);
+
+    // Once per frame, keep it off the log
+    if (USB_DC_SOF == status) {
+        if (NULL != gSofCb) {
+            gSofCb();
+        }
+        return;
+    }
+
     gUsbStatus = status;
     
     LOG_INF("USB Status Change: 0x%02X", status);
@@ -324,6 +1075,8 @@ void usb_status_cb(enum usb_dc_status_code status, const uint8_t *pParam) {
         case USB_DC_RESET: {
             LOG_INF("USB_DC_RESET - device being reset");
             isUsbConfigured = false;
+            // Hosts expect report protocol after a bus reset
+            gKbdProtocol = HID_PROTOCOL_REPORT;
             break;
         }
             
@@ -370,15 +1123,11 @@ void usb_status_cb(enum usb_dc_status_code status, const uint8_t *pParam) {
             break;
         }
             
-        case USB_DC_SOF: {
-            // LOG_DBG("USB_DC_SOF");
-            break;
-        }
-            
         case USB_DC_UNKNOWN:
         default: {
             LOG_WRN("USB_DC_UNKNOWN: 0x%02X", status);
             break;
         }
     }
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ * Benchmark baseline, generated by:
+ *   scripts/bench_extract.py --baseline tests/benchmark/src/bench_baseline.h handler.log
+ * Regenerate it on the machine that runs the benchmark when a change is
+ * meant to move a number, and commit it together with that change.
+ */
+
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+#include "bench_corpus.h"
+
+static const struct bench_Baseline_t gBenchBaseline[] = {
+    //  device                   parse_ns decode_ns encode_ns uart_bytes uart_cmds enum_us
+    {"hid_boot_mouse",        {519, 23, 23, 1700, 600, 158003}},
+    {"hid_boot_keyboard",     {599, 118, 394, 2200, 600, 165151}},
+    {"raspberry_pi_mouse",    {508, 28, 26, 1800, 600, 158182}},
+    {"zowie_fk2",             {658, 30, 30, 1800, 500, 155590}},
+    {"razer_viper_ultimate",  {733, 31, 30, 2000, 500, 157989}},
+    {"logitech_g305",         {1252, 30, 31, 2100, 500, 167987}},
+};
+
+static const struct bench_ParseBaseline_t gBenchParseBaseline[] = {
+    //  descriptor                            parse_ns
+    {"config/hid_boot_keyboard",              61},
+    {"config/hid_boot_mouse",                 60},
+    {"config/logitech_g305",                  61},
+    {"config/raspberry_pi_mouse",             61},
+    {"config/razer_viper_ultimate",           65},
+    {"config/sample_keyboard",                88},
+    {"config/sample_mouse",                   64},
+    {"config/zowie_fk2",                      64},
+    {"report/hid_boot_keyboard",              398},
+    {"report/hid_boot_mouse",                 451},
+    {"report/logitech_g305",                  1123},
+    {"report/raspberry_pi_mouse",             466},
+    {"report/razer_viper_ultimate",           665},
+    {"report/zowie_fk2",                      565},
+    {"regress/cfg_endpoint_first",            539},
+    {"regress/cfg_five_endpoints",            624},
+    {"regress/cfg_five_interfaces",           1342},
+    {"regress/cfg_hid_past_end",              345},
+    {"regress/cfg_short_hid",                 372},
+    {"regress/cfg_short_interface",           405},
+    {"regress/cfg_zero_length",               543},
+    {"regress/cfg_zero_report_length",        438},
+    {"regress/rep_seventeen_usages",          706},
+    {"regress/rep_size_count_overflow",       240},
+    {"regress/rep_truncated_item",            527},
+    {"regress/rep_unbalanced_collections",    727},
+};
+
+#endif /* BENCH_BASELINE_H */
@@ -0,0 +1,332 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           bench_corpus.c
+ * @brief          Device corpus the benchmark runs over
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Report descriptors as captured from the devices (the same ones the HID
+ * mouse unit tests use) plus the boot mouse and boot keyboard of the HID
+ * 1.11 specification. Speeds, packet sizes and intervals follow what the
+ * devices report. Appending a device is fine, renaming one orphans its
+ * baseline.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "bench_corpus.h"
+
+/**
+ * @brief HID 1.11 Appendix B.2 boot mouse - 3 buttons, 8-bit X/Y
+ */
+static const uint8_t HID_BOOT_MOUSE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x05,        //     Report Size (5)
+    0x81, 0x01,        //     Input (Const,Array,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief HID 1.11 Appendix B.1 boot keyboard - modifiers, LEDs, 6 keys
+ */
+static const uint8_t HID_BOOT_KEYBOARD[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop)
+    0x09, 0x06,        // Usage (Keyboard)
+    0xA1, 0x01,        // Collection (Application)
+    0x05, 0x07,        //   Usage Page (Keyboard)
+    0x19, 0xE0,        //   Usage Minimum (Left Control)
+    0x29, 0xE7,        //   Usage Maximum (Right GUI)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x08,        //   Report Count (8)
+    0x81, 0x02,        //   Input (Data, Var, Abs)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x08,        //   Report Size (8)
+    0x81, 0x01,        //   Input (Const)
+    0x95, 0x05,        //   Report Count (5)
+    0x75, 0x01,        //   Report Size (1)
+    0x05, 0x08,        //   Usage Page (LEDs)
+    0x19, 0x01,        //   Usage Minimum (Num Lock)
+    0x29, 0x05,        //   Usage Maximum (Kana)
+    0x91, 0x02,        //   Output (Data, Var, Abs)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x03,        //   Report Size (3)
+    0x91, 0x01,        //   Output (Const)
+    0x95, 0x06,        //   Report Count (6)
+    0x75, 0x08,        //   Report Size (8)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x65,        //   Logical Maximum (101)
+    0x05, 0x07,        //   Usage Page (Keyboard)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0x65,        //   Usage Maximum (101)
+    0x81, 0x00,        //   Input (Data, Array)
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Raspberry Pi Mouse - 3 buttons, 8-bit X/Y/Wheel
+ */
+static const uint8_t RASPBERRY_PI[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x75, 0x01,        //     Report Size (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x75, 0x05,        //     Report Size (5)
+    0x95, 0x01,        //     Report Count (1)
+    0x81, 0x01,        //     Input (Const,Array,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief ZOWIE FK2 - 6 buttons, 16-bit X/Y, wheel
+ */
+static const uint8_t ZOWIE_FK2[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x06,        //     Usage Maximum (0x06)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x06,        //     Report Count (6)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x02,        //     Report Count (2)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x01,        //     Input (Const,Array,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xA1, 0x00,        //   Collection (Physical)
+    0x95, 0x01,        //     Report Count (1)
+    0x75, 0x08,        //     Report Size (8)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Razer Viper Ultimate - 5 buttons, 16-bit X/Y, wheel, 90 byte feature report
+ */
+static const uint8_t RAZER_VIPER_ULTIMATE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x05,        //     Usage Maximum (0x05)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x75, 0x01,        //     Report Size (1)
+    0x95, 0x05,        //     Report Count (5)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x75, 0x01,        //     Report Size (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x03,        //     Input (Const,Var,Abs)
+    0x06, 0x00, 0xFF,  //     Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x40,        //     Usage (0x40)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x02,        //     Report Count (2)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x16, 0x00, 0x80,  //     Logical Minimum (-32768)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0x06, 0x00, 0xFF,  //   Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x02,        //   Usage (0x02)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x5A,        //   Report Count (90)
+    0xB1, 0x01,        //   Feature (Const,Array,Abs)
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Logitech G305 - 16 buttons, 16-bit X/Y, wheel, pan, Report IDs 2/3/4/8
+ */
+static const uint8_t LOGITECH_G305[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x02,        //   Report ID (2)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x10,        //     Usage Maximum (0x10)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x10,        //     Report Count (16)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x05, 0x0C,        //     Usage Page (Consumer)
+    0x0A, 0x38, 0x02,  //     Usage (AC Pan)
+    0x95, 0x01,        //     Report Count (1)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+    0x05, 0x0C,        // Usage Page (Consumer)
+    0x09, 0x01,        // Usage (Consumer Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x03,        //   Report ID (3)
+    0x75, 0x10,        //   Report Size (16)
+    0x95, 0x02,        //   Report Count (2)
+    0x15, 0x01,        //   Logical Minimum (1)
+    0x26, 0xFF, 0x02,  //   Logical Maximum (767)
+    0x19, 0x01,        //   Usage Minimum (Consumer Control)
+    0x2A, 0xFF, 0x02,  //   Usage Maximum (0x02FF)
+    0x81, 0x00,        //   Input (Data,Array,Abs)
+    0xC0,              // End Collection
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x80,        // Usage (Sys Control)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x04,        //   Report ID (4)
+    0x75, 0x02,        //   Report Size (2)
+    0x95, 0x01,        //   Report Count (1)
+    0x15, 0x01,        //   Logical Minimum (1)
+    0x25, 0x03,        //   Logical Maximum (3)
+    0x09, 0x82,        //   Usage (Sys Sleep)
+    0x09, 0x81,        //   Usage (Sys Power Down)
+    0x09, 0x83,        //   Usage (Sys Wake Up)
+    0x81, 0x60,        //   Input (Data,Array,Abs)
+    0x75, 0x06,        //   Report Size (6)
+    0x81, 0x03,        //   Input (Const,Var,Abs)
+    0xC0,              // End Collection
+    0x06, 0xBC, 0xFF,  // Usage Page (Vendor Defined 0xFFBC)
+    0x09, 0x88,        // Usage (0x88)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x08,        //   Report ID (8)
+    0x19, 0x01,        //   Usage Minimum (0x01)
+    0x29, 0xFF,        //   Usage Maximum (0xFF)
+    0x15, 0x01,        //   Logical Minimum (1)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, 0x01,        //   Report Count (1)
+    0x81, 0x00,        //   Input (Data,Array,Abs)
+    0xC0,              // End Collection
+};
+
+#define BENCH_DEVICE(_name, _pid, _ls, _ep0, _proto, _mps, _interval, _desc, _len, _id) \
+    {                                                                               \
+        .name = (_name),                                                            \
+        .profile = {                                                                \
+            .pid = (_pid),                                                          \
+            .is_low_speed = (_ls),                                                  \
+            .ep0_max_packet = (_ep0),                                               \
+            .protocol = (_proto),                                                   \
+            .ep_max_packet = (_mps),                                                \
+            .interval = (_interval),                                                \
+            .pReportDesc = (_desc),                                                 \
+            .report_desc_len = sizeof(_desc),                                       \
+            .report_len = (_len),                                                   \
+            .report_id = (_id),                                                     \
+        },                                                                          \
+    }
+
+const struct bench_Device_t gBenchCorpus[] = {
+    //           name                    PID     LS     EP0  proto MPS  ms  descriptor            len  ID
+    BENCH_DEVICE("hid_boot_mouse",       0x0003, true,  8,   2,    8,   10, HID_BOOT_MOUSE,       3,   0),
+    BENCH_DEVICE("hid_boot_keyboard",    0x0004, true,  8,   1,    8,   10, HID_BOOT_KEYBOARD,    8,   0),
+    BENCH_DEVICE("raspberry_pi_mouse",   0x0005, true,  8,   2,    8,   10, RASPBERRY_PI,         4,   0),
+    BENCH_DEVICE("zowie_fk2",            0x0006, false, 64,  2,    8,   1,  ZOWIE_FK2,            6,   0),
+    BENCH_DEVICE("razer_viper_ultimate", 0x0007, false, 64,  2,    8,   1,  RAZER_VIPER_ULTIMATE, 8,   0),
+    BENCH_DEVICE("logitech_g305",        0x0008, false, 32,  2,    16,  1,  LOGITECH_G305,        9,   2),
+};
+
+const size_t gBenchCorpusCount = ARRAY_SIZE(gBenchCorpus);
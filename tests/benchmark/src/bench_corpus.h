@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           bench_corpus.h
+ * @brief          Device corpus the benchmark runs over
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Each entry is the report descriptor of a real device (or of the HID
+ * specification's boot devices) with the bus parameters it enumerates with.
+ * The simulator builds the device and configuration descriptors around it.
+ * Results are keyed by the device name, in the run and in the baseline.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include "ch37x_sim_hid.h"
+
+/* Macros -------------------------------------------------------------------*/
+// Host CPU time only fails the run with CONFIG_GHOSTHIDE_BENCH_CPU_GATE
+#if defined(CONFIG_GHOSTHIDE_BENCH_CPU_GATE)
+#define BENCH_CPU_TOLERANCE_PCT     CONFIG_GHOSTHIDE_BENCH_CPU_TOLERANCE_PCT
+#else
+#define BENCH_CPU_TOLERANCE_PCT     0
+#endif
+
+/**
+ * @brief One corpus device
+ */
+struct bench_Device_t {
+    const char *name;                   // Key into the baseline, keep it stable
+    struct CH37xSimHid_Profile_t profile;
+};
+
+/**
+ * @brief Metrics of one device, lower is better for all of them
+ */
+struct bench_Result_t {
+    uint32_t parse_ns;                  // Report descriptor compile
+    uint32_t decode_ns;                 // Whole report decode
+    uint32_t encode_ns;                 // Whole report encode
+    uint32_t uart_bytes;                // UART bytes per report, x100
+    uint32_t uart_cmds;                 // CH375 commands per report, x100
+    uint32_t enum_us;                   // Simulated hostInit to HID open
+};
+
+/**
+ * @brief Checked-in reference of one device
+ */
+struct bench_Baseline_t {
+    const char *name;
+    struct bench_Result_t result;
+};
+
+/**
+ * @brief Checked-in parse time of one tests/corpus file
+ */
+struct bench_ParseBaseline_t {
+    const char *name;                   // "<directory>/<file>", as in gCorpus[]
+    uint32_t ns;
+};
+
+extern const struct bench_Device_t gBenchCorpus[];
+extern const size_t gBenchCorpusCount;
+
+#endif /* BENCH_CORPUS_H */
@@ -0,0 +1,380 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           bench_main.c
+ * @brief          Parser, codec, UART and enumeration benchmark
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Every corpus device is attached behind the CH375 model and measured:
+ *   - parse_ns     report descriptor compile, host CPU time
+ *   - decode_ns    whole report decode, host CPU time
+ *   - encode_ns    whole report encode, host CPU time
+ *   - uart_bytes   UART bytes per forwarded report, hundredths
+ *   - uart_cmds    CH375 commands per forwarded report, hundredths
+ *   - enum_us      hostInit to HID device open, simulated time
+ *
+ * CPU times are the best of several rounds, measured with the host's
+ * process clock since native_sim time stands still while code runs. The
+ * other three are deterministic. Results are printed as BENCH_JSON and
+ * BENCH_CSV lines (scripts/bench_extract.py turns a console log into files)
+ * and compared with bench_baseline.h: a simulated metric above its baseline
+ * by more than the configured tolerance fails the run. CPU times are only
+ * reported ("info") unless CONFIG_GHOSTHIDE_BENCH_CPU_GATE is set.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#if defined(CONFIG_EXTERNAL_LIBC)
+#include <time.h>
+#endif
+#include "ch375_host.h"
+#include "hid_parser.h"
+#include "hid_mouse.h"
+#include "hid_keyboard.h"
+#include "ch37x_sim.h"
+#include "ch37x_sim_hid.h"
+#include "bench_corpus.h"
+#include "bench_baseline.h"
+
+#define BENCH_ROUNDS            15
+#define BENCH_PARSE_LOOPS       500
+#define BENCH_CODEC_LOOPS       20000
+#define BENCH_REPORTS           100
+#define BENCH_FETCH_TRIES       4
+
+/**
+ * @brief What a metric is compared against
+ */
+struct bench_Metric_t {
+    const char *name;
+    size_t offset;
+    bool is_cpu;                // Host CPU time, noisy
+};
+
+static const struct bench_Metric_t gMetrics[] = {
+    {"parse_ns",    offsetof(struct bench_Result_t, parse_ns),    true},
+    {"decode_ns",   offsetof(struct bench_Result_t, decode_ns),   true},
+    {"encode_ns",   offsetof(struct bench_Result_t, encode_ns),   true},
+    {"uart_bytes",  offsetof(struct bench_Result_t, uart_bytes),  false},
+    {"uart_cmds",   offsetof(struct bench_Result_t, uart_cmds),   false},
+    {"enum_us",     offsetof(struct bench_Result_t, enum_us),     false},
+};
+
+static struct CH37xSim_Chip_t gChip;
+static struct CH37xSimHid_Device_t gSimHid;
+static struct ch375_Context_t *pCtx;
+static struct USB_Device_t gUdev;
+static struct USBHID_Device_t gHidDev;
+static struct HID_Mouse_t gMouse;
+static struct HID_Keyboard_t gKbd;
+static bool gIsKeyboard;
+static struct HID_ReportLayout_t gLayout;
+static volatile uint32_t gSink;
+
+static int sim_writeCmd(struct ch375_Context_t *pCtx, uint8_t cmd)
+{
+    ch37xSim_writeCmd(ch375_getPriv(pCtx), cmd);
+    return CH375_SUCCESS;
+}
+
+static int sim_writeData(struct ch375_Context_t *pCtx, uint8_t data)
+{
+    ch37xSim_writeData(ch375_getPriv(pCtx), data);
+    return CH375_SUCCESS;
+}
+
+static int sim_readData(struct ch375_Context_t *pCtx, uint8_t *pData)
+{
+    return (0 == ch37xSim_readData(ch375_getPriv(pCtx), pData)) ? CH375_SUCCESS : CH375_TIMEOUT;
+}
+
+static int sim_queryInt(struct ch375_Context_t *pCtx)
+{
+    return ch37xSim_queryInt(ch375_getPriv(pCtx));
+}
+
+/**
+ * @brief CPU time in ns
+ */
+static uint64_t cpu_ns(void)
+{
+#if defined(CONFIG_EXTERNAL_LIBC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + ts.tv_nsec;
+#else
+    return k_cyc_to_ns_floor64(k_cycle_get_64());
+#endif
+}
+
+static uint32_t link_cmds(const struct ch37x_LinkStats_t *pStats)
+{
+    uint32_t total = 0;
+
+    for (int i = 0; i < CH37X_STATS_CMD_COUNT; i++) {
+        total += pStats->cmds[i];
+    }
+    return total;
+}
+
+/* ========================================================================
+ * Measurements
+ * ======================================================================== */
+
+static uint32_t measure_parse(const struct bench_Device_t *pDevice)
+{
+    const struct CH37xSimHid_Profile_t *pProfile = &pDevice->profile;
+    uint64_t best = UINT64_MAX;
+
+    zassert_equal(HID_compileReportLayout(pProfile->pReportDesc, pProfile->report_desc_len, &gLayout), 0,
+                  "%s: report descriptor rejected", pDevice->name);
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t startNs = cpu_ns();
+
+        for (int i = 0; i < BENCH_PARSE_LOOPS; i++) {
+            HID_compileReportLayout(pProfile->pReportDesc, pProfile->report_desc_len, &gLayout);
+            gSink += gLayout.report_map[0];
+        }
+        best = MIN(best, cpu_ns() - startNs);
+    }
+
+    return (uint32_t)(best / BENCH_PARSE_LOOPS);
+}
+
+/**
+ * @brief Decode then encode the same report, best round of each
+ */
+static void measure_codec(const struct bench_Device_t *pDevice, struct bench_Result_t *pResult)
+{
+    struct HID_MouseState_t mouseState;
+    struct HID_KeyboardState_t kbdState;
+    uint8_t report[CH37X_SIM_HID_REPORT_MAX];
+    uint64_t bestDecode = UINT64_MAX;
+    uint64_t bestEncode = UINT64_MAX;
+
+    // Something in every field, Report ID first
+    memset(report, 0x5A, sizeof(report));
+    report[0] = (0 != pDevice->profile.report_id) ? pDevice->profile.report_id : 0x5A;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t startNs = cpu_ns();
+
+        for (int i = 0; i < BENCH_CODEC_LOOPS; i++) {
+            if (gIsKeyboard) {
+                hidKeyboard_Decode(&gKbd, report, &kbdState);
+            } else {
+                hidMouse_Decode(&gMouse, report, &mouseState);
+            }
+            gSink += report[i & 0x07];
+        }
+        bestDecode = MIN(bestDecode, cpu_ns() - startNs);
+
+        startNs = cpu_ns();
+        for (int i = 0; i < BENCH_CODEC_LOOPS; i++) {
+            if (gIsKeyboard) {
+                hidKeyboard_Encode(&gKbd, &kbdState, report);
+            } else {
+                hidMouse_Encode(&gMouse, &mouseState, report);
+            }
+            gSink += report[i & 0x07];
+        }
+        bestEncode = MIN(bestEncode, cpu_ns() - startNs);
+    }
+
+    pResult->decode_ns = (uint32_t)(bestDecode / BENCH_CODEC_LOOPS);
+    pResult->encode_ns = (uint32_t)(bestEncode / BENCH_CODEC_LOOPS);
+}
+
+/**
+ * @brief Poll once per bInterval, as the forwarding loop does, and count the
+ * link traffic of every report that makes it through
+ */
+static void measure_uart(const struct bench_Device_t *pDevice, struct bench_Result_t *pResult)
+{
+    struct ch37x_LinkStats_t before;
+    struct ch37x_LinkStats_t after;
+    uint32_t intervalUs = pDevice->profile.interval * 1000U;
+    int reports = 0;
+
+    ch375_getLinkStats(pCtx, &before);
+
+    for (int i = 0; i < BENCH_REPORTS; i++) {
+        k_busy_wait(intervalUs);
+
+        for (int tries = 0; tries < BENCH_FETCH_TRIES; tries++) {
+            int ret = gIsKeyboard ? hidKeyboard_FetchReport(&gKbd) : hidMouse_FetchReport(&gMouse);
+
+            if (USBHID_SUCCESS == ret) {
+                reports++;
+                break;
+            }
+        }
+    }
+
+    ch375_getLinkStats(pCtx, &after);
+    zassert_equal(reports, BENCH_REPORTS, "%s: only %d reports", pDevice->name, reports);
+
+    pResult->uart_bytes = (((after.tx_bytes - before.tx_bytes) + (after.rx_bytes - before.rx_bytes)) * 100U) /
+                          BENCH_REPORTS;
+    pResult->uart_cmds = ((link_cmds(&after) - link_cmds(&before)) * 100U) / BENCH_REPORTS;
+}
+
+/**
+ * @brief Attach the device, bring the host up as main.c does and time it
+ * up to the point the device could forward its first report
+ */
+static uint32_t enumerate(const struct bench_Device_t *pDevice)
+{
+    uint64_t startUs;
+
+    ch37xSim_init(&gChip, CH37X_SIM_CH375, CH375_DEFAULT_BAUDRATE);
+    zassert_equal(ch37xSimHid_initProfile(&gSimHid, &pDevice->profile), 0, "%s: bad profile", pDevice->name);
+    ch37xSim_attach(&gChip, &gSimHid.dev);
+    zassert_equal(ch375_openContext(&pCtx, sim_writeCmd, sim_writeData, sim_readData, sim_queryInt, &gChip),
+                  CH375_SUCCESS);
+
+    startUs = ch37xSim_nowUs();
+
+    zassert_equal(ch375_hostInit(pCtx, CH375_WORK_BAUDRATE), CH37X_HOST_SUCCESS);
+    ch37xSim_setLinkBaudrate(&gChip, CH375_WORK_BAUDRATE);
+    zassert_equal(ch375_hostWaitReady(pCtx, CH375_HOST_READY_TIMEOUT_MS), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostWaitDeviceConnect(pCtx, 10), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostUdevOpen(pCtx, &gUdev), CH37X_HOST_SUCCESS, "%s: enumeration", pDevice->name);
+    zassert_equal(USBHID_open(&gUdev, 0, &gHidDev), USBHID_SUCCESS, "%s: HID open", pDevice->name);
+    zassert_mem_equal(gHidDev.raw_hid_report_desc, pDevice->profile.pReportDesc, pDevice->profile.report_desc_len,
+                      "%s: report descriptor read back wrong", pDevice->name);
+
+    gIsKeyboard = (USBHID_TYPE_KEYBOARD == gHidDev.hid_type);
+    if (gIsKeyboard) {
+        zassert_equal(hidKeyboard_Open(&gHidDev, &gKbd), USBHID_SUCCESS, "%s: keyboard open", pDevice->name);
+    } else {
+        zassert_equal(hidMouse_Open(&gHidDev, &gMouse), USBHID_SUCCESS, "%s: mouse open", pDevice->name);
+    }
+
+    return (uint32_t)(ch37xSim_nowUs() - startUs);
+}
+
+/* ========================================================================
+ * Reporting
+ * ======================================================================== */
+
+static uint32_t metric_get(const struct bench_Result_t *pResult, const struct bench_Metric_t *pMetric)
+{
+    return *(const uint32_t *)((const uint8_t *)pResult + pMetric->offset);
+}
+
+static const struct bench_Result_t *find_baseline(const char *pName)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(gBenchBaseline); i++) {
+        if (0 == strcmp(gBenchBaseline[i].name, pName)) {
+            return &gBenchBaseline[i].result;
+        }
+    }
+    return NULL;
+}
+
+static void print_json(const char *pName, const struct bench_Result_t *pResult)
+{
+    printk("BENCH_JSON {\"device\":\"%s\",\"parse_ns\":%u,\"decode_ns\":%u,\"encode_ns\":%u,"
+           "\"uart_bytes_per_report\":%u.%02u,\"uart_cmds_per_report\":%u.%02u,\"enum_us\":%u}\n",
+           pName, pResult->parse_ns, pResult->decode_ns, pResult->encode_ns,
+           pResult->uart_bytes / 100U, pResult->uart_bytes % 100U,
+           pResult->uart_cmds / 100U, pResult->uart_cmds % 100U, pResult->enum_us);
+}
+
+/**
+ * @brief Print one CSV row per metric and count the regressions
+ * @note A baseline of 0 (or no baseline) is reported but never fails, nor
+ * does a CPU time without CONFIG_GHOSTHIDE_BENCH_CPU_GATE.
+ */
+static int check_baseline(const char *pName, const struct bench_Result_t *pResult)
+{
+    const struct bench_Result_t *pBase = find_baseline(pName);
+    int regressions = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(gMetrics); i++) {
+        const struct bench_Metric_t *pMetric = &gMetrics[i];
+        uint32_t value = metric_get(pResult, pMetric);
+        uint32_t base = (NULL != pBase) ? metric_get(pBase, pMetric) : 0;
+        uint32_t tolerance = pMetric->is_cpu ? BENCH_CPU_TOLERANCE_PCT :
+                                               CONFIG_GHOSTHIDE_BENCH_SIM_TOLERANCE_PCT;
+        uint64_t limit = ((uint64_t)base * (100U + tolerance)) / 100U;
+        const char *pStatus = "ok";
+
+        if (0 == base) {
+            pStatus = "new";
+        } else if (pMetric->is_cpu && !IS_ENABLED(CONFIG_GHOSTHIDE_BENCH_CPU_GATE)) {
+            pStatus = "info";
+        } else if (value > limit) {
+            pStatus = "regressed";
+            regressions++;
+        }
+
+        printk("BENCH_CSV %s,%s,%u,%u,%llu,%s\n", pName, pMetric->name, value, base,
+               (unsigned long long)limit, pStatus);
+    }
+
+    return regressions;
+}
+
+static void bench_teardown(void *f)
+{
+    if (gIsKeyboard) {
+        hidKeyboard_Close(&gKbd);
+    } else {
+        hidMouse_Close(&gMouse);
+    }
+    USBHID_close(&gHidDev);
+    ch375_hostUdevClose(&gUdev);
+
+    if (NULL != pCtx) {
+        ch375_closeContext(pCtx);
+        pCtx = NULL;
+    }
+
+    memset(&gUdev, 0x00, sizeof(gUdev));
+    memset(&gHidDev, 0x00, sizeof(gHidDev));
+}
+
+/* ========================================================================
+ * Test: Every corpus device stays within its baseline
+ * ======================================================================== */
+ZTEST(benchmark, test_corpus)
+{
+    int regressions = 0;
+
+    printk("BENCH_CSV device,metric,value,baseline,limit,status\n");
+
+    for (size_t i = 0; i < gBenchCorpusCount; i++) {
+        const struct bench_Device_t *pDevice = &gBenchCorpus[i];
+        struct bench_Result_t result = {0};
+
+        result.parse_ns = measure_parse(pDevice);
+        result.enum_us = enumerate(pDevice);
+        measure_codec(pDevice, &result);
+        measure_uart(pDevice, &result);
+        bench_teardown(NULL);
+
+        print_json(pDevice->name, &result);
+        regressions += check_baseline(pDevice->name, &result);
+    }
+
+    zassert_equal(regressions, 0, "%d metric(s) regressed past the baseline", regressions);
+}
+
+ZTEST_SUITE(benchmark, NULL, NULL, NULL, bench_teardown, NULL);
@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           bench_parse.c
+ * @brief          Descriptor parse throughput over tests/corpus
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Every corpus file is parsed the way enumeration parses it:
+ *   - config/   ch375_hostParseConfig() and the HID descriptor of each
+ *               interface, must succeed
+ *   - report/   HID_compileReportLayout(), must succeed
+ *   - regress/  both of the above, the result does not matter
+ * The time per descriptor is the best of several rounds of host CPU time,
+ * printed as a BENCH_PARSE line and checked against gBenchParseBaseline like
+ * the device CPU times, so only with CONFIG_GHOSTHIDE_BENCH_CPU_GATE. A BENCH_PARSE_SUMMARY line per directory gives the
+ * descriptors per second over the directory and its slowest descriptor.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#if defined(CONFIG_EXTERNAL_LIBC)
+#include <time.h>
+#endif
+#include "ch375_host.h"
+#include "hid_parser.h"
+#include "corpus.h"
+#include "bench_baseline.h"
+
+#define BENCH_ROUNDS            15
+#define BENCH_PARSE_LOOPS       500
+
+static const char *const gKindNames[] = {"config", "report", "regress"};
+
+/**
+ * @brief Totals of one corpus directory
+ */
+struct bench_ParseSummary_t {
+    uint64_t total_ns;
+    uint32_t count;
+    uint32_t worst_ns;
+    const char *pWorst;
+};
+
+static struct USB_Device_t gParseUdev;
+static struct HID_ReportLayout_t gParseLayout;
+static volatile uint32_t gParseSink;
+
+/**
+ * @brief CPU time in ns
+ */
+static uint64_t cpu_ns(void)
+{
+#if defined(CONFIG_EXTERNAL_LIBC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec * NSEC_PER_SEC) + ts.tv_nsec;
+#else
+    return k_cyc_to_ns_floor64(k_cycle_get_64());
+#endif
+}
+
+/**
+ * @brief Parse a configuration descriptor and look up every interface's HID descriptor
+ * @return number of HID descriptors found, negative if the parse failed
+ */
+static int parse_config(const struct corpus_Entry_t *pEntry)
+{
+    int found = 0;
+
+    gParseUdev.raw_conf_desc = (uint8_t *)pEntry->pData;
+    gParseUdev.raw_conf_desc_len = pEntry->len;
+
+    if (CH37X_HOST_SUCCESS != ch375_hostParseConfig(&gParseUdev)) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < gParseUdev.interface_count; i++) {
+        struct USB_HID_Descriptor_t *pHidDesc;
+
+        if (0 == USBHID_getHidDescriptor(&gParseUdev, gParseUdev.interfaces[i].interface_number, &pHidDesc)) {
+            found++;
+        }
+    }
+
+    return found;
+}
+
+static int parse_report(const struct corpus_Entry_t *pEntry)
+{
+    return HID_compileReportLayout(pEntry->pData, (uint16_t)MIN(pEntry->len, UINT16_MAX), &gParseLayout);
+}
+
+static void parse_entry(const struct corpus_Entry_t *pEntry)
+{
+    if (CORPUS_REPORT != pEntry->kind) {
+        gParseSink += (uint32_t)parse_config(pEntry);
+    }
+    if (CORPUS_CONFIG != pEntry->kind) {
+        gParseSink += (uint32_t)parse_report(pEntry);
+    }
+}
+
+static uint32_t measure_entry(const struct corpus_Entry_t *pEntry)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t startNs = cpu_ns();
+
+        for (int i = 0; i < BENCH_PARSE_LOOPS; i++) {
+            parse_entry(pEntry);
+        }
+        best = MIN(best, cpu_ns() - startNs);
+    }
+
+    return (uint32_t)(best / BENCH_PARSE_LOOPS);
+}
+
+/**
+ * @brief Print the CSV row of a descriptor
+ * @return 1 if it regressed past its baseline, 0 otherwise or without
+ * CONFIG_GHOSTHIDE_BENCH_CPU_GATE
+ */
+static int check_parse_baseline(const char *pName, uint32_t ns)
+{
+    uint32_t base = 0;
+    uint64_t limit;
+    const char *pStatus = "ok";
+
+    for (size_t i = 0; i < ARRAY_SIZE(gBenchParseBaseline); i++) {
+        if (0 == strcmp(gBenchParseBaseline[i].name, pName)) {
+            base = gBenchParseBaseline[i].ns;
+            break;
+        }
+    }
+
+    limit = ((uint64_t)base * (100U + BENCH_CPU_TOLERANCE_PCT)) / 100U;
+    if (0 == base) {
+        pStatus = "new";
+    } else if (!IS_ENABLED(CONFIG_GHOSTHIDE_BENCH_CPU_GATE)) {
+        pStatus = "info";
+    } else if (ns > limit) {
+        pStatus = "regressed";
+    }
+
+    printk("BENCH_CSV %s,parse_ns,%u,%u,%llu,%s\n", pName, ns, base, (unsigned long long)limit, pStatus);
+
+    return (0 == strcmp(pStatus, "regressed")) ? 1 : 0;
+}
+
+/* ========================================================================
+ * Test: The corpus parses as its directories say, within its baseline
+ * ======================================================================== */
+ZTEST(benchmark, test_parse_throughput)
+{
+    struct bench_ParseSummary_t summary[ARRAY_SIZE(gKindNames)] = {0};
+    int regressions = 0;
+
+    printk("BENCH_CSV device,metric,value,baseline,limit,status\n");
+
+    for (size_t i = 0; i < gCorpusCount; i++) {
+        const struct corpus_Entry_t *pEntry = &gCorpus[i];
+        struct bench_ParseSummary_t *pSummary = &summary[pEntry->kind];
+        uint32_t ns;
+
+        if (CORPUS_CONFIG == pEntry->kind) {
+            zassert_true(parse_config(pEntry) > 0, "%s: no HID interface parsed", pEntry->name);
+        } else if (CORPUS_REPORT == pEntry->kind) {
+            zassert_equal(parse_report(pEntry), 0, "%s: report descriptor rejected", pEntry->name);
+        }
+
+        ns = measure_entry(pEntry);
+
+        pSummary->total_ns += ns;
+        pSummary->count++;
+        if (ns >= pSummary->worst_ns) {
+            pSummary->worst_ns = ns;
+            pSummary->pWorst = pEntry->name;
+        }
+
+        printk("BENCH_PARSE {\"descriptor\":\"%s\",\"bytes\":%u,\"parse_ns\":%u}\n", pEntry->name,
+               (uint32_t)pEntry->len, ns);
+        regressions += check_parse_baseline(pEntry->name, ns);
+    }
+
+    for (size_t k = 0; k < ARRAY_SIZE(summary); k++) {
+        if (0 == summary[k].count) {
+            continue;
+        }
+
+        printk("BENCH_PARSE_SUMMARY {\"corpus\":\"%s\",\"descriptors\":%u,\"descriptors_per_sec\":%llu,"
+               "\"worst_ns\":%u,\"worst\":\"%s\"}\n", gKindNames[k], summary[k].count,
+               (unsigned long long)((NSEC_PER_SEC * summary[k].count) / MAX(summary[k].total_ns, 1)),
+               summary[k].worst_ns, summary[k].pWorst);
+    }
+
+    zassert_equal(regressions, 0, "%d descriptor(s) regressed past the baseline", regressions);
+}
@@ -0,0 +1,43 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Builds tests/corpus into the app as gCorpus[] (see corpus.h). Include it
+# after project(); a file added to or removed from the corpus re-runs CMake.
+
+set(CORPUS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(CORPUS_SOURCE ${CMAKE_CURRENT_BINARY_DIR}/corpus/corpus_data.c)
+
+set(CORPUS_ARRAYS "")
+set(CORPUS_TABLE "")
+foreach(CORPUS_KIND config report regress)
+    string(TOUPPER ${CORPUS_KIND} CORPUS_KIND_UPPER)
+    file(GLOB CORPUS_FILES CONFIGURE_DEPENDS ${CORPUS_DIR}/${CORPUS_KIND}/*.bin)
+    list(SORT CORPUS_FILES)
+
+    foreach(CORPUS_FILE ${CORPUS_FILES})
+        get_filename_component(CORPUS_NAME ${CORPUS_FILE} NAME_WE)
+        set(CORPUS_SYMBOL ${CORPUS_KIND}_${CORPUS_NAME})
+        file(READ ${CORPUS_FILE} CORPUS_HEX HEX)
+        if("${CORPUS_HEX}" STREQUAL "")
+            message(FATAL_ERROR "${CORPUS_FILE}: empty corpus file")
+        endif()
+        string(REGEX REPLACE "(..)" "0x\\1," CORPUS_BYTES "${CORPUS_HEX}")
+
+        string(APPEND CORPUS_ARRAYS "static const uint8_t ${CORPUS_SYMBOL}[] = {${CORPUS_BYTES}};\n")
+        string(APPEND CORPUS_TABLE
+            "    {\"${CORPUS_KIND}/${CORPUS_NAME}\", CORPUS_${CORPUS_KIND_UPPER}, "
+            "${CORPUS_SYMBOL}, sizeof(${CORPUS_SYMBOL})},\n")
+    endforeach()
+endforeach()
+
+file(CONFIGURE OUTPUT ${CORPUS_SOURCE} @ONLY CONTENT
+"/* Generated from tests/corpus by corpus.cmake, do not edit */
+#include \"corpus.h\"
+
+@CORPUS_ARRAYS@
+const struct corpus_Entry_t gCorpus[] = {
+@CORPUS_TABLE@};
+
+const size_t gCorpusCount = ARRAY_SIZE(gCorpus);
+")
+
+target_include_directories(app PRIVATE ${CORPUS_DIR})
+target_sources(app PRIVATE ${CORPUS_SOURCE})
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           corpus.h
+ * @brief          Descriptor corpus built into a test image
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * tests/corpus holds one descriptor per file:
+ *   - config/   configuration descriptors the host must accept
+ *   - report/   report descriptors the HID parser must accept
+ *   - regress/  malformed descriptors of either kind, kept once they broke
+ *               a parser; they only have to be survived
+ * corpus.cmake turns every file into an entry of gCorpus[], named
+ * "<directory>/<file name without .bin>". The same directories seed the
+ * fuzzer in tests/fuzz.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <zephyr/kernel.h>
+#include <stdint.h>
+
+/**
+ * @brief Directory an entry comes from
+ */
+typedef enum {
+    CORPUS_CONFIG = 0,
+    CORPUS_REPORT,
+    CORPUS_REGRESS,
+} corpus_Kind_e;
+
+/**
+ * @brief One corpus file
+ */
+struct corpus_Entry_t {
+    const char *name;
+    corpus_Kind_e kind;
+    const uint8_t *pData;
+    size_t len;
+};
+
+extern const struct corpus_Entry_t gCorpus[];
+extern const size_t gCorpusCount;
+
+#endif /* CORPUS_H */
@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           fuzz_main.c
+ * @brief          libFuzzer harness for the descriptor parsers
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Every input is handed to both parsers that see device data before the
+ * device is trusted: as a configuration descriptor to ch375_hostParseConfig()
+ * and USBHID_getHidDescriptor(), and as a report descriptor to
+ * HID_compileReportLayout(). Each parser gets its own heap copy of exactly
+ * the input size, so ASan flags the first byte read past the end. A layout that compiles must also hold together: every
+ * field lies inside its report, and reading every element of every field
+ * out of a report of that size stays in bounds. Anything else is a crash.
+ *
+ * libFuzzer hands the input over from outside the simulated CPU, the fuzz
+ * IRQ wakes main() which runs it, as in Zephyr's fuzzing sample.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/irq.h>
+#include <string.h>
+#include "ch375_host.h"
+#include "hid_parser.h"
+
+/* Input of the current run, set by the native simulator's libFuzzer glue */
+extern const uint8_t *posix_fuzz_buf;
+extern size_t posix_fuzz_sz;
+
+static K_SEM_DEFINE(gFuzzSem, 0, K_SEM_MAX_LIMIT);
+static struct HID_ReportLayout_t gLayout;
+
+/**
+ * @brief Copy the input to a heap block of exactly its size
+ * @return the copy, NULL for an empty input
+ */
+static uint8_t *copy_input(const uint8_t *pData, size_t len)
+{
+    uint8_t *pCopy;
+
+    if (0 == len) {
+        return NULL;
+    }
+
+    pCopy = k_malloc(len);
+    __ASSERT(NULL != pCopy, "heap too small for a %zu byte input", len);
+    memcpy(pCopy, pData, len);
+
+    return pCopy;
+}
+
+static void fuzz_config(const uint8_t *pData, size_t len)
+{
+    struct USB_Device_t udev;
+    uint8_t *pCopy = copy_input(pData, len);
+
+    if (NULL == pCopy) {
+        return;
+    }
+
+    memset(&udev, 0x00, sizeof(udev));
+    udev.raw_conf_desc = pCopy;
+    udev.raw_conf_desc_len = len;
+
+    if (CH37X_HOST_SUCCESS == ch375_hostParseConfig(&udev)) {
+        __ASSERT(udev.interface_count <= USB_MAX_INTERFACES, "%u interfaces", udev.interface_count);
+
+        for (uint8_t i = 0; i < udev.interface_count; i++) {
+            struct USB_HID_Descriptor_t *pHidDesc = NULL;
+
+            __ASSERT(udev.interfaces[i].endpoint_count <= USB_MAX_ENDPOINTS, "%u endpoints",
+                     udev.interfaces[i].endpoint_count);
+
+            if (0 == USBHID_getHidDescriptor(&udev, udev.interfaces[i].interface_number, &pHidDesc)) {
+                __ASSERT((uint8_t *)pHidDesc >= pCopy &&
+                         (uint8_t *)pHidDesc + pHidDesc->bLength <= pCopy + len, "HID descriptor outside input");
+                __ASSERT(pHidDesc->bLength >= sizeof(struct USB_HID_Descriptor_t), "short HID descriptor");
+            }
+        }
+    }
+
+    k_free(pCopy);
+}
+
+/**
+ * @brief Read every element of every field out of a report of the
+ * compiled size, zero filled
+ */
+static void extract_all(const struct HID_ReportLayout_t *pLayout)
+{
+    for (uint8_t r = 0; r < pLayout->report_count; r++) {
+        const struct HID_ReportInfo_t *pInfo = &pLayout->reports[r];
+
+        __ASSERT((uint32_t)pInfo->field_first + pInfo->field_count <= pLayout->field_count, "report %u fields",
+                 pInfo->report_id);
+
+        for (uint8_t f = pInfo->field_first; f < pInfo->field_first + pInfo->field_count; f++) {
+            const struct HID_Field_t *pField = &pLayout->fields[f];
+            uint32_t reportBits;
+            uint8_t *pReport;
+
+            if (HID_REPORT_TYPE_INPUT == pField->report_type) {
+                reportBits = pInfo->input_bits;
+            } else if (HID_REPORT_TYPE_OUTPUT == pField->report_type) {
+                reportBits = pInfo->output_bits;
+            } else {
+                reportBits = pInfo->feature_bits;
+            }
+
+            __ASSERT(pField->report_id == pInfo->report_id, "field %u in the wrong report", f);
+            __ASSERT(pField->bit_size >= 1 && pField->bit_size <= 32, "field %u is %u bits", f, pField->bit_size);
+            __ASSERT((uint32_t)pField->bit_offset + ((uint32_t)pField->bit_size * pField->count) <= reportBits,
+                     "field %u ends past report %u", f, pInfo->report_id);
+
+            pReport = k_calloc(1, (reportBits + 7) / 8);
+            __ASSERT(NULL != pReport, "heap too small for a %u bit report", reportBits);
+
+            for (uint32_t i = 0; i < pField->count; i++) {
+                (void)HID_extractBits(pReport, pField->bit_offset + (i * pField->bit_size), pField->bit_size);
+            }
+
+            k_free(pReport);
+        }
+    }
+}
+
+static void fuzz_report(const uint8_t *pData, size_t len)
+{
+    uint16_t reportLen = (uint16_t)MIN(len, UINT16_MAX);
+    uint8_t *pCopy = copy_input(pData, reportLen);
+
+    if (NULL == pCopy) {
+        return;
+    }
+
+    if (0 == HID_compileReportLayout(pCopy, reportLen, &gLayout)) {
+        __ASSERT(gLayout.field_count <= HID_LAYOUT_MAX_FIELDS, "%u fields", gLayout.field_count);
+        __ASSERT(gLayout.report_count <= HID_LAYOUT_MAX_REPORTS, "%u reports", gLayout.report_count);
+        extract_all(&gLayout);
+    }
+
+    k_free(pCopy);
+}
+
+static void fuzz_isr(const void *arg)
+{
+    ARG_UNUSED(arg);
+
+    // Run the input in thread context, closer to where the parsers run on the device
+    k_sem_give(&gFuzzSem);
+}
+
+int main(void)
+{
+    IRQ_CONNECT(CONFIG_ARCH_POSIX_FUZZ_IRQ, 0, fuzz_isr, NULL, 0);
+    irq_enable(CONFIG_ARCH_POSIX_FUZZ_IRQ);
+
+    while (true) {
+        k_sem_take(&gFuzzSem, K_FOREVER);
+
+        fuzz_config(posix_fuzz_buf, posix_fuzz_sz);
+        fuzz_report(posix_fuzz_buf, posix_fuzz_sz);
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ * 
+ * @file           mock_usb_hid_proxy.c
+ * @brief          USB HID proxy mock implementation
+ * 
+ * @author         destrocore
+ * @date           2025
+ * 
+ * @details
+ * Implements usbhid_proxyTrySendReport() for unit tests. Every report that
+ * finds the endpoint free is accepted and recorded.
+ * 
+ * @copyright 
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "usb_hid_proxy.h"
+#include "mock_usb_hid_proxy.h"
+
+static int mockSendCount = 0;
+static bool isMockKbdBoot = false;
+static bool isMockBusy[USBHID_PROXY_IFACE_COUNT];
+static bool isMockReadyOnBusy[USBHID_PROXY_IFACE_COUNT];
+static mock_proxySendHook_t pMockSendHook = NULL;
+static usbhid_proxyReadyCb_t pMockReadyCb[USBHID_PROXY_IFACE_COUNT];
+static size_t mockLastLen = 0;
+static const uint8_t *pMockLastPointer = NULL;
+static uint8_t mockLastReport[MOCK_PROXY_REPORT_MAX];
+static uint32_t mockLastCaptureCyc = 0;
+static uint32_t mockCoalesced[USBHID_PROXY_IFACE_COUNT];
+static uint32_t mockDropped[USBHID_PROXY_IFACE_COUNT];
+
+static int record_report(uint8_t *pReport, size_t len)
+{
+    if (NULL == pReport || 0 == len || len > MOCK_PROXY_REPORT_MAX) {
+        return -EINVAL;
+    }
+
+    mockSendCount++;
+    mockLastLen = len;
+    pMockLastPointer = pReport;
+    memcpy(mockLastReport, pReport, len);
+
+    return 0;
+}
+
+int usbhid_proxyTrySendReport(uint8_t ifaceNum, uint8_t *pReport, size_t len, uint32_t captureCyc)
+{
+    if (ifaceNum >= USBHID_PROXY_IFACE_COUNT) {
+        return -EINVAL;
+    }
+
+    if (NULL != pMockSendHook) {
+        pMockSendHook(ifaceNum);
+    }
+
+    if (true == isMockBusy[ifaceNum]) {
+        if (true == isMockReadyOnBusy[ifaceNum]) {
+            isMockReadyOnBusy[ifaceNum] = false;
+            mock_proxyFireReady(ifaceNum);
+        }
+        return -EBUSY;
+    }
+
+    // Like the real endpoint, busy until the host polls it
+    isMockBusy[ifaceNum] = true;
+    mockLastCaptureCyc = captureCyc;
+
+    return record_report(pReport, len);
+}
+
+void usbhid_proxySetReadyCallback(uint8_t ifaceNum, usbhid_proxyReadyCb_t cb)
+{
+    if (ifaceNum < USBHID_PROXY_IFACE_COUNT) {
+        pMockReadyCb[ifaceNum] = cb;
+    }
+}
+
+void usbhid_proxyCountCoalesced(uint8_t ifaceNum)
+{
+    mockCoalesced[ifaceNum]++;
+}
+
+void usbhid_proxyCountDropped(uint8_t ifaceNum)
+{
+    mockDropped[ifaceNum]++;
+}
+
+bool usbhid_proxyKbdIsBootProtocol(void)
+{
+    return isMockKbdBoot;
+}
+
+void mock_proxyReset(void)
+{
+    mockSendCount = 0;
+    isMockKbdBoot = false;
+    memset(isMockBusy, 0x00, sizeof(isMockBusy));
+    memset(isMockReadyOnBusy, 0x00, sizeof(isMockReadyOnBusy));
+    pMockSendHook = NULL;
+    memset(mockCoalesced, 0x00, sizeof(mockCoalesced));
+    memset(mockDropped, 0x00, sizeof(mockDropped));
+    mockLastLen = 0;
+    pMockLastPointer = NULL;
+    memset(mockLastReport, 0x00, sizeof(mockLastReport));
+}
+
+int mock_proxyGetSendCount(void)
+{
+    return mockSendCount;
+}
+
+const uint8_t *mock_proxyGetLastReport(size_t *pLen)
+{
+    if (NULL != pLen) {
+        *pLen = mockLastLen;
+    }
+
+    return mockLastReport;
+}
+
+uint32_t mock_proxyGetLastCaptureCyc(void)
+{
+    return mockLastCaptureCyc;
+}
+
+const uint8_t *mock_proxyGetLastPointer(void)
+{
+    return pMockLastPointer;
+}
+
+void mock_proxySetKbdBootProtocol(bool isBoot)
+{
+    isMockKbdBoot = isBoot;
+}
+
+void mock_proxySetBusy(uint8_t ifaceNum, bool isBusy)
+{
+    isMockBusy[ifaceNum] = isBusy;
+}
+
+void mock_proxyFireReady(uint8_t ifaceNum)
+{
+    isMockBusy[ifaceNum] = false;
+
+    if (NULL != pMockReadyCb[ifaceNum]) {
+        pMockReadyCb[ifaceNum](ifaceNum);
+    }
+}
+
+void mock_proxySetReadyOnBusy(uint8_t ifaceNum)
+{
+    isMockReadyOnBusy[ifaceNum] = true;
+}
+
+void mock_proxySetSendHook(mock_proxySendHook_t hook)
+{
+    pMockSendHook = hook;
+}
+
+uint32_t mock_proxyGetCoalesced(uint8_t ifaceNum)
+{
+    return mockCoalesced[ifaceNum];
+}
+
+uint32_t mock_proxyGetDropped(uint8_t ifaceNum)
+{
+    return mockDropped[ifaceNum];
+}
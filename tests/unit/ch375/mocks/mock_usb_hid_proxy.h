@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ * 
+ * @file           mock_usb_hid_proxy.h
+ * @brief          USB HID proxy mock for unit testing
+ * 
+ * @author         destrocore
+ * @date           2025
+ * 
+ * @details
+ * Replaces the USB device side of the proxy. Records the last report
+ * handed to usbhid_proxyTrySendReport() so tests can check the translated
+ * output and whether it was sent from the input buffer in place.
+ * 
+ * @copyright 
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifndef MOCK_USB_HID_PROXY_H
+#define MOCK_USB_HID_PROXY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MOCK_PROXY_REPORT_MAX 64
+
+/**
+ * @brief Runs at the start of every send attempt, while the caller holds its queue
+ */
+typedef void (*mock_proxySendHook_t)(uint8_t ifaceNum);
+
+/**
+ * @brief Reset recorded reports
+ */
+void mock_proxyReset(void);
+
+/**
+ * @brief Number of reports sent since the last reset
+ */
+int mock_proxyGetSendCount(void);
+
+/**
+ * @brief Copy of the last sent report
+ * @param pLen Optional pointer receiving the report length
+ * @return Pointer to the copy
+ */
+const uint8_t *mock_proxyGetLastReport(size_t *pLen);
+
+/**
+ * @brief Capture time passed with the last report sent through the try path
+ */
+uint32_t mock_proxyGetLastCaptureCyc(void);
+
+/**
+ * @brief Buffer pointer passed with the last sent report
+ */
+const uint8_t *mock_proxyGetLastPointer(void);
+
+/**
+ * @brief Pretend the host switched the keyboard protocol
+ */
+void mock_proxySetKbdBootProtocol(bool isBoot);
+
+/**
+ * @brief Make usbhid_proxyTrySendReport() report a busy endpoint
+ */
+void mock_proxySetBusy(uint8_t ifaceNum, bool isBusy);
+
+/**
+ * @brief Free the endpoint and run its ready callback, like int_in_ready
+ */
+void mock_proxyFireReady(uint8_t ifaceNum);
+
+/**
+ * @brief Complete the transfer in flight during the next busy send attempt
+ * @note The ready callback runs before -EBUSY is returned, like an endpoint
+ *       finishing while the caller holds the queue.
+ */
+void mock_proxySetReadyOnBusy(uint8_t ifaceNum);
+
+/**
+ * @brief Install a send hook, NULL removes it
+ */
+void mock_proxySetSendHook(mock_proxySendHook_t hook);
+
+/**
+ * @brief Reports counted as coalesced / dropped since the last reset
+ */
+uint32_t mock_proxyGetCoalesced(uint8_t ifaceNum);
+uint32_t mock_proxyGetDropped(uint8_t ifaceNum);
+
+#endif /* MOCK_USB_HID_PROXY_H */
@@ -0,0 +1,268 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           test_ch37x_replay.c
+ * @brief          CH37x link capture and replay unit tests
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Captures an enumeration of the simulated devices, plays the capture back
+ * to a fresh CH375 context and checks the cores come out with the same
+ * device in about the same time, and that a write the capture does not
+ * have is caught. Needs CONFIG_GHOSTHIDE_LINK_CAPTURE (unit.ch37x.replay).
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/ztest.h>
+#include "ch375_host.h"
+#include "hid_parser.h"
+#include "ch37x_sim.h"
+#include "ch37x_sim_hid.h"
+#include "ch37x_capture.h"
+#include "ch37x_replay.h"
+
+#if defined(CONFIG_GHOSTHIDE_LINK_CAPTURE)
+
+#define TEST_MOUSE_HZ           100
+#define TEST_TIME_TOLERANCE_PCT 5
+
+static struct CH37xSim_Chip_t gChip;
+static struct CH37xSimHid_Device_t gSimHid;
+static struct CH37xReplay_t gReplay;
+static struct ch375_Context_t *pCtx;
+static struct USB_Device_t gUdev;
+static struct USBHID_Device_t gHidDev;
+static uint8_t gTrace[sizeof(struct ch37x_CaptureHeader_t) +
+                      (CONFIG_GHOSTHIDE_LINK_CAPTURE_RECORDS * CH37X_CAPTURE_RECORD_SIZE)];
+
+static int sim_writeCmd(struct ch375_Context_t *pCtx, uint8_t cmd)
+{
+    ch37xSim_writeCmd(ch375_getPriv(pCtx), cmd);
+    return CH375_SUCCESS;
+}
+
+static int sim_writeData(struct ch375_Context_t *pCtx, uint8_t data)
+{
+    ch37xSim_writeData(ch375_getPriv(pCtx), data);
+    return CH375_SUCCESS;
+}
+
+static int sim_readData(struct ch375_Context_t *pCtx, uint8_t *pData)
+{
+    return (0 == ch37xSim_readData(ch375_getPriv(pCtx), pData)) ? CH375_SUCCESS : CH375_TIMEOUT;
+}
+
+static int sim_queryInt(struct ch375_Context_t *pCtx)
+{
+    return ch37xSim_queryInt(ch375_getPriv(pCtx));
+}
+
+static int replay_writeCmd(struct ch375_Context_t *pCtx, uint8_t cmd)
+{
+    ch37xReplay_writeCmd(ch375_getPriv(pCtx), cmd);
+    return CH375_SUCCESS;
+}
+
+static int replay_writeData(struct ch375_Context_t *pCtx, uint8_t data)
+{
+    ch37xReplay_writeData(ch375_getPriv(pCtx), data);
+    return CH375_SUCCESS;
+}
+
+static int replay_readData(struct ch375_Context_t *pCtx, uint8_t *pData)
+{
+    int ret = ch37xReplay_readData(ch375_getPriv(pCtx), pData);
+
+    if (-ETIMEDOUT == ret) {
+        return CH375_TIMEOUT;
+    }
+
+    return (0 == ret) ? CH375_SUCCESS : ret;
+}
+
+static int replay_queryInt(struct ch375_Context_t *pCtx)
+{
+    return ch37xReplay_queryInt(ch375_getPriv(pCtx));
+}
+
+/**
+ * @brief Enumerate a simulated device on a port with the capture on
+ * @return length of the exported trace
+ */
+static int capture_enumeration(bool isKeyboard, uint8_t port, uint64_t *pElapsedUs)
+{
+    uint64_t startUs;
+    int len;
+
+    ch37xSim_init(&gChip, CH37X_SIM_CH375, CH375_DEFAULT_BAUDRATE);
+    if (isKeyboard) {
+        ch37xSimHid_initKeyboard(&gSimHid, 0);
+    } else {
+        ch37xSimHid_initMouse(&gSimHid, TEST_MOUSE_HZ);
+    }
+    ch37xSim_attach(&gChip, &gSimHid.dev);
+
+    zassert_equal(ch375_openContext(&pCtx, sim_writeCmd, sim_writeData, sim_readData, sim_queryInt, &gChip),
+                  CH375_SUCCESS);
+    ch37xCapture_clear();
+    ch37xCapture_bindPort(pCtx, port);
+
+    startUs = ch37xSim_nowUs();
+    zassert_equal(ch375_hostInit(pCtx, CH375_WORK_BAUDRATE), CH37X_HOST_SUCCESS);
+    ch37xSim_setLinkBaudrate(&gChip, CH375_WORK_BAUDRATE);
+    zassert_equal(ch375_hostWaitDeviceConnect(pCtx, 10), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostUdevOpen(pCtx, &gUdev), CH37X_HOST_SUCCESS);
+    zassert_equal(USBHID_open(&gUdev, 0, &gHidDev), USBHID_SUCCESS);
+    *pElapsedUs = ch37xSim_nowUs() - startUs;
+
+    len = ch37xCapture_export(gTrace, sizeof(gTrace));
+    zassert_true(len > (int)sizeof(struct ch37x_CaptureHeader_t));
+
+    // Nothing the replay does below may land in the trace
+    ch37xCapture_bindPort(NULL, port);
+
+    USBHID_close(&gHidDev);
+    ch375_hostUdevClose(&gUdev);
+    ch375_closeContext(pCtx);
+    pCtx = NULL;
+    memset(&gUdev, 0x00, sizeof(gUdev));
+    memset(&gHidDev, 0x00, sizeof(gHidDev));
+
+    return len;
+}
+
+static void open_replay(int len, uint8_t port)
+{
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, (size_t)len, port), 0);
+    zassert_equal(ch375_openContext(&pCtx, replay_writeCmd, replay_writeData, replay_readData, replay_queryInt,
+                                    &gReplay), CH375_SUCCESS);
+}
+
+static void test_setup(void *f)
+{
+    memset(&gUdev, 0x00, sizeof(gUdev));
+    memset(&gHidDev, 0x00, sizeof(gHidDev));
+    pCtx = NULL;
+}
+
+static void test_teardown(void *f)
+{
+    USBHID_close(&gHidDev);
+    ch375_hostUdevClose(&gUdev);
+
+    if (NULL != pCtx) {
+        ch375_closeContext(pCtx);
+        pCtx = NULL;
+    }
+}
+
+/* ========================================================================
+ * Test: A replayed enumeration ends with the same device and timing
+ * ======================================================================== */
+ZTEST(ch37x_replay, test_round_trip_mouse)
+{
+    uint64_t captureUs;
+    uint64_t startUs;
+    uint64_t replayUs;
+    int len;
+
+    len = capture_enumeration(false, 0, &captureUs);
+    open_replay(len, 0);
+
+    startUs = ch37xSim_nowUs();
+    zassert_equal(ch375_hostInit(pCtx, CH375_WORK_BAUDRATE), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostWaitDeviceConnect(pCtx, 10), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostUdevOpen(pCtx, &gUdev), CH37X_HOST_SUCCESS);
+    zassert_equal(USBHID_open(&gUdev, 0, &gHidDev), USBHID_SUCCESS);
+    replayUs = ch37xSim_nowUs() - startUs;
+
+    zassert_false(gReplay.is_diverged, "diverged at record %u", gReplay.diverge_pos);
+    zassert_true(ch37xReplay_isDone(&gReplay));
+    zassert_equal(gUdev.vendor_id, CH37X_SIM_HID_VID);
+    zassert_equal(gUdev.product_id, CH37X_SIM_HID_MOUSE_PID);
+    zassert_equal(gHidDev.hid_type, USBHID_TYPE_MOUSE);
+
+    zassert_true(replayUs * 100U >= captureUs * (100U - TEST_TIME_TOLERANCE_PCT),
+                 "replay %llu us, capture %llu us", replayUs, captureUs);
+    zassert_true(replayUs * 100U <= captureUs * (100U + TEST_TIME_TOLERANCE_PCT),
+                 "replay %llu us, capture %llu us", replayUs, captureUs);
+}
+
+/* ========================================================================
+ * Test: A port only plays its own records
+ * ======================================================================== */
+ZTEST(ch37x_replay, test_round_trip_keyboard_port_b)
+{
+    uint64_t captureUs;
+    int len;
+
+    len = capture_enumeration(true, 1, &captureUs);
+
+    // Port A has no records in this capture
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, (size_t)len, 0), 0);
+    zassert_true(ch37xReplay_isDone(&gReplay));
+
+    open_replay(len, 1);
+    zassert_equal(ch375_hostInit(pCtx, CH375_WORK_BAUDRATE), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostWaitDeviceConnect(pCtx, 10), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostUdevOpen(pCtx, &gUdev), CH37X_HOST_SUCCESS);
+    zassert_equal(USBHID_open(&gUdev, 0, &gHidDev), USBHID_SUCCESS);
+
+    zassert_false(gReplay.is_diverged, "diverged at record %u", gReplay.diverge_pos);
+    zassert_equal(gUdev.product_id, CH37X_SIM_HID_KEYBOARD_PID);
+    zassert_equal(gHidDev.hid_type, USBHID_TYPE_KEYBOARD);
+}
+
+/* ========================================================================
+ * Test: The first write the capture does not have is reported
+ * ======================================================================== */
+ZTEST(ch37x_replay, test_divergence)
+{
+    uint64_t captureUs;
+    uint8_t data = 0;
+    int len;
+
+    len = capture_enumeration(false, 0, &captureUs);
+    open_replay(len, 0);
+
+    // The capture starts with CHECK_EXIST, not a baud rate switch
+    ch375_setBaudrate(pCtx, CH375_WORK_BAUDRATE);
+
+    zassert_true(gReplay.is_diverged);
+    zassert_equal(gReplay.diverge_pos, 0);
+    zassert_equal(ch37xReplay_readData(&gReplay, &data), -ETIMEDOUT);
+    zassert_false(ch37xReplay_isDone(&gReplay));
+}
+
+/* ========================================================================
+ * Test: Anything but a trace file of this version is refused
+ * ======================================================================== */
+ZTEST(ch37x_replay, test_open_rejects_bad_trace)
+{
+    uint64_t captureUs;
+    int len;
+
+    len = capture_enumeration(false, 0, &captureUs);
+
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, sizeof(struct ch37x_CaptureHeader_t) - 1, 0), -EINVAL);
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, (size_t)len - 1, 0), -EINVAL);
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, (size_t)len, CH37X_CAPTURE_PORT_COUNT), -EINVAL);
+
+    gTrace[4] = CH37X_CAPTURE_VERSION + 1;
+    zassert_equal(ch37xReplay_open(&gReplay, gTrace, (size_t)len, 0), -EINVAL);
+}
+
+ZTEST_SUITE(ch37x_replay, NULL, NULL, test_setup, test_teardown, NULL);
+
+#endif /* CONFIG_GHOSTHIDE_LINK_CAPTURE */
@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ *
+ * @file           test_ch37x_sim.c
+ * @brief          CH37x simulator unit tests
+ *
+ * @author         destrocore
+ * @date           2025
+ *
+ * @details
+ * Runs the real CH375 core, host layer and HID parser against the chip
+ * model and its virtual devices: link timing, baud rate mismatch, full
+ * enumeration of the full speed mouse and the low speed keyboard, a report
+ * descriptor longer than one control packet, and the pacing of interrupt IN
+ * reports.
+ *
+ * @copyright
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/ztest.h>
+#include "ch375_host.h"
+#include "hid_parser.h"
+#include "hid_mouse.h"
+#include "ch37x_sim.h"
+#include "ch37x_sim_hid.h"
+
+#define TEST_MOUSE_HZ       100
+#define TEST_KEYS_PER_SEC   0
+
+// Wheel and pan mouse with 16-bit X/Y, 73 bytes so it spans two 64 byte reads
+static const uint8_t LONG_REPORT_DESC[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02,
+    0x95, 0x01, 0x75, 0x03, 0x81, 0x03,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x81, 0x06,
+    0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+    0x05, 0x0C, 0x0A, 0x38, 0x02, 0x95, 0x01, 0x81, 0x06,
+    0xC0, 0xC0,
+};
+
+static const struct CH37xSimHid_Profile_t LONG_DESC_PROFILE = {
+    .pid = 0x0010,
+    .is_low_speed = false,
+    .ep0_max_packet = 64,
+    .protocol = 2,
+    .ep_max_packet = 8,
+    .interval = 1,
+    .pReportDesc = LONG_REPORT_DESC,
+    .report_desc_len = sizeof(LONG_REPORT_DESC),
+    .report_len = 7,
+    .report_id = 0,
+};
+
+static struct CH37xSim_Chip_t gChip;
+static struct CH37xSimHid_Device_t gSimHid;
+static struct ch375_Context_t *pCtx;
+static struct USB_Device_t gUdev;
+static struct USBHID_Device_t gHidDev;
+
+static int sim_writeCmd(struct ch375_Context_t *pCtx, uint8_t cmd)
+{
+    ch37xSim_writeCmd(ch375_getPriv(pCtx), cmd);
+    return CH375_SUCCESS;
+}
+
+static int sim_writeData(struct ch375_Context_t *pCtx, uint8_t data)
+{
+    ch37xSim_writeData(ch375_getPriv(pCtx), data);
+    return CH375_SUCCESS;
+}
+
+static int sim_readData(struct ch375_Context_t *pCtx, uint8_t *pData)
+{
+    return (0 == ch37xSim_readData(ch375_getPriv(pCtx), pData)) ? CH375_SUCCESS : CH375_TIMEOUT;
+}
+
+static int sim_queryInt(struct ch375_Context_t *pCtx)
+{
+    return ch37xSim_queryInt(ch375_getPriv(pCtx));
+}
+
+static void open_sim(bool isKeyboard)
+{
+    ch37xSim_init(&gChip, CH37X_SIM_CH375, CH375_DEFAULT_BAUDRATE);
+
+    if (isKeyboard) {
+        ch37xSimHid_initKeyboard(&gSimHid, TEST_KEYS_PER_SEC);
+    } else {
+        ch37xSimHid_initMouse(&gSimHid, TEST_MOUSE_HZ);
+    }
+    ch37xSim_attach(&gChip, &gSimHid.dev);
+
+    zassert_equal(ch375_openContext(&pCtx, sim_writeCmd, sim_writeData, sim_readData, sim_queryInt, &gChip),
+                  CH375_SUCCESS);
+}
+
+/**
+ * @brief Bring the host up and enumerate, as main.c does
+ */
+static void enumerate(void)
+{
+    zassert_equal(ch375_hostInit(pCtx, CH375_WORK_BAUDRATE), CH37X_HOST_SUCCESS);
+    ch37xSim_setLinkBaudrate(&gChip, CH375_WORK_BAUDRATE);
+    zassert_equal(ch375_hostWaitReady(pCtx, CH375_HOST_READY_TIMEOUT_MS), CH37X_HOST_SUCCESS);
+
+    zassert_equal(ch375_hostWaitDeviceConnect(pCtx, 10), CH37X_HOST_SUCCESS);
+    zassert_equal(ch375_hostUdevOpen(pCtx, &gUdev), CH37X_HOST_SUCCESS);
+    zassert_equal(USBHID_open(&gUdev, 0, &gHidDev), USBHID_SUCCESS);
+}
+
+static void test_setup(void *f)
+{
+    memset(&gUdev, 0x00, sizeof(gUdev));
+    memset(&gHidDev, 0x00, sizeof(gHidDev));
+    pCtx = NULL;
+}
+
+static void test_teardown(void *f)
+{
+    USBHID_close(&gHidDev);
+    ch375_hostUdevClose(&gUdev);
+
+    if (NULL != pCtx) {
+        ch375_closeContext(pCtx);
+        pCtx = NULL;
+    }
+}
+
+/* ========================================================================
+ * Test: Every byte costs its 9-bit frame time
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_check_exist_frame_time)
+{
+    uint64_t startUs;
+
+    open_sim(false);
+
+    startUs = ch37xSim_nowUs();
+    zassert_equal(ch375_checkExist(pCtx), CH375_SUCCESS);
+
+    // Command, test byte, answer: 11 bits each at 9600 baud
+    zassert_true(ch37xSim_nowUs() - startUs >= (3U * 11U * 1000000U) / CH375_DEFAULT_BAUDRATE);
+}
+
+/* ========================================================================
+ * Test: The link only works once both ends run at the same rate
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_baudrate_mismatch)
+{
+    open_sim(false);
+
+    zassert_equal(ch375_setBaudrate(pCtx, CH375_WORK_BAUDRATE), CH375_SUCCESS);
+    zassert_equal(ch37xSim_getChipBaudrate(&gChip), 115384);
+    zassert_not_equal(ch375_checkExist(pCtx), CH375_SUCCESS);
+
+    ch37xSim_setLinkBaudrate(&gChip, CH375_WORK_BAUDRATE);
+    zassert_equal(ch375_checkExist(pCtx), CH375_SUCCESS);
+}
+
+/* ========================================================================
+ * Test: Readiness is polled, a chip at another rate times out
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_wait_ready)
+{
+    uint64_t startUs;
+
+    open_sim(false);
+
+    startUs = ch37xSim_nowUs();
+    zassert_equal(ch375_hostWaitReady(pCtx, CH375_HOST_READY_TIMEOUT_MS), CH37X_HOST_SUCCESS);
+    // One CHECK_EXIST, no settle time on top
+    zassert_true(ch37xSim_nowUs() - startUs < (4U * 11U * 1000000U) / CH375_DEFAULT_BAUDRATE);
+
+    zassert_equal(ch375_setBaudrate(pCtx, CH375_WORK_BAUDRATE), CH375_SUCCESS);
+    startUs = ch37xSim_nowUs();
+    zassert_equal(ch375_hostWaitReady(pCtx, 20), CH37X_HOST_TIMEOUT);
+    zassert_true(ch37xSim_nowUs() - startUs >= 20U * 1000U);
+
+    ch37xSim_setLinkBaudrate(&gChip, CH375_WORK_BAUDRATE);
+    zassert_equal(ch375_hostWaitReady(pCtx, CH375_HOST_READY_TIMEOUT_MS), CH37X_HOST_SUCCESS);
+}
+
+/* ========================================================================
+ * Test: Full speed mouse enumerates through the real host stack
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_enumerate_mouse)
+{
+    open_sim(false);
+    enumerate();
+
+    zassert_equal(gUdev.vendor_id, CH37X_SIM_HID_VID);
+    zassert_equal(gUdev.product_id, CH37X_SIM_HID_MOUSE_PID);
+    zassert_equal(gUdev.ep0_max_packet, 64);
+    zassert_equal(gSimHid.dev.address, 1);
+    zassert_equal(gSimHid.config, 1);
+    zassert_equal(gHidDev.hid_type, USBHID_TYPE_MOUSE);
+}
+
+/* ========================================================================
+ * Test: A report descriptor over 64 bytes is read whole, not head twice
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_enumerate_long_report_descriptor)
+{
+    zassert_true(sizeof(LONG_REPORT_DESC) > 64);
+
+    ch37xSim_init(&gChip, CH37X_SIM_CH375, CH375_DEFAULT_BAUDRATE);
+    zassert_equal(ch37xSimHid_initProfile(&gSimHid, &LONG_DESC_PROFILE), 0);
+    ch37xSim_attach(&gChip, &gSimHid.dev);
+    zassert_equal(ch375_openContext(&pCtx, sim_writeCmd, sim_writeData, sim_readData, sim_queryInt, &gChip),
+                  CH375_SUCCESS);
+    enumerate();
+
+    zassert_equal(gHidDev.raw_hid_report_desc_len, sizeof(LONG_REPORT_DESC));
+    zassert_mem_equal(gHidDev.raw_hid_report_desc, LONG_REPORT_DESC, sizeof(LONG_REPORT_DESC),
+                      "Report descriptor tail differs from the device's");
+    zassert_equal(gHidDev.hid_type, USBHID_TYPE_MOUSE);
+}
+
+/* ========================================================================
+ * Test: Interrupt IN is NAKed until the next report is due
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_mouse_report_pacing)
+{
+    struct HID_Mouse_t mouse;
+
+    open_sim(false);
+    enumerate();
+    zassert_equal(hidMouse_Open(&gHidDev, &mouse), USBHID_SUCCESS);
+
+    zassert_equal(hidMouse_FetchReport(&mouse), USBHID_SUCCESS);
+    zassert_equal(hidMouse_FetchReport(&mouse), -EAGAIN);
+
+    k_busy_wait(1000000U / TEST_MOUSE_HZ);
+    zassert_equal(hidMouse_FetchReport(&mouse), USBHID_SUCCESS);
+    zassert_equal(gSimHid.seq, 2);
+
+    hidMouse_Close(&mouse);
+}
+
+/* ========================================================================
+ * Test: Low speed keyboard enumerates with an 8 byte control pipe
+ * ======================================================================== */
+ZTEST(ch37x_sim, test_enumerate_keyboard_low_speed)
+{
+    open_sim(true);
+    enumerate();
+
+    zassert_equal(gUdev.product_id, CH37X_SIM_HID_KEYBOARD_PID);
+    zassert_equal(gUdev.ep0_max_packet, 8);
+    zassert_true(gChip.is_low_speed);
+    zassert_equal(gHidDev.hid_type, USBHID_TYPE_KEYBOARD);
+}
+
+ZTEST_SUITE(ch37x_sim, NULL, NULL, test_setup, test_teardown, NULL);
@@ -376,6 +376,102 @@ ZTEST(ch375_descriptors, test_malformed_length_exceeds) {
     zassert_true(detected_overflow, "Should detect length overflow");
 }
 
+/* ========================================================================
+ * Test: Configuration Parse Of Untrusted Descriptors
+ * ======================================================================== */
+ZTEST(ch375_descriptors, test_parse_config_mouse) {
+
+    struct USB_Device_t udev = {0};
+
+    udev.raw_conf_desc = (uint8_t *)sampleMouseConfig;
+    udev.raw_conf_desc_len = sizeof(sampleMouseConfig);
+
+    zassert_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+    zassert_equal(udev.interface_count, 1);
+    zassert_equal(udev.interfaces[0].interface_protocol, 0x02);
+    zassert_equal(udev.interfaces[0].endpoint_count, 1);
+    zassert_equal(udev.interfaces[0].endpoints[0].ep_addr, 0x81);
+}
+
+ZTEST(ch375_descriptors, test_parse_config_endpoint_before_interface) {
+
+    struct USB_Device_t udev = {0};
+    uint8_t desc[] = {
+        0x09, 0x02, 0x29, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+        0x07, 0x05, 0x81, 0x03, 0x08, 0x00, 0x0A,
+        0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x02, 0x00,
+        0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x34, 0x00,
+        0x07, 0x05, 0x82, 0x03, 0x08, 0x00, 0x0A
+    };
+
+    udev.raw_conf_desc = desc;
+    udev.raw_conf_desc_len = sizeof(desc);
+
+    // The stray endpoint has no interface to go to and is dropped
+    zassert_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+    zassert_equal(udev.interface_count, 1);
+    zassert_equal(udev.interfaces[0].endpoint_count, 1);
+    zassert_equal(udev.interfaces[0].endpoints[0].ep_addr, 0x82);
+}
+
+ZTEST(ch375_descriptors, test_parse_config_limits) {
+
+    struct USB_Device_t udev = {0};
+    uint8_t desc[9 + (USB_MAX_INTERFACES + 1) * 9 + (USB_MAX_ENDPOINTS + 1) * 7];
+    uint8_t *pCur = desc;
+
+    memcpy(pCur, sampleMouseConfig, 9);
+    pCur += 9;
+
+    // One interface with an endpoint too many, then interfaces past the limit
+    for (uint8_t i = 0; i <= USB_MAX_INTERFACES; i++) {
+        uint8_t ifc[] = {0x09, 0x04, i, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00};
+
+        memcpy(pCur, ifc, sizeof(ifc));
+        pCur += sizeof(ifc);
+
+        for (uint8_t e = 0; 0 == i && e <= USB_MAX_ENDPOINTS; e++) {
+            uint8_t ep[] = {0x07, 0x05, (uint8_t)(0x81 + e), 0x03, 0x08, 0x00, 0x0A};
+
+            memcpy(pCur, ep, sizeof(ep));
+            pCur += sizeof(ep);
+        }
+    }
+
+    udev.raw_conf_desc = desc;
+    udev.raw_conf_desc_len = pCur - desc;
+
+    zassert_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+    zassert_equal(udev.interface_count, USB_MAX_INTERFACES);
+    zassert_equal(udev.interfaces[0].endpoint_count, USB_MAX_ENDPOINTS);
+    zassert_equal(udev.interfaces[USB_MAX_INTERFACES - 1].interface_number, USB_MAX_INTERFACES - 1);
+}
+
+ZTEST(ch375_descriptors, test_parse_config_rejects_malformed) {
+
+    struct USB_Device_t udev = {0};
+    uint8_t shortInterface[] = {
+        0x09, 0x02, 0x14, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+        0x04, 0x04, 0x00, 0x00,
+        0x07, 0x05, 0x81, 0x03, 0x08, 0x00, 0x0A
+    };
+    uint8_t pastEnd[] = {
+        0x09, 0x02, 0x0F, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+        0x09, 0x04, 0x00, 0x00
+    };
+
+    udev.raw_conf_desc = shortInterface;
+    udev.raw_conf_desc_len = sizeof(shortInterface);
+    zassert_not_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+
+    udev.raw_conf_desc = pastEnd;
+    udev.raw_conf_desc_len = sizeof(pastEnd);
+    zassert_not_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+
+    udev.raw_conf_desc = NULL;
+    zassert_not_equal(ch375_hostParseConfig(&udev), CH37X_HOST_SUCCESS);
+}
+
 /* ========================================================================
  * Test: HID Descriptor Parsing
  * ======================================================================== */
@@ -155,6 +155,83 @@ const uint8_t RAZER_BLACKWIDOW_V4_KEYBOARD[177] = {
 		0xC0               // End Collection
 	};
 
+/**
+ * @brief NKRO keyboard: modifiers + usage bitmap 0x00..0x77, Report ID 1
+ */
+#define NKRO_KEYBOARD_REPORT_SIZE   17
+
+const uint8_t NKRO_KEYBOARD[] = {
+		0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+		0x09, 0x06,        // Usage (Keyboard)
+		0xA1, 0x01,        // Collection (Application)
+		0x85, 0x01,        //   Report ID (1)
+		0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+		0x19, 0xE0,        //   Usage Minimum (0xE0)
+		0x29, 0xE7,        //   Usage Maximum (0xE7)
+		0x15, 0x00,        //   Logical Minimum (0)
+		0x25, 0x01,        //   Logical Maximum (1)
+		0x75, 0x01,        //   Report Size (1)
+		0x95, 0x08,        //   Report Count (8)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0x19, 0x00,        //   Usage Minimum (0x00)
+		0x29, 0x77,        //   Usage Maximum (0x77)
+		0x95, 0x78,        //   Report Count (120)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0xC0,              // End Collection
+		0x05, 0x0C,        // Usage Page (Consumer)
+		0x09, 0x01,        // Usage (Consumer Control)
+		0xA1, 0x01,        // Collection (Application)
+		0x85, 0x02,        //   Report ID (2)
+		0x19, 0x00,        //   Usage Minimum (0x00)
+		0x2A, 0x3C, 0x02,  //   Usage Maximum (0x023C)
+		0x15, 0x00,        //   Logical Minimum (0)
+		0x26, 0x3C, 0x02,  //   Logical Maximum (572)
+		0x95, 0x01,        //   Report Count (1)
+		0x75, 0x10,        //   Report Size (16)
+		0x81, 0x00,        //   Input (Data,Array,Abs)
+		0xC0               // End Collection
+	};
+
+/**
+ * @brief Modifiers listed usage by usage, key bitmap split over several items
+ */
+#define SPLIT_BITMAP_KEYBOARD_REPORT_SIZE   7
+
+const uint8_t SPLIT_BITMAP_KEYBOARD[] = {
+		0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+		0x09, 0x06,        // Usage (Keyboard)
+		0xA1, 0x01,        // Collection (Application)
+		0x05, 0x07,        //   Usage Page (Kbrd/Keypad)
+		0x09, 0xE0,        //   Usage (Left Control)
+		0x09, 0xE1,        //   Usage (Left Shift)
+		0x09, 0xE2,        //   Usage (Left Alt)
+		0x09, 0xE3,        //   Usage (Left GUI)
+		0x09, 0xE4,        //   Usage (Right Control)
+		0x09, 0xE5,        //   Usage (Right Shift)
+		0x09, 0xE6,        //   Usage (Right Alt)
+		0x09, 0xE7,        //   Usage (Right GUI)
+		0x15, 0x00,        //   Logical Minimum (0)
+		0x25, 0x01,        //   Logical Maximum (1)
+		0x75, 0x01,        //   Report Size (1)
+		0x95, 0x08,        //   Report Count (8)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0x19, 0x04,        //   Usage Minimum (0x04)
+		0x29, 0x1D,        //   Usage Maximum (0x1D)
+		0x95, 0x1A,        //   Report Count (26)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0x19, 0x1E,        //   Usage Minimum (0x1E)
+		0x29, 0x27,        //   Usage Maximum (0x27)
+		0x95, 0x0A,        //   Report Count (10)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0x95, 0x04,        //   Report Count (4)
+		0x81, 0x01,        //   Input (Const)
+		0x19, 0x28,        //   Usage Minimum (0x28)
+		0x29, 0x2F,        //   Usage Maximum (0x2F)
+		0x95, 0x08,        //   Report Count (8)
+		0x81, 0x02,        //   Input (Data,Var,Abs)
+		0xC0               // End Collection
+	};
+
 static void test_setup(void *f)
 {
     mock_ch375Reset();
@@ -799,8 +876,12 @@ ZTEST(hid_keyboard, test_gaming_keyboard_with_report_id)
     int ret = hidKeyboard_Open(&hidDev, &kbd);
     
     zassert_equal(ret, USBHID_SUCCESS);
-    zassert_equal(kbd.report_length, HID_KBD_REPORT_SIZE);
-    zassert_equal(kbd.keys.count, HID_KBD_MAX_KEYS);
+    zassert_equal(kbd.report_id, 1);
+    zassert_equal(kbd.report_length, 16, "ID byte + modifiers + 14 keys");
+    zassert_equal(kbd.modifier.report_buf_off, 1);
+    zassert_equal(kbd.keys.report_buf_off, 2);
+    zassert_equal(kbd.keys.count, 14);
+    zassert_equal(kbd.bitmap_count, 0);
     
     hidKeyboard_Close(&kbd);
 }
@@ -1044,6 +1125,278 @@ ZTEST(hid_keyboard, test_keyboard_constants)
     zassert_equal(HID_KBD_MAX_KEYS, 6);
 }
 
+/* ========================================================================
+ * Test: Decode-once state snapshot
+ * ======================================================================== */
+ZTEST(hid_keyboard, test_state_decode_encode)
+{
+    struct HID_Keyboard_t kbd;
+    struct HID_KeyboardState_t state;
+    uint8_t report[HID_KBD_REPORT_SIZE] = {0x22, 0x00, HID_KBD_LETTER('w'), 0x00, HID_KBD_LETTER('d'), 0, 0, 0};
+    uint8_t encoded[HID_KBD_REPORT_SIZE];
+    
+    hidDev.pUdev = &gUdev;
+    hidDev.hid_type = USBHID_TYPE_KEYBOARD;
+    hidDev.raw_hid_report_desc = (uint8_t *)COOLERMASTER_MASTERKEYS_S_1;
+    hidDev.raw_hid_report_desc_len = sizeof(COOLERMASTER_MASTERKEYS_S_1);
+    
+    int ret = hidKeyboard_Open(&hidDev, &kbd);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    hidKeyboard_Decode(&kbd, report, &state);
+    zassert_equal(state.modifiers, 0x22);
+    zassert_equal(state.key_count, 2, "Empty slots are not stored");
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('w')));
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('d')));
+    zassert_false(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('a')));
+    
+    // Encoding packs the keys to the front of the array in usage order
+    hidKeyboard_Encode(&kbd, &state, encoded);
+    zassert_equal(encoded[0], 0x22);
+    zassert_equal(encoded[1], 0x00);
+    zassert_equal(encoded[2], HID_KBD_LETTER('d'));
+    zassert_equal(encoded[3], HID_KBD_LETTER('w'));
+    zassert_equal(encoded[4], 0x00);
+    
+    hidKeyboard_Close(&kbd);
+}
+
+/* ========================================================================
+ * Test: ErrorRollOver keeps the previous state
+ * ======================================================================== */
+ZTEST(hid_keyboard, test_error_rollover)
+{
+    struct HID_Keyboard_t kbd;
+    struct HID_KeyboardState_t state;
+    uint8_t pressed[HID_KBD_REPORT_SIZE] = {0x02, 0x00, HID_KBD_LETTER('w'), 0, 0, 0, 0, 0};
+    uint8_t rollover[HID_KBD_REPORT_SIZE] = {0x02, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+    uint8_t *pBuff;
+    uint32_t len;
+    
+    hidDev.pUdev = &gUdev;
+    hidDev.hid_type = USBHID_TYPE_KEYBOARD;
+    hidDev.raw_hid_report_desc = (uint8_t *)COOLERMASTER_MASTERKEYS_S_1;
+    hidDev.raw_hid_report_desc_len = sizeof(COOLERMASTER_MASTERKEYS_S_1);
+    
+    int ret = hidKeyboard_Open(&hidDev, &kbd);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    // Decode alone refuses the report and leaves the state alone
+    memset(&state, 0xAA, sizeof(state));
+    zassert_false(hidKeyboard_Decode(&kbd, rollover, &state));
+    zassert_equal(state.modifiers, 0xAA);
+    
+    ret = USBHID_getReportBuffer(&hidDev, &pBuff, &len, false);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    memcpy(pBuff, pressed, sizeof(pressed));
+    zassert_equal(hidKeyboard_GetState(&kbd, &state, false), USBHID_SUCCESS);
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('w')));
+    
+    // Too many keys down, the keyboard only knows something is held
+    memcpy(pBuff, rollover, sizeof(rollover));
+    zassert_equal(hidKeyboard_GetState(&kbd, &state, false), USBHID_SUCCESS);
+    zassert_equal(state.key_count, 1, "Rollover must not decode as all keys up");
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('w')));
+    zassert_equal(state.modifiers, 0x02);
+    
+    memset(pBuff, 0x00, HID_KBD_REPORT_SIZE);
+    zassert_equal(hidKeyboard_GetState(&kbd, &state, false), USBHID_SUCCESS);
+    zassert_equal(state.key_count, 0);
+    
+    hidKeyboard_Close(&kbd);
+}
+
+/* ========================================================================
+ * Test: NKRO usage bitmap
+ * ======================================================================== */
+ZTEST(hid_keyboard, test_nkro_bitmap)
+{
+    struct HID_Keyboard_t kbd;
+    struct HID_KeyboardState_t state;
+    uint8_t report[NKRO_KEYBOARD_REPORT_SIZE] = {0};
+    uint8_t encoded[NKRO_KEYBOARD_REPORT_SIZE];
+    uint8_t keys[10] = {
+        HID_KBD_LETTER('q'), HID_KBD_LETTER('w'), HID_KBD_LETTER('e'), HID_KBD_LETTER('r'),
+        HID_KBD_LETTER('a'), HID_KBD_LETTER('s'), HID_KBD_LETTER('d'), HID_KBD_LETTER('f'),
+        HID_KBD_NUMBER('1'), HID_KBD_NUMBER('2')
+    };
+    uint32_t value;
+    
+    hidDev.pUdev = &gUdev;
+    hidDev.hid_type = USBHID_TYPE_KEYBOARD;
+    hidDev.raw_hid_report_desc = (uint8_t *)NKRO_KEYBOARD;
+    hidDev.raw_hid_report_desc_len = sizeof(NKRO_KEYBOARD);
+    
+    int ret = hidKeyboard_Open(&hidDev, &kbd);
+    zassert_equal(ret, USBHID_SUCCESS);
+    zassert_equal(kbd.report_id, 1);
+    zassert_equal(kbd.report_length, NKRO_KEYBOARD_REPORT_SIZE);
+    zassert_equal(kbd.modifier.report_buf_off, 1);
+    zassert_equal(kbd.keys.count, 0, "Bitmap keyboard has no key array");
+    zassert_equal(kbd.bitmap_count, 1);
+    zassert_equal(kbd.bitmaps[0].report_bit_off, 16);
+    zassert_equal(kbd.bitmaps[0].usage_min, 0);
+    zassert_equal(kbd.bitmaps[0].count, 120);
+    
+    // Ten keys at once, more than a boot report can carry
+    report[0] = 0x01;
+    report[1] = 0x02;
+    for (int i = 0; i < 10; i++) {
+        report[2 + (keys[i] >> 3)] |= BIT(keys[i] & 0x07);
+    }
+    
+    hidKeyboard_Decode(&kbd, report, &state);
+    zassert_equal(state.modifiers, 0x02);
+    zassert_equal(state.key_count, 10, "No key is dropped under rollover");
+    for (int i = 0; i < 10; i++) {
+        zassert_true(hidKeyboard_StateHasKey(&state, keys[i]));
+    }
+    zassert_false(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('z')));
+    
+    hidKeyboard_Encode(&kbd, &state, encoded);
+    zassert_mem_equal(encoded, report, NKRO_KEYBOARD_REPORT_SIZE);
+    
+    // Accessors work on the bitmap directly
+    uint8_t *pBuff;
+    uint32_t len;
+    ret = USBHID_getReportBuffer(&hidDev, &pBuff, &len, false);
+    zassert_equal(ret, USBHID_SUCCESS);
+    memcpy(pBuff, report, NKRO_KEYBOARD_REPORT_SIZE);
+    zassert_equal(hidKeyboard_GetKey(&kbd, HID_KBD_NUMBER('2'), &value, false), USBHID_SUCCESS);
+    zassert_equal(value, 1);
+    zassert_equal(hidKeyboard_SetKey(&kbd, HID_KBD_NUMBER('2'), 0, false), USBHID_SUCCESS);
+    zassert_equal(hidKeyboard_GetKey(&kbd, HID_KBD_NUMBER('2'), &value, false), USBHID_SUCCESS);
+    zassert_equal(value, 0);
+    zassert_equal(hidKeyboard_GetKey(&kbd, HID_KBD_LETTER('q'), &value, false), USBHID_SUCCESS);
+    zassert_equal(value, 1);
+    
+    hidKeyboard_Close(&kbd);
+}
+
+/* ========================================================================
+ * Test: Per-usage modifiers and a split bitmap - every run is decoded
+ * ======================================================================== */
+ZTEST(hid_keyboard, test_split_bitmap)
+{
+    struct HID_Keyboard_t kbd;
+    struct HID_KeyboardState_t state;
+    uint8_t report[SPLIT_BITMAP_KEYBOARD_REPORT_SIZE] = {0};
+    uint8_t encoded[SPLIT_BITMAP_KEYBOARD_REPORT_SIZE];
+    
+    hidDev.pUdev = &gUdev;
+    hidDev.hid_type = USBHID_TYPE_KEYBOARD;
+    hidDev.raw_hid_report_desc = (uint8_t *)SPLIT_BITMAP_KEYBOARD;
+    hidDev.raw_hid_report_desc_len = sizeof(SPLIT_BITMAP_KEYBOARD);
+    
+    zassert_equal(hidKeyboard_Open(&hidDev, &kbd), USBHID_SUCCESS);
+    zassert_equal(kbd.report_length, SPLIT_BITMAP_KEYBOARD_REPORT_SIZE);
+    zassert_equal(kbd.modifier.count, 0, "Modifiers are not one 8-bit field");
+    zassert_equal(kbd.keys.count, 0);
+    
+    // Contiguous items merge, the padding splits the last run off
+    zassert_equal(kbd.bitmap_count, 3);
+    zassert_equal(kbd.bitmaps[0].usage_min, HID_KBD_USAGE_LEFT_CTRL);
+    zassert_equal(kbd.bitmaps[0].count, 8);
+    zassert_equal(kbd.bitmaps[1].report_bit_off, 8);
+    zassert_equal(kbd.bitmaps[1].usage_min, 0x04);
+    zassert_equal(kbd.bitmaps[1].count, 36);
+    zassert_equal(kbd.bitmaps[2].report_bit_off, 48);
+    zassert_equal(kbd.bitmaps[2].usage_min, 0x28);
+    
+    // Right Alt, 'a', '1' and Enter, one from each item
+    report[0] = BIT(6);
+    report[1] = BIT(0);
+    report[4] = BIT(2);
+    report[6] = BIT(0);
+    
+    zassert_true(hidKeyboard_Decode(&kbd, report, &state));
+    zassert_equal(state.modifiers, BIT(6));
+    zassert_equal(state.key_count, 3);
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_LETTER('a')));
+    zassert_true(hidKeyboard_StateHasKey(&state, HID_KBD_NUMBER('1')));
+    zassert_true(hidKeyboard_StateHasKey(&state, 0x28));
+    
+    hidKeyboard_Encode(&kbd, &state, encoded);
+    zassert_mem_equal(encoded, report, SPLIT_BITMAP_KEYBOARD_REPORT_SIZE);
+    
+    hidKeyboard_Close(&kbd);
+}
+
+/* ========================================================================
+ * Test: Key event diff and table dispatch
+ * ======================================================================== */
+static uint8_t gEventKeys[8];
+static bool gEventPressed[8];
+static uint32_t gEventCount;
+
+static void record_key_event(uint8_t keyCode, bool isPressed, void *pUserData)
+{
+    (*(uint32_t *)pUserData)++;
+    if (gEventCount < ARRAY_SIZE(gEventKeys)) {
+        gEventKeys[gEventCount] = keyCode;
+        gEventPressed[gEventCount] = isPressed;
+    }
+    gEventCount++;
+}
+
+ZTEST(hid_keyboard, test_key_event_dispatch)
+{
+    struct HID_KeyEventTable_t table;
+    struct HID_KeyboardState_t state;
+    uint32_t pressCount = 0;
+    uint32_t shiftCount = 0;
+    
+    gEventCount = 0;
+    hidKeyboard_InitEvents(&table);
+    memset(&state, 0x00, sizeof(state));
+    
+    zassert_equal(hidKeyboard_BindKey(&table, HID_KBD_LETTER('a'), HID_KEY_EVENT_PRESS,
+                                            record_key_event, &pressCount), USBHID_SUCCESS);
+    zassert_equal(hidKeyboard_BindKey(&table, HID_KBD_USAGE_LEFT_CTRL + 1,
+                    HID_KEY_EVENT_PRESS | HID_KEY_EVENT_RELEASE, record_key_event, &shiftCount), USBHID_SUCCESS);
+    
+    // Unbound keys change state but run nothing
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('b'), true);
+    zassert_equal(hidKeyboard_DispatchEvents(&table, &state), 1);
+    zassert_equal(gEventCount, 0);
+    
+    // Unchanged state produces no events
+    zassert_equal(hidKeyboard_DispatchEvents(&table, &state), 0);
+    
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    state.modifiers = 0x02;
+    zassert_equal(hidKeyboard_DispatchEvents(&table, &state), 2);
+    zassert_equal(gEventCount, 2);
+    zassert_equal(gEventKeys[0], HID_KBD_LETTER('a'), "Events come in key code order");
+    zassert_true(gEventPressed[0]);
+    zassert_equal(gEventKeys[1], HID_KBD_USAGE_LEFT_CTRL + 1);
+    zassert_true(gEventPressed[1]);
+    
+    // Releasing 'a' is not bound, releasing shift is
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), false);
+    state.modifiers = 0x00;
+    zassert_equal(hidKeyboard_DispatchEvents(&table, &state), 2);
+    zassert_equal(gEventCount, 3);
+    zassert_false(gEventPressed[2]);
+    zassert_equal(pressCount, 1);
+    zassert_equal(shiftCount, 2);
+    
+    // Rebinding reuses the slot, unbinding frees it
+    zassert_equal(hidKeyboard_BindKey(&table, HID_KBD_LETTER('a'), HID_KEY_EVENT_RELEASE,
+                                            record_key_event, &pressCount), USBHID_SUCCESS);
+    zassert_equal(table.key_map[HID_KBD_LETTER('a')], 0);
+    zassert_equal(hidKeyboard_UnbindKey(&table, HID_KBD_LETTER('a')), USBHID_SUCCESS);
+    zassert_equal(table.key_map[HID_KBD_LETTER('a')], HID_KBD_ACTION_NONE);
+    zassert_equal(hidKeyboard_UnbindKey(&table, HID_KBD_LETTER('a')), USBHID_PARAM_INVALID);
+    
+    for (uint8_t i = 0; i < HID_KBD_MAX_ACTIONS; i++) {
+        hidKeyboard_BindKey(&table, HID_KBD_LETTER('c') + i, HID_KEY_EVENT_PRESS, record_key_event, &pressCount);
+    }
+    zassert_equal(hidKeyboard_BindKey(&table, HID_KBD_NUMBER('9'), HID_KEY_EVENT_PRESS,
+                                    record_key_event, &pressCount), USBHID_ALLOC_FAILED);
+}
+
 /* ========================================================================
  * Test Suite Setup
  * ======================================================================== */
@@ -237,6 +237,72 @@ static const uint8_t LOGITECH_G305_2[148] = {
     0xC0,              // End Collection
 };
 
+/**
+ * @brief Gaming mouse with 12-bit packed X/Y - 16 buttons, 12-bit X/Y, wheel
+ */
+static const uint8_t PACKED_12BIT[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x10,        //     Usage Maximum (0x10)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x10,        //     Report Count (16)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0xF8,  //     Logical Minimum (-2047)
+    0x26, 0xFF, 0x07,  //     Logical Maximum (2047)
+    0x75, 0x0C,        //     Report Size (12)
+    0x95, 0x02,        //     Report Count (2)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+static const uint8_t MIXED_XY_SIZE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x08,        //     Usage Maximum (0x08)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x08,        //     Report Count (8)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x30,        //     Usage (X)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
 static void test_setup(void *f)
 {
     mock_ch375Reset();
@@ -746,6 +812,54 @@ ZTEST(hid_mouse, test_open_logitech_g305_with_report_id)
     hidMouse_Close(&mouse);
 }
 
+/* ========================================================================
+ * Test: Report ID routing - only the pointer report is delivered
+ * ======================================================================== */
+ZTEST(hid_mouse, test_report_id_routing)
+{
+    struct HID_Mouse_t mouse;
+    uint8_t *pBuff;
+    uint32_t len;
+    int32_t value;
+    uint8_t consumerReport[] = {0x03, 0xE9, 0x00, 0x00, 0x00};
+    uint8_t vendorReport[] = {0x08, 0x01};
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)LOGITECH_G305_2;
+    gHidDev.raw_hid_report_desc_len = sizeof(LOGITECH_G305_2);
+    
+    int ret = hidMouse_Open(&gHidDev, &mouse);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    // Report ID byte leads the report, offsets are fixed at open
+    zassert_equal(mouse.report_id, 2);
+    zassert_equal(mouse.report_id_offset, 1);
+    zassert_equal(mouse.report_len, 9, "ID + 2 button bytes + 2x16-bit axes + wheel + pan");
+    zassert_equal(mouse.button.report_bit_off, 8);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_X], 24);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_Y], 40);
+    zassert_equal(mouse.wheel.report_bit_off, 56);
+    
+    zassert_equal(HID_getReportInfo(&gHidDev.layout, 2)->route, HID_REPORT_ROUTE_ACCEPT);
+    zassert_is_null(HID_routeReport(&gHidDev.layout, (uint8_t[]){0x01}));
+    zassert_equal(HID_routeReport(&gHidDev.layout, consumerReport)->route, HID_REPORT_ROUTE_DROP);
+    zassert_equal(HID_routeReport(&gHidDev.layout, vendorReport)->route, HID_REPORT_ROUTE_DROP);
+    
+    USBHID_getReportBuffer(&gHidDev, &pBuff, &len, false);
+    pBuff[0] = 0x02;
+    pBuff[1] = 0x01;
+    pBuff[3] = 0xFE;
+    pBuff[4] = 0xFF;
+    
+    hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_X, &value, false);
+    zassert_equal(value, -2);
+    hidMouse_GetButton(&mouse, HID_MOUSE_BUTTON_LEFT, (uint32_t *)&value, false);
+    zassert_equal(value, 1);
+    
+    hidMouse_Close(&mouse);
+}
+
 /* ========================================================================
  * Test: Button Operations
  * ======================================================================== */
@@ -1022,6 +1136,212 @@ ZTEST(hid_mouse, test_open_non_mouse_device)
     zassert_equal(ret, USBHID_NOT_SUPPORT, "Should reject non-mouse device");
 }
 
+/* ========================================================================
+ * Test: 12-bit Packed Axes
+ * ======================================================================== */
+ZTEST(hid_mouse, test_packed_12bit_axes)
+{
+    struct HID_Mouse_t mouse;
+    uint8_t *pBuff;
+    uint32_t len;
+    int32_t value;
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)PACKED_12BIT;
+    gHidDev.raw_hid_report_desc_len = sizeof(PACKED_12BIT);
+    
+    int ret = hidMouse_Open(&gHidDev, &mouse);
+    zassert_equal(ret, USBHID_SUCCESS);
+    zassert_equal(mouse.orientation.size, 12, "Should be 12-bit axes");
+    zassert_equal(mouse.report_len, 6);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_X], 16);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_Y], 28);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_WHEEL], 40);
+    
+    hidMouse_SetOrientation(&mouse, HID_MOUSE_AXIS_X, -2047, false);
+    hidMouse_SetOrientation(&mouse, HID_MOUSE_AXIS_Y, 1234, false);
+    
+    USBHID_getReportBuffer(&gHidDev, &pBuff, &len, false);
+    
+    // X = 0x801, Y = 0x4D2 packed LSB first
+    zassert_equal(pBuff[2], 0x01);
+    zassert_equal(pBuff[3], 0x28);
+    zassert_equal(pBuff[4], 0x4D);
+    
+    hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_X, &value, false);
+    zassert_equal(value, -2047);
+    hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_Y, &value, false);
+    zassert_equal(value, 1234);
+    
+    pBuff[5] = 0xFE;
+    hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_WHEEL, &value, false);
+    zassert_equal(value, -2);
+    
+    // Buttons must not be disturbed by axis writes
+    hidMouse_SetButton(&mouse, 15, 1, false);
+    hidMouse_SetOrientation(&mouse, HID_MOUSE_AXIS_X, 5, false);
+    zassert_equal(pBuff[1], 0x80);
+    
+    hidMouse_Close(&mouse);
+}
+
+/* ========================================================================
+ * Test: X and Y of different sizes
+ * ======================================================================== */
+ZTEST(hid_mouse, test_mixed_xy_size)
+{
+    struct HID_Mouse_t mouse;
+    struct HID_MouseState_t state;
+    uint8_t *pBuff;
+    uint32_t len;
+    int32_t value;
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)MIXED_XY_SIZE;
+    gHidDev.raw_hid_report_desc_len = sizeof(MIXED_XY_SIZE);
+    
+    int ret = hidMouse_Open(&gHidDev, &mouse);
+    zassert_equal(ret, USBHID_SUCCESS);
+    zassert_equal(mouse.orientation.size, 8);
+    zassert_equal(mouse.orientation_y.size, 16);
+    zassert_equal(mouse.report_len, 4);
+    zassert_equal(mouse.axis_bit_off[HID_MOUSE_AXIS_Y], 16);
+    
+    USBHID_getReportBuffer(&gHidDev, &pBuff, &len, false);
+    
+    // X = -3, Y = -300 (0xFED4)
+    pBuff[1] = 0xFD;
+    pBuff[2] = 0xD4;
+    pBuff[3] = 0xFE;
+    
+    hidMouse_Decode(&mouse, pBuff, &state);
+    zassert_equal(state.x, -3);
+    zassert_equal(state.y, -300, "Y must be decoded with its own 16-bit size");
+    
+    hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_Y, &value, false);
+    zassert_equal(value, -300);
+    
+    hidMouse_SetOrientation(&mouse, HID_MOUSE_AXIS_Y, 1000, false);
+    zassert_equal(pBuff[2], 0xE8);
+    zassert_equal(pBuff[3], 0x03);
+    zassert_equal(pBuff[1], 0xFD, "X must not be disturbed by a Y write");
+    
+    // Encode clamps each axis to its own range
+    state.x = 500;
+    state.y = 500;
+    hidMouse_Encode(&mouse, &state, pBuff);
+    zassert_equal(pBuff[1], 0x7F);
+    zassert_equal(pBuff[2], 0xF4);
+    zassert_equal(pBuff[3], 0x01);
+    
+    hidMouse_Close(&mouse);
+}
+
+/* ========================================================================
+ * Test: Decode-once state snapshot
+ * ======================================================================== */
+ZTEST(hid_mouse, test_state_decode_encode)
+{
+    struct HID_Mouse_t mouse;
+    struct HID_MouseState_t state;
+    uint8_t report[6] = {0x05, 0x80, 0x01, 0x28, 0x4D, 0xFE};
+    uint8_t encoded[6] = {0};
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)PACKED_12BIT;
+    gHidDev.raw_hid_report_desc_len = sizeof(PACKED_12BIT);
+    
+    int ret = hidMouse_Open(&gHidDev, &mouse);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    hidMouse_Decode(&mouse, report, &state);
+    zassert_equal(state.buttons, 0x8005);
+    zassert_equal(state.x, -2047);
+    zassert_equal(state.y, 1234);
+    zassert_equal(state.wheel, -2);
+    
+    hidMouse_Encode(&mouse, &state, encoded);
+    zassert_mem_equal(encoded, report, sizeof(report), "Round trip must be lossless");
+    
+    // Out of range values are clamped to the logical range, not wrapped
+    state.x = 5000;
+    state.wheel = -300;
+    hidMouse_Encode(&mouse, &state, encoded);
+    hidMouse_Decode(&mouse, encoded, &state);
+    zassert_equal(state.x, 2047);
+    zassert_equal(state.y, 1234);
+    zassert_equal(state.wheel, -127);
+    
+    hidMouse_Close(&mouse);
+}
+
+/* ========================================================================
+ * Benchmark: Decode + encode vs. per-field accessors
+ * ======================================================================== */
+#define STATE_BENCH_ITERATIONS 10000
+
+ZTEST(hid_mouse, test_state_benchmark)
+{
+    struct HID_Mouse_t mouse;
+    struct HID_MouseState_t state;
+    uint8_t *pBuff;
+    uint32_t len;
+    uint32_t start;
+    uint32_t stateCycles;
+    uint32_t accessorCycles;
+    uint32_t checksum = 0;
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)PACKED_12BIT;
+    gHidDev.raw_hid_report_desc_len = sizeof(PACKED_12BIT);
+    
+    int ret = hidMouse_Open(&gHidDev, &mouse);
+    zassert_equal(ret, USBHID_SUCCESS);
+    
+    USBHID_getReportBuffer(&gHidDev, &pBuff, &len, false);
+    memcpy(pBuff, (uint8_t[]){0x01, 0x00, 0x05, 0x30, 0x00, 0x01}, 6);
+    
+    start = k_cycle_get_32();
+    for (uint32_t i = 0; i < STATE_BENCH_ITERATIONS; i++) {
+        hidMouse_GetState(&mouse, &state, false);
+        state.y = -state.y;
+        hidMouse_Encode(&mouse, &state, pBuff);
+        checksum += state.buttons;
+    }
+    stateCycles = k_cycle_get_32() - start;
+    
+    start = k_cycle_get_32();
+    for (uint32_t i = 0; i < STATE_BENCH_ITERATIONS; i++) {
+        uint32_t value;
+        int32_t axis;
+        
+        for (uint32_t b = 0; b < 8; b++) {
+            hidMouse_GetButton(&mouse, b, &value, false);
+            checksum += value;
+        }
+        hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_X, &axis, false);
+        hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_Y, &axis, false);
+        hidMouse_SetOrientation(&mouse, HID_MOUSE_AXIS_Y, -axis, false);
+        hidMouse_GetOrientation(&mouse, HID_MOUSE_AXIS_WHEEL, &axis, false);
+    }
+    accessorCycles = k_cycle_get_32() - start;
+    
+    TC_PRINT("%u reports: decode+encode %u cycles, accessors %u cycles\n",
+             STATE_BENCH_ITERATIONS, stateCycles, accessorCycles);
+    
+    // Both loops flip Y an even number of times
+    hidMouse_GetState(&mouse, &state, false);
+    zassert_equal(state.x, 5);
+    zassert_equal(state.y, 3);
+    zassert_equal(checksum, 2 * STATE_BENCH_ITERATIONS);
+    
+    hidMouse_Close(&mouse);
+}
+
 /* ========================================================================
  * Test Suite Setup
  * ======================================================================== */
@@ -0,0 +1,868 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * ╔═══════════════════════════════════════════════════════════════════════╗
+ * ║                          GhostHIDe Project                            ║
+ * ╚═══════════════════════════════════════════════════════════════════════╝
+ * 
+ * @file           test_hid_output.c
+ * @brief          HID output translation unit tests
+ * 
+ * @author         destrocore
+ * @date           2025
+ * 
+ * @details
+ * Unit tests for the mouse translation plans. Every plan kind must produce
+ * the same output report as the generic decode/encode path.
+ * 
+ * @copyright 
+ * Copyright (c) 2025 akaDestrocore
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <zephyr/ztest.h>
+#include "usb_stubs.h"
+#include "hid_parser.h"
+#include "hid_mouse.h"
+#include "hid_keyboard.h"
+#include "hid_output.h"
+#include "mock_ch375_hw.h"
+#include "mock_usb_hid_proxy.h"
+
+#define PRODUCER_COUNT      2
+#define PRODUCER_SAMPLES    20000
+#define PRODUCER_STACK_SIZE 1024
+
+static struct ch375_Context_t *pCtx;
+static struct USB_Device_t gUdev;
+static struct USBHID_Device_t gHidDev;
+static struct k_thread gProducers[PRODUCER_COUNT];
+static K_THREAD_STACK_ARRAY_DEFINE(gProducerStacks, PRODUCER_COUNT, PRODUCER_STACK_SIZE);
+
+/**
+ * @brief Same layout as the proxy's own mouse report - 8 buttons, 16-bit X/Y, wheel
+ */
+static const uint8_t OUTPUT_LAYOUT_MOUSE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x08,        //     Usage Maximum (0x08)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x08,        //     Report Count (8)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Report ID, 16 buttons, 16-bit X/Y, wheel and pan
+ */
+static const uint8_t REPORT_ID_16BIT_MOUSE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x02,        //   Report ID (2)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x10,        //     Usage Maximum (0x10)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x10,        //     Report Count (16)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0x80,  //     Logical Minimum (-32767)
+    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
+    0x75, 0x10,        //     Report Size (16)
+    0x95, 0x02,        //     Report Count (2)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x01,        //     Report Count (1)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0x05, 0x0C,        //     Usage Page (Consumer)
+    0x0A, 0x38, 0x02,  //     Usage (AC Pan)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Boot style mouse - 3 buttons + padding, 8-bit X/Y/wheel
+ */
+static const uint8_t BOOT_8BIT_MOUSE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x03,        //     Usage Maximum (0x03)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x03,        //     Report Count (3)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x95, 0x05,        //     Report Count (5)
+    0x81, 0x03,        //     Input (Const,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x09, 0x38,        //     Usage (Wheel)
+    0x15, 0x81,        //     Logical Minimum (-127)
+    0x25, 0x7F,        //     Logical Maximum (127)
+    0x75, 0x08,        //     Report Size (8)
+    0x95, 0x03,        //     Report Count (3)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief 12-bit packed X/Y, only the generic remap can handle it
+ */
+static const uint8_t PACKED_12BIT_MOUSE[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop Ctrls)
+    0x09, 0x02,        // Usage (Mouse)
+    0xA1, 0x01,        // Collection (Application)
+    0x09, 0x01,        //   Usage (Pointer)
+    0xA1, 0x00,        //   Collection (Physical)
+    0x05, 0x09,        //     Usage Page (Button)
+    0x19, 0x01,        //     Usage Minimum (0x01)
+    0x29, 0x08,        //     Usage Maximum (0x08)
+    0x15, 0x00,        //     Logical Minimum (0)
+    0x25, 0x01,        //     Logical Maximum (1)
+    0x95, 0x08,        //     Report Count (8)
+    0x75, 0x01,        //     Report Size (1)
+    0x81, 0x02,        //     Input (Data,Var,Abs)
+    0x05, 0x01,        //     Usage Page (Generic Desktop Ctrls)
+    0x16, 0x01, 0xF8,  //     Logical Minimum (-2047)
+    0x26, 0xFF, 0x07,  //     Logical Maximum (2047)
+    0x75, 0x0C,        //     Report Size (12)
+    0x95, 0x02,        //     Report Count (2)
+    0x09, 0x30,        //     Usage (X)
+    0x09, 0x31,        //     Usage (Y)
+    0x81, 0x06,        //     Input (Data,Var,Rel)
+    0xC0,              //   End Collection
+    0xC0,              // End Collection
+};
+
+/**
+ * @brief Copy of the keyboard interface descriptor in usb_hid_proxy.c
+ */
+static const uint8_t PROXY_NKRO_KEYBOARD[] = {
+    0x05, 0x01,        // Usage Page (Generic Desktop)
+    0x09, 0x06,        // Usage (Keyboard)
+    0xA1, 0x01,        // Collection (Application)
+    0x05, 0x07,        //   Usage Page (Key Codes)
+    0x19, 0xE0,        //   Usage Minimum (224)
+    0x29, 0xE7,        //   Usage Maximum (231)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x08,        //   Report Count (8)
+    0x81, 0x02,        //   Input (Data, Variable, Absolute)
+    0x95, 0x01,        //   Report Count (1)
+    0x75, 0x08,        //   Report Size (8)
+    0x81, 0x01,        //   Input (Constant)
+    0x95, 0x06,        //   Report Count (6)
+    0x75, 0x08,        //   Report Size (8)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0xE7,        //   Logical Maximum (231)
+    0x05, 0x07,        //   Usage Page (Key Codes)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0xE7,        //   Usage Maximum (231)
+    0x81, 0x00,        //   Input (Data, Array)
+    0x05, 0x07,        //   Usage Page (Key Codes)
+    0x19, 0x00,        //   Usage Minimum (0)
+    0x29, 0x7F,        //   Usage Maximum (127)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x25, 0x01,        //   Logical Maximum (1)
+    0x75, 0x01,        //   Report Size (1)
+    0x95, 0x80,        //   Report Count (128)
+    0x81, 0x02,        //   Input (Data, Variable, Absolute)
+    0xC0               // End Collection
+};
+
+static void test_setup(void *f)
+{
+    mock_ch375Reset();
+    mock_proxyReset();
+    hidOutput_init();
+    zassert_equal(mock_ch375Init(&pCtx), CH375_SUCCESS);
+    
+    memset(&gUdev, 0x00, sizeof(gUdev));
+    gUdev.ctx = pCtx;
+    
+    memset(&gHidDev, 0x00, sizeof(gHidDev));
+}
+
+static void test_teardown(void *f)
+{
+    if (NULL != gHidDev.report_buffer) {
+        USBHID_freeReportBuffer(&gHidDev);
+    }
+    
+    if (NULL != pCtx) {
+        ch375_closeContext(pCtx);
+        pCtx = NULL;
+    }
+}
+
+/**
+ * @brief Open a mouse, load a raw report and check the planned output against the generic path
+ */
+static void check_plan(const uint8_t *pDesc, uint16_t descLen, const uint8_t *pReport, uint32_t reportLen,
+                                                    uint8_t expectedKind, struct HID_OutputPlan_t *pPlan)
+{
+    struct HID_Mouse_t mouse;
+    uint8_t *pBuff;
+    uint8_t expected[HID_OUTPUT_REPORT_SIZE];
+    size_t sentLen;
+    
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_MOUSE;
+    gHidDev.raw_hid_report_desc = (uint8_t *)pDesc;
+    gHidDev.raw_hid_report_desc_len = descLen;
+    
+    zassert_equal(hidMouse_Open(&gHidDev, &mouse), USBHID_SUCCESS);
+    zassert_equal(mouse.report_len, reportLen);
+    
+    hidOutput_planMouse(&mouse, pPlan);
+    zassert_equal(pPlan->kind, expectedKind);
+    
+    USBHID_getReportBuffer(&gHidDev, &pBuff, NULL, false);
+    memcpy(pBuff, pReport, reportLen);
+    gHidDev.report_cyc = 0x1234;
+    
+    zassert_equal(hidOutput_buildMouseReport(&mouse, expected), 0);
+    zassert_equal(hidOutput_sendMousePlanned(&mouse, pPlan), 0);
+    
+    zassert_equal(mock_proxyGetSendCount(), 1);
+    zassert_equal(mock_proxyGetLastCaptureCyc(), 0x1234, "Report must carry its arrival time");
+    zassert_mem_equal(mock_proxyGetLastReport(&sentLen), expected, HID_OUTPUT_REPORT_SIZE);
+    zassert_equal(sentLen, HID_OUTPUT_REPORT_SIZE);
+    
+    if (HID_OUTPUT_PLAN_IDENTITY == expectedKind) {
+        zassert_equal_ptr(mock_proxyGetLastPointer(), pBuff + pPlan->src[0], "Identity must send in place");
+    }
+    
+    hidMouse_Close(&mouse);
+}
+
+/* ========================================================================
+ * Test: Identity plan - input already in output format
+ * ======================================================================== */
+ZTEST(hid_output, test_plan_identity)
+{
+    struct HID_OutputPlan_t plan;
+    const uint8_t report[] = {0x81, 0x34, 0xFF, 0x10, 0x00, 0xFF};
+    
+    check_plan(OUTPUT_LAYOUT_MOUSE, sizeof(OUTPUT_LAYOUT_MOUSE), report, sizeof(report),
+                                                    HID_OUTPUT_PLAN_IDENTITY, &plan);
+    zassert_equal(plan.src[0], 0);
+}
+
+/* ========================================================================
+ * Test: Permute plan - Report ID and a second button byte are skipped
+ * ======================================================================== */
+ZTEST(hid_output, test_plan_permute_report_id)
+{
+    struct HID_OutputPlan_t plan;
+    const uint8_t report[] = {0x02, 0x05, 0x80, 0xFE, 0xFF, 0x20, 0x00, 0x01, 0x7F};
+    const uint8_t src[HID_OUTPUT_REPORT_SIZE] = {1, 3, 4, 5, 6, 7};
+    
+    check_plan(REPORT_ID_16BIT_MOUSE, sizeof(REPORT_ID_16BIT_MOUSE), report, sizeof(report),
+                                                    HID_OUTPUT_PLAN_PERMUTE, &plan);
+    zassert_mem_equal(plan.src, src, sizeof(src));
+}
+
+/* ========================================================================
+ * Test: Permute plan - 8-bit axes are sign extended, padding masked
+ * ======================================================================== */
+ZTEST(hid_output, test_plan_permute_8bit)
+{
+    struct HID_OutputPlan_t plan;
+    const uint8_t report[] = {0xFD, 0xF6, 0x0A, 0xFF};
+    const uint8_t *pSent;
+    
+    check_plan(BOOT_8BIT_MOUSE, sizeof(BOOT_8BIT_MOUSE), report, sizeof(report),
+                                                    HID_OUTPUT_PLAN_PERMUTE, &plan);
+    
+    pSent = mock_proxyGetLastReport(NULL);
+    zassert_equal(pSent[0], 0x05, "Padding bits must not leak into buttons");
+    zassert_equal((int16_t)sys_get_le16(&pSent[1]), -10);
+    zassert_equal((int16_t)sys_get_le16(&pSent[3]), 10);
+    zassert_equal((int8_t)pSent[5], -1);
+}
+
+/* ========================================================================
+ * Test: Remap plan - packed fields go through decode/encode
+ * ======================================================================== */
+ZTEST(hid_output, test_plan_remap)
+{
+    struct HID_OutputPlan_t plan;
+    const uint8_t report[] = {0x03, 0x01, 0x28, 0x4D};
+    
+    check_plan(PACKED_12BIT_MOUSE, sizeof(PACKED_12BIT_MOUSE), report, sizeof(report),
+                                                    HID_OUTPUT_PLAN_REMAP, &plan);
+}
+
+/**
+ * @brief Check the last sent mouse report
+ */
+static void check_mouse_report(uint8_t buttons, int16_t x, int16_t y, int8_t wheel)
+{
+    const uint8_t *pSent = mock_proxyGetLastReport(NULL);
+    
+    zassert_equal(pSent[0], buttons);
+    zassert_equal((int16_t)sys_get_le16(&pSent[1]), x);
+    zassert_equal((int16_t)sys_get_le16(&pSent[3]), y);
+    zassert_equal((int8_t)pSent[5], wheel);
+}
+
+/* ========================================================================
+ * Test: Busy mouse endpoint - motion and clicks are merged, not dropped
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_coalesce_busy)
+{
+    struct HID_MouseState_t state = {.buttons = 0x01, .x = 100, .y = -50, .wheel = 1};
+    
+    mock_proxySetBusy(0, true);
+    zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0, "Busy endpoint must not fail the caller");
+    
+    // Click released before the host polled
+    state.buttons = 0x00;
+    state.x = 200;
+    state.y = 0;
+    state.wheel = 0;
+    zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0);
+    zassert_equal(mock_proxyGetSendCount(), 0);
+    
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 1);
+    check_mouse_report(0x01, 300, -50, 1);
+    zassert_equal(mock_proxyGetCoalesced(0), 1, "Two samples went out as one report");
+    zassert_equal(mock_proxyGetDropped(0), 0);
+    
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 2, "The release follows on its own");
+    check_mouse_report(0x00, 0, 0, 0);
+    
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 2, "Nothing left to send");
+}
+
+/* ========================================================================
+ * Test: Endpoint freed while the thread held the ring - carry still goes out
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_ready_during_flush)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 5, .y = 0, .wheel = 0};
+    
+    // The ready callback runs inside the busy send attempt and finds the ring claimed
+    mock_proxySetBusy(0, true);
+    mock_proxySetReadyOnBusy(0);
+    zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0);
+    zassert_equal(mock_proxyGetSendCount(), 1, "The carry must not wait for the next sample");
+    check_mouse_report(0x00, 5, 0, 0);
+    
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 1, "Nothing left to send");
+}
+
+/* ========================================================================
+ * Test: Merged motion beyond the report range is split
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_coalesce_split)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 20000, .y = -20000, .wheel = 150};
+    
+    mock_proxySetBusy(0, true);
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+    
+    mock_proxyFireReady(0);
+    check_mouse_report(0x00, INT16_MAX, INT16_MIN, INT8_MAX);
+    mock_proxyFireReady(0);
+    check_mouse_report(0x00, 40000 - INT16_MAX, -40000 - INT16_MIN, INT8_MAX);
+    mock_proxyFireReady(0);
+    check_mouse_report(0x00, 0, 0, 300 - 2 * INT8_MAX);
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 3);
+}
+
+/* ========================================================================
+ * Test: Samples beyond the mouse ring depth keep their motion
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_ring_overflow)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 3, .y = -2, .wheel = 0};
+    
+    mock_proxySetBusy(0, true);
+    for (int i = 0; i < 3 * HID_OUTPUT_MOUSE_RING_DEPTH; i++) {
+        zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0);
+    }
+    zassert_equal(mock_proxyGetSendCount(), 0);
+    
+    
+    mock_proxyFireReady(0);
+    check_mouse_report(0x00, 9 * HID_OUTPUT_MOUSE_RING_DEPTH, -6 * HID_OUTPUT_MOUSE_RING_DEPTH, 0);
+    zassert_equal(mock_proxyGetCoalesced(0), 3 * HID_OUTPUT_MOUSE_RING_DEPTH - 1);
+    zassert_equal(mock_proxyGetDropped(0), 0, "Motion folded into the carry is not dropped");
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 1, "Nothing left to send");
+}
+
+/**
+ * @brief Fill the mouse ring while the first report is being sent, then click in the overflow
+ */
+static void fill_mouse_ring_hook(uint8_t ifaceNum)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 1, .y = 0, .wheel = 0};
+    
+    mock_proxySetSendHook(NULL);
+    for (int i = 0; i < HID_OUTPUT_MOUSE_RING_DEPTH; i++) {
+        hidOutput_sendMouseState(&state, k_cycle_get_32());
+    }
+    
+    state.buttons = 0x01;
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+    state.buttons = 0x00;
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+}
+
+/* ========================================================================
+ * Test: A click that comes and goes while the mouse ring is full
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_ring_overflow_click)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 1, .y = 0, .wheel = 0};
+    
+    mock_proxySetSendHook(fill_mouse_ring_hook);
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+    zassert_equal(mock_proxyGetSendCount(), 1);
+    check_mouse_report(0x00, 1, 0, 0);
+    // The ring folded into the carry behind the busy endpoint, plus both samples that found it full
+    zassert_equal(mock_proxyGetCoalesced(0), (HID_OUTPUT_MOUSE_RING_DEPTH - 1) + 2);
+    zassert_equal(mock_proxyGetDropped(0), 0, "Overflow motion is kept, not dropped");
+    
+    // Next sample after the ring drained carries the click and the folded motion
+    hidOutput_sendMouseState(&state, k_cycle_get_32());
+    mock_proxyFireReady(0);
+    check_mouse_report(0x01, HID_OUTPUT_MOUSE_RING_DEPTH + 3, 0, 0);
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 3, "The release follows on its own");
+    check_mouse_report(0x00, 0, 0, 0);
+    mock_proxyFireReady(0);
+    zassert_equal(mock_proxyGetSendCount(), 3);
+}
+
+/**
+ * @brief Check that the last sent keyboard report holds exactly one key (or none)
+ */
+static void check_keyboard_report(uint8_t keyCode)
+{
+    const uint8_t *pSent = mock_proxyGetLastReport(NULL);
+    uint8_t expected[USBHID_PROXY_KBD_REPORT_SIZE] = {0};
+    
+    if (0 != keyCode) {
+        expected[USBHID_PROXY_KBD_BITMAP_OFFSET + (keyCode >> 3)] = BIT(keyCode & 0x07);
+    }
+    zassert_mem_equal(pSent, expected, USBHID_PROXY_KBD_REPORT_SIZE);
+}
+
+/* ========================================================================
+ * Test: Busy keyboard endpoint - states queue in order, taps survive
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_queue_order)
+{
+    struct HID_KeyboardState_t state;
+    struct HID_OutputQueueStats_t stats;
+    
+    memset(&state, 0x00, sizeof(state));
+    mock_proxySetBusy(1, true);
+    
+    // Tap 'a' then tap 'b' before the host polls once
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), false);
+    hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('b'), true);
+    hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('b'), false);
+    hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+    zassert_equal(mock_proxyGetSendCount(), 0);
+    
+    // Releasing 'a' and pressing 'b' share a report, nothing else is merged
+    hidOutput_getKeyboardQueueStats(&stats);
+    zassert_equal(stats.depth, 3);
+    zassert_equal(stats.high_water, 3);
+    zassert_equal(stats.collapsed, 1);
+    zassert_equal(stats.overflowed, 0);
+    zassert_equal(mock_proxyGetCoalesced(1), 1);
+    zassert_equal(mock_proxyGetDropped(1), 0);
+    
+    mock_proxyFireReady(1);
+    check_keyboard_report(HID_KBD_LETTER('a'));
+    mock_proxyFireReady(1);
+    check_keyboard_report(HID_KBD_LETTER('b'));
+    mock_proxyFireReady(1);
+    check_keyboard_report(0);
+    mock_proxyFireReady(1);
+    zassert_equal(mock_proxyGetSendCount(), 3);
+    
+    hidOutput_getKeyboardQueueStats(&stats);
+    zassert_equal(stats.depth, 0);
+}
+
+/* ========================================================================
+ * Test: Endpoint freed while the thread held the queue - next state still goes out
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_ready_during_drain)
+{
+    struct HID_KeyboardState_t state;
+    
+    memset(&state, 0x00, sizeof(state));
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    
+    mock_proxySetBusy(1, true);
+    mock_proxySetReadyOnBusy(1);
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    zassert_equal(mock_proxyGetSendCount(), 1, "The state must not wait for the next key");
+    check_keyboard_report(HID_KBD_LETTER('a'));
+    
+    mock_proxyFireReady(1);
+    zassert_equal(mock_proxyGetSendCount(), 1, "Nothing left to send");
+}
+
+/* ========================================================================
+ * Test: Full keyboard queue still ends in the right state
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_queue_overflow)
+{
+    struct HID_KeyboardState_t state;
+    struct HID_OutputQueueStats_t stats;
+    
+    memset(&state, 0x00, sizeof(state));
+    mock_proxySetBusy(1, true);
+    
+    // Every state toggles the same key, none can be collapsed
+    for (int i = 0; i < 2 * HID_OUTPUT_KBD_QUEUE_DEPTH + 1; i++) {
+        hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('q'), (0 == (i & 1)));
+        hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+    }
+    
+    hidOutput_getKeyboardQueueStats(&stats);
+    zassert_equal(stats.depth, HID_OUTPUT_KBD_QUEUE_DEPTH);
+    zassert_equal(stats.high_water, HID_OUTPUT_KBD_QUEUE_DEPTH);
+    zassert_true(stats.overflowed > 0);
+    zassert_equal(stats.overflowed + stats.collapsed, HID_OUTPUT_KBD_QUEUE_DEPTH + 1);
+    zassert_equal(mock_proxyGetDropped(1), stats.overflowed);
+    zassert_equal(mock_proxyGetCoalesced(1), stats.collapsed);
+    
+    for (int i = 0; i < HID_OUTPUT_KBD_QUEUE_DEPTH; i++) {
+        mock_proxyFireReady(1);
+    }
+    zassert_equal(mock_proxyGetSendCount(), HID_OUTPUT_KBD_QUEUE_DEPTH);
+    check_keyboard_report(HID_KBD_LETTER('q'));
+}
+
+/**
+ * @brief Fill the keyboard queue while the first state is being sent, then release everything
+ */
+static void fill_keyboard_queue_hook(uint8_t ifaceNum)
+{
+    struct HID_KeyboardState_t state;
+    
+    mock_proxySetSendHook(NULL);
+    memset(&state, 0x00, sizeof(state));
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    
+    // The first state is still queued, these fill the rest
+    for (int i = 0; i < HID_OUTPUT_KBD_QUEUE_DEPTH - 1; i++) {
+        hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('q'), (0 == (i & 1)));
+        zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    }
+    
+    memset(&state, 0x00, sizeof(state));
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0, "The release must be taken");
+}
+
+/* ========================================================================
+ * Test: Full keyboard queue while the drain is claimed - the newest state is kept
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_queue_full_while_draining)
+{
+    struct HID_KeyboardState_t state;
+    struct HID_OutputQueueStats_t stats;
+    
+    memset(&state, 0x00, sizeof(state));
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    
+    mock_proxySetSendHook(fill_keyboard_queue_hook);
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    zassert_equal(mock_proxyGetSendCount(), 1);
+    check_keyboard_report(HID_KBD_LETTER('a'));
+    
+    // The held release took the slot the first state freed
+    hidOutput_getKeyboardQueueStats(&stats);
+    zassert_equal(stats.depth, HID_OUTPUT_KBD_QUEUE_DEPTH);
+    zassert_equal(stats.overflowed, 1);
+    zassert_equal(mock_proxyGetDropped(1), 0, "Nothing was lost");
+    
+    for (int i = 0; i < HID_OUTPUT_KBD_QUEUE_DEPTH; i++) {
+        mock_proxyFireReady(1);
+    }
+    zassert_equal(mock_proxyGetSendCount(), HID_OUTPUT_KBD_QUEUE_DEPTH + 1);
+    check_keyboard_report(0);
+    mock_proxyFireReady(1);
+    zassert_equal(mock_proxyGetSendCount(), HID_OUTPUT_KBD_QUEUE_DEPTH + 1, "Nothing left to send");
+}
+
+/* ========================================================================
+ * Test: NKRO keyboard output - every key reaches the host
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_nkro)
+{
+    struct HID_Keyboard_t kbd;
+    struct HID_KeyboardState_t state;
+    struct HID_KeyboardState_t decoded;
+    const uint8_t *pSent;
+    size_t sentLen;
+    
+    memset(&state, 0x00, sizeof(state));
+    state.modifiers = 0x02;
+    for (uint8_t key = HID_KBD_LETTER('a'); key <= HID_KBD_LETTER('j'); key++) {
+        hidKeyboard_StateSetKey(&state, key, true);
+    }
+    // Keypad Comma, beyond the bitmap
+    hidKeyboard_StateSetKey(&state, 0x85, true);
+    zassert_equal(state.key_count, 11);
+    
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    pSent = mock_proxyGetLastReport(&sentLen);
+    zassert_equal(sentLen, USBHID_PROXY_KBD_REPORT_SIZE);
+    zassert_equal(pSent[HID_KBD_MODIFIER_OFFSET], 0x02);
+    zassert_equal(pSent[HID_KBD_KEYS_OFFSET], 0x85);
+    zassert_equal(pSent[HID_KBD_KEYS_OFFSET + 1], 0x00);
+    
+    // The host side view of the report matches what was sent
+    gHidDev.pUdev = &gUdev;
+    gHidDev.hid_type = USBHID_TYPE_KEYBOARD;
+    gHidDev.raw_hid_report_desc = (uint8_t *)PROXY_NKRO_KEYBOARD;
+    gHidDev.raw_hid_report_desc_len = sizeof(PROXY_NKRO_KEYBOARD);
+    
+    zassert_equal(hidKeyboard_Open(&gHidDev, &kbd), USBHID_SUCCESS);
+    zassert_equal(kbd.report_length, USBHID_PROXY_KBD_REPORT_SIZE);
+    zassert_equal(kbd.bitmap_count, 1);
+    zassert_equal(kbd.bitmaps[0].report_bit_off, USBHID_PROXY_KBD_BITMAP_OFFSET * 8);
+    zassert_equal(kbd.bitmaps[0].count, USBHID_PROXY_KBD_BITMAP_USAGES);
+    
+    hidKeyboard_Decode(&kbd, pSent, &decoded);
+    zassert_mem_equal(&decoded, &state, sizeof(state));
+    
+    hidKeyboard_Close(&kbd);
+}
+
+/* ========================================================================
+ * Test: Boot protocol keyboard output - ErrorRollOver past 6 keys
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_boot_rollover)
+{
+    struct HID_KeyboardState_t state;
+    const uint8_t *pSent;
+    size_t sentLen;
+    
+    memset(&state, 0x00, sizeof(state));
+    mock_proxySetKbdBootProtocol(true);
+    
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('w'), true);
+    hidKeyboard_StateSetKey(&state, HID_KBD_LETTER('a'), true);
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    pSent = mock_proxyGetLastReport(&sentLen);
+    zassert_equal(sentLen, USBHID_PROXY_KBD_BOOT_REPORT_SIZE);
+    zassert_equal(pSent[HID_KBD_KEYS_OFFSET], HID_KBD_LETTER('a'));
+    zassert_equal(pSent[HID_KBD_KEYS_OFFSET + 1], HID_KBD_LETTER('w'));
+    zassert_equal(pSent[HID_KBD_KEYS_OFFSET + 2], 0x00);
+    
+    for (uint8_t key = HID_KBD_LETTER('b'); key <= HID_KBD_LETTER('f'); key++) {
+        hidKeyboard_StateSetKey(&state, key, true);
+    }
+    zassert_equal(hidOutput_sendKeyboardState(&state, k_cycle_get_32()), 0);
+    mock_proxyFireReady(1);
+    pSent = mock_proxyGetLastReport(&sentLen);
+    for (int i = 0; i < HID_KBD_MAX_KEYS; i++) {
+        zassert_equal(pSent[HID_KBD_KEYS_OFFSET + i], HID_KBD_USAGE_ERR_ROLLOVER);
+    }
+}
+
+/* ========================================================================
+ * Test: Reports carry the capture time of the oldest data they hold
+ * ======================================================================== */
+ZTEST(hid_output, test_report_capture_time)
+{
+    struct HID_MouseState_t state = { .buttons = 0, .x = 1, .y = 0, .wheel = 0 };
+    struct HID_KeyboardState_t kbdState;
+    uint32_t startCyc;
+    uint32_t firstCyc;
+    
+    mock_proxySetBusy(0, true);
+    startCyc = k_cycle_get_32();
+    zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0);
+    
+    // Later motion merged into the same report must not make it look younger
+    firstCyc = k_cycle_get_32();
+    while (k_cycle_get_32() == firstCyc) {
+    }
+    zassert_equal(hidOutput_sendMouseState(&state, k_cycle_get_32()), 0);
+    mock_proxyFireReady(0);
+    check_mouse_report(0, 2, 0, 0);
+    zassert_true(mock_proxyGetLastCaptureCyc() - startCyc <= firstCyc - startCyc);
+    
+    // A queued keyboard state keeps the time it was queued at
+    memset(&kbdState, 0x00, sizeof(kbdState));
+    mock_proxySetBusy(1, true);
+    startCyc = k_cycle_get_32();
+    hidKeyboard_StateSetKey(&kbdState, HID_KBD_LETTER('a'), true);
+    zassert_equal(hidOutput_sendKeyboardState(&kbdState, k_cycle_get_32()), 0);
+    firstCyc = k_cycle_get_32();
+    while (k_cycle_get_32() == firstCyc) {
+    }
+    mock_proxyFireReady(1);
+    check_keyboard_report(HID_KBD_LETTER('a'));
+    zassert_true(mock_proxyGetLastCaptureCyc() - startCyc <= firstCyc - startCyc);
+}
+
+/**
+ * @brief One mouse input thread, moves right and down one count per sample
+ */
+static void mouse_producer(void *p1, void *p2, void *p3)
+{
+    struct HID_MouseState_t state = {.buttons = 0x00, .x = 1, .y = 1, .wheel = 0};
+    
+    for (int i = 0; i < PRODUCER_SAMPLES; i++) {
+        hidOutput_sendMouseState(&state, k_cycle_get_32());
+        k_yield();
+    }
+}
+
+/**
+ * @brief One keyboard input thread, taps its own key over and over
+ */
+static void keyboard_producer(void *p1, void *p2, void *p3)
+{
+    struct HID_KeyboardState_t state;
+    uint8_t keyCode = (uint8_t)(uintptr_t)p1;
+    
+    memset(&state, 0x00, sizeof(state));
+    for (int i = 0; i < PRODUCER_SAMPLES; i++) {
+        hidKeyboard_StateSetKey(&state, keyCode, (0 == (i & 1)));
+        hidOutput_sendKeyboardState(&state, k_cycle_get_32());
+        k_yield();
+    }
+}
+
+/**
+ * @brief Run the producers on their own threads and wait for them
+ */
+static void run_producers(k_thread_entry_t entry, void *pArg0, void *pArg1)
+{
+    void *pArgs[PRODUCER_COUNT] = {pArg0, pArg1};
+    
+    for (int i = 0; i < PRODUCER_COUNT; i++) {
+        k_thread_create(&gProducers[i], gProducerStacks[i], K_THREAD_STACK_SIZEOF(gProducerStacks[i]),
+                        entry, pArgs[i], NULL, NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+    }
+    for (int i = 0; i < PRODUCER_COUNT; i++) {
+        k_thread_join(&gProducers[i], K_FOREVER);
+    }
+}
+
+/* ========================================================================
+ * Test: Two mice on two input threads - no motion is lost
+ * ======================================================================== */
+ZTEST(hid_output, test_mouse_two_producers)
+{
+    const uint8_t *pSent;
+    int32_t sumX = 0;
+    int32_t sumY = 0;
+    int sendCount = 0;
+    
+    mock_proxySetBusy(0, true);
+    run_producers(mouse_producer, NULL, NULL);
+    
+    // Drain what the host did not take yet
+    do {
+        sendCount = mock_proxyGetSendCount();
+        mock_proxyFireReady(0);
+        if (mock_proxyGetSendCount() != sendCount) {
+            pSent = mock_proxyGetLastReport(NULL);
+            sumX += (int16_t)sys_get_le16(&pSent[1]);
+            sumY += (int16_t)sys_get_le16(&pSent[3]);
+        }
+    } while (mock_proxyGetSendCount() != sendCount);
+    
+    zassert_equal(sumX, PRODUCER_COUNT * PRODUCER_SAMPLES, "X lost %d counts",
+                                            PRODUCER_COUNT * PRODUCER_SAMPLES - sumX);
+    zassert_equal(sumY, PRODUCER_COUNT * PRODUCER_SAMPLES);
+}
+
+/* ========================================================================
+ * Test: Two keyboards on two input threads - the queue stays consistent
+ * ======================================================================== */
+ZTEST(hid_output, test_keyboard_two_producers)
+{
+    struct HID_OutputQueueStats_t stats;
+    
+    mock_proxySetBusy(1, true);
+    run_producers(keyboard_producer, (void *)(uintptr_t)HID_KBD_LETTER('a'),
+                                    (void *)(uintptr_t)HID_KBD_LETTER('b'));
+    
+    hidOutput_getKeyboardQueueStats(&stats);
+    // A full queue holds one more state back for the consumer
+    zassert_true(stats.depth <= HID_OUTPUT_KBD_QUEUE_DEPTH + 1, "Queue depth %u", stats.depth);
+    zassert_true(stats.high_water <= HID_OUTPUT_KBD_QUEUE_DEPTH);
+    
+    for (uint32_t i = 0; i < stats.depth + 1; i++) {
+        mock_proxyFireReady(1);
+    }
+    zassert_equal(mock_proxyGetSendCount(), stats.depth, "Every queued state goes out once");
+    
+    hidOutput_getKeyboardQueueStats(&stats);
+    zassert_equal(stats.depth, 0);
+}
+
+/* ========================================================================
+ * Test Suite Setup
+ * ======================================================================== */
+ZTEST_SUITE(hid_output, NULL, NULL, test_setup, test_teardown, NULL);
@@ -152,6 +152,56 @@ static const uint8_t HidMouseWithReportID[] = {
     0xC1, 0x00                  // END_COLLECTION
 };
 
+/**
+ * @brief Consumer report declared ahead of the mouse report, both on one endpoint
+ */
+static const uint8_t HidCompositeReportIDs[] = {
+    0x05, 0x0C,                 // USAGE_PAGE (Consumer Devices)
+    0x09, 0x01,                 // USAGE (Consumer Control)
+    0xA1, 0x01,                 // COLLECTION (Application)
+    0x85, 0x03,                 //   REPORT_ID (3)
+    0x15, 0x00,                 //   LOGICAL_MINIMUM (0)
+    0x25, 0x01,                 //   LOGICAL_MAXIMUM (1)
+    0x75, 0x01,                 //   REPORT_SIZE (1)
+    0x95, 0x02,                 //   REPORT_COUNT (2)
+    0x09, 0xE9,                 //   USAGE (Volume Up)
+    0x09, 0xEA,                 //   USAGE (Volume Down)
+    0x81, 0x02,                 //   INPUT (Data,Var,Abs)
+    0x95, 0x06,                 //   REPORT_COUNT (6)
+    0x81, 0x03,                 //   INPUT (Cnst,Var,Abs)
+    0xC0,                       // END_COLLECTION
+    0x05, 0x01,                 // USAGE_PAGE (Generic Desktop)
+    0x09, 0x02,                 // USAGE (Mouse)
+    0xA1, 0x01,                 // COLLECTION (Application)
+    0x85, 0x01,                 //   REPORT_ID (1)
+    0x05, 0x09,                 //   USAGE_PAGE (Button)
+    0x19, 0x01,                 //   USAGE_MINIMUM (Button 1)
+    0x29, 0x03,                 //   USAGE_MAXIMUM (Button 3)
+    0x95, 0x03,                 //   REPORT_COUNT (3)
+    0x81, 0x02,                 //   INPUT (Data,Var,Abs)
+    0x95, 0x05,                 //   REPORT_COUNT (5)
+    0x81, 0x03,                 //   INPUT (Cnst,Var,Abs)
+    0x05, 0x01,                 //   USAGE_PAGE (Generic Desktop)
+    0x09, 0x30,                 //   USAGE (X)
+    0x09, 0x31,                 //   USAGE (Y)
+    0x15, 0x81,                 //   LOGICAL_MINIMUM (-127)
+    0x25, 0x7F,                 //   LOGICAL_MAXIMUM (127)
+    0x75, 0x08,                 //   REPORT_SIZE (8)
+    0x95, 0x02,                 //   REPORT_COUNT (2)
+    0x81, 0x06,                 //   INPUT (Data,Var,Rel)
+    0xC0,                       // END_COLLECTION
+    0x05, 0x0C,                 // USAGE_PAGE (Consumer Devices)
+    0x09, 0x01,                 // USAGE (Consumer Control)
+    0xA1, 0x01,                 // COLLECTION (Application)
+    0x85, 0x03,                 //   REPORT_ID (3)
+    0x75, 0x08,                 //   REPORT_SIZE (8)
+    0x95, 0x01,                 //   REPORT_COUNT (1)
+    0x26, 0xFF, 0x00,           //   LOGICAL_MAXIMUM (255)
+    0x09, 0xE0,                 //   USAGE (Volume)
+    0x81, 0x02,                 //   INPUT (Data,Var,Abs)
+    0xC0                        // END_COLLECTION
+};
+
 /**
  * @brief Mouse descriptor with wheel
  */
@@ -274,52 +324,40 @@ ZTEST(hid_parser, test_fetch_item_buffer_overflow) {
  * ======================================================================== */
 ZTEST(hid_parser, test_parse_mouse_descriptor) {
     
-    uint8_t detectedType = 0;
+    struct HID_ReportLayout_t layout;
     
-    int ret = HID_parseReportDescriptor(
-        (uint8_t *)HidMouseReportDesc,
-        sizeof(HidMouseReportDesc),
-        &detectedType
-    );
+    int ret = HID_compileReportLayout(HidMouseReportDesc, sizeof(HidMouseReportDesc), &layout);
     
     zassert_equal(ret, 0);
-    zassert_equal(detectedType, USBHID_TYPE_MOUSE);
+    zassert_equal(layout.hid_type, USBHID_TYPE_MOUSE);
 }
 
 ZTEST(hid_parser, test_parse_keyboard_descriptor) {
     
-    uint8_t detectedType = 0;
+    struct HID_ReportLayout_t layout;
     
-    int ret = HID_parseReportDescriptor(
-        (uint8_t *)HidKeyboardReportDesc,
-        sizeof(HidKeyboardReportDesc),
-        &detectedType
-    );
+    int ret = HID_compileReportLayout(HidKeyboardReportDesc, sizeof(HidKeyboardReportDesc), &layout);
     
     zassert_equal(ret, 0);
-    zassert_equal(detectedType, USBHID_TYPE_KEYBOARD);
+    zassert_equal(layout.hid_type, USBHID_TYPE_KEYBOARD);
 }
 
 ZTEST(hid_parser, test_parse_mouse_with_wheel) {
     
-    uint8_t detectedType = 0;
+    struct HID_ReportLayout_t layout;
     
-    int ret = HID_parseReportDescriptor(
-        (uint8_t *)MouseWheelReportDesc,
-        sizeof(MouseWheelReportDesc),
-        &detectedType
-    );
+    int ret = HID_compileReportLayout(MouseWheelReportDesc, sizeof(MouseWheelReportDesc), &layout);
     
     zassert_equal(ret, 0);
-    zassert_equal(detectedType, USBHID_TYPE_MOUSE);
+    zassert_equal(layout.hid_type, USBHID_TYPE_MOUSE);
 }
 
 ZTEST(hid_parser, test_parse_invalid_descriptor) {
     
     uint8_t pInvalid[] = {0xC0, 0xFF, 0xEE};
-    uint8_t detectedType = 0;
+    struct HID_ReportLayout_t layout;
     
-    int ret = HID_parseReportDescriptor(pInvalid, sizeof(pInvalid), &detectedType);
+    int ret = HID_compileReportLayout(pInvalid, sizeof(pInvalid), &layout);
     
     zassert_not_equal(ret, 0, "Should fail on invalid descriptor");
 }
@@ -397,17 +435,13 @@ ZTEST(hid_parser, test_double_alloc_fails) {
  * ======================================================================== */
 ZTEST(hid_parser, test_report_id_detection) {
     
-    uint8_t detectedType = 0;
+    struct HID_ReportLayout_t layout;
     
     // Parse descriptor with Report ID
-    int ret = HID_parseReportDescriptor(
-        (uint8_t *)HidMouseWithReportID,
-        sizeof(HidMouseWithReportID),
-        &detectedType
-    );
+    int ret = HID_compileReportLayout(HidMouseWithReportID, sizeof(HidMouseWithReportID), &layout);
     
     zassert_equal(ret, 0);
-    zassert_equal(detectedType, USBHID_TYPE_MOUSE);
+    zassert_equal(layout.hid_type, USBHID_TYPE_MOUSE);
     
     // Verify Report ID item is present in descriptor
     struct HID_Item_t item;
@@ -504,6 +538,261 @@ ZTEST(hid_parser, test_report_buffer_not_allocated) {
     zassert_equal(ret, USBHID_BUFFER_NOT_ALLOC);
 }
 
+/* ========================================================================
+ * Test: Bit Field Access
+ * ======================================================================== */
+ZTEST(hid_parser, test_extract_bits_unaligned) {
+    
+    // X = 0x801 (12 bit) at bit 4, Y = 0x4D2 (12 bit) at bit 16
+    uint8_t pData[] = {0x10, 0x80, 0xD2, 0x04};
+    
+    zassert_equal(HID_extractBits(pData, 4, 12), 0x801);
+    zassert_equal(HID_extractSigned(pData, 4, 12), -2047);
+    zassert_equal(HID_extractBits(pData, 16, 12), 0x4D2);
+    zassert_equal(HID_extractSigned(pData, 16, 12), 1234);
+    zassert_equal(HID_extractBits(pData, 4, 1), 1);
+    zassert_equal(HID_extractBits(pData, 0, 32), 0x04D28010);
+}
+
+ZTEST(hid_parser, test_insert_bits_unaligned) {
+    
+    uint8_t pData[4];
+    
+    memset(pData, 0xFF, sizeof(pData));
+    HID_insertBits(pData, 4, 12, (uint32_t)-2047);
+    
+    // Neighbouring bits must be left untouched
+    zassert_equal(pData[0], 0x1F);
+    zassert_equal(pData[1], 0x80);
+    zassert_equal(pData[2], 0xFF);
+    zassert_equal(HID_extractSigned(pData, 4, 12), -2047);
+    
+    HID_insertBits(pData, 0, 32, 0x12345678);
+    zassert_equal(HID_extractBits(pData, 0, 32), 0x12345678);
+}
+
+/* ========================================================================
+ * Test: Compiled Report Layout
+ * ======================================================================== */
+ZTEST(hid_parser, test_compile_layout_mouse) {
+    
+    struct HID_ReportLayout_t layout;
+    const struct HID_Field_t *pField;
+    uint32_t index = 0;
+    
+    int ret = HID_compileReportLayout(MouseWheelReportDesc, sizeof(MouseWheelReportDesc), &layout);
+    
+    zassert_equal(ret, 0);
+    zassert_true(layout.is_compiled);
+    zassert_equal(layout.hid_type, USBHID_TYPE_MOUSE);
+    zassert_false(layout.has_report_id);
+    
+    // 3 buttons share one entry, padding is not recorded, X/Y/Wheel get one entry each
+    zassert_equal(layout.field_count, 4);
+    zassert_equal(layout.report_count, 1);
+    zassert_equal(layout.reports[0].input_bits, 32);
+    
+    pField = HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_UP_BUTTON | 0x03, &index);
+    zassert_not_null(pField);
+    zassert_equal(pField->bit_offset, 0);
+    zassert_equal(pField->bit_size, 1);
+    zassert_equal(pField->count, 3);
+    zassert_equal(index, 2);
+    
+    pField = HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_GD_Y, &index);
+    zassert_not_null(pField);
+    zassert_equal(pField->bit_offset, 16);
+    zassert_equal(pField->bit_size, 8);
+    zassert_equal(pField->logical_minimum, -127);
+    zassert_true(pField->flags & HID_FIELD_SIGNED);
+    zassert_true(pField->flags & HID_FIELD_RELATIVE);
+    
+    pField = HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_GD_WHEEL, NULL);
+    zassert_not_null(pField);
+    zassert_equal(pField->bit_offset, 24);
+    
+    // Not in the descriptor
+    zassert_is_null(HID_findField(&layout, HID_REPORT_TYPE_INPUT, 0, HID_GD_Z, NULL));
+    zassert_is_null(HID_findField(&layout, HID_REPORT_TYPE_OUTPUT, 0, HID_GD_X, NULL));
+}
+
+ZTEST(hid_parser, test_compile_layout_report_id) {
+    
+    struct HID_ReportLayout_t layout;
+    const struct HID_ReportInfo_t *pInfo;
+    
+    int ret = HID_compileReportLayout(HidMouseWithReportID, sizeof(HidMouseWithReportID), &layout);
+    
+    zassert_equal(ret, 0);
+    zassert_true(layout.has_report_id);
+    
+    pInfo = HID_getReportInfo(&layout, 1);
+    zassert_not_null(pInfo);
+    zassert_true(pInfo->input_bits > 0);
+    zassert_is_null(HID_getReportInfo(&layout, 7));
+}
+
+ZTEST(hid_parser, test_report_id_dispatch) {
+    
+    struct HID_ReportLayout_t layout;
+    const struct HID_ReportInfo_t *pInfo;
+    uint8_t mouseReport[] = {0x01, 0x01, 0x05, 0xFB};
+    uint8_t consumerReport[] = {0x03, 0x01, 0x40};
+    uint8_t unknownReport[] = {0x07, 0x00, 0x00};
+    uint32_t index;
+    
+    int ret = HID_compileReportLayout(HidCompositeReportIDs, sizeof(HidCompositeReportIDs), &layout);
+    
+    zassert_equal(ret, 0);
+    zassert_equal(layout.hid_type, USBHID_TYPE_MOUSE);
+    zassert_equal(layout.report_count, 2);
+    zassert_equal(layout.report_map[0], HID_REPORT_INDEX_NONE);
+    zassert_equal(layout.report_map[2], HID_REPORT_INDEX_NONE);
+    
+    // Fields of report 3 come from two collections but must end up contiguous
+    pInfo = HID_getReportInfo(&layout, 3);
+    zassert_not_null(pInfo);
+    zassert_equal(pInfo->field_count, 3);
+    zassert_equal(pInfo->input_bits, 16);
+    zassert_equal(pInfo->app_usage, 0x000C0001);
+    for (uint32_t i = pInfo->field_first; i < pInfo->field_first + pInfo->field_count; i++) {
+        zassert_equal(layout.fields[i].report_id, 3);
+    }
+    
+    pInfo = HID_routeReport(&layout, mouseReport);
+    zassert_not_null(pInfo);
+    zassert_equal(pInfo->report_id, 1);
+    zassert_equal(pInfo->app_usage, HID_GD_MOUSE);
+    zassert_equal(pInfo->route, HID_REPORT_ROUTE_ACCEPT);
+    
+    zassert_equal(HID_routeReport(&layout, consumerReport)->report_id, 3);
+    zassert_is_null(HID_routeReport(&layout, unknownReport));
+    
+    // Lookups stay inside one report
+    zassert_not_null(HID_findReportField(&layout, 1, HID_REPORT_TYPE_INPUT, HID_UP_BUTTON | 0x03, &index));
+    zassert_equal(index, 2);
+    zassert_is_null(HID_findReportField(&layout, 3, HID_REPORT_TYPE_INPUT, HID_GD_X, NULL));
+    zassert_is_null(HID_findReportField(&layout, 2, HID_REPORT_TYPE_INPUT, HID_GD_X, NULL));
+    
+    zassert_equal(HID_setReportRoute(&layout, 3, HID_REPORT_ROUTE_DROP), 0);
+    zassert_equal(HID_routeReport(&layout, consumerReport)->route, HID_REPORT_ROUTE_DROP);
+    zassert_equal(HID_setReportRoute(&layout, 7, HID_REPORT_ROUTE_DROP), -EINVAL);
+}
+
+ZTEST(hid_parser, test_compile_layout_keyboard) {
+    
+    struct HID_ReportLayout_t layout;
+    const struct HID_ReportInfo_t *pInfo;
+    
+    int ret = HID_compileReportLayout(HidKeyboardReportDesc, sizeof(HidKeyboardReportDesc), &layout);
+    
+    zassert_equal(ret, 0);
+    zassert_equal(layout.hid_type, USBHID_TYPE_KEYBOARD);
+    
+    pInfo = HID_getReportInfo(&layout, 0);
+    zassert_not_null(pInfo);
+    zassert_equal(pInfo->input_bits, 64, "Boot keyboard input report is 8 bytes");
+    zassert_true(pInfo->output_bits > 0, "LED output report expected");
+}
+
+ZTEST(hid_parser, test_compile_layout_invalid) {
+    
+    struct HID_ReportLayout_t layout;
+    uint8_t pInvalid[] = {0xC0, 0xFF, 0xEE};
+    
+    zassert_equal(HID_compileReportLayout(NULL, 10, &layout), -EINVAL);
+    zassert_equal(HID_compileReportLayout(pInvalid, sizeof(pInvalid), NULL), -EINVAL);
+    zassert_not_equal(HID_compileReportLayout(pInvalid, sizeof(pInvalid), &layout), 0);
+}
+
+ZTEST(hid_parser, test_compile_layout_usage_overflow) {
+    
+    struct HID_ReportLayout_t layout;
+    const struct HID_Field_t *pField;
+    uint8_t desc[6 + 2 + (2 * (HID_PARSER_MAX_USAGES + 1)) + 11];
+    uint8_t *pCur = desc;
+    const uint8_t head[] = {0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x05, 0x09};
+    const uint8_t tail[] = {0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, HID_PARSER_MAX_USAGES + 1, 0x81, 0x02, 0xC0};
+    
+    // One Usage more than the parser keeps, each naming one element of the Input
+    memcpy(pCur, head, sizeof(head));
+    pCur += sizeof(head);
+    for (uint8_t i = 1; i <= HID_PARSER_MAX_USAGES + 1; i++) {
+        *pCur++ = 0x09;
+        *pCur++ = i;
+    }
+    memcpy(pCur, tail, sizeof(tail));
+    
+    zassert_equal(HID_compileReportLayout(desc, sizeof(desc), &layout), 0);
+    zassert_equal(layout.reports[0].input_bits, HID_PARSER_MAX_USAGES + 1);
+    
+    // The last kept usage names its own element only, the dropped one is not guessed
+    pField = HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_UP_BUTTON | HID_PARSER_MAX_USAGES, NULL);
+    zassert_not_null(pField);
+    zassert_equal(pField->count, 1);
+    zassert_equal(pField->bit_offset, HID_PARSER_MAX_USAGES - 1);
+    zassert_is_null(HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE,
+                                  HID_UP_BUTTON | (HID_PARSER_MAX_USAGES + 1), NULL));
+}
+
+ZTEST(hid_parser, test_compile_layout_size_overflow) {
+    
+    struct HID_ReportLayout_t layout;
+    const uint8_t desc[] = {
+        0x05, 0x01, 0x09, 0x02, 0xA1, 0x01,
+        0x09, 0x30,                         // Usage (X)
+        0x77, 0xFF, 0xFF, 0xFF, 0xFF,       // Report Size (0xFFFFFFFF)
+        0x97, 0xFF, 0xFF, 0xFF, 0xFF,       // Report Count (0xFFFFFFFF)
+        0x81, 0x02,
+        0x09, 0x31,                         // Usage (Y)
+        0x75, 0x08, 0x95, 0x01, 0x81, 0x06,
+        0xC0
+    };
+    
+    // The product wraps in 32 bits, the item must be dropped and not shift Y
+    HID_compileReportLayout(desc, sizeof(desc), &layout);
+    zassert_is_null(HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_GD_X, NULL));
+    if (layout.is_compiled) {
+        const struct HID_Field_t *pField = HID_findField(&layout, HID_REPORT_TYPE_INPUT, HID_GD_MOUSE, HID_GD_Y, NULL);
+        
+        zassert_not_null(pField);
+        zassert_equal(pField->bit_offset, 0);
+    }
+}
+
+/* ========================================================================
+ * Test: HID Descriptor Lookup In Untrusted Configurations
+ * ======================================================================== */
+ZTEST(hid_parser, test_get_hid_descriptor) {
+    
+    struct USB_HID_Descriptor_t *pHidDesc = NULL;
+    uint8_t config[] = {
+        0x09, 0x02, 0x22, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+        0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x02, 0x00,
+        0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x34, 0x00,
+        0x07, 0x05, 0x81, 0x03, 0x04, 0x00, 0x0A
+    };
+    
+    udev.raw_conf_desc = config;
+    udev.raw_conf_desc_len = sizeof(config);
+    
+    zassert_equal(USBHID_getHidDescriptor(&udev, 0, &pHidDesc), 0);
+    zassert_equal_ptr(pHidDesc, &config[18]);
+    zassert_equal(sys_le16_to_cpu(pHidDesc->wClassDescriptorLength), 52);
+    zassert_not_equal(USBHID_getHidDescriptor(&udev, 1, &pHidDesc), 0, "No interface 1");
+    
+    // HID descriptor cut short, then running past the end of the configuration
+    config[18] = 0x06;
+    zassert_not_equal(USBHID_getHidDescriptor(&udev, 0, &pHidDesc), 0);
+    
+    config[18] = 0x09;
+    udev.raw_conf_desc_len = 23;
+    zassert_not_equal(USBHID_getHidDescriptor(&udev, 0, &pHidDesc), 0);
+    
+    udev.raw_conf_desc = NULL;
+    udev.raw_conf_desc_len = 0;
+}
+
 /* ========================================================================
  * Test Suite Setup
  * ======================================================================== */
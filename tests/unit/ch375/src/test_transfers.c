@@ -12,8 +12,9 @@
  * 
  * @details
  * Unit tests for USB control and bulk transfers including GET_DESCRIPTOR,
- * SET_ADDRESS, STALL handling, disconnect detection, multi-packet data
- * phase, NAK retry logic, and clear stall endpoint recovery.
+ * SET_ADDRESS, STALL handling, disconnect detection, fail-fast 0 ms
+ * transfers, multi-packet data phase, NAK retry logic, and clear stall
+ * endpoint recovery.
  * 
  * @copyright 
  * Copyright (c) 2025 akaDestrocore
@@ -186,6 +187,40 @@ ZTEST(ch375_transfers, test_control_transfer_disconnect)
     zassert_equal(ret, CH37X_HOST_DEV_DISCONNECT);
 }
 
+/* ========================================================================
+ * Test: Control Transfer - Zero Timeout Fails Fast on NAK
+ * ======================================================================== */
+ZTEST(ch375_transfers, test_control_transfer_zero_timeout_nak)
+{
+    uint8_t leds = 0x02;
+    uint8_t history[64];
+    int count = 0;
+    bool isNoRetry = false;
+
+    // SETUP stage success
+    queue_control_success_responses();
+
+    // Device NAKs the DATA OUT stage
+    mock_ch375QueueStatus(0x00);
+    mock_ch375QueueStatus(CH37X_PID2STATUS(USB_PID_NAK));
+    mock_ch375QueueStatus(CH37X_PID2STATUS(USB_PID_NAK));
+
+    // SET_REPORT (Output), as sent for keyboard LEDs
+    int ret = ch375_hostControlTransfer(&udev, USB_REQ_TYPE(USB_DIR_OUT, USB_TYPE_CLASS, USB_RECIP_INTERFACE),
+                                                    0x09, 0x0200, 0, &leds, sizeof(leds), NULL, 0);
+
+    zassert_equal(ret, CH37X_HOST_TIMEOUT, "NAK should end a 0 ms transfer");
+
+    // SET_RETRY 0x25, 0x05 means a single attempt per token
+    mock_ch375GetDataHistory(history, &count, sizeof(history));
+    for (int i = 0; i + 1 < count; i++) {
+        if (0x25 == history[i] && 0x05 == history[i + 1]) {
+            isNoRetry = true;
+        }
+    }
+    zassert_true(isNoRetry, "Should disable NAK retries");
+}
+
 /* ========================================================================
  * Test: Control Transfer - Multi-Packet Data Phase
  * ======================================================================== */